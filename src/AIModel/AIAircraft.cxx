@@ -24,6 +24,7 @@
 
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
+#include <Main/snapshot.hxx>
 #include <Scenery/scenery.hxx>
 #include <Airports/dynamics.hxx>
 #include <Airports/airport.hxx>
@@ -1438,3 +1439,27 @@ void FGAIAircraft::updateModelProperties(double dt)
 //  double flapPosNorm = props->getDoubleValue();
 }
 
+void FGAIAircraft::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+    // ahead of the base class data, so all of it is read before the base
+    // class applies its part
+    w.put<double>(prev_dist_to_go);
+    w.put<double>(minBearing);
+    w.put<double>(speedFraction);
+    FGAIBase::saveSnapshot(w);
+}
+
+bool FGAIAircraft::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+    double prevDistToGo = r.get<double>();
+    double newMinBearing = r.get<double>();
+    double newSpeedFraction = r.get<double>();
+    if (!FGAIBase::restoreSnapshot(r)) {
+        return false;
+    }
+
+    prev_dist_to_go = prevDistToGo;
+    minBearing = newMinBearing;
+    speedFraction = newSpeedFraction;
+    return true;
+}
@@ -45,6 +45,10 @@ public:
     virtual void update(double dt);
     virtual void unbind();
 
+    // adds the state of approaching the current waypoint
+    virtual void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    virtual bool restoreSnapshot(flightgear::SnapshotReader& r);
+
     void setPerformance(const std::string& acType, const std::string& perfString);
   //  void setPerformance(PerformanceData *ps);
 
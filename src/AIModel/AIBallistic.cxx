@@ -958,6 +958,25 @@ void FGAIBallistic::handleEndOfLife(double elevation) {
     }
 }
 
+void FGAIBallistic::takeOverEndOfFlight(EndOfFlight reason, double elevation_m,
+                                        const FGAIBase* object) {
+    switch (reason) {
+    case EndImpact:
+        // fills in the material properties, like handle_impact() does
+        getHtAGL(pos.getElevationM() + 100);
+        _impact_reported = true;
+        handleEndOfLife(elevation_m);
+        break;
+    case EndCollision:
+        report_impact(pos.getElevationM(), object);
+        _collision_reported = true;
+        break;
+    case EndExpiry:
+        handle_expiry();
+        break;
+    }
+}
+
 void FGAIBallistic::handle_impact() {
     // Try terrain intersection
     double start = pos.getElevationM() + 100;
@@ -49,6 +49,14 @@ public:
 
     void Run(double dt);
 
+    enum EndOfFlight { EndImpact, EndCollision, EndExpiry };
+
+    /// Report the end of a flight simulated elsewhere (by
+    /// FGAIBallisticParticles) as if this object had flown it. Call after
+    /// the object was attached to the AI manager.
+    void takeOverEndOfFlight(EndOfFlight reason, double elevation_m,
+                             const FGAIBase* object);
+
     void setAzimuth( double az );
     void setElevation( double el );
     void setAzimuthRandomError(double error);
@@ -0,0 +1,495 @@
+// AIBallisticParticles.cxx - bulk simulation of simple ballistic submodels
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AIBallisticParticles.hxx"
+
+#include <cmath>
+#include <limits>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/math/sg_random.h>
+#include <simgear/props/props.hxx>
+#include <simgear/scene/model/modellib.hxx>
+#include <simgear/scene/util/OsgMath.hxx>
+
+#include <Environment/gravity.hxx>
+#include <Main/globals.hxx>
+#include <Scenery/scenery.hxx>
+
+#include "AIManager.hxx"
+
+using simgear::SGModelLib;
+
+namespace
+{
+
+// the far above ground test looks up terrain per cell of 1/1024 degree
+const double CellsPerDegree = 1024.0;
+// particles closer than this to the cell's terrain elevation get an exact
+// intersection test
+const double GroundMarginM = 150.0;
+// forget cell elevations now and then, scenery tiles come and go
+const double CellCacheLifeSec = 5.0;
+
+// the atmosphere particles fly through, tabulated up to 100000ft
+const int AtmosphereSteps = 1001;
+const double AtmosphereStepFt = 100.0;
+
+template <class T>
+void eraseSwap(std::vector<T>& v, size_t i)
+{
+    v[i] = v.back();
+    v.pop_back();
+}
+
+uint64_t terrainCell(double lat, double lon)
+{
+    uint64_t y = (uint64_t) (floor(lat * CellsPerDegree) + (1 << 20));
+    uint64_t x = (uint64_t) (floor(lon * CellsPerDegree) + (1 << 20));
+    return (y << 32) | x;
+}
+
+/// air density (slugs/ft3) and speed of sound (fps) as
+/// FGAIBase::CalculateMach() computes them
+void standardAtmosphere(double altitude_ft, double& rho, double& a)
+{
+    double T, p;
+    if (altitude_ft < 36152) {
+        T = 59 - 0.00356 * altitude_ft;
+        p = 2116 * pow((T + 459.7) / 518.6, 5.256);
+    } else if (altitude_ft < 82345) {
+        T = -70;
+        p = 473.1 * exp(1.73 - 0.000048 * altitude_ft);
+    } else {
+        T = -205.05 + 0.00164 * altitude_ft;
+        p = 51.97 * pow((T + 459.7) / 389.98, -11.388);
+    }
+
+    rho = p / (1718 * (T + 459.7));
+    a = sqrt(1.4 * 1716 * (T + 459.7));
+}
+
+/**
+ * standardAtmosphere() sampled every AtmosphereStepFt and interpolated, so every
+ * particle can use the air it is flying through each frame without the
+ * pow() and exp() calls.
+ */
+class AtmosphereTable
+{
+public:
+    AtmosphereTable()
+    {
+        for (int i = 0; i < AtmosphereSteps; ++i)
+            standardAtmosphere(i * AtmosphereStepFt, _rho[i], _a[i]);
+    }
+
+    void lookup(double altitude_ft, double& rho, double& a) const
+    {
+        double x = altitude_ft / AtmosphereStepFt;
+        if (!(x >= 0) || (x >= AtmosphereSteps - 1)) {
+            standardAtmosphere(altitude_ft, rho, a);
+            return;
+        }
+
+        int j = (int) x;
+        double f = x - j;
+        rho = _rho[j] + f * (_rho[j + 1] - _rho[j]);
+        a = _a[j] + f * (_a[j + 1] - _a[j]);
+    }
+
+private:
+    double _rho[AtmosphereSteps];
+    double _a[AtmosphereSteps];
+};
+
+const AtmosphereTable& atmosphere()
+{
+    static const AtmosphereTable table;
+    return table;
+}
+
+/// first order filter of a heading, turning the short way
+double filterHeading(double hdg, double target, double c)
+{
+    double diff = target - hdg;
+    if (diff > 180)
+        diff -= 360;
+    else if (diff < -180)
+        diff += 360;
+
+    hdg += diff * c;
+    if (hdg < 0)
+        hdg += 360;
+    else if (hdg >= 360)
+        hdg -= 360;
+    return hdg;
+}
+
+} // of anonymous namespace
+
+FGAIBallisticParticles::FGAIBallisticParticles() :
+    _cellCacheAge(0),
+    _maxCount(4096)
+{
+}
+
+FGAIBallisticParticles::~FGAIBallisticParticles()
+{
+    clear();
+}
+
+bool FGAIBallisticParticles::canSimulate(const submodel* sm)
+{
+    // anything attached to other objects or properties, or which has to
+    // exist as long as the scripts watching it, stays a full FGAIBallistic
+    return sm->particle && !sm->slaved && !sm->ext_force
+        && !sm->force_stabilised && !sm->contents_node && (sm->life >= 0);
+}
+
+unsigned FGAIBallisticParticles::typeIndex(submodel* sm)
+{
+    std::map<submodel*, unsigned>::iterator it = _typeIndex.find(sm);
+    if (it != _typeIndex.end())
+        return it->second;
+
+    if (!_root.valid()) {
+        _root = new osg::Group;
+        _root->setName("ballistic particles");
+        globals->get_scenery()->get_models_branch()->addChild(_root.get());
+    }
+
+    Type type;
+    type.sm = sm;
+    type.cdRandomness = 0;
+    type.group = new osg::Group;
+    type.group->setName(sm->name);
+    _root->addChild(type.group.get());
+
+    std::string path = SGModelLib::findDataFile(sm->model);
+    if (path.empty()) {
+        SG_LOG(SG_AI, SG_WARN, "Submodels: could not find model " << sm->model
+               << " of " << sm->name);
+    } else {
+        // animations of the shared model see one property tree for all
+        type.model = SGModelLib::loadDeferredModel(path, new SGPropertyNode);
+    }
+
+    unsigned index = _types.size();
+    _types.push_back(type);
+    _typeIndex[sm] = index;
+    return index;
+}
+
+osg::PositionAttitudeTransform* FGAIBallisticParticles::takeTransform(Type& type)
+{
+    if (!type.model.valid())
+        return 0;
+
+    osg::PositionAttitudeTransform* transform;
+    if (type.freeTransforms.empty()) {
+        transform = new osg::PositionAttitudeTransform;
+        transform->addChild(type.model.get());
+        type.group->addChild(transform);
+    } else {
+        transform = type.freeTransforms.back();
+        type.freeTransforms.pop_back();
+    }
+    transform->setNodeMask(~0u);
+    return transform;
+}
+
+bool FGAIBallisticParticles::add(submodel* sm, const SGGeod& pos,
+                                 double azimuth, double elevation, double roll,
+                                 double speed_fps, double mass_slugs)
+{
+    if (size() >= _maxCount || mass_slugs <= 0)
+        return false;
+
+    unsigned type = typeIndex(sm);
+    if (type > std::numeric_limits<uint16_t>::max())
+        return false;
+
+    // the random errors as FGAIBallistic::setAzimuth() and friends apply them
+    double life = sm->life;
+    if (sm->random) {
+        double azError = sm->azimuth_error->get_value();
+        double elError = sm->elevation_error->get_value();
+        double lifeRandomness = sm->life_randomness->get_value();
+        azimuth += -azError + 2 * azError * sg_random();
+        elevation += -elError + 2 * elError * sg_random();
+        life = life * lifeRandomness + life * (1 - lifeRandomness) * sg_random();
+    }
+
+    double hs = cos(elevation * SG_DEGREES_TO_RADIANS) * speed_fps;
+    _lat.push_back(pos.getLatitudeDeg());
+    _lon.push_back(pos.getLongitudeDeg());
+    _alt.push_back(pos.getElevationFt());
+    _vNorth.push_back(cos(azimuth * SG_DEGREES_TO_RADIANS) * hs);
+    _vEast.push_back(sin(azimuth * SG_DEGREES_TO_RADIANS) * hs);
+    _vUp.push_back(sin(elevation * SG_DEGREES_TO_RADIANS) * speed_fps);
+    _hdg.push_back(azimuth);
+    _pitch.push_back(elevation);
+    _roll.push_back(roll);
+    _age.push_back(0);
+    _life.push_back(life);
+    _cd.push_back(sm->cd);
+    _initCd.push_back(sm->cd);
+    _dragK.push_back(0.5 * sm->drag_area / mass_slugs);
+    _type.push_back(type);
+    _visual.push_back(takeTransform(_types[type]));
+    return true;
+}
+
+void FGAIBallisticParticles::remove(size_t i)
+{
+    if (_visual[i]) {
+        _visual[i]->setNodeMask(0);
+        _types[_type[i]].freeTransforms.push_back(_visual[i]);
+    }
+
+    eraseSwap(_lat, i);
+    eraseSwap(_lon, i);
+    eraseSwap(_alt, i);
+    eraseSwap(_vNorth, i);
+    eraseSwap(_vEast, i);
+    eraseSwap(_vUp, i);
+    eraseSwap(_hdg, i);
+    eraseSwap(_pitch, i);
+    eraseSwap(_roll, i);
+    eraseSwap(_age, i);
+    eraseSwap(_life, i);
+    eraseSwap(_cd, i);
+    eraseSwap(_initCd, i);
+    eraseSwap(_dragK, i);
+    eraseSwap(_type, i);
+    eraseSwap(_visual, i);
+}
+
+void FGAIBallisticParticles::clear()
+{
+    while (!_lat.empty())
+        remove(_lat.size() - 1);
+
+    if (_root.valid()) {
+        while (_root->getNumParents())
+            _root->getParent(0)->removeChild(_root.get());
+    }
+
+    _root = 0;
+    _types.clear();
+    _typeIndex.clear();
+    _cellElevation.clear();
+    _ended.clear();
+}
+
+bool FGAIBallisticParticles::groundElevation(double lat, double lon, double alt_m,
+                                             double& elev_m)
+{
+    FGScenery* scenery = globals->get_scenery();
+
+    uint64_t cell = terrainCell(lat, lon);
+    std::unordered_map<uint64_t, float>::iterator it = _cellElevation.find(cell);
+    if (it == _cellElevation.end()) {
+        double centerLat = (floor(lat * CellsPerDegree) + 0.5) / CellsPerDegree;
+        double centerLon = (floor(lon * CellsPerDegree) + 0.5) / CellsPerDegree;
+        double e;
+        float cellElev = std::numeric_limits<float>::quiet_NaN();
+        if (scenery->get_elevation_m(SGGeod::fromDegM(centerLon, centerLat, 10000),
+                                     e, 0, _root.get()))
+            cellElev = e;
+        it = _cellElevation.insert(std::make_pair(cell, cellElev)).first;
+    }
+
+    // no scenery yet, or far above it
+    if (std::isnan(it->second) || (alt_m - it->second > GroundMarginM))
+        return false;
+
+    return scenery->get_elevation_m(SGGeod::fromDegM(lon, lat, alt_m + 100),
+                                    elev_m, 0, _root.get());
+}
+
+void FGAIBallisticParticles::endParticle(size_t i, FGAIBallistic::EndOfFlight reason,
+                                         double ground_elev_m, FGAIBase* object)
+{
+    const submodel* sm = _types[_type[i]].sm;
+    bool report = (reason == FGAIBallistic::EndImpact && sm->impact)
+        || (reason == FGAIBallistic::EndCollision && sm->collision)
+        || (reason == FGAIBallistic::EndExpiry && sm->expiry);
+
+    if (report) {
+        double hs = sqrt(_vNorth[i] * _vNorth[i] + _vEast[i] * _vEast[i]);
+        double azimuth = atan2(_vEast[i], _vNorth[i]) * SG_RADIANS_TO_DEGREES;
+        if (azimuth < 0)
+            azimuth += 360;
+
+        Ended e;
+        e.sm = _types[_type[i]].sm;
+        e.reason = reason;
+        e.pos = SGGeod::fromDegFt(_lon[i], _lat[i], _alt[i]);
+        if (reason == FGAIBallistic::EndImpact)
+            e.pos.setElevationM(ground_elev_m);
+        e.speed_kt = sqrt(hs * hs + _vUp[i] * _vUp[i]) / SG_KT_TO_FPS;
+        e.azimuth = azimuth;
+        e.elevation = atan2(_vUp[i], hs) * SG_RADIANS_TO_DEGREES;
+        e.hdg = _hdg[i];
+        e.pitch = _pitch[i];
+        e.roll = _roll[i];
+        // FGAIBallistic restarts the life timer on expiry
+        e.life = (reason == FGAIBallistic::EndExpiry) ? _life[i] : _life[i] - _age[i];
+        e.ground_elev_m = ground_elev_m;
+        e.object = object;
+        _ended.push_back(e);
+    }
+
+    remove(i);
+}
+
+const FGAIBallisticParticles::EndedList&
+FGAIBallisticParticles::update(double dt, FGAIManager* manager)
+{
+    _ended.clear();
+    if (_lat.empty() || dt <= 0)
+        return _ended;
+
+    _cellCacheAge += dt;
+    if (_cellCacheAge > CellCacheLifeSec) {
+        _cellCacheAge = 0;
+        _cellElevation.clear();
+    }
+
+    for (Type& type : _types) {
+        type.cdRandomness = type.sm->random ? type.sm->cd_randomness->get_value() : 0;
+    }
+
+    // gravity hardly changes over the area the particles cover
+    SGGeod first = SGGeod::fromDegFt(_lon[0], _lat[0], _alt[0]);
+    const double gravity = SG_METER_TO_FEET
+        * Environment::Gravity::instance()->getGravity(first);
+    const double windFromNorth = manager->get_wind_from_north();
+    const double windFromEast = manager->get_wind_from_east();
+    const double filter = dt / (0.9 + dt);
+
+    size_t i = 0;
+    while (i < _lat.size()) {
+        const Type& type = _types[_type[i]];
+        const submodel* sm = type.sm;
+
+        _age[i] += dt;
+        if (_age[i] > _life[i]) {
+            endParticle(i, FGAIBallistic::EndExpiry, _alt[i] * SG_FEET_TO_METER, 0);
+            continue;
+        }
+
+        if (sm->random) {
+            float cdMin = _cd[i] * 0.9f;
+            float cdMax = _cd[i] * 1.1f;
+            _cd[i] = _initCd[i] * (1 - type.cdRandomness + 2 * type.cdRandomness * sg_random());
+            _cd[i] = SGMiscf::clip(_cd[i], cdMin, cdMax);
+        }
+
+        // drag, with Cd adjusted by Mach number, as in FGAIBallistic::Run(),
+        // for the density and speed of sound at the particle's altitude
+        double vn = _vNorth[i], ve = _vEast[i], vu = _vUp[i];
+        double speedKt = sqrt(vn * vn + ve * ve + vu * vu) / SG_KT_TO_FPS;
+        if (speedKt > 0) {
+            double rho, a;
+            atmosphere().lookup(_alt[i], rho, a);
+            double mach = speedKt / a;
+            double cdm;
+            if (mach < 0.7)
+                cdm = 0.0125 * mach + _cd[i];
+            else if (mach < 1.2)
+                cdm = 0.3742 * mach * mach - 0.252 * mach + 0.0021 + _cd[i];
+            else
+                cdm = 0.2965 * pow(mach, -1.1506) + _cd[i];
+
+            double newSpeedKt = speedKt - cdm * rho * _dragK[i] * speedKt * speedKt * dt;
+            double scale = (newSpeedKt > 0) ? newSpeedKt / speedKt : 0;
+            vn *= scale;
+            ve *= scale;
+            vu *= scale;
+        }
+
+        // the horizontal step uses the speed before gravity acts, like Run()
+        double latRad = _lat[i] * SG_DEGREES_TO_RADIANS;
+        double ftPerDegLat = 366468.96 - 3717.12 * cos(latRad);
+        double ftPerDegLon = 365228.16 * cos(latRad);
+        double windN = sm->wind ? windFromNorth : 0;
+        double windE = sm->wind ? windFromEast : 0;
+
+        vu -= (gravity - sm->buoyancy) * dt;
+
+        _lat[i] += (vn - windN) / ftPerDegLat * dt;
+        _lon[i] += (ve - windE) / ftPerDegLon * dt;
+        _alt[i] += vu * dt;
+        _vNorth[i] = vn;
+        _vEast[i] = ve;
+        _vUp[i] = vu;
+
+        if (sm->aero_stabilised) {
+            double hs = sqrt(vn * vn + ve * ve);
+            double azimuth = atan2(ve, vn) * SG_RADIANS_TO_DEGREES;
+            if (azimuth < 0)
+                azimuth += 360;
+            double elevation = atan2(vu, hs) * SG_RADIANS_TO_DEGREES;
+
+            _pitch[i] = elevation * filter + _pitch[i] * (1 - filter);
+            _hdg[i] = filterHeading(_hdg[i], azimuth, filter);
+        }
+
+        if (_alt[i] < -1000.0) {
+            remove(i);
+            continue;
+        }
+
+        double altM = _alt[i] * SG_FEET_TO_METER;
+        double groundM;
+        if (groundElevation(_lat[i], _lon[i], altM, groundM) && (altM <= groundM)) {
+            // without impact reporting a particle below ground just goes away
+            endParticle(i, FGAIBallistic::EndImpact, groundM, 0);
+            continue;
+        }
+
+        if (sm->collision) {
+            SGVec3d cartPos = SGVec3d::fromGeod(SGGeod::fromDegM(_lon[i], _lat[i], altM));
+            FGAIBase* object = manager->calcCollision(cartPos, _alt[i], sm->fuse_range);
+            if (object) {
+                endParticle(i, FGAIBallistic::EndCollision, altM, object);
+                continue;
+            }
+        }
+
+        if (_visual[i]) {
+            SGGeod pos = SGGeod::fromDegFt(_lon[i], _lat[i], _alt[i]);
+            SGQuatd orient = SGQuatd::fromLonLat(pos);
+            orient *= SGQuatd::fromYawPitchRollDeg(_hdg[i], _pitch[i],
+                                                   sm->no_roll ? 0.0 : _roll[i]);
+            // the scenegraph model is rotated 180 degrees about the y axis,
+            // like SGModelPlacement does
+            orient *= SGQuatd::fromRealImag(0, SGVec3d(0, 1, 0));
+            _visual[i]->setPosition(toOsg(SGVec3d::fromGeod(pos)));
+            _visual[i]->setAttitude(toOsg(orient));
+        }
+
+        ++i;
+    }
+
+    return _ended;
+}
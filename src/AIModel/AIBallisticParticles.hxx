@@ -0,0 +1,139 @@
+// AIBallisticParticles.hxx - bulk simulation of simple ballistic submodels
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AIBALLISTICPARTICLES_HXX
+#define _FG_AIBALLISTICPARTICLES_HXX
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include <osg/ref_ptr>
+#include <osg/Group>
+#include <osg/PositionAttitudeTransform>
+
+#include <simgear/math/SGMath.hxx>
+
+#include "AIBallistic.hxx"
+#include "submodel.hxx"
+
+/**
+ * Flies released submodels as particles instead of full FGAIBallistic
+ * objects: no property subtree, no paged model of their own, state kept
+ * in parallel arrays and stepped in one loop per frame.
+ *
+ * Only submodels whose flight the particle step models exactly qualify,
+ * see canSimulate(). The physics are those of FGAIBallistic::Run().
+ * Particles whose end must be reported (impact, collision or expiry
+ * enabled) are handed back at that moment, for the submodel manager to
+ * promote them to an FGAIBallistic which reports and, if configured,
+ * releases the sub-submodel.
+ *
+ * All particles of a submodel share one model node, each one only adds a
+ * transform from a pool.
+ */
+class FGAIBallisticParticles
+{
+public:
+    typedef FGSubmodelMgr::submodel submodel;
+
+    /// a particle which has to continue as a full FGAIBallistic
+    struct Ended {
+        submodel* sm;
+        FGAIBallistic::EndOfFlight reason;
+        SGGeod pos;
+        double speed_kt;
+        double azimuth;      ///< of the velocity, degrees
+        double elevation;    ///< of the velocity, degrees
+        double hdg, pitch, roll;
+        double life;         ///< remaining, seconds
+        double ground_elev_m;
+        FGAIBasePtr object;  ///< hit by a collision
+    };
+    typedef std::vector<Ended> EndedList;
+
+    FGAIBallisticParticles();
+    ~FGAIBallisticParticles();
+
+    static bool canSimulate(const submodel* sm);
+
+    /// Start a particle with the initial conditions FGSubmodelMgr::release()
+    /// computed. Returns false if the pool is full.
+    bool add(submodel* sm, const SGGeod& pos, double azimuth, double elevation,
+             double roll, double speed_fps, double mass_slugs);
+
+    /// Step all particles. Returns those which ended and have to report it,
+    /// valid until the next update.
+    const EndedList& update(double dt, FGAIManager* manager);
+
+    /// forget all particles and remove the visuals from the scene
+    void clear();
+
+    size_t size() const { return _lat.size(); }
+
+    void setMaxCount(size_t n) { _maxCount = n; }
+
+private:
+    /// per submodel constants and the visuals its particles share
+    struct Type {
+        submodel* sm;
+        osg::ref_ptr<osg::Group> group;
+        osg::ref_ptr<osg::Node> model;
+        std::vector<osg::PositionAttitudeTransform*> freeTransforms;
+        double cdRandomness;    ///< sampled once per update
+    };
+
+    unsigned typeIndex(submodel* sm);
+    osg::PositionAttitudeTransform* takeTransform(Type& type);
+    void remove(size_t i);
+    bool groundElevation(double lat, double lon, double alt_m, double& elev_m);
+    void endParticle(size_t i, FGAIBallistic::EndOfFlight reason,
+                     double ground_elev_m, FGAIBase* object);
+
+    // particle state, index i is one particle
+    std::vector<double> _lat;       ///< degrees
+    std::vector<double> _lon;       ///< degrees
+    std::vector<double> _alt;       ///< feet
+    std::vector<double> _vNorth;    ///< fps
+    std::vector<double> _vEast;     ///< fps
+    std::vector<double> _vUp;       ///< fps
+    std::vector<float> _hdg;
+    std::vector<float> _pitch;
+    std::vector<float> _roll;
+    std::vector<float> _age;        ///< seconds
+    std::vector<float> _life;       ///< seconds
+    std::vector<float> _cd;
+    std::vector<float> _initCd;
+    std::vector<float> _dragK;      ///< 0.5 * eda / mass, times rho
+    std::vector<uint16_t> _type;
+    std::vector<osg::PositionAttitudeTransform*> _visual;
+
+    std::vector<Type> _types;
+    std::map<submodel*, unsigned> _typeIndex;
+    osg::ref_ptr<osg::Group> _root;
+
+    /// terrain elevation below cells of about 110m, shared by all particles
+    /// for the cheap "far above ground" test
+    std::unordered_map<uint64_t, float> _cellElevation;
+    double _cellCacheAge;
+
+    EndedList _ended;
+
+    size_t _maxCount;
+};
+
+#endif // _FG_AIBALLISTICPARTICLES_HXX
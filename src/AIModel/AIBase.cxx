@@ -28,7 +28,6 @@
 
 #include <simgear/compiler.h>
 
-#include <boost/foreach.hpp>
 #include <string>
 
 #include <osg/ref_ptr>
@@ -43,6 +42,7 @@
 
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/snapshot.hxx>
 #include <Scenery/scenery.hxx>
 #include <Scripting/NasalSys.hxx>
 #include <Scripting/NasalModelData.hxx>
@@ -212,6 +212,11 @@ FGAIBase::~FGAIBase() {
 void
 FGAIBase::removeModel()
 {
+    if (_modelTemplate) {
+        _modelTemplate->removeInstance();
+        _modelTemplate = 0;
+    }
+
     if (!_model.valid())
         return;
 
@@ -303,7 +308,9 @@ void FGAIBase::update(double dt) {
                 name <<  "aifx:";
                 name << _refID;
                 _fx = new FGFX(name.str(), props);
-                _fx->init();
+                std::string dir;
+                SGPropertyNode* fx = _modelTemplate->getSoundConfig(fxpath, dir);
+                _fx->init(fx, dir);
             }
         }
     }
@@ -386,22 +393,14 @@ bool FGAIBase::init(bool search_in_AI_path)
         return false;
     }
 
-    string f;
-    if(search_in_AI_path)
-    {
-        BOOST_FOREACH(SGPath p, globals->get_data_paths("AI")) {
-            p.append(model_path);
-            if (p.exists()) {
-                f = p.local8BitStr();
-                break;
-            }
-        } // of AI data paths iteration
-    } // of search in AI path
+    // objects of the same model share the lookup of its files
+    if (manager)
+        _modelTemplate = manager->getModelCache().get(model_path, search_in_AI_path);
+    else
+        _modelTemplate = FGAIModelCache::resolve(model_path, search_in_AI_path);
+    _modelTemplate->addInstance();
 
-    if (f.empty()) {
-        f = simgear::SGModelLib::findDataFile(model_path);
-    }
-    
+    string f = _modelTemplate->getFile();
     if(f.empty())
         f = fgGetString("/sim/multiplay/default-model", default_model);
     else
@@ -956,3 +955,117 @@ void FGAIBase::setGeodPos(const SGGeod& geod)
     pos = geod;
 }
 
+void FGAIBase::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+    w.put<int32_t>(_otype);
+    w.putString(_callsign);
+    w.put<double>(pos.getLongitudeDeg());
+    w.put<double>(pos.getLatitudeDeg());
+    w.put<double>(pos.getElevationM());
+    w.put<double>(hdg);
+    w.put<double>(roll);
+    w.put<double>(pitch);
+    w.put<double>(speed);
+    w.put<double>(altitude_ft);
+    w.put<double>(vs);
+    w.put<double>(tgt_heading);
+    w.put<double>(tgt_altitude_ft);
+    w.put<double>(tgt_speed);
+    w.put<double>(tgt_roll);
+    w.put<double>(tgt_pitch);
+    w.put<double>(tgt_yaw);
+    w.put<double>(tgt_vs);
+
+    w.put<uint8_t>(fp ? 1 : 0);
+    if (fp) {
+        FGAIWaypoint* curr = fp->getCurrentWaypoint();
+        w.put<int32_t>(fp->getLeg());
+        w.put<int32_t>(fp->getCurrentWaypointIndex());
+        w.putString(curr ? curr->getName() : std::string());
+        w.put<double>(curr ? curr->getLatitude() : 0.0);
+        w.put<double>(curr ? curr->getLongitude() : 0.0);
+        w.put<double>(fp->getLeadDistance());
+    }
+}
+
+bool FGAIBase::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+    if ((r.get<int32_t>() != _otype) || (r.getString() != _callsign)) {
+        return false;
+    }
+
+    double lon = r.get<double>();
+    double lat = r.get<double>();
+    double elev = r.get<double>();
+    double newHdg = r.get<double>();
+    double newRoll = r.get<double>();
+    double newPitch = r.get<double>();
+    double newSpeed = r.get<double>();
+    double newAltitude = r.get<double>();
+    double newVs = r.get<double>();
+    double targets[7];
+    for (int i = 0; i < 7; ++i) {
+        targets[i] = r.get<double>();
+    }
+
+    bool hasPlan = r.get<uint8_t>() != 0;
+    int leg = 0, index = 0;
+    std::string wptName;
+    double wptLat = 0, wptLon = 0, leadDistance = 0;
+    if (hasPlan) {
+        leg = r.get<int32_t>();
+        index = r.get<int32_t>();
+        wptName = r.getString();
+        wptLat = r.get<double>();
+        wptLon = r.get<double>();
+        leadDistance = r.get<double>();
+    }
+
+    if (r.failed() || (hasPlan != (fp != nullptr))) {
+        return false;
+    }
+
+    // the plan has to hold the waypoint at the same place; plans which
+    // erase waypoints behind them, or moved on to the next leg, do not
+    if (fp) {
+        if ((leg != fp->getLeg()) || (index < 0)
+            || (index > fp->getNrOfWayPoints()))
+        {
+            return false;
+        }
+
+        if (index < fp->getNrOfWayPoints()) {
+            FGAIWaypoint* wpt = fp->getWayPoint(index);
+            if ((wpt->getName() != wptName)
+                || (fabs(wpt->getLatitude() - wptLat) > 1e-7)
+                || (fabs(wpt->getLongitude() - wptLon) > 1e-7))
+            {
+                return false;
+            }
+        } else if (!wptName.empty()) {
+            return false;
+        }
+    }
+
+    pos = SGGeod::fromDegM(lon, lat, elev);
+    hdg = newHdg;
+    roll = newRoll;
+    pitch = newPitch;
+    speed = newSpeed;
+    altitude_ft = newAltitude;
+    vs = newVs;
+    tgt_heading = targets[0];
+    tgt_altitude_ft = targets[1];
+    tgt_speed = targets[2];
+    tgt_roll = targets[3];
+    tgt_pitch = targets[4];
+    tgt_yaw = targets[5];
+    tgt_vs = targets[6];
+
+    if (fp) {
+        fp->setCurrentWaypointIndex(index);
+        fp->setLeadDistance(leadDistance);
+    }
+    return true;
+}
+
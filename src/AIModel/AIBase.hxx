@@ -33,11 +33,17 @@
 
 #include <simgear/math/sg_geodesy.hxx>
 
+#include "AIModelCache.hxx"
+
 namespace osg { class PagedLOD; }
 
 namespace simgear {
 class BVHMaterial;
 }
+namespace flightgear {
+class SnapshotWriter;
+class SnapshotReader;
+}
 class FGAIManager;
 class FGAIFlightPlan;
 class FGFX;
@@ -114,6 +120,13 @@ public:
     
     SGGeod getGeodPos() const;
     void setGeodPos(const SGGeod& pos);
+
+    // Kinematics and the flight plan position for a snapshot, see
+    // Main/snapshot.hxx. Restoring fails if the data belongs to a different
+    // kind of object, or the flight plan no longer has the waypoint it was
+    // heading for, e.g. after traffic erased the waypoints it passed.
+    virtual void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    virtual bool restoreSnapshot(flightgear::SnapshotReader& r);
     
     SGVec3d getCartPosAt(const SGVec3d& off) const;
     SGVec3d getCartPos() const;
@@ -245,6 +258,7 @@ private:
     osg::ref_ptr<osg::PagedLOD> _interior;
 
     osg::ref_ptr<FGAIModelData> _modeldata;
+    FGAIModelCache::TemplateRef _modelTemplate;
 
     SGSharedPtr<FGFX>  _fx;
 
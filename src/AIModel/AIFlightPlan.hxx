@@ -110,6 +110,8 @@ public:
    FGAIWaypoint* const getPreviousWaypoint( void ) const;
    FGAIWaypoint* const getCurrentWaypoint( void ) const;
    FGAIWaypoint* const getNextWaypoint( void ) const;
+   int getCurrentWaypointIndex() const { return wpt_iterator - waypoints.begin(); }
+   void setCurrentWaypointIndex(int index) { wpt_iterator = waypoints.begin() + index; }
    void IncrementWaypoint( bool erase );
    void DecrementWaypoint( bool erase );
 
@@ -30,6 +30,7 @@
 
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/snapshot.hxx>
 #include <Airports/airport.hxx>
 #include <Scripting/NasalSys.hxx>
 
@@ -47,6 +48,18 @@
 #include "AIGroundVehicle.hxx"
 #include "AIEscort.hxx"
 
+namespace
+{
+
+// the longest extent FGAIManager::collisionExtent() gives, a carrier's
+const double MaxCollisionLengthFt = 750;
+
+// how far beyond a query range the proximity grid is searched, for the
+// objects which moved since the last update
+const double GridMarginM = 250;
+
+} // of anonymous namespace
+
 class FGAIManager::Scenario
 {
 public:
@@ -133,6 +146,7 @@ FGAIManager::init() {
     globals->get_commands()->addCommand("load-scenario", this, &FGAIManager::loadScenarioCommand);
     globals->get_commands()->addCommand("unload-scenario", this, &FGAIManager::unloadScenarioCommand);
     _environmentVisiblity = fgGetNode("/environment/visibility-m");
+    _modelCache.bind(root->getNode("model-cache", true));
     
     // Create an (invisible) AIAircraft representation of the current
     // users's aircraft, that mimicks the user aircraft's behavior.
@@ -177,6 +191,7 @@ FGAIManager::reinit()
     unloadAllScenarios();
     
     update(0.0);
+    _modelCache.clearUnused();
     std::for_each(ai_list.begin(), ai_list.end(), std::mem_fn(&FGAIBase::reinit));
     
     // (re-)load scenarios
@@ -196,8 +211,10 @@ FGAIManager::shutdown()
     }
     
     ai_list.clear();
+    _proximityGrid.clear();
     _environmentVisiblity.clear();
     _userAircraft.clear();
+    _modelCache.clearUnused();
     
     globals->get_commands()->removeCommand("load-scenario");
     globals->get_commands()->removeCommand("unload-scenario");
@@ -219,6 +236,7 @@ void FGAIManager::removeDeadItem(FGAIBase* base)
 {
     SGPropertyNode *props = base->_getProps();
     
+    _proximityGrid.remove(base);
     props->setBoolValue("valid", false);
     base->unbind();
     
@@ -268,9 +286,12 @@ FGAIManager::update(double dt)
                    "\n\tError:" << e.getFormattedMessage());
             base->setDie(true);
         }
+
+        _proximityGrid.set(base, base->getCartPos());
     } // of live AI objects iteration
 
     thermal_lift_node->setDoubleValue( strength );  // for thermals
+    _modelCache.updateStats();
 }
 
 /** update LOD settings of all AI/MP models */
@@ -311,6 +332,7 @@ FGAIManager::attach(FGAIBase *model)
         || model->getType()==FGAIBase::otStatic);
     model->bind();
     p->setBoolValue("valid", true);
+    _proximityGrid.set(model, model->getCartPos());
 }
 
 bool FGAIManager::isVisible(const SGGeod& pos) const
@@ -532,59 +554,53 @@ FGAIManager::loadScenarioFile(const std::string& filename)
     return 0;
 }
 
-const FGAIBase *
-FGAIManager::calcCollision(double alt, double lat, double lon, double fuse_range)
+void
+FGAIManager::collisionExtent(int type, double fuse_range,
+                             double& height_ft, double& length_ft)
 {
     // we specify tgt extent (ft) according to the AIObject type
-    double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
-    double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
-    ai_list_iterator ai_list_itr = ai_list.begin();
-    ai_list_iterator end = ai_list.end();
+    static const double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
+    static const double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
+
+    height_ft = tgt_ht[type] + fuse_range;
+    length_ft = tgt_length[type] + fuse_range;
+}
 
+const FGAIBase *
+FGAIManager::calcCollision(double alt, double lat, double lon, double fuse_range)
+{
     SGGeod pos(SGGeod::fromDegFt(lon, lat, alt));
-    SGVec3d cartPos(SGVec3d::fromGeod(pos));
-    
-    while (ai_list_itr != end) {
-        double tgt_alt = (*ai_list_itr)->_getAltitude();
-        int type       = (*ai_list_itr)->getType();
-        tgt_ht[type] += fuse_range;
+    return calcCollision(SGVec3d::fromGeod(pos), alt, fuse_range);
+}
 
-        if (fabs(tgt_alt - alt) > tgt_ht[type] || type == FGAIBase::otBallistic
+FGAIBase *
+FGAIManager::calcCollision(const SGVec3d& cartPos, double alt, double fuse_range)
+{
+    // only objects which could reach the position are tested
+    double reachM = (MaxCollisionLengthFt + fuse_range) * SG_FEET_TO_METER;
+    findObjectsInRange(cartPos, reachM, _nearbyObjects);
+
+    for (FGAIBase* object : _nearbyObjects) {
+        double tgt_alt = object->_getAltitude();
+        int type       = object->getType();
+        double tgt_ht, tgt_length;
+        collisionExtent(type, fuse_range, tgt_ht, tgt_length);
+
+        if (fabs(tgt_alt - alt) > tgt_ht || type == FGAIBase::otBallistic
             || type == FGAIBase::otStorm || type == FGAIBase::otThermal ) {
-                //SG_LOG(SG_AI, SG_DEBUG, "AIManager: skipping "
-                //    << fabs(tgt_alt - alt)
-                //    << " "
-                //    << type
-                //    );
-                ++ai_list_itr;
                 continue;
         }
 
-        int id         = (*ai_list_itr)->getID();
-
-        double range = calcRangeFt(cartPos, (*ai_list_itr));
-
-        //SG_LOG(SG_AI, SG_DEBUG, "AIManager:  AI list size "
-        //    << ai_list.size()
-        //    << " type " << type
-        //    << " ID " << id
-        //    << " range " << range
-        //    //<< " bearing " << bearing
-        //    << " alt " << tgt_alt
-        //    );
-
-        tgt_length[type] += fuse_range;
-
-        if (range < tgt_length[type]){
+        double range = calcRangeFt(cartPos, object);
+        if (range < tgt_length){
             SG_LOG(SG_AI, SG_DEBUG, "AIManager: HIT! "
                 << " type " << type
-                << " ID " << id
+                << " ID " << object->getID()
                 << " range " << range
                 << " alt " << tgt_alt
                 );
-            return (*ai_list_itr).get();
+            return object;
         }
-        ++ai_list_itr;
     }
     return 0;
 }
@@ -596,9 +612,85 @@ FGAIManager::calcRangeFt(const SGVec3d& aCartPos, const FGAIBase* aObject) const
     return distM * SG_METER_TO_FEET;
 }
 
+void FGAIManager::findObjectsInRange(const SGVec3d& cartPos, double rangeM,
+                                     std::vector<FGAIBase*>& result) const
+{
+    _proximityGrid.findInRange(cartPos, rangeM + GridMarginM, result);
+    result.erase(std::remove_if(result.begin(), result.end(),
+                                std::mem_fn(&FGAIBase::getDie)),
+                 result.end());
+}
+
+void FGAIManager::findNearestObjects(const SGVec3d& cartPos, size_t k, double maxRangeM,
+                                     std::vector<FGAIBase*>& result) const
+{
+    // objects which died since the last update take places among the k,
+    // ask for as many more
+    size_t wanted = k;
+    for (;;) {
+        _proximityGrid.findNearest(cartPos, wanted, maxRangeM, result);
+        size_t found = result.size();
+        result.erase(std::remove_if(result.begin(), result.end(),
+                                    std::mem_fn(&FGAIBase::getDie)),
+                     result.end());
+        if ((result.size() >= k) || (found < wanted))
+            break;
+
+        wanted += found - result.size();
+    }
+
+    if (result.size() > k)
+        result.resize(k);
+}
+
 FGAIAircraft* FGAIManager::getUserAircraft() const
 {
     return _userAircraft.get();
 }
 
+void FGAIManager::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+    for (const FGAIBasePtr& base : ai_list) {
+        if (base->getDie() || base->isa(FGAIBase::otMultiplayer) ||
+            (base.get() == _userAircraft.get()))
+        {
+            continue;
+        }
+
+        w.beginSection(base->getID());
+        base->saveSnapshot(w);
+        w.endSection();
+    }
+}
+
+bool FGAIManager::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+    std::map<int, FGAIBase*> objects;
+    for (const FGAIBasePtr& base : ai_list) {
+        objects[base->getID()] = base.ptr();
+    }
+
+    bool ok = true;
+    uint32_t id;
+    flightgear::SnapshotReader section;
+    while (r.nextSection(id, section)) {
+        std::map<int, FGAIBase*>::iterator it = objects.find(id);
+        if ((it == objects.end()) || it->second->getDie()) {
+            continue; // gone since
+        }
+
+        if (!it->second->restoreSnapshot(section)) {
+            SG_LOG(SG_AI, SG_WARN, "snapshot: not restoring AI object "
+                   << id << ", it changed since");
+            ok = false;
+            continue;
+        }
+
+        // it may have moved further than the grid margin covers
+        _proximityGrid.set(it->second, it->second->getCartPos());
+    }
+
+    return ok && !r.failed();
+}
+
 //end AIManager.cxx
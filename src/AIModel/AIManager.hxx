@@ -29,10 +29,18 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/structure/SGSharedPtr.hxx>
 
+#include "AIModelCache.hxx"
+#include "AIProximityGrid.hxx"
+
 class FGAIBase;
 class FGAIThermal;
 class FGAIAircraft;
 
+namespace flightgear {
+class SnapshotWriter;
+class SnapshotReader;
+}
+
 typedef SGSharedPtr<FGAIBase> FGAIBasePtr;
 
 class FGAIManager : public SGSubsystem
@@ -53,6 +61,12 @@ public:
     void attach(FGAIBase *model);
 
     const FGAIBase *calcCollision(double alt, double lat, double lon, double fuse_range);
+    FGAIBase *calcCollision(const SGVec3d& cartPos, double alt, double fuse_range);
+
+    /// height and length (ft) around an object of the given type within
+    /// which a submodel with that fuse range hits it
+    static void collisionExtent(int type, double fuse_range,
+                                double& height_ft, double& length_ft);
 
     inline double get_user_heading() const { return user_heading; }
     inline double get_user_pitch() const { return user_pitch; }
@@ -82,6 +96,22 @@ public:
 
     double calcRangeFt(const SGVec3d& aCartPos, const FGAIBase* aObject) const;
 
+    /**
+     * @brief the live AI objects within rangeM of a position, in no
+     * particular order. Positions are those of the last update, so the
+     * range is widened by how far an object may have moved since: check
+     * the exact range where it matters.
+     */
+    void findObjectsInRange(const SGVec3d& cartPos, double rangeM,
+                            std::vector<FGAIBase*>& result) const;
+
+    /**
+     * @brief the k live AI objects nearest to a position as of the last
+     * update, and within maxRangeM of it, nearest first
+     */
+    void findNearestObjects(const SGVec3d& cartPos, size_t k, double maxRangeM,
+                            std::vector<FGAIBase*>& result) const;
+
     static const char* subsystemName() { return "ai-model"; }
     
     /**
@@ -91,6 +121,16 @@ public:
      * avoid correctly.
      */
     FGAIAircraft* getUserAircraft() const;
+
+    /// the models the AI objects share
+    FGAIModelCache& getModelCache() { return _modelCache; }
+
+    /// Kinematics of the AI objects for a snapshot (Main/snapshot.hxx).
+    /// Multiplayer objects and the user aircraft are left out, since
+    /// others own their state. Restoring applies to the objects which
+    /// still exist.
+    void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    bool restoreSnapshot(flightgear::SnapshotReader& r);
 private:
     // FGSubmodelMgr is a friend for access to the AI_list
     friend class FGSubmodelMgr;
@@ -146,6 +186,12 @@ private:
     ScenarioDict _scenarios;
     
     SGSharedPtr<FGAIAircraft> _userAircraft;
+
+    FGAIModelCache _modelCache;
+
+    /// where the objects were at the end of the last update
+    FGAIProximityGrid _proximityGrid;
+    std::vector<FGAIBase*> _nearbyObjects;
 };
 
 #endif  // _FG_AIMANAGER_HXX
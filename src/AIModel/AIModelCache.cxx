@@ -0,0 +1,157 @@
+// AIModelCache.cxx - what AI objects showing the same model share
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AIModelCache.hxx"
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/props/props_io.hxx>
+#include <simgear/scene/model/modellib.hxx>
+#include <simgear/structure/exception.hxx>
+
+#include <Main/globals.hxx>
+
+FGAIModelCache::Template::Template() :
+    _instances(0),
+    _soundRead(false)
+{
+}
+
+SGPropertyNode*
+FGAIModelCache::Template::getSoundConfig(const std::string& path, std::string& dir)
+{
+    // models name their sound configuration, so it is the same for all
+    // objects of a template, but check anyway
+    if (!_soundRead || (path != _soundPath)) {
+        _soundRead = true;
+        _soundPath = path;
+        _soundRoot.clear();
+
+        SGPath file = globals->resolve_aircraft_path(path);
+        if (file.isNull()) {
+            SG_LOG(SG_SOUND, SG_ALERT, "File not found: '" << path);
+            return NULL;
+        }
+
+        SG_LOG(SG_SOUND, SG_INFO, "Reading AI model sound from " << file);
+        SGPropertyNode_ptr root = new SGPropertyNode;
+        try {
+            readProperties(file, root);
+        } catch (const sg_exception &) {
+            SG_LOG(SG_SOUND, SG_ALERT, "Error reading file '" << file << '\'');
+            return NULL;
+        }
+
+        _soundRoot = root;
+        _soundDir = file.dir();
+    }
+
+    if (!_soundRoot) {
+        return NULL;
+    }
+
+    dir = _soundDir;
+    return _soundRoot->getNode("fx");
+}
+
+FGAIModelCache::FGAIModelCache() :
+    _hits(0),
+    _misses(0)
+{
+}
+
+FGAIModelCache::TemplateRef
+FGAIModelCache::get(const std::string& modelPath, bool searchAIPath)
+{
+    std::string key = (searchAIPath ? "AI:" : "") + modelPath;
+    TemplateDict::iterator it = _templates.find(key);
+    if (it != _templates.end()) {
+        ++_hits;
+        return it->second;
+    }
+
+    ++_misses;
+    TemplateRef t = resolve(modelPath, searchAIPath);
+
+    // models not found are looked up again next time, they may have been
+    // installed since, e.g. for multiplayer pilots
+    if (t->isInstalled()) {
+        _templates[key] = t;
+    }
+    return t;
+}
+
+FGAIModelCache::TemplateRef
+FGAIModelCache::resolve(const std::string& modelPath, bool searchAIPath)
+{
+    TemplateRef t = new Template;
+    if (searchAIPath) {
+        for (SGPath p : globals->get_data_paths("AI")) {
+            p.append(modelPath);
+            if (p.exists()) {
+                t->_file = p.local8BitStr();
+                break;
+            }
+        } // of AI data paths iteration
+    }
+
+    if (t->_file.empty()) {
+        t->_file = simgear::SGModelLib::findDataFile(modelPath);
+    }
+
+    return t;
+}
+
+void FGAIModelCache::clearUnused()
+{
+    TemplateDict::iterator it = _templates.begin();
+    while (it != _templates.end()) {
+        if (it->second->getInstances() == 0) {
+            _templates.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FGAIModelCache::bind(SGPropertyNode* node)
+{
+    _templatesNode = node->getNode("templates", true);
+    _instancesNode = node->getNode("instances", true);
+    _hitsNode = node->getNode("hits", true);
+    _missesNode = node->getNode("misses", true);
+}
+
+void FGAIModelCache::updateStats()
+{
+    if (!_templatesNode) {
+        return;
+    }
+
+    unsigned instances = 0;
+    for (const TemplateDict::value_type& entry : _templates) {
+        instances += entry.second->getInstances();
+    }
+
+    _templatesNode->setIntValue(_templates.size());
+    _instancesNode->setIntValue(instances);
+    _hitsNode->setIntValue(_hits);
+    _missesNode->setIntValue(_misses);
+}
@@ -0,0 +1,101 @@
+// AIModelCache.hxx - what AI objects showing the same model share
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AIMODELCACHE_HXX
+#define _FG_AIMODELCACHE_HXX
+
+#include <map>
+#include <string>
+
+#include <simgear/props/props.hxx>
+#include <simgear/structure/SGReferenced.hxx>
+#include <simgear/structure/SGSharedPtr.hxx>
+
+/**
+ * Templates of the models of AI and multiplayer objects, so a fleet of
+ * identical aircraft looks up its model file and reads its sound
+ * configuration once, instead of once per aircraft. Liveries of AI
+ * traffic are model files of their own, so the model path covers them.
+ *
+ * The scene graph of each object still comes from SGModelLib, since its
+ * animations are bound to the properties of that object. The geometry
+ * and textures below it are shared through the osgDB object cache.
+ */
+class FGAIModelCache
+{
+public:
+    class Template : public SGReferenced
+    {
+    public:
+        /// the model file to load, empty if none was found
+        const std::string& getFile() const { return _file; }
+        bool isInstalled() const { return !_file.empty(); }
+
+        /// The <fx> entries of a sound configuration, read on first use.
+        /// NULL if it cannot be read. 'dir' is set to the directory the
+        /// samples are relative to.
+        SGPropertyNode* getSoundConfig(const std::string& path, std::string& dir);
+
+        /// objects showing the model
+        unsigned getInstances() const { return _instances; }
+        void addInstance() { ++_instances; }
+        void removeInstance() { --_instances; }
+
+    private:
+        friend class FGAIModelCache;
+        Template();
+
+        std::string _file;
+        unsigned _instances;
+
+        bool _soundRead;
+        std::string _soundPath;
+        std::string _soundDir;
+        SGPropertyNode_ptr _soundRoot;
+    };
+
+    typedef SGSharedPtr<Template> TemplateRef;
+
+    FGAIModelCache();
+
+    /// The template of a model, made on first use. Models which are not
+    /// found are not kept, so they are found once installed.
+    TemplateRef get(const std::string& modelPath, bool searchAIPath);
+
+    /// a template of its own, for an object without a manager
+    static TemplateRef resolve(const std::string& modelPath, bool searchAIPath);
+
+    /// forget the templates no object uses
+    void clearUnused();
+
+    /// statistics go below this node
+    void bind(SGPropertyNode* node);
+    void updateStats();
+
+private:
+    typedef std::map<std::string, TemplateRef> TemplateDict;
+    TemplateDict _templates;
+
+    unsigned _hits;
+    unsigned _misses;
+
+    SGPropertyNode_ptr _templatesNode;
+    SGPropertyNode_ptr _instancesNode;
+    SGPropertyNode_ptr _hitsNode;
+    SGPropertyNode_ptr _missesNode;
+};
+
+#endif  // _FG_AIMODELCACHE_HXX
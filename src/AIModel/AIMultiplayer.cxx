@@ -131,8 +131,8 @@ void FGAIMultiplayer::update(double dt)
   double curtime = globals->get_sim_time_sec();
 
   // Get the last available time
-  MotionInfo::reverse_iterator it = mMotionInfo.rbegin();
-  double curentPkgTime = it->second.time;
+  const FGMultiplayerMotionSample& newest = mMotionInfo.newest();
+  double curentPkgTime = newest.time;
 
   // Dynamically optimize the time offset between the feeder and the client
   // Well, 'dynamically' means that the dynamic of that update must be very
@@ -143,7 +143,7 @@ void FGAIMultiplayer::update(double dt)
   // component will provide this. We just take the error of the currently
   // requested time to the most recent available packet. This is the
   // target we want to reach in average.
-  double lag = it->second.lag;
+  double lag = newest.lag;
   if (!mTimeOffsetSet) {
     mTimeOffsetSet = true;
     mTimeOffset = curentPkgTime - curtime - lag;
@@ -206,7 +206,7 @@ void FGAIMultiplayer::update(double dt)
       SG_LOG(SG_AI, SG_DEBUG, "Offset adjust system: time offset = "
              << mTimeOffset << ", expected longitudinal position error due to "
              " current adjustment of the offset: "
-             << fabs(norm(it->second.linearVel)*systemIncrement));
+             << fabs(norm(newest.linearVel)*systemIncrement));
     }
   }
 
@@ -224,177 +224,61 @@ void FGAIMultiplayer::update(double dt)
     // that is good ...
 
     // Find the first packet before the target time
-    MotionInfo::iterator nextIt = mMotionInfo.upper_bound(tInterp);
-    if (nextIt == mMotionInfo.begin()) {
+    size_t nextIdx = mMotionInfo.upperBound(tInterp);
+    if (nextIdx == 0) {
       SG_LOG(SG_AI, SG_DEBUG, "Taking oldest packet!");
       // We have no packet before the target time, just use the first one
-      MotionInfo::iterator firstIt = mMotionInfo.begin();
-      ecPos = firstIt->second.position;
-      ecOrient = firstIt->second.orientation;
-      ecLinearVel = firstIt->second.linearVel;
+      const FGMultiplayerMotionSample& first = mMotionInfo[0];
+      ecPos = first.position;
+      ecOrient = first.orientation;
+      ecLinearVel = first.linearVel;
       speed = norm(ecLinearVel) * SG_METER_TO_NM * 3600.0;
+      applyProperties(first);
 
-      std::vector<FGPropertyData*>::const_iterator firstPropIt;
-      std::vector<FGPropertyData*>::const_iterator firstPropItEnd;
-      firstPropIt = firstIt->second.properties.begin();
-      firstPropItEnd = firstIt->second.properties.end();
-      while (firstPropIt != firstPropItEnd) {
-        //cout << " Setting property..." << (*firstPropIt)->id;
-        PropertyMap::iterator pIt = mPropertyMap.find((*firstPropIt)->id);
-        if (pIt != mPropertyMap.end())
-        {
-          //cout << "Found " << pIt->second->getPath() << ":";
-          switch ((*firstPropIt)->type) {
-            case props::INT:
-            case props::BOOL:
-            case props::LONG:
-              pIt->second->setIntValue((*firstPropIt)->int_value);
-              //cout << "Int: " << (*firstPropIt)->int_value << "\n";
-              break;
-            case props::FLOAT:
-            case props::DOUBLE:
-              pIt->second->setFloatValue((*firstPropIt)->float_value);
-              //cout << "Flo: " << (*firstPropIt)->float_value << "\n";
-              break;
-            case props::STRING:
-            case props::UNSPECIFIED:
-              pIt->second->setStringValue((*firstPropIt)->string_value);
-              //cout << "Str: " << (*firstPropIt)->string_value << "\n";    
-              break;
-            default:
-              // FIXME - currently defaults to float values
-              pIt->second->setFloatValue((*firstPropIt)->float_value);
-              //cout << "Unknown: " << (*firstPropIt)->float_value << "\n";
-              break;
-          }            
-        }
-        else
-        {
-          SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*firstPropIt)->id << "\n");
-        }
-        ++firstPropIt;
-      }
+    } else if (nextIdx == mMotionInfo.size()) {
+      // The target time is exactly the one of the newest packet
+      ecPos = newest.position;
+      ecOrient = newest.orientation;
+      ecLinearVel = newest.linearVel;
+      speed = norm(ecLinearVel) * SG_METER_TO_NM * 3600.0;
+      applyProperties(newest);
 
     } else {
       // Ok, we have really found something where our target time is in between
       // do interpolation here
-      MotionInfo::iterator prevIt = nextIt;
-      --prevIt;
-
-      /*
-      * RJH: 2017-02-16 another exception thrown here when running under debug (and hence huge frame delays)
-      * the value of nextIt was already end(); which I think means that we cannot run the entire next section of code.
-      */
-      if (nextIt != prevIt && nextIt != mMotionInfo.end()) {
-          // Interpolation coefficient is between 0 and 1
-          double intervalStart = prevIt->second.time;
-          double intervalEnd = nextIt->second.time;
-
-          double intervalLen = intervalEnd - intervalStart;
-          double tau = 0.0;
-          if (intervalLen != 0.0) tau = (tInterp - intervalStart) / intervalLen;
-
-          SG_LOG(SG_AI, SG_DEBUG, "Multiplayer vehicle interpolation: ["
-              << intervalStart << ", " << intervalEnd << "], intervalLen = "
-              << intervalLen << ", interpolation parameter = " << tau);
-
-          // Here we do just linear interpolation on the position
-          ecPos = interpolate(tau, prevIt->second.position, nextIt->second.position);
-          ecOrient = interpolate((float)tau, prevIt->second.orientation,
-              nextIt->second.orientation);
-          ecLinearVel = interpolate((float)tau, prevIt->second.linearVel, nextIt->second.linearVel);
-          speed = norm(ecLinearVel) * SG_METER_TO_NM * 3600.0;
-
-          if (prevIt->second.properties.size()
-              == nextIt->second.properties.size()) {
-              std::vector<FGPropertyData*>::const_iterator prevPropIt;
-              std::vector<FGPropertyData*>::const_iterator prevPropItEnd;
-              std::vector<FGPropertyData*>::const_iterator nextPropIt;
-              std::vector<FGPropertyData*>::const_iterator nextPropItEnd;
-              prevPropIt = prevIt->second.properties.begin();
-              prevPropItEnd = prevIt->second.properties.end();
-              nextPropIt = nextIt->second.properties.begin();
-              nextPropItEnd = nextIt->second.properties.end();
-              while (prevPropIt != prevPropItEnd) {
-                  PropertyMap::iterator pIt = mPropertyMap.find((*prevPropIt)->id);
-                  //cout << " Setting property..." << (*prevPropIt)->id;
-
-                  if (pIt != mPropertyMap.end())
-                  {
-                      //cout << "Found " << pIt->second->getPath() << ":";
-
-                      int ival;
-                      float val;
-                      /*
-                       * RJH - 2017-01-25
-                       * During multiplayer operations a series of crashes were encountered that affected all players
-                       * within range of each other and resulting in an exception being thrown at exactly the same moment in time
-                       * (within case props::STRING: ref http://i.imgur.com/y6MBoXq.png)
-                       * Investigation showed that the nextPropIt and prevPropIt were pointing to different properties
-                       * which may be caused due to certain models that have overloaded mp property transmission and
-                       * these craft have their properties truncated due to packet size. However the result of this
-                       * will be different contents in the previous and current packets, so here we protect against
-                       * this by only considering properties where the previous and next id are the same.
-                       * It might be a better solution to search the previous and next lists to locate the matching id's
-                       */
-                      if (*nextPropIt && (*nextPropIt)->id == (*prevPropIt)->id) {
-                          switch ((*prevPropIt)->type) {
-                          case props::INT:
-                          case props::BOOL:
-                          case props::LONG:
-                              ival = (int)(0.5 + (1 - tau)*((double)(*prevPropIt)->int_value) +
-                                  tau*((double)(*nextPropIt)->int_value));
-                              pIt->second->setIntValue(ival);
-                              //cout << "Int: " << ival << "\n";
-                              break;
-                          case props::FLOAT:
-                          case props::DOUBLE:
-                              val = (1 - tau)*(*prevPropIt)->float_value +
-                                  tau*(*nextPropIt)->float_value;
-                              //cout << "Flo: " << val << "\n";
-                              pIt->second->setFloatValue(val);
-                              break;
-                          case props::STRING:
-                          case props::UNSPECIFIED:
-                              //cout << "Str: " << (*nextPropIt)->string_value << "\n";
-                              pIt->second->setStringValue((*nextPropIt)->string_value);
-                              break;
-                          default:
-                              // FIXME - currently defaults to float values
-                              val = (1 - tau)*(*prevPropIt)->float_value +
-                                  tau*(*nextPropIt)->float_value;
-                              //cout << "Unk: " << val << "\n";
-                              pIt->second->setFloatValue(val);
-                              break;
-                          }
-                      }
-                      else
-                      {
-                          SG_LOG(SG_AI, SG_WARN, "MP packet mismatch during lag interpolation: " << (*prevPropIt)->id << " != " << (*nextPropIt)->id << "\n");
-                      }
-                  }
-                  else
-                  {
-                      SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*prevPropIt)->id << "\n");
-                  }
-
-                  ++prevPropIt;
-                  ++nextPropIt;
-              }
-          }
-
-          // Now throw away too old data
-          if (prevIt != mMotionInfo.begin())
-          {
-              --prevIt;
-              mMotionInfo.erase(mMotionInfo.begin(), prevIt);
-          }
-      }
+      size_t prevIdx = nextIdx - 1;
+      const FGMultiplayerMotionSample& prev = mMotionInfo[prevIdx];
+      const FGMultiplayerMotionSample& next = mMotionInfo[nextIdx];
+
+      // Interpolation coefficient is between 0 and 1
+      double intervalStart = prev.time;
+      double intervalEnd = next.time;
+
+      double intervalLen = intervalEnd - intervalStart;
+      double tau = 0.0;
+      if (intervalLen != 0.0) tau = (tInterp - intervalStart) / intervalLen;
+
+      SG_LOG(SG_AI, SG_DEBUG, "Multiplayer vehicle interpolation: ["
+          << intervalStart << ", " << intervalEnd << "], intervalLen = "
+          << intervalLen << ", interpolation parameter = " << tau);
+
+      // Here we do just linear interpolation on the position
+      ecPos = interpolate(tau, prev.position, next.position);
+      ecOrient = interpolate((float)tau, prev.orientation, next.orientation);
+      ecLinearVel = interpolate((float)tau, prev.linearVel, next.linearVel);
+      speed = norm(ecLinearVel) * SG_METER_TO_NM * 3600.0;
+
+      if (prev.properties.size() == next.properties.size())
+        applyProperties(prev, next, tau);
+
+      // Now throw away too old data, keeping one packet before prev
+      if (prevIdx > 0)
+        mMotionInfo.dropOldest(prevIdx - 1);
     }
   } else {
     // Ok, we need to predict the future, so, take the best data we can have
     // and do some eom computation to guess that for now.
-    FGExternalMotionData& motionInfo = it->second;
+    const FGMultiplayerMotionSample& motionInfo = newest;
 
     // The time to predict, limit to 3 seconds
     double t = tInterp - motionInfo.time;
@@ -427,48 +311,8 @@ void FGAIMultiplayer::update(double dt)
 		ecPos += t*(ecVel);
 	}
 
-	std::vector<FGPropertyData*>::const_iterator firstPropIt;
-    std::vector<FGPropertyData*>::const_iterator firstPropItEnd;
     speed = norm(ecLinearVel) * SG_METER_TO_NM * 3600.0;
-    firstPropIt = it->second.properties.begin();
-    firstPropItEnd = it->second.properties.end();
-    while (firstPropIt != firstPropItEnd) {
-      PropertyMap::iterator pIt = mPropertyMap.find((*firstPropIt)->id);
-      //cout << " Setting property..." << (*firstPropIt)->id;
-      
-      if (pIt != mPropertyMap.end())
-      {
-        switch ((*firstPropIt)->type) {
-          case props::INT:
-          case props::BOOL:
-          case props::LONG:
-            pIt->second->setIntValue((*firstPropIt)->int_value);
-            //cout << "Int: " << (*firstPropIt)->int_value << "\n";
-            break;
-          case props::FLOAT:
-          case props::DOUBLE:
-            pIt->second->setFloatValue((*firstPropIt)->float_value);
-            //cout << "Flo: " << (*firstPropIt)->float_value << "\n";
-            break;
-          case props::STRING:
-          case props::UNSPECIFIED:
-            pIt->second->setStringValue((*firstPropIt)->string_value);
-            //cout << "Str: " << (*firstPropIt)->string_value << "\n";
-            break;
-          default:
-            // FIXME - currently defaults to float values
-            pIt->second->setFloatValue((*firstPropIt)->float_value);
-            //cout << "Unk: " << (*firstPropIt)->float_value << "\n";
-            break;
-        }            
-      }
-      else
-      {
-        SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << (*firstPropIt)->id << "\n");
-      }
-      
-      ++firstPropIt;
-    }
+    applyProperties(motionInfo);
   }
   
   // extract the position
@@ -540,26 +384,90 @@ void FGAIMultiplayer::update(double dt)
 }
 
 void
-FGAIMultiplayer::addMotionInfo(FGExternalMotionData& motionInfo,
-                               long stamp)
+FGAIMultiplayer::applyProperties(const FGMultiplayerMotionSample& sample)
 {
-  mLastTimestamp = stamp;
+  std::vector<FGMultiplayerPropertyValue>::const_iterator propIt;
+  for (propIt = sample.properties.begin(); propIt != sample.properties.end(); ++propIt) {
+    PropertyMap::iterator pIt = mPropertyMap.find(propIt->id);
+    if (pIt == mPropertyMap.end()) {
+      SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << propIt->id << "\n");
+      continue;
+    }
+
+    switch (propIt->type) {
+      case simgear::props::INT:
+      case simgear::props::BOOL:
+      case simgear::props::LONG:
+        pIt->second->setIntValue(propIt->int_value);
+        break;
+      case simgear::props::STRING:
+      case simgear::props::UNSPECIFIED:
+        pIt->second->setStringValue(sample.stringValue(*propIt));
+        break;
+      default:
+        // FIXME - currently defaults to float values
+        pIt->second->setFloatValue(propIt->float_value);
+        break;
+    }
+  }
+}
 
-  if (!mMotionInfo.empty()) {
-    double diff = motionInfo.time - mMotionInfo.rbegin()->first;
+void
+FGAIMultiplayer::applyProperties(const FGMultiplayerMotionSample& prev,
+                                 const FGMultiplayerMotionSample& next,
+                                 double tau)
+{
+  for (size_t i = 0; i < prev.properties.size(); ++i) {
+    const FGMultiplayerPropertyValue& prevProp = prev.properties[i];
+    const FGMultiplayerPropertyValue& nextProp = next.properties[i];
+
+    PropertyMap::iterator pIt = mPropertyMap.find(prevProp.id);
+    if (pIt == mPropertyMap.end()) {
+      SG_LOG(SG_AI, SG_DEBUG, "Unable to find property: " << prevProp.id << "\n");
+      continue;
+    }
 
-    // packet is very old -- MP has probably reset (incl. his timebase)
-    if (diff < -10.0)
-      mMotionInfo.clear();
+    /*
+     * RJH - 2017-01-25
+     * Models which overload the mp property transmission get their
+     * properties truncated due to packet size, so two packets may list
+     * different properties at the same position. Only interpolate where
+     * the previous and next id are the same.
+     */
+    if (nextProp.id != prevProp.id) {
+      SG_LOG(SG_AI, SG_WARN, "MP packet mismatch during lag interpolation: "
+             << prevProp.id << " != " << nextProp.id << "\n");
+      continue;
+    }
 
-    // drop packets arriving out of order
-    else if (diff < 0.0)
-      return;
+    switch (prevProp.type) {
+      case simgear::props::INT:
+      case simgear::props::BOOL:
+      case simgear::props::LONG:
+        pIt->second->setIntValue((int)(0.5 + (1 - tau)*((double)prevProp.int_value) +
+                                       tau*((double)nextProp.int_value)));
+        break;
+      case simgear::props::STRING:
+      case simgear::props::UNSPECIFIED:
+        pIt->second->setStringValue(next.stringValue(nextProp));
+        break;
+      default:
+        // FIXME - currently defaults to float values
+        pIt->second->setFloatValue((1 - tau)*prevProp.float_value +
+                                   tau*nextProp.float_value);
+        break;
+    }
   }
-  mMotionInfo[motionInfo.time] = motionInfo;
-  // We just copied the property (pointer) list - they are ours now. Clear the
-  // properties list in given/returned object, so former owner won't deallocate them.
-  motionInfo.properties.clear();
+}
+
+void
+FGAIMultiplayer::addMotionInfo(const FGExternalMotionData& motionInfo,
+                               long stamp)
+{
+  mLastTimestamp = stamp;
+
+  // copied into the ring, the caller keeps ownership of the properties
+  mMotionInfo.add(motionInfo);
 }
 
 void
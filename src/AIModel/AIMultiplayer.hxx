@@ -26,6 +26,7 @@
 
 #include <MultiPlayer/mpmessages.hxx>
 #include "AIBase.hxx"
+#include "AIMultiplayerMotion.hxx"
 
 class FGAIMultiplayer : public FGAIBase {
 public:
@@ -36,7 +37,7 @@ public:
   virtual void bind();
   virtual void update(double dt);
 
-  void addMotionInfo(FGExternalMotionData& motionInfo, long stamp);
+  void addMotionInfo(const FGExternalMotionData& motionInfo, long stamp);
   void setDoubleProperty(const std::string& prop, double val);
 
   long getLastTimestamp(void) const
@@ -77,9 +78,12 @@ public:
 
 private:
 
-  // Automatic sorting of motion data according to its timestamp
-  typedef std::map<double,FGExternalMotionData> MotionInfo;
-  MotionInfo mMotionInfo;
+  void applyProperties(const FGMultiplayerMotionSample& sample);
+  void applyProperties(const FGMultiplayerMotionSample& prev,
+                       const FGMultiplayerMotionSample& next, double tau);
+
+  // Received motion data, sorted by its timestamp
+  FGMultiplayerMotionRing mMotionInfo;
 
   // Map between the property id's from the multiplayers network packets
   // and the property nodes
@@ -0,0 +1,133 @@
+// AIMultiplayerMotion.cxx - jitter buffer of multiplayer motion packets
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#include "AIMultiplayerMotion.hxx"
+
+void
+FGMultiplayerMotionSample::assign(const FGExternalMotionData& motionInfo)
+{
+  time = motionInfo.time;
+  lag = motionInfo.lag;
+  position = motionInfo.position;
+  orientation = motionInfo.orientation;
+  linearVel = motionInfo.linearVel;
+  angularVel = motionInfo.angularVel;
+  linearAccel = motionInfo.linearAccel;
+  angularAccel = motionInfo.angularAccel;
+
+  // clear() keeps the capacity, so this only allocates while the sample
+  // sees a bigger packet than ever before
+  properties.clear();
+  strings.clear();
+  std::vector<FGPropertyData*>::const_iterator it;
+  for (it = motionInfo.properties.begin(); it != motionInfo.properties.end(); ++it) {
+    const FGPropertyData* data = *it;
+    if (!data)
+      continue;
+
+    FGMultiplayerPropertyValue value;
+    value.id = data->id;
+    value.type = data->type;
+    value.int_value = 0;
+    value.float_value = 0;
+    value.string_offset = 0;
+
+    switch (data->type) {
+      case simgear::props::INT:
+      case simgear::props::BOOL:
+      case simgear::props::LONG:
+        value.int_value = data->int_value;
+        break;
+      case simgear::props::STRING:
+      case simgear::props::UNSPECIFIED: {
+        const char* s = data->string_value ? data->string_value : "";
+        value.string_offset = strings.size();
+        strings.insert(strings.end(), s, s + strlen(s) + 1);
+        break;
+      }
+      default:
+        value.float_value = data->float_value;
+        break;
+    }
+    properties.push_back(value);
+  }
+}
+
+FGMultiplayerMotionRing::FGMultiplayerMotionRing(size_t capacity) :
+  _slots(std::max<size_t>(capacity, 2)),
+  _head(0),
+  _count(0)
+{
+}
+
+bool
+FGMultiplayerMotionRing::add(const FGExternalMotionData& motionInfo)
+{
+  if (_count > 0) {
+    double diff = motionInfo.time - newest().time;
+
+    // packet is very old -- MP has probably reset (incl. his timebase)
+    if (diff < -10.0)
+      clear();
+
+    // drop packets arriving out of order
+    else if (diff < 0.0)
+      return false;
+
+    // a duplicate replaces the sample it repeats, like the map did
+    else if (diff == 0.0)
+      --_count;
+  }
+
+  if (_count == _slots.size()) {
+    // full: overwrite the oldest sample
+    _head = (_head + 1) % _slots.size();
+    --_count;
+  }
+
+  _slots[(_head + _count) % _slots.size()].assign(motionInfo);
+  ++_count;
+  return true;
+}
+
+size_t
+FGMultiplayerMotionRing::upperBound(double t) const
+{
+  size_t lo = 0, hi = _count;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if ((*this)[mid].time <= t)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+void
+FGMultiplayerMotionRing::dropOldest(size_t n)
+{
+  n = std::min(n, _count);
+  _head = (_head + n) % _slots.size();
+  _count -= n;
+}
@@ -0,0 +1,97 @@
+// AIMultiplayerMotion.hxx - jitter buffer of multiplayer motion packets
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AIMultiplayerMotion_HXX
+#define _FG_AIMultiplayerMotion_HXX
+
+#include <vector>
+
+#include <MultiPlayer/mpmessages.hxx>
+
+/// a property value of a received packet, strings live in the owning sample
+struct FGMultiplayerPropertyValue {
+  unsigned id;
+  simgear::props::Type type;
+  int int_value;
+  float float_value;
+  unsigned string_offset;
+};
+
+/**
+ * One received motion packet. The property values are stored by value in
+ * vectors which keep their capacity when the sample is overwritten, so a
+ * warmed up sample is refilled without allocating.
+ */
+class FGMultiplayerMotionSample {
+public:
+  void assign(const FGExternalMotionData& motionInfo);
+
+  const char* stringValue(const FGMultiplayerPropertyValue& p) const
+  { return &strings[p.string_offset]; }
+
+  double time;
+  double lag;
+  SGVec3d position;
+  SGQuatf orientation;
+  SGVec3f linearVel;
+  SGVec3f angularVel;
+  SGVec3f linearAccel;
+  SGVec3f angularAccel;
+
+  std::vector<FGMultiplayerPropertyValue> properties;
+  std::vector<char> strings;
+};
+
+/**
+ * Fixed capacity ring of motion samples ordered by time, oldest first.
+ * Once full, a new packet replaces the oldest one.
+ */
+class FGMultiplayerMotionRing {
+public:
+  explicit FGMultiplayerMotionRing(size_t capacity = 64);
+
+  bool empty() const { return _count == 0; }
+  size_t size() const { return _count; }
+  size_t capacity() const { return _slots.size(); }
+
+  /// Copy a received packet into the ring. Returns false if it was
+  /// dropped for arriving out of order. A packet more than 10 seconds
+  /// older than the newest one means the sender restarted its clock,
+  /// the ring is cleared and the packet kept.
+  bool add(const FGExternalMotionData& motionInfo);
+
+  /// i = 0 is the oldest sample
+  const FGMultiplayerMotionSample& operator[](size_t i) const
+  { return _slots[(_head + i) % _slots.size()]; }
+
+  const FGMultiplayerMotionSample& newest() const
+  { return (*this)[_count - 1]; }
+
+  /// index of the first sample newer than t, size() if there is none
+  size_t upperBound(double t) const;
+
+  /// forget the n oldest samples
+  void dropOldest(size_t n);
+
+  void clear() { _head = _count = 0; }
+
+private:
+  std::vector<FGMultiplayerMotionSample> _slots;
+  size_t _head;
+  size_t _count;
+};
+
+#endif  // _FG_AIMultiplayerMotion_HXX
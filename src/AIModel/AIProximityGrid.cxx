@@ -0,0 +1,223 @@
+// AIProximityGrid.cxx - find AI objects near a position
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AIProximityGrid.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+struct Candidate {
+    FGAIBase* object;
+    double dist2;
+
+    bool operator<(const Candidate& other) const
+    { return dist2 < other.dist2; }
+};
+
+} // of anonymous namespace
+
+FGAIProximityGrid::FGAIProximityGrid(double cellSizeM) :
+    _cellSizeM(cellSizeM)
+{
+}
+
+void FGAIProximityGrid::set(FGAIBase* object, const SGVec3d& cartPos)
+{
+    uint64_t cell = key(cartPos);
+    auto it = _slots.find(object);
+    if (it != _slots.end()) {
+        if (it->second.cell == cell) {
+            _cells[cell][it->second.index].pos = cartPos;
+            return;
+        }
+
+        removeItem(it->second.cell, it->second.index);
+    }
+
+    Cell& items = _cells[cell];
+    Slot slot = { cell, items.size() };
+    _slots[object] = slot;
+    Item item = { object, cartPos };
+    items.push_back(item);
+}
+
+void FGAIProximityGrid::remove(const FGAIBase* object)
+{
+    auto it = _slots.find(object);
+    if (it == _slots.end())
+        return;
+
+    Slot slot = it->second;
+    _slots.erase(it);
+    removeItem(slot.cell, slot.index);
+}
+
+void FGAIProximityGrid::clear()
+{
+    _cells.clear();
+    _slots.clear();
+}
+
+void FGAIProximityGrid::removeItem(uint64_t cell, size_t index)
+{
+    auto it = _cells.find(cell);
+    if (it == _cells.end())
+        return;
+
+    Cell& items = it->second;
+    if (index + 1 < items.size()) {
+        items[index] = items.back();
+        _slots[items[index].object].index = index;
+    }
+    items.pop_back();
+
+    // keep empty cells for objects coming back, unless traffic moving
+    // across the world leaves too many of them behind
+    if (items.empty() && (_cells.size() > 2 * _slots.size() + 64))
+        _cells.erase(it);
+}
+
+bool FGAIProximityGrid::coversAllCells(double radiusM) const
+{
+    // A big radius is cheaper to serve by going through the cells there
+    // are than by looking up every cell around the position. Stepping to
+    // the next cell costs a fraction of a hash lookup.
+    double r = std::ceil(radiusM / _cellSizeM);
+    return 4 * (2 * r + 1) * (2 * r + 1) * (2 * r + 1) >= _cells.size();
+}
+
+/**
+ * Call visitor(item) for the items in the cells within radiusM of
+ * cartPos, which may include some further away.
+ */
+template <class Visitor>
+void FGAIProximityGrid::visitInRange(const SGVec3d& cartPos, double radiusM,
+                                     Visitor& visitor) const
+{
+    int64_t n = (int64_t) std::ceil(radiusM / _cellSizeM);
+    int64_t cx = coord(cartPos.x()), cy = coord(cartPos.y()), cz = coord(cartPos.z());
+
+    if (coversAllCells(radiusM)) {
+        for (const CellDict::value_type& cell : _cells) {
+            int64_t x, y, z;
+            unpack(cell.first, x, y, z);
+            if ((std::abs(x - cx) > n) || (std::abs(y - cy) > n) || (std::abs(z - cz) > n))
+                continue;
+
+            for (const Item& item : cell.second)
+                visitor(item);
+        }
+        return;
+    }
+
+    for (int64_t x = cx - n; x <= cx + n; ++x) {
+        for (int64_t y = cy - n; y <= cy + n; ++y) {
+            for (int64_t z = cz - n; z <= cz + n; ++z) {
+                auto it = _cells.find(pack(x, y, z));
+                if (it == _cells.end())
+                    continue;
+
+                for (const Item& item : it->second)
+                    visitor(item);
+            }
+        }
+    }
+}
+
+void FGAIProximityGrid::findInRange(const SGVec3d& cartPos, double radiusM,
+                                    std::vector<FGAIBase*>& result) const
+{
+    result.clear();
+    const double radius2 = radiusM * radiusM;
+    auto visitor = [&](const Item& item) {
+        if (distSqr(cartPos, item.pos) <= radius2)
+            result.push_back(item.object);
+    };
+    visitInRange(cartPos, radiusM, visitor);
+}
+
+void FGAIProximityGrid::findNearest(const SGVec3d& cartPos, size_t k, double maxRadiusM,
+                                    std::vector<FGAIBase*>& result) const
+{
+    result.clear();
+    if (k == 0 || _slots.empty())
+        return;
+
+    // widen the search until it holds k objects: anything outside the
+    // radius is further away than those inside
+    std::vector<Candidate> candidates;
+    double radiusM = std::min(_cellSizeM, maxRadiusM);
+    for (;;) {
+        // once all cells are searched anyway, take all within reach
+        if (coversAllCells(radiusM))
+            radiusM = maxRadiusM;
+
+        candidates.clear();
+        const double radius2 = radiusM * radiusM;
+        auto visitor = [&](const Item& item) {
+            double d2 = distSqr(cartPos, item.pos);
+            if (d2 <= radius2) {
+                Candidate c = { item.object, d2 };
+                candidates.push_back(c);
+            }
+        };
+
+        visitInRange(cartPos, radiusM, visitor);
+        if ((candidates.size() >= k) || (radiusM >= maxRadiusM))
+            break;
+
+        radiusM = std::min(2 * radiusM, maxRadiusM);
+    }
+
+    size_t n = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end());
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        result.push_back(candidates[i].object);
+}
+
+int64_t FGAIProximityGrid::coord(double v) const
+{
+    return (int64_t) std::floor(v / _cellSizeM);
+}
+
+uint64_t FGAIProximityGrid::pack(int64_t x, int64_t y, int64_t z)
+{
+    const int64_t mask = (1 << 21) - 1;
+    return ((uint64_t) ((x + (1 << 20)) & mask) << 42)
+        | ((uint64_t) ((y + (1 << 20)) & mask) << 21)
+        | (uint64_t) ((z + (1 << 20)) & mask);
+}
+
+void FGAIProximityGrid::unpack(uint64_t key, int64_t& x, int64_t& y, int64_t& z)
+{
+    const uint64_t mask = (1 << 21) - 1;
+    x = (int64_t) ((key >> 42) & mask) - (1 << 20);
+    y = (int64_t) ((key >> 21) & mask) - (1 << 20);
+    z = (int64_t) (key & mask) - (1 << 20);
+}
+
+uint64_t FGAIProximityGrid::key(const SGVec3d& p) const
+{
+    return pack(coord(p.x()), coord(p.y()), coord(p.z()));
+}
@@ -0,0 +1,93 @@
+// AIProximityGrid.hxx - find AI objects near a position
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AIPROXIMITYGRID_HXX
+#define _FG_AIPROXIMITYGRID_HXX
+
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include <simgear/math/SGMath.hxx>
+
+class FGAIBase;
+
+/**
+ * A uniform spatial hash of AI objects by their cartesian position, so
+ * queries for the objects near a point only look at the cells around
+ * it, instead of at every object.
+ *
+ * Positions are those passed to set(): the grid does not look at the
+ * objects themselves. FGAIManager updates it once per frame, so an
+ * object may have moved since; callers which need the exact position
+ * search a little wider and check the candidates.
+ *
+ * Objects are moved between cells only when they cross a cell border,
+ * and cells keep their storage, so a stable scene does not allocate.
+ */
+class FGAIProximityGrid
+{
+public:
+    explicit FGAIProximityGrid(double cellSizeM = 2000);
+
+    /// add an object, or update its position
+    void set(FGAIBase* object, const SGVec3d& cartPos);
+    void remove(const FGAIBase* object);
+    void clear();
+
+    size_t size() const
+    { return _slots.size(); }
+
+    /// All objects within radiusM of cartPos, in no particular order.
+    void findInRange(const SGVec3d& cartPos, double radiusM,
+                     std::vector<FGAIBase*>& result) const;
+
+    /// The k objects nearest to cartPos and within maxRadiusM of it,
+    /// nearest first.
+    void findNearest(const SGVec3d& cartPos, size_t k, double maxRadiusM,
+                     std::vector<FGAIBase*>& result) const;
+
+private:
+    struct Item {
+        FGAIBase* object;
+        SGVec3d pos;
+    };
+
+    struct Slot {
+        uint64_t cell;
+        size_t index;
+    };
+
+    typedef std::vector<Item> Cell;
+    typedef std::unordered_map<uint64_t, Cell> CellDict;
+
+    bool coversAllCells(double radiusM) const;
+    template <class Visitor>
+    void visitInRange(const SGVec3d& cartPos, double radiusM, Visitor& visitor) const;
+
+    int64_t coord(double v) const;
+    static uint64_t pack(int64_t x, int64_t y, int64_t z);
+    static void unpack(uint64_t key, int64_t& x, int64_t& y, int64_t& z);
+    uint64_t key(const SGVec3d& p) const;
+
+    void removeItem(uint64_t cell, size_t index);
+
+    double _cellSizeM;
+    CellDict _cells;
+    std::unordered_map<const FGAIBase*, Slot> _slots;
+};
+
+#endif  // _FG_AIPROXIMITYGRID_HXX
@@ -22,6 +22,7 @@
 #include "AIBase.hxx"
 #include "AIManager.hxx"
 #include "AIBallistic.hxx"
+#include "AIBallisticParticles.hxx"
 
 using std::cout;
 using std::endl;
@@ -83,6 +84,19 @@ void FGSubmodelMgr::init()
     _contrail_trigger       = fgGetNode("ai/submodels/contrails", true);
     _contrail_trigger->setBoolValue(false);
 
+    SGPropertyNode* particles = fgGetNode("/sim/submodels/particles", true);
+    _particles_enabled_node = particles->getChild("enabled", 0, true);
+    if (!_particles_enabled_node->hasValue())
+        _particles_enabled_node->setBoolValue(true);
+    _particles_max_node = particles->getChild("max-count", 0, true);
+    if (!_particles_max_node->hasValue())
+        _particles_max_node->setIntValue(4096);
+    _particles_count_node = particles->getChild("count", 0, true);
+    _particles_promoted_node = particles->getChild("promoted", 0, true);
+    _particles_count_node->setIntValue(0);
+    _particles_promoted_node->setIntValue(0);
+    _particles.reset(new FGAIBallisticParticles);
+
     load();
 }
 
@@ -100,6 +114,12 @@ void FGSubmodelMgr::postinit()
     //_model_added_node->addChangeListener(this, false);
 }
 
+void FGSubmodelMgr::shutdown()
+{
+    if (_particles)
+        _particles->clear();
+}
+
 void FGSubmodelMgr::bind()
 {
 }
@@ -115,6 +135,9 @@ void FGSubmodelMgr::unbind()
 
 void FGSubmodelMgr::update(double dt)
 {
+    // particles already released keep flying, like AI objects do
+    updateParticles(dt);
+
     if (!_serviceable_node->getBoolValue())
         return;
 
@@ -254,26 +277,57 @@ bool FGSubmodelMgr::release(submodel *sm, double dt)
     // Calculate submodel's initial conditions in world-coordinates
     transform(sm);
 
-    FGAIBallistic* ballist = new FGAIBallistic;
-    ballist->setPath(sm->model.c_str());
-    ballist->setName(sm->name);
-    ballist->setSlaved(sm->slaved);
-    ballist->setRandom(sm->random);
-    ballist->setLifeRandomness(sm->life_randomness->get_value());
+    if (_particles_enabled_node->getBoolValue()
+        && FGAIBallisticParticles::canSimulate(sm)
+        && _particles->add(sm, offsetpos, IC.azimuth, IC.elevation, IC.roll,
+                           IC.speed, IC.mass)) {
+        _particles_count_node->setIntValue(_particles->size());
+
+        if (sm->count > 0)
+            sm->count--;
+        return true;
+    }
+
+    FGAIBallistic* ballist = newBallistic(sm);
     ballist->setLatitude(offsetpos.getLatitudeDeg());
     ballist->setLongitude(offsetpos.getLongitudeDeg());
     ballist->setAltitude(offsetpos.getElevationFt());
-    ballist->setAzimuthRandomError(sm->azimuth_error->get_value());
     ballist->setAzimuth(IC.azimuth);
-    ballist->setElevationRandomError(sm->elevation_error->get_value());
     ballist->setElevation(IC.elevation);
     ballist->setRoll(IC.roll);
     ballist->setSpeed(IC.speed / SG_KT_TO_FPS);
     ballist->setWind_from_east(IC.wind_from_east);
     ballist->setWind_from_north(IC.wind_from_north);
     ballist->setMass(IC.mass);
-    ballist->setDragArea(sm->drag_area);
     ballist->setLife(sm->life);
+    ballist->setXoffset(_x_offset);
+    ballist->setYoffset(_y_offset);
+    ballist->setZoffset(_z_offset);
+    ballist->setPitchoffset(sm->pitch_offset->get_value());
+    ballist->setYawoffset(sm->yaw_offset->get_value());
+    ballist->setParentNodes(_selected_ac);
+    ballist->setContentsNode(sm->contents_node);
+
+    aiManager()->attach(ballist);
+
+    if (sm->count > 0)
+        sm->count--;
+    return true;
+}
+
+FGAIBallistic* FGSubmodelMgr::newBallistic(submodel *sm)
+{
+    // everything but the initial conditions, which need the randomness
+    // set before them
+    FGAIBallistic* ballist = new FGAIBallistic;
+    ballist->setPath(sm->model.c_str());
+    ballist->setName(sm->name);
+    ballist->setSlaved(sm->slaved);
+    ballist->setRandom(sm->random);
+    ballist->setLifeRandomness(sm->life_randomness->get_value());
+    ballist->setAzimuthRandomError(sm->azimuth_error->get_value());
+    ballist->setElevationRandomError(sm->elevation_error->get_value());
+    ballist->setDragArea(sm->drag_area);
     ballist->setBuoyancy(sm->buoyancy);
     ballist->setWind(sm->wind);
     ballist->setCdRandomness(sm->cd_randomness->get_value());
@@ -290,20 +344,46 @@ bool FGSubmodelMgr::release(submodel *sm, double dt)
     ballist->setForceStabilisation(sm->force_stabilised);
     ballist->setExternalForce(sm->ext_force);
     ballist->setForcePath(sm->force_path.c_str());
-    ballist->setXoffset(_x_offset);
-    ballist->setYoffset(_y_offset);
-    ballist->setZoffset(_z_offset);
-    ballist->setPitchoffset(sm->pitch_offset->get_value());
-    ballist->setYawoffset(sm->yaw_offset->get_value());
-    ballist->setParentNodes(_selected_ac);
-    ballist->setContentsNode(sm->contents_node);
     ballist->setWeight(sm->weight);
+    return ballist;
+}
 
-    aiManager()->attach(ballist);
+void FGSubmodelMgr::updateParticles(double dt)
+{
+    FGAIManager* manager = aiManager();
+    if (!_particles || !manager)
+        return;
 
-    if (sm->count > 0)
-        sm->count--;
-    return true;
+    _particles->setMaxCount(std::max(_particles_max_node->getIntValue(), 0));
+    const FGAIBallisticParticles::EndedList& ended = _particles->update(dt, manager);
+
+    // particles which have to report their end continue as full objects
+    FGAIBallisticParticles::EndedList::const_iterator it;
+    for (it = ended.begin(); it != ended.end(); ++it) {
+        FGAIBallistic* ballist = newBallistic(it->sm);
+        ballist->setRandom(false);
+        ballist->setLatitude(it->pos.getLatitudeDeg());
+        ballist->setLongitude(it->pos.getLongitudeDeg());
+        ballist->setAltitude(it->pos.getElevationFt());
+        ballist->setAzimuth(it->azimuth);
+        ballist->setElevation(it->elevation);
+        ballist->setRoll(it->roll);
+        ballist->setSpeed(it->speed_kt);
+        ballist->setMass(it->sm->weight * lbs_to_slugs);
+        ballist->setLife(it->life);
+        ballist->setRandom(it->sm->random);
+
+        manager->attach(ballist);
+        ballist->setHeading(it->hdg);
+        ballist->setPitch(it->pitch);
+        ballist->takeOverEndOfFlight(it->reason, it->ground_elev_m, it->object);
+    }
+
+    if (!ended.empty()) {
+        _particles_promoted_node->setIntValue(_particles_promoted_node->getIntValue()
+                                              + ended.size());
+    }
+    _particles_count_node->setIntValue(_particles->size());
 }
 
 void FGSubmodelMgr::load()
@@ -528,6 +608,7 @@ void FGSubmodelMgr::setData(int id, const string& path, bool serviceable, const
         sm->ext_force        = entry_node->getBoolValue("external-force", false);
         sm->force_path       = entry_node->getStringValue("force-path", "");
         sm->random           = entry_node->getBoolValue("random", false);
+        sm->particle         = entry_node->getBoolValue("particle", false);
 
         SGPropertyNode_ptr prop_root = fgGetNode("/", true);
         SGPropertyNode n;
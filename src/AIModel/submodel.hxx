@@ -17,10 +17,13 @@
 
 #include <Autopilot/inputvalue.hxx>
 
+#include <memory>
 #include <vector>
 #include <string>
 
 class FGAIBase;
+class FGAIBallistic;
+class FGAIBallisticParticles;
 class FGAIManager;
 
 class FGSubmodelMgr : public SGSubsystem, public SGPropertyChangeListener
@@ -77,6 +80,7 @@ public:
         bool               force_stabilised;
         bool               ext_force;
         std::string        force_path;
+        bool               particle;
     }   submodel;
 
     typedef struct {
@@ -104,6 +108,7 @@ public:
     void load();
     void init();
     void postinit();
+    void shutdown();
     void bind();
     void unbind();
     void update(double dt);
@@ -171,6 +176,13 @@ private:
     SGPropertyNode_ptr _model_added_node;
     SGPropertyNode_ptr _path_node;
     SGPropertyNode_ptr _selected_ac;
+    SGPropertyNode_ptr _particles_enabled_node;
+    SGPropertyNode_ptr _particles_max_node;
+    SGPropertyNode_ptr _particles_count_node;
+    SGPropertyNode_ptr _particles_promoted_node;
+
+    // simple submodels fly here rather than as FGAIBallistic objects
+    std::unique_ptr<FGAIBallisticParticles> _particles;
 
     IC_struct  IC;
 
@@ -184,6 +196,8 @@ private:
     void transform(submodel *);
     void setParentNode(int parent_id);
     bool release(submodel *, double dt);
+    FGAIBallistic* newBallistic(submodel *);
+    void updateParticles(double dt);
 
     int _count;
 
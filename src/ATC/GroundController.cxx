@@ -75,7 +75,8 @@ bool compare_trafficrecords(FGTrafficRecord a, FGTrafficRecord b)
 }
 
 FGGroundController::FGGroundController() :
-    parent(NULL)
+    parent(NULL),
+    dynamics(NULL)
 {
     hasNetwork = false;
     count = 0;
@@ -113,20 +114,9 @@ void FGGroundController::announcePosition(int id,
         return;
     }
 
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (!activeTraffic.empty()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = searchActiveTraffic(id);
     // Add a new TrafficRecord if no one exsists for this aircraft.
-    if (i == activeTraffic.end() || (activeTraffic.empty())) {
+    if (i == activeTraffic.end()) {
         FGTrafficRecord rec;
         rec.setId(id);
         rec.setLeg(leg);
@@ -136,38 +126,67 @@ void FGGroundController::announcePosition(int id,
         rec.setAircraft(aircraft);
         if (leg == 2) {
             activeTraffic.push_front(rec);
+            i = activeTraffic.begin();
         } else {
             activeTraffic.push_back(rec);   
+            i = --activeTraffic.end();
         }
-        
+        trafficIndex[id] = i;
     } else {
         i->setPositionAndIntentions(currentPosition, intendedRoute);
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
     }
+
+    FGGroundNetwork* network = groundNetwork();
+    if (network) {
+        network->updateOccupancy(id, i->getCurrentPosition(), i->getIntentions());
+    }
 }
 
 
 void FGGroundController::signOff(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id alread has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    TrafficVectorIterator i = searchActiveTraffic(id);
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: Aircraft without traffic record is signing off at " << SG_ORIGIN);
     } else {
-        i = activeTraffic.erase(i);
+        trafficIndex.erase(id);
+        activeTraffic.erase(i);
+        FGGroundNetwork* network = groundNetwork();
+        if (network) {
+            network->removeOccupancy(id);
+        }
+    }
+}
+
+TrafficVectorIterator FGGroundController::searchActiveTraffic(int id)
+{
+    TrafficIdMap::iterator it = trafficIndex.find(id);
+    if (it == trafficIndex.end()) {
+        return activeTraffic.end();
     }
+
+    return it->second;
 }
+
+void FGGroundController::rebuildTrafficIndex()
+{
+    trafficIndex.clear();
+    for (TrafficVectorIterator i = activeTraffic.begin(); i != activeTraffic.end(); ++i) {
+        trafficIndex[i->getId()] = i;
+    }
+}
+
+FGGroundNetwork* FGGroundController::groundNetwork() const
+{
+    if (!dynamics) {
+        return NULL;
+    }
+
+    return dynamics->parent()->groundNetwork();
+}
+
 /**
  * The ground network can deal with the following states:
  * 0 =  Normal; no action required
@@ -222,28 +241,25 @@ void FGGroundController::updateAircraftInformation(int id, double lat, double lo
     // Probably use a status mechanism similar to the Engine start procedure in the startup controller.
 
 
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    TrafficVectorIterator current, closest;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
+    TrafficVectorIterator i = searchActiveTraffic(id);
+    TrafficVectorIterator current;
     // update position of the current aircraft
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: updating aircraft without traffic record at " << SG_ORIGIN);
+        return;
     } else {
         i->setPositionAndHeading(lat, lon, heading, speed, alt);
         current = i;
     }
 
+    // keep the segment occupancy index in sync, the conflict checks
+    // below are lookups into it
+    FGGroundNetwork* network = groundNetwork();
+    if (network) {
+        network->updateOccupancy(id, current->getCurrentPosition(), current->getIntentions());
+    }
+
     setDt(getDt() + dt);
 
     // Update every three secs, but add some randomness
@@ -308,23 +324,13 @@ void FGGroundController::checkSpeedAdjustment(int id, double lat,
 {
 
     TrafficVectorIterator current, closest, closestOnNetwork;
-    TrafficVectorIterator i = activeTraffic.begin();
+    TrafficVectorIterator i = searchActiveTraffic(id);
     bool otherReasonToSlowDown = false;
 //    bool previousInstruction;
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && (i != activeTraffic.end()))
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
-        return;
-    }
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: Trying to access non-existing aircraft in FGGroundNetwork::checkSpeedAdjustment at " << SG_ORIGIN);
+        return;
     }
     current = i;
     //closest = current;
@@ -337,9 +343,18 @@ void FGGroundController::checkSpeedAdjustment(int id, double lat,
         //TrafficVector iterator closest;
         closest = current;
         closestOnNetwork = current;
-        for (TrafficVectorIterator i = activeTraffic.begin();
-                i != activeTraffic.end(); i++) {
-            if (i == current) {
+
+        // Only aircraft on our current segment or on the remainder of our
+        // route can make us slow down, so look those up in the occupancy
+        // index instead of scanning all active traffic.
+        intVec ahead;
+        FGGroundNetwork* network = groundNetwork();
+        if (network) {
+            network->findTrafficAhead(id, ahead);
+        }
+        for (intVecIterator a = ahead.begin(); a != ahead.end(); a++) {
+            TrafficVectorIterator i = searchActiveTraffic(*a);
+            if ((i == activeTraffic.end()) || (i == current)) {
                 continue;
             }
 
@@ -457,23 +472,13 @@ void FGGroundController::checkHoldPosition(int id, double lat,
 {
     FGGroundNetwork* network = dynamics->parent()->groundNetwork();
     TrafficVectorIterator current;
-    TrafficVectorIterator i = activeTraffic.begin();
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end())
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
-        return;
-    }
+    TrafficVectorIterator i = searchActiveTraffic(id);
 
     time_t now = globals->get_time_params()->get_cur_time();
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: Trying to access non-existing aircraft in FGGroundNetwork::checkHoldPosition at " << SG_ORIGIN);
+        return;
     }
     current = i;
     // 
@@ -606,21 +611,12 @@ bool FGGroundController::checkForCircularWaits(int id)
     //cerr << "Performing Wait check " << id << endl;
     int target = 0;
     TrafficVectorIterator current, other;
-    TrafficVectorIterator i = activeTraffic.begin();
+    TrafficVectorIterator i = searchActiveTraffic(id);
     int trafficSize = activeTraffic.size();
-    if (trafficSize) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    } else {
-        return false;
-    }
-    if (i == activeTraffic.end() || (trafficSize == 0)) {
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: Trying to access non-existing aircraft in FGGroundNetwork::checkForCircularWaits at " << SG_ORIGIN);
+        return false;
     }
 
     current = i;
@@ -636,19 +632,8 @@ bool FGGroundController::checkForCircularWaits(int id)
 
     while ((target > 0) && (target != id) && counter++ < trafficSize) {
         //printed = true;
-        TrafficVectorIterator i = activeTraffic.begin();
-        if (trafficSize) {
-            //while ((i->getId() != id) && i != activeTraffic.end())
-            while (i != activeTraffic.end()) {
-                if (i->getId() == target) {
-                    break;
-                }
-                i++;
-            }
-        } else {
-            return false;
-        }
-        if (i == activeTraffic.end() || (trafficSize == 0)) {
+        TrafficVectorIterator i = searchActiveTraffic(target);
+        if (i == activeTraffic.end()) {
             //cerr << "[Waiting for traffic at Runway: DONE] " << endl << endl;;
             // The target id is not found on the current network, which means it's at the tower
             //SG_LOG(SG_GENERAL, SG_ALERT, "AI error: Trying to access non-existing aircraft in FGGroundNetwork::checkForCircularWaits");
@@ -698,19 +683,8 @@ bool FGGroundController::checkForCircularWaits(int id)
 // Note that this function is probably obsolete...
 bool FGGroundController::hasInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    TrafficVectorIterator i = searchActiveTraffic(id);
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: checking ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
     } else {
@@ -721,19 +695,8 @@ bool FGGroundController::hasInstruction(int id)
 
 FGATCInstruction FGGroundController::getInstruction(int id)
 {
-    TrafficVectorIterator i = activeTraffic.begin();
-    // Search search if the current id has an entry
-    // This might be faster using a map instead of a vector, but let's start by taking a safe route
-    if (activeTraffic.size()) {
-        //while ((i->getId() != id) && i != activeTraffic.end()) {
-        while (i != activeTraffic.end()) {
-            if (i->getId() == id) {
-                break;
-            }
-            i++;
-        }
-    }
-    if (i == activeTraffic.end() || (activeTraffic.size() == 0)) {
+    TrafficVectorIterator i = searchActiveTraffic(id);
+    if (i == activeTraffic.end()) {
         SG_LOG(SG_GENERAL, SG_ALERT,
                "AI error: requesting ATC instruction for aircraft without traffic record at " << SG_ORIGIN);
     } else {
@@ -974,8 +937,17 @@ void FGGroundController::update(double dt)
         updateActiveTraffic(i, priority, now);
     }
 
+    // dead aircraft never sign off, so drop them from the occupancy index
+    // before their records go away
+    for (i = activeTraffic.begin(); i != activeTraffic.end(); i++) {
+        if (!i->getAircraft() || i->getAircraft()->getDie()) {
+            network->removeOccupancy(i->getId());
+        }
+    }
+
     eraseDeadTraffic(startupTraffic);
     eraseDeadTraffic(activeTraffic);
+    rebuildTrafficIndex();
 }
 
 void FGGroundController::updateStartupTraffic(TrafficVectorIterator i,
@@ -1007,21 +979,16 @@ void FGGroundController::updateStartupTraffic(TrafficVectorIterator i,
         return;
     }
 
-    // Check for all active aircraft whether it's current pos segment is
-    // an opposite of one of the departing aircraft's intentions
-    for (TrafficVectorIterator j = activeTraffic.begin(); j != activeTraffic.end(); j++) {
-        int pos = j->getCurrentPosition();
-        if (pos > 0) {
-            FGTaxiSegment *seg = network->findOppositeSegment(pos-1);
-            if (seg) {
-                int posReverse = seg->getIndex();
-                for (intVecIterator k = i->getIntentions().begin(); k != i->getIntentions().end(); k++) {
-                    if ((*k) == posReverse) {
-                        i->denyPushBack();
-                        network->findSegment(posReverse)->block(i->getId(), now, now);
-                    }
-                }
-            }
+    // Check whether any active aircraft is currently taxiing on the
+    // opposite of one of the departing aircraft's intentions
+    for (intVecIterator k = i->getIntentions().begin(); k != i->getIntentions().end(); k++) {
+        if ((*k) <= 0) {
+            continue;
+        }
+        FGTaxiSegment *seg = network->findOppositeSegment(*k);
+        if (seg && !network->occupantsOf(seg->getIndex()).empty()) {
+            i->denyPushBack();
+            network->findSegment(*k)->block(i->getId(), now, now);
         }
     }
     // if the current aircraft is still allowed to pushback, we can start reserving a route for if by blocking all the entry taxiways.
@@ -26,10 +26,12 @@
 #include <simgear/compiler.h>
 
 #include <string>
+#include <map>
 
 #include <ATC/trafficcontrol.hxx>
 
 class FGAirportDynamics;
+class FGGroundNetwork;
 
 /**************************************************************************************
  * class FGGroundNetWork
@@ -47,6 +49,11 @@ private:
     TrafficVector activeTraffic;
     TrafficVectorIterator currTraffic;
 
+    // id -> record lookup for activeTraffic; list iterators stay valid
+    // until the record itself is erased
+    typedef std::map<int, TrafficVectorIterator> TrafficIdMap;
+    TrafficIdMap trafficIndex;
+
     FGTowerController *towerController;
     FGAirport *parent;
     FGAirportDynamics* dynamics;
@@ -60,6 +67,10 @@ private:
 
     void updateStartupTraffic(TrafficVectorIterator i, int& priority, time_t now);
     bool updateActiveTraffic(TrafficVectorIterator i, int& priority, time_t now);
+
+    TrafficVectorIterator searchActiveTraffic(int id);
+    void rebuildTrafficIndex();
+    FGGroundNetwork* groundNetwork() const;
 public:
     FGGroundController();
     ~FGGroundController();
@@ -342,19 +342,21 @@ int FGTrafficRecord::crosses(FGGroundNetwork * net,
         }
     }
     if (! intentions.empty() && ! other.intentions.empty()) {
+        // collect the nodes the other aircraft will pass once, instead of
+        // comparing every pair of route segments
+        intVec otherNodes;
+        otherNodes.reserve(other.intentions.size());
+        for (j = other.intentions.begin(); j != other.intentions.end(); j++) {
+            if ((*j) > 0)
+                otherNodes.push_back(net->findSegment(*j)->getEnd()->getIndex());
+        }
+        std::sort(otherNodes.begin(), otherNodes.end());
         for (i = intentions.begin(); i != intentions.end(); i++) {
-            for (j = other.intentions.begin(); j != other.intentions.end();
-                    j++) {
-                //cerr << "finding segment " << *i << " and " << *j << endl;
-                if (((*i) > 0) && ((*j) > 0)) {
-                    currentTargetNode =
-                        net->findSegment(*i)->getEnd()->getIndex();
-                    otherTargetNode =
-                        net->findSegment(*j)->getEnd()->getIndex();
-                    if (currentTargetNode == otherTargetNode) {
-                        //cerr << "Routes will cross at " << currentTargetNode << endl;
-                        return currentTargetNode;
-                    }
+            if ((*i) > 0) {
+                currentTargetNode = net->findSegment(*i)->getEnd()->getIndex();
+                if (std::binary_search(otherNodes.begin(), otherNodes.end(), currentTargetNode)) {
+                    //cerr << "Routes will cross at " << currentTargetNode << endl;
+                    return currentTargetNode;
                 }
             }
         }
@@ -414,42 +416,27 @@ bool FGTrafficRecord::isOpposing(FGGroundNetwork * net,
                 return true;
         }
 
+        intVec otherIntentions(other.intentions);
+        std::sort(otherIntentions.begin(), otherIntentions.end());
+
         for (intVecIterator i = intentions.begin(); i != intentions.end();
                 i++) {
+            if ((*i) <= 0)
+                continue;
+            FGTaxiSegment* seg = net->findSegment(*i);
+            if (seg->getStart()->getIndex() != node)
+                continue;
             if ((opp = net->findSegment(other.currentPos)->opposite())) {
-                if ((*i) > 0)
-                    if (opp->getIndex() ==
-                            net->findSegment(*i)->getIndex()) {
-                        if (net->findSegment(*i)->getStart()->getIndex() ==
-                                node) {
-                            {
-                                //cerr << "Found the node " << node << endl;
-                                return true;
-                            }
-                        }
-                    }
+                if (opp->getIndex() == seg->getIndex()) {
+                    //cerr << "Found the node " << node << endl;
+                    return true;
+                }
             }
-            if (! other.intentions.empty()) {
-                for (intVecIterator j = other.intentions.begin();
-                        j != other.intentions.end(); j++) {
-                    // cerr << "Current segment 1 " << (*i) << endl;
-                    if ((*i) > 0) {
-                        if ((opp = net->findSegment(*i)->opposite())) {
-                            if (opp->getIndex() ==
-                                    net->findSegment(*j)->getIndex()) {
-                                //cerr << "Nodes " << net->findSegment(*i)->getIndex()
-                                //   << " and  " << net->findSegment(*j)->getIndex()
-                                //   << " are opposites " << endl;
-                                if (net->findSegment(*i)->getStart()->
-                                        getIndex() == node) {
-                                    {
-                                        //cerr << "Found the node " << node << endl;
-                                        return true;
-                                    }
-                                }
-                            }
-                        }
-                    }
+            if ((opp = seg->opposite())) {
+                if (std::binary_search(otherIntentions.begin(), otherIntentions.end(),
+                                       opp->getIndex())) {
+                    //cerr << "Found the node " << node << endl;
+                    return true;
                 }
             }
         }
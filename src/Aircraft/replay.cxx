@@ -203,6 +203,29 @@ FGReplay::unbind()
     // nothing to unbind
 }
 
+void
+FGReplay::rewindTo(double time)
+{
+    if (time >= sim_time)
+        return;
+
+    replay_list_type* lists[] = { &short_term, &medium_term, &long_term };
+    for (replay_list_type* list : lists)
+    {
+        while (!list->empty() && (list->back()->sim_time > time))
+        {
+            recycler.push_back(list->back());
+            list->pop_back();
+        }
+    }
+
+    sim_time = time;
+    if (last_mt_time > time)
+        last_mt_time = time;
+    if (last_lt_time > time)
+        last_lt_time = time;
+}
+
 void
 FGReplay::fillRecycler()
 {
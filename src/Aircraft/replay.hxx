@@ -75,6 +75,13 @@ public:
     bool saveTape(const SGPropertyNode* ConfigData);
     bool loadTape(const SGPropertyNode* ConfigData);
 
+    /// the time of the latest recording
+    double getRecordTime() const { return sim_time; }
+
+    /// Drop what was recorded after 'time', so recording goes on from
+    /// there. Used when restoring a snapshot taken at that time.
+    void rewindTo(double time);
+
 private:
     void clear();
     FGReplayData* record(double time);
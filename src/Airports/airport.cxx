@@ -29,6 +29,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <sstream>
 #include <boost/foreach.hpp>
 
 #include <simgear/misc/sg_path.hxx>
@@ -46,6 +47,7 @@
 #include <Airports/xmlloader.hxx>
 #include <Airports/dynamics.hxx>
 #include <Airports/airportdynamicsmanager.hxx>
+#include <Airports/airportprefetcher.hxx>
 #include <Navaids/procedure.hxx>
 #include <Navaids/waypoint.hxx>
 #include <ATC/CommStation.hxx>
@@ -548,13 +550,15 @@ void FGAirport::loadProcedures() const
   
   mProceduresLoaded = true;
   SGPath path;
-  if (!XMLLoader::findAirportData(ident(), "procedures", path)) {
+  std::string contents;
+  if (!XMLLoader::readAirportData(this, "procedures", path, contents)) {
     SG_LOG(SG_GENERAL, SG_INFO, "no procedures data available for " << ident());
     return;
   }
   
   SG_LOG(SG_GENERAL, SG_INFO, ident() << ": loading procedures from " << path);
-  RouteBase::loadAirportProcedures(path, const_cast<FGAirport*>(this));
+  std::istringstream stream(contents);
+  RouteBase::loadAirportProcedures(path, stream, const_cast<FGAirport*>(this));
 }
 
 void FGAirport::loadSceneryDefinitions() const
@@ -566,13 +570,15 @@ void FGAirport::loadSceneryDefinitions() const
   mThresholdDataLoaded = true;
   
   SGPath path;
-  if (!XMLLoader::findAirportData(ident(), "threshold", path)) {
+  std::string contents;
+  if (!XMLLoader::readAirportData(this, "threshold", path, contents)) {
     return; // no XML threshold data
   }
   
   try {
     SGPropertyNode_ptr rootNode = new SGPropertyNode;
-    readProperties(path, rootNode);
+    std::istringstream stream(contents);
+    readProperties(stream, rootNode, path.utf8Str());
     const_cast<FGAirport*>(this)->readThresholdData(rootNode);
   } catch (sg_exception& e) {
     SG_LOG(SG_NAVAID, SG_WARN, ident() << "loading threshold XML failed:" << e.getFormattedMessage());
@@ -674,13 +680,15 @@ void FGAirport::validateTowerData() const
   }
   
   SGPath path;
-  if (!XMLLoader::findAirportData(ident(), "twr", path)) {
+  std::string contents;
+  if (!XMLLoader::readAirportData(this, "twr", path, contents)) {
     return; // no XML tower data, base position is fine
   }
   
   try {
     SGPropertyNode_ptr rootNode = new SGPropertyNode;
-    readProperties(path, rootNode);
+    std::istringstream stream(contents);
+    readProperties(stream, rootNode, path.utf8Str());
     const_cast<FGAirport*>(this)->readTowerData(rootNode);
     mHasTower = true;
   } catch (sg_exception& e){
@@ -712,13 +720,15 @@ void FGAirport::validateILSData()
   mILSDataLoaded = true;
     
   SGPath path;
-  if (!XMLLoader::findAirportData(ident(), "ils", path)) {
+  std::string contents;
+  if (!XMLLoader::readAirportData(this, "ils", path, contents)) {
     return; // no XML ILS data
   }
   
   try {
       SGPropertyNode_ptr rootNode = new SGPropertyNode;
-      readProperties(path, rootNode);
+      std::istringstream stream(contents);
+      readProperties(stream, rootNode, path.utf8Str());
       readILSData(rootNode);
   } catch (sg_exception& e){
       SG_LOG(SG_NAVAID, SG_WARN, ident() << "loading ils XML failed:" << e.getFormattedMessage());
@@ -962,6 +972,16 @@ FGAirportDynamicsRef FGAirport::getDynamics() const
 
 FGGroundNetwork *FGAirport::groundNetwork() const
 {
+    if (!_groundNetwork.get()) {
+        // usually loaded in the background already, as the airport came
+        // into range
+        flightgear::AirportPrefetcher* prefetcher =
+            flightgear::AirportDynamicsManager::prefetcher();
+        if (prefetcher) {
+            _groundNetwork.reset(prefetcher->takeGroundNet(this));
+        }
+    }
+
     if (!_groundNetwork.get()) {
         _groundNetwork.reset(new FGGroundNetwork(const_cast<FGAirport*>(this)));
 
@@ -24,16 +24,30 @@
 #include <simgear/structure/exception.hxx>
 
 #include "airport.hxx"
+#include "airportprefetcher.hxx"
+#include "groundnetcache.hxx"
 #include "xmlloader.hxx"
 #include "dynamics.hxx"
 #include "runwayprefs.hxx"
 
 #include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
 
 namespace flightgear
 {
 
-AirportDynamicsManager::AirportDynamicsManager()
+namespace {
+
+// how often, and after how far a move, the airports around the user are
+// looked up again
+const double prefetchIntervalSec = 30.0;
+const double prefetchMoveNm = 5.0;
+const unsigned int prefetchMaxAirports = 16;
+
+} // of anonymous namespace
+
+AirportDynamicsManager::AirportDynamicsManager() :
+    m_prefetchTimer(0.0)
 {
 
 }
@@ -47,18 +61,70 @@ AirportDynamicsManager::~AirportDynamicsManager()
 
 void AirportDynamicsManager::init()
 {
+    if (!fgGetBool("/sim/airport/prefetch/enabled", true)) {
+        return;
+    }
 
+    SGPath cacheDir;
+    if (fgGetBool("/sim/airport/groundnet-cache", true)) {
+        cacheDir = FGGroundNetCache::defaultDir();
+    }
 
+    m_prefetcher.reset(new AirportPrefetcher);
+    m_prefetcher->start(globals->get_fg_scenery(), cacheDir);
+    m_lastPrefetchPos = SGGeod();
+    m_prefetchTimer = prefetchIntervalSec; // look around on the first update
 }
 
 void AirportDynamicsManager::shutdown()
 {
     m_dynamics.clear();
+    m_prefetcher.reset();
 }
 
 void AirportDynamicsManager::update(double dt)
 {
-    SG_UNUSED(dt);
+    if (!m_prefetcher) {
+        return;
+    }
+
+    m_prefetchTimer += dt;
+    SGGeod pos = globals->get_aircraft_position();
+    double movedNm = SGGeodesy::distanceNm(pos, m_lastPrefetchPos);
+    if ((m_prefetchTimer < prefetchIntervalSec) && (movedNm < prefetchMoveNm)) {
+        return;
+    }
+
+    m_prefetchTimer = 0.0;
+    m_lastPrefetchPos = pos;
+    prefetchNearby();
+}
+
+void AirportDynamicsManager::prefetchNearby()
+{
+    double rangeNm = fgGetDouble("/sim/airport/prefetch/range-nm", 30.0);
+    FGAirport::AirportFilter filter;
+    FGPositionedList airports = FGPositioned::findClosestN(m_lastPrefetchPos,
+        prefetchMaxAirports, rangeNm, &filter);
+
+    // closest first, so the departure airport is ready soonest
+    for (FGPositionedRef p : airports) {
+        m_prefetcher->request(static_cast<FGAirport*>(p.ptr()));
+    }
+}
+
+AirportPrefetcher* AirportDynamicsManager::prefetcher()
+{
+    AirportDynamicsManager* instance = globals->get_subsystem<AirportDynamicsManager>();
+    return instance ? instance->m_prefetcher.get() : NULL;
+}
+
+void AirportDynamicsManager::prefetch(const FGAirportRef& apt)
+{
+    AirportPrefetcher* p = prefetcher();
+    if (p) {
+        p->request(apt);
+    }
 }
 
 void AirportDynamicsManager::reinit()
@@ -26,12 +26,17 @@
 #include <simgear/structure/SGSharedPtr.hxx>
 
 #include <map>
+#include <memory>
+
+#include <simgear/math/SGGeod.hxx>
 
 #include "airports_fwd.hxx"
 
 namespace flightgear
 {
 
+class AirportPrefetcher;
+
 class AirportDynamicsManager : public SGSubsystem
 {
 public:
@@ -50,9 +55,24 @@ public:
     FGAirportDynamicsRef dynamicsForICAO(const std::string& icao);
 
     static const char* subsystemName() { return "airport-dynamics"; }
+
+    /**
+     * The prefetcher loading airport data in the background, null if
+     * disabled or there is no manager.
+     */
+    static AirportPrefetcher* prefetcher();
+
+    /// ask for the data of 'apt' to be loaded in the background
+    static void prefetch(const FGAirportRef& apt);
 private:
+    void prefetchNearby();
+
     typedef std::map<std::string, FGAirportDynamicsRef> ICAODynamicsDict;
     ICAODynamicsDict m_dynamics;
+
+    std::unique_ptr<AirportPrefetcher> m_prefetcher;
+    SGGeod m_lastPrefetchPos;
+    double m_prefetchTimer;
 };
 
 } // of namespace
@@ -0,0 +1,319 @@
+// airportprefetcher.cxx - load airport data ahead of its first use
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "airportprefetcher.hxx"
+
+#include <sstream>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/iostreams/sgstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "airport.hxx"
+#include "groundnetwork.hxx"
+#include "xmlloader.hxx"
+
+namespace flightgear
+{
+
+namespace {
+
+// the scenery file name of each item, in the order of AirportPrefetcher::Item
+const char* itemFileNames[] = {
+    "groundnet",
+    "procedures",
+    "threshold",
+    "twr",
+    "ils"
+};
+
+double nowSec()
+{
+    return SGTimeStamp::now().toSecs();
+}
+
+} // of anonymous namespace
+
+const double AirportPrefetcher::maxAgeSec = 600.0;
+
+class AirportPrefetcher::Worker : public SGThread
+{
+public:
+    explicit Worker(AirportPrefetcher* owner) :
+        _owner(owner)
+    { }
+
+protected:
+    virtual void run()
+    {
+        _owner->run();
+    }
+
+private:
+    AirportPrefetcher* _owner;
+};
+
+AirportPrefetcher::AirportPrefetcher() :
+    _stopping(false)
+{
+}
+
+AirportPrefetcher::~AirportPrefetcher()
+{
+    stop();
+}
+
+void AirportPrefetcher::start(const PathList& sceneryPaths,
+                              const SGPath& groundNetCacheDir)
+{
+    if (_worker) {
+        return;
+    }
+
+    _sceneryPaths = sceneryPaths;
+    _groundNetCacheDir = groundNetCacheDir;
+    _stopping = false;
+    _worker.reset(new Worker(this));
+    _worker->start();
+}
+
+void AirportPrefetcher::stop()
+{
+    if (!_worker) {
+        return;
+    }
+
+    {
+        SGGuard<SGMutex> g(_lock);
+        _stopping = true;
+        _changed.broadcast();
+    }
+
+    _worker->join();
+    _worker.reset();
+
+    // queued entries were not loaded: forget them, so they are queued
+    // again if the prefetcher is restarted, unless the airport took some
+    // of their items already
+    SGGuard<SGMutex> g(_lock);
+    for (Entry* e : _queue) {
+        if (e->taken == 0) {
+            _entries.erase(e->airport->ident());
+        } else {
+            e->state = DONE;
+            e->taken = (1u << NUM_ITEMS) - 1;
+        }
+    }
+    _queue.clear();
+}
+
+void AirportPrefetcher::request(const FGAirportRef& apt)
+{
+    if (!apt || !_worker) {
+        return;
+    }
+
+    SGGuard<SGMutex> g(_lock);
+    std::unique_ptr<Entry>& slot = _entries[apt->ident()];
+    if (slot) {
+        return; // queued, loaded or used before
+    }
+
+    slot.reset(new Entry);
+    slot->airport = apt;
+    _queue.push_back(slot.get());
+    _changed.signal();
+}
+
+int AirportPrefetcher::itemForFile(const std::string& fileName)
+{
+    for (int i = PROCEDURES; i < NUM_ITEMS; ++i) {
+        if (fileName == itemFileNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+AirportPrefetcher::Entry*
+AirportPrefetcher::entryForTake(const FGAirport* apt, Item item)
+{
+    const unsigned bit = 1u << item;
+    EntryDict::iterator it = _entries.find(apt->ident());
+    if (it == _entries.end()) {
+        // the airport loads it itself: remember that, so a later request
+        // does not load it again for nothing
+        Entry* e = new Entry;
+        e->state = DONE;
+        e->taken = bit;
+        e->doneAt = nowSec();
+        _entries[apt->ident()].reset(e);
+        return NULL;
+    }
+
+    Entry* e = it->second.get();
+    if (e->taken & bit) {
+        return NULL;
+    }
+
+    while (e->state == LOADING) {
+        _changed.wait(_lock);
+    }
+
+    // a queued entry is loaded without this item
+    e->taken |= bit;
+    return (e->state == DONE) ? e : NULL;
+}
+
+FGGroundNetwork* AirportPrefetcher::takeGroundNet(const FGAirport* apt)
+{
+    SGGuard<SGMutex> g(_lock);
+    Entry* e = entryForTake(apt, GROUNDNET);
+    return e ? e->groundNet.release() : NULL;
+}
+
+bool AirportPrefetcher::takeFile(const FGAirport* apt, const std::string& fileName,
+                                 bool& found, SGPath& path, std::string& contents)
+{
+    int item = itemForFile(fileName);
+    if (item < 0) {
+        return false;
+    }
+
+    SGGuard<SGMutex> g(_lock);
+    Entry* e = entryForTake(apt, static_cast<Item>(item));
+    if (!e) {
+        return false;
+    }
+
+    File& f = e->files[item];
+    found = f.found;
+    path = f.path;
+    contents.swap(f.contents);
+    f = File();
+    return true;
+}
+
+void AirportPrefetcher::run()
+{
+    for (;;) {
+        Entry* e;
+        unsigned skip;
+        {
+            SGGuard<SGMutex> g(_lock);
+            while (_queue.empty() && !_stopping) {
+                _changed.wait(_lock);
+            }
+
+            if (_stopping) {
+                return;
+            }
+
+            e = _queue.front();
+            _queue.pop_front();
+            e->state = LOADING;
+            skip = e->taken;
+        }
+
+        // the entry stays while it is LOADING, and nobody else touches its
+        // data until it is DONE
+        unsigned failed = load(e, skip);
+
+        SGGuard<SGMutex> g(_lock);
+        e->state = DONE;
+        e->taken |= failed;
+        e->doneAt = nowSec();
+        expire(e->doneAt);
+        _changed.broadcast();
+    }
+}
+
+unsigned AirportPrefetcher::load(Entry* e, unsigned skip)
+{
+    const std::string& ident = e->airport->ident();
+    unsigned failed = 0;
+
+    if (!(skip & (1u << GROUNDNET))) {
+        std::unique_ptr<FGGroundNetwork> net(new FGGroundNetwork(e->airport.ptr()));
+        SGPath path;
+        if (XMLLoader::findAirportData(ident, "groundnet", _sceneryPaths, path)) {
+            XMLLoader::loadGroundNet(net.get(), path, _groundNetCacheDir);
+        }
+        net->init();
+        e->groundNet = std::move(net);
+    }
+
+    for (int i = PROCEDURES; i < NUM_ITEMS; ++i) {
+        if (skip & (1u << i)) {
+            continue;
+        }
+
+        File& f = e->files[i];
+        if (!XMLLoader::findAirportData(ident, itemFileNames[i], _sceneryPaths, f.path)) {
+            continue; // nothing to read, which is a result as well
+        }
+
+        sg_ifstream in(f.path, std::ios::in | std::ios::binary);
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        if (!in) {
+            // let the airport load it the usual way, and report the error
+            failed |= 1u << i;
+            continue;
+        }
+
+        f.found = true;
+        f.contents = contents.str();
+    }
+
+    SG_LOG(SG_NAVAID, SG_DEBUG, "prefetched data of " << ident);
+    return failed;
+}
+
+void AirportPrefetcher::expire(double now)
+{
+    const unsigned allItems = (1u << NUM_ITEMS) - 1;
+    EntryDict::iterator it = _entries.begin();
+    while (it != _entries.end()) {
+        Entry* e = it->second.get();
+        if ((e->state != DONE) || (e->taken == allItems) ||
+            (now - e->doneAt < maxAgeSec))
+        {
+            ++it;
+            continue;
+        }
+
+        if (e->taken == 0) {
+            // never used: forget it entirely, so it is prefetched again
+            // when the airport comes into range again
+            _entries.erase(it++);
+        } else {
+            // the airport has the rest already, only free the leftovers
+            e->groundNet.reset();
+            for (int i = 0; i < NUM_ITEMS; ++i) {
+                e->files[i] = File();
+            }
+            e->taken = allItems;
+            ++it;
+        }
+    }
+}
+
+} // of namespace flightgear
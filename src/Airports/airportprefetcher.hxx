@@ -0,0 +1,140 @@
+// airportprefetcher.hxx - load airport data ahead of its first use
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef AIRPORT_PREFETCHER_HXX
+#define AIRPORT_PREFETCHER_HXX
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/threads/SGThread.hxx>
+
+#include "airports_fwd.hxx"
+
+namespace flightgear
+{
+
+/**
+ * Loads the ground network of airports which are likely to be needed soon
+ * on a thread of its own, and reads their other per-airport XML files
+ * (procedures, threshold, twr, ils) into memory. Those are parsed on the
+ * main thread when they are first used, since that resolves navaids and
+ * runways through the NavDataCache; what is saved is the scenery search
+ * and the disk access.
+ *
+ * FGAirport takes the results on first use. If the data is not ready yet,
+ * it is either waited for (already being loaded) or loaded by the caller
+ * as before (still queued); the prefetcher then skips it.
+ */
+class AirportPrefetcher
+{
+public:
+    AirportPrefetcher();
+    ~AirportPrefetcher();
+
+    /**
+     * Start the loader thread. The scenery paths and the groundnet cache
+     * directory (null to not use one) are fixed from then on.
+     */
+    void start(const PathList& sceneryPaths, const SGPath& groundNetCacheDir);
+    void stop();
+
+    /// queue the data of 'apt', unless that happened before
+    void request(const FGAirportRef& apt);
+
+    /**
+     * The ground network of 'apt', loaded and initialised. Returns null if
+     * it was not prefetched, ownership passes to the caller otherwise.
+     */
+    FGGroundNetwork* takeGroundNet(const FGAirport* apt);
+
+    /**
+     * The contents of the XML file 'fileName' ("procedures", "twr", ...) of
+     * 'apt'. Returns false if it was not prefetched, otherwise 'found' tells
+     * if the scenery has the file at all.
+     */
+    bool takeFile(const FGAirport* apt, const std::string& fileName,
+                  bool& found, SGPath& path, std::string& contents);
+
+    /// drop results nobody took for this many seconds
+    static const double maxAgeSec;
+
+private:
+    enum Item {
+        GROUNDNET = 0,
+        PROCEDURES,
+        THRESHOLD,
+        TOWER,
+        ILS,
+        NUM_ITEMS
+    };
+
+    enum State {
+        QUEUED,
+        LOADING,
+        DONE
+    };
+
+    struct File {
+        File() : found(false) {}
+        bool found;
+        SGPath path;
+        std::string contents;
+    };
+
+    struct Entry {
+        Entry() : state(QUEUED), taken(0), doneAt(0) {}
+        FGAirportRef airport;
+        State state;
+        unsigned taken;     ///< bit per Item, set once the airport has it
+        std::unique_ptr<FGGroundNetwork> groundNet;
+        File files[NUM_ITEMS];
+        double doneAt;      ///< SGTimeStamp seconds
+    };
+
+    class Worker;
+
+    static int itemForFile(const std::string& fileName);
+
+    /// the entry of 'apt' once 'item' may be taken from it, or null if the
+    /// prefetcher does not have it. Called with the lock held.
+    Entry* entryForTake(const FGAirport* apt, Item item);
+
+    void run();
+    /// load the items not in 'skip', returns those which failed
+    unsigned load(Entry* e, unsigned skip);
+    void expire(double now);
+
+    typedef std::map<std::string, std::unique_ptr<Entry> > EntryDict;
+
+    SGMutex _lock;
+    SGWaitCondition _changed;
+    EntryDict _entries;
+    std::deque<Entry*> _queue;
+    bool _stopping;
+
+    PathList _sceneryPaths;
+    SGPath _groundNetCacheDir;
+    std::unique_ptr<Worker> _worker;
+};
+
+} // of namespace flightgear
+
+#endif // AIRPORT_PREFETCHER_HXX
@@ -45,7 +45,6 @@
 #include <cstddef>              // std::size_t
 #include <string>
 #include <vector>
-#include <utility>              // std::pair, std::move()
 
 #include "airport.hxx"
 #include "runways.hxx"
@@ -75,9 +74,31 @@ static FGPositioned::Type fptypeFromRobinType(unsigned int aType)
 
 namespace flightgear
 {
+// Size of the buffer apt.dat files are decompressed into. It only grows if a
+// single line doesn't fit.
+static const std::size_t readBufferSize = 4 * 1024 * 1024;
+
+bool APTLoader::Token::operator==(const char* s) const
+{
+  return strlen(s) == size && memcmp(data, s, size) == 0;
+}
+
+double APTLoader::Token::toDouble() const
+{
+  return atof(data);
+}
+
+int APTLoader::Token::toInt() const
+{
+  return atoi(data);
+}
+
 APTLoader::APTLoader()
-  :  last_apt_id(""),
+  :  skipAirport(true),
+     nbLoadedAirports(0),
+     last_apt_id(""),
      last_apt_elev(0.0),
+     pavement(false),
      currentAirportPosID(0),
      cache(NavDataCache::instance())
 { }
@@ -99,226 +120,242 @@ void APTLoader::readAptDatFile(const SGPath &aptdb_file,
                           sg_location(aptdb_file));
   }
 
-  string line;
-
-  unsigned int rowCode = 0;     // terminology used in the apt.dat format spec
+  // The file is decompressed into a large buffer and its complete lines are
+  // parsed in place. An incomplete last line is moved to the front of the
+  // buffer, to be completed by the next read. The extra byte is for the NUL
+  // after the last line of the file, which may have no terminator.
+  vector<char> buffer(readBufferSize + 1);
+  std::size_t carried = 0;
   unsigned int line_num = 0;
-  // "airport identifier": terminology used in the apt.dat format spec. It is
-  // often an ICAO code, but not always.
-  string currentAirportId;
-  // Boolean used to make sure we don't try to load the same airport several
-  // times. Defaults to true only to ensure we don't add garbage to
-  // 'airportInfoMap' under the key "" (empty airport identifier) in case the
-  // apt.dat file doesn't have a start-of-airport row code (1, 16 or 17) after
-  // its header---which would be invalid, anyway.
-  bool skipAirport = true;
-
-  // Read the apt.dat header (two lines)
-  while ( line_num < 2 && std::getline(in, line) ) {
-    // 'line' may end with an \r character (tested on Linux, only \n was
-    // stripped: std::getline() only discards the _native_ line terminator)
-    line_num++;
-
-    if ( line_num == 1 ) {
-      std::string stripped_line = simgear::strutils::strip(line);
-      // First line indicates IBM ("I") or Macintosh ("A") line endings.
-      if ( stripped_line != "I" && stripped_line != "A" ) {
-        std::string pb = "invalid first line (neither 'I' nor 'A')";
-        SG_LOG( SG_GENERAL, SG_ALERT, aptdb_file << ": " << pb);
-        throw sg_format_exception("cannot parse '" + apt_dat + "': " + pb,
-                                  stripped_line);
+  bool eof = false;
+  // Don't add lines to whatever airport the previous file ended with, in
+  // case this one has no start-of-airport row code (1, 16 or 17) after its
+  // header---which would be invalid, anyway.
+  skipAirport = true;
+
+  while ( !eof ) {
+    in.read(&buffer[carried], buffer.size() - 1 - carried);
+    throwExceptionIfStreamError(in, aptdb_file);
+    eof = in.eof();
+
+    const std::size_t filled = carried + static_cast<std::size_t>(in.gcount());
+    buffer[filled] = '\0';
+    const char* p = &buffer[0];
+    const char* const end = p + filled;
+
+    while ( p < end ) {
+      const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+      if ( !eol ) {
+        if ( !eof )
+          break;                // completed by the next read
+        eol = end;
       }
-    } else {     // second line of the file
-      std::istringstream s(line);
-      int apt_dat_format_version;
-      s >> apt_dat_format_version;
-      SG_LOG( SG_GENERAL, SG_INFO,
-              "apt.dat format version (" << apt_dat << "): " <<
-              apt_dat_format_version );
-    }
-  } // end of the apt.dat header
-
-  throwExceptionIfStreamError(in, aptdb_file);
-
-  while ( std::getline(in, line) ) {
-    // 'line' may end with an \r character, see above
-    line_num++;
-
-    if ( isBlankOrCommentLine(line) )
-      continue;
-
-    if ((line_num % 100) == 0) {
-      // every 100 lines
-      unsigned int percent = ((bytesReadSoFar + in.approxOffset()) * 100)
-                             / totalSizeOfAllAptDatFiles;
-      cache->setRebuildPhaseProgress(
-        NavDataCache::REBUILD_READING_APT_DAT_FILES, percent);
-    }
-
-    // Extract the first field into 'rowCode'
-    rowCode = atoi(line.c_str());
-
-    if ( rowCode == 1  /* Airport */ ||
-         rowCode == 16 /* Seaplane base */ ||
-         rowCode == 17 /* Heliport */ ) {
-      vector<string> tokens(simgear::strutils::split(line));
-      if (tokens.size() < 6) {
-        SG_LOG( SG_GENERAL, SG_WARN,
-                apt_dat << ":"  << line_num << ": invalid airport header "
-                "(at least 6 fields are required)" );
-        skipAirport = true; // discard everything until the next airport header
+      // The line may end with an \r character: only \n is a terminator here
+      const char* line = p;
+      p = (eol < end) ? eol + 1 : end;
+      line_num++;
+
+      if ( line_num == 1 ) {
+        std::string stripped_line =
+          simgear::strutils::strip(std::string(line, eol));
+        // First line indicates IBM ("I") or Macintosh ("A") line endings.
+        if ( stripped_line != "I" && stripped_line != "A" ) {
+          std::string pb = "invalid first line (neither 'I' nor 'A')";
+          SG_LOG( SG_GENERAL, SG_ALERT, aptdb_file << ": " << pb);
+          throw sg_format_exception("cannot parse '" + apt_dat + "': " + pb,
+                                    stripped_line);
+        }
+        continue;
+      } else if ( line_num == 2 ) {
+        std::istringstream s(std::string(line, eol));
+        int apt_dat_format_version;
+        s >> apt_dat_format_version;
+        SG_LOG( SG_GENERAL, SG_INFO,
+                "apt.dat format version (" << apt_dat << "): " <<
+                apt_dat_format_version );
         continue;
       }
 
-      currentAirportId = tokens[4]; // often an ICAO, but not always
-      // Check if the airport is already in 'airportInfoMap'; get the
-      // existing entry, if any, otherwise insert a new one.
-      std::pair<AirportInfoMapType::iterator, bool>
-        insertRetval = airportInfoMap.insert(
-          AirportInfoMapType::value_type(currentAirportId, RawAirportInfo()));
-      skipAirport = !insertRetval.second;
+      if ( isBlankOrCommentLine(line, eol) )
+        continue;
 
-      if ( skipAirport ) {
-        SG_LOG( SG_GENERAL, SG_INFO,
-                apt_dat << ":"  << line_num << ": skipping airport " <<
-                currentAirportId << " (already defined earlier)" );
-      } else {
-        // We haven't seen this airport yet in any apt.dat file
-        RawAirportInfo& airportInfo = insertRetval.first->second;
-        airportInfo.file = aptdb_file;
-        airportInfo.rowCode = rowCode;
-        airportInfo.firstLineNum = line_num;
-        airportInfo.firstLineTokens = std::move(tokens);
+      if ((line_num % 100) == 0) {
+        // every 100 lines
+        unsigned int percent = ((bytesReadSoFar + in.approxOffset()) * 100)
+                               / totalSizeOfAllAptDatFiles;
+        cache->setRebuildPhaseProgress(
+          NavDataCache::REBUILD_READING_APT_DAT_FILES, percent);
       }
-    } else if ( rowCode == 99 ) {
-      SG_LOG( SG_GENERAL, SG_DEBUG,
-              apt_dat << ":"  << line_num << ": code 99 found "
-              "(normally at end of file)" );
-    } else if ( !skipAirport ) {
-      // Line belonging to an already started, and not skipped airport entry;
-      // just append it.
-      airportInfoMap[currentAirportId].otherLines.emplace_back(
-        line_num, rowCode, line);
+
+      parseLine(apt_dat, line_num, line, eol);
+    } // of loop over the complete lines in 'buffer'
+
+    carried = end - p;
+    if ( carried == buffer.size() - 1 ) {
+      // A single line fills the whole buffer
+      buffer.resize(2 * buffer.size());
+    } else if ( carried > 0 ) {
+      memmove(&buffer[0], p, carried);
     }
   } // of file reading loop
 
-  throwExceptionIfStreamError(in, aptdb_file);
+  finishAirport(apt_dat);
 }
 
 void APTLoader::loadAirports()
 {
-  AirportInfoMapType::size_type nbLoadedAirports = 0;
-  AirportInfoMapType::size_type nbAirports = airportInfoMap.size();
-
-  // Loop over all airports found in all apt.dat files
-  for (AirportInfoMapType::const_iterator it = airportInfoMap.begin();
-       it != airportInfoMap.end(); it++) {
-    // Full path to the apt.dat file this airport info comes from
-    const string aptDat = it->second.file.utf8Str();
-    last_apt_id = it->first;    // this is just the current airport identifier
-    // The first line for this airport was already split over whitespace, but
-    // remains to be parsed for the most part.
-    parseAirportLine(it->second.rowCode, it->second.firstLineTokens);
-    const LinesList& lines = it->second.otherLines;
-
-    // Loop over the second and subsequent lines
-    for (LinesList::const_iterator linesIt = lines.begin();
-         linesIt != lines.end(); linesIt++) {
-      // Beware that linesIt->str may end with an '\r' character, see above!
-      unsigned int rowCode = linesIt->rowCode;
-
-      if ( rowCode == 10 ) { // Runway v810
-        parseRunwayLine810(aptDat, linesIt->number,
-                           simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 100 ) { // Runway v850
-        parseRunwayLine850(aptDat, linesIt->number,
-                           simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 101 ) { // Water Runway v850
-        parseWaterRunwayLine850(aptDat, linesIt->number,
-                                simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 102 ) { // Helipad v850
-        parseHelipadLine850(aptDat, linesIt->number,
-                            simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 18 ) {
-        // beacon entry (ignore)
-      } else if ( rowCode == 14 ) {  // Viewpoint/control tower
-        parseViewpointLine(aptDat, linesIt->number,
-                           simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 19 ) {
-        // windsock entry (ignore)
-      } else if ( rowCode == 20 ) {
-        // Taxiway sign (ignore)
-      } else if ( rowCode == 21 ) {
-        // lighting objects (ignore)
-      } else if ( rowCode == 15 ) {
-        // custom startup locations (ignore)
-      } else if ( rowCode == 0 ) {
-        // ??
-      } else if ( rowCode >= 50 && rowCode <= 56) {
-        parseCommLine(aptDat, linesIt->number, rowCode,
-                      simgear::strutils::split(linesIt->str));
-      } else if ( rowCode == 110 ) {
-        pavement = true;
-        parsePavementLine850(simgear::strutils::split(linesIt->str, 0, 4));
-      } else if ( rowCode >= 111 && rowCode <= 114 ) {
-        if ( pavement )
-          parsePavementNodeLine850(aptDat, linesIt->number, rowCode,
-                                   simgear::strutils::split(linesIt->str));
-      } else if ( rowCode >= 115 && rowCode <= 116 ) {
-        // other pavement nodes (ignore)
-      } else if ( rowCode == 120 ) {
-        pavement = false;
-      } else if ( rowCode == 130 ) {
-        pavement = false;
-      } else if ( rowCode >= 1000 ) {
-        // airport traffic flow (ignore)
-      } else {
-        std::ostringstream oss;
-        string cleanedLine = cleanLine(linesIt->str);
-        oss << aptDat << ":" << linesIt->number << ": unknown row code " <<
-          rowCode;
-        SG_LOG( SG_GENERAL, SG_ALERT, oss.str() << " (" << cleanedLine << ")" );
-        throw sg_format_exception(oss.str(), cleanedLine);
-      }
-    } // of loop over the second and subsequent apt.dat lines for the airport
+  // Airports are loaded as their apt.dat file is read; nothing is left to do
+  // but to report.
+  SG_LOG( SG_GENERAL, SG_INFO,
+          "Loaded data for " << nbLoadedAirports << " airports" );
+}
 
-    finishAirport(aptDat);
-    nbLoadedAirports++;
+void APTLoader::parseLine(const string& aptDat, unsigned int lineNum,
+                          const char* begin, const char* end)
+{
+  // Extract the first field into 'rowCode'. The line is not blank, so this
+  // doesn't read past its end.
+  unsigned int rowCode = atoi(begin); // terminology of the apt.dat format spec
+
+  if ( rowCode == 1  /* Airport */ ||
+       rowCode == 16 /* Seaplane base */ ||
+       rowCode == 17 /* Heliport */ ) {
+    finishAirport(aptDat);      // the previous one, if any
+    tokenize(begin, end);
+
+    if (tokens.size() < 6) {
+      SG_LOG( SG_GENERAL, SG_WARN,
+              aptDat << ":"  << lineNum << ": invalid airport header "
+              "(at least 6 fields are required)" );
+      skipAirport = true; // discard everything until the next airport header
+      return;
+    }
+
+    // "airport identifier": terminology used in the apt.dat format spec. It
+    // is often an ICAO code, but not always.
+    const string airportId = tokens[4].str();
+    // Make sure we don't load the same airport several times
+    skipAirport = !knownAirports.insert(airportId).second;
 
-    if ((nbLoadedAirports % 300) == 0) {
-      // Every 300 airports
-      unsigned int percent = nbLoadedAirports * 100 / nbAirports;
-      cache->setRebuildPhaseProgress(NavDataCache::REBUILD_LOADING_AIRPORTS,
-                                     percent);
+    if ( skipAirport ) {
+      SG_LOG( SG_GENERAL, SG_INFO,
+              aptDat << ":"  << lineNum << ": skipping airport " <<
+              airportId << " (already defined earlier)" );
+      return;
     }
-  } // of loop over 'airportInfoMap'
 
-  SG_LOG( SG_GENERAL, SG_INFO,
-          "Loaded data for " << nbLoadedAirports << " airports" );
+    last_apt_id = airportId;
+    parseAirportLine(rowCode, tokens);
+    nbLoadedAirports++;
+  } else if ( rowCode == 99 ) {
+    SG_LOG( SG_GENERAL, SG_DEBUG,
+            aptDat << ":"  << lineNum << ": code 99 found "
+            "(normally at end of file)" );
+  } else if ( skipAirport ) {
+    // line of a skipped airport
+  } else if ( rowCode == 10 ) { // Runway v810
+    tokenize(begin, end);
+    parseRunwayLine810(aptDat, lineNum, tokens);
+  } else if ( rowCode == 100 ) { // Runway v850
+    tokenize(begin, end);
+    parseRunwayLine850(aptDat, lineNum, tokens);
+  } else if ( rowCode == 101 ) { // Water Runway v850
+    tokenize(begin, end);
+    parseWaterRunwayLine850(aptDat, lineNum, tokens);
+  } else if ( rowCode == 102 ) { // Helipad v850
+    tokenize(begin, end);
+    parseHelipadLine850(aptDat, lineNum, tokens);
+  } else if ( rowCode == 18 ) {
+    // beacon entry (ignore)
+  } else if ( rowCode == 14 ) {  // Viewpoint/control tower
+    tokenize(begin, end);
+    parseViewpointLine(aptDat, lineNum, tokens);
+  } else if ( rowCode == 19 ) {
+    // windsock entry (ignore)
+  } else if ( rowCode == 20 ) {
+    // Taxiway sign (ignore)
+  } else if ( rowCode == 21 ) {
+    // lighting objects (ignore)
+  } else if ( rowCode == 15 ) {
+    // custom startup locations (ignore)
+  } else if ( rowCode == 0 ) {
+    // ??
+  } else if ( rowCode >= 50 && rowCode <= 56) {
+    tokenize(begin, end);
+    parseCommLine(aptDat, lineNum, rowCode, tokens);
+  } else if ( rowCode == 110 ) {
+    pavement = true;
+    tokenize(begin, end, 4);
+    parsePavementLine850(tokens);
+  } else if ( rowCode >= 111 && rowCode <= 114 ) {
+    if ( pavement ) {
+      tokenize(begin, end);
+      parsePavementNodeLine850(aptDat, lineNum, rowCode, tokens);
+    }
+  } else if ( rowCode >= 115 && rowCode <= 116 ) {
+    // other pavement nodes (ignore)
+  } else if ( rowCode == 120 ) {
+    pavement = false;
+  } else if ( rowCode == 130 ) {
+    pavement = false;
+  } else if ( rowCode >= 1000 ) {
+    // airport traffic flow (ignore)
+  } else {
+    std::ostringstream oss;
+    string cleanedLine = cleanLine(begin, end);
+    oss << aptDat << ":" << lineNum << ": unknown row code " << rowCode;
+    SG_LOG( SG_GENERAL, SG_ALERT, oss.str() << " (" << cleanedLine << ")" );
+    throw sg_format_exception(oss.str(), cleanedLine);
+  }
 }
 
 // Tell whether an apt.dat line is blank or a comment line
-bool APTLoader::isBlankOrCommentLine(const std::string& line)
+bool APTLoader::isBlankOrCommentLine(const char* begin, const char* end)
 {
-  size_t pos = line.find_first_not_of(" \t");
-  return ( pos == std::string::npos ||
-           line[pos] == '\r' ||
-           line.find("##", pos) == pos );
+  const char* p = begin;
+  while ( p < end && (*p == ' ' || *p == '\t') )
+    p++;
+
+  return ( p == end || *p == '\r' ||
+           (end - p >= 2 && p[0] == '#' && p[1] == '#') );
 }
 
-std::string APTLoader::cleanLine(const std::string& line)
+std::string APTLoader::cleanLine(const char* begin, const char* end)
 {
-  std::string res = line;
-
-  // Lines obtained from readAptDatFile() may end with \r, which can be quite
-  // confusing when printed to the terminal.
-  for (std::string::reverse_iterator it = res.rbegin();
-       it != res.rend() && *it == '\r'; /* empty */)
-  { // The beauty of C++ iterators...
-    it = std::string::reverse_iterator(res.erase( (it+1).base() ));
-  }
+  // Lines may end with \r, which can be quite confusing when printed to the
+  // terminal.
+  while ( end > begin && end[-1] == '\r' )
+    end--;
+
+  return std::string(begin, end);
+}
+
+void APTLoader::tokenize(const char* begin, const char* end,
+                         std::size_t maxSplit)
+{
+  tokens.clear();
+  const char* p = begin;
 
-  return res;
+  while ( p < end && isspace(static_cast<unsigned char>(*p)) )
+    p++;
+
+  while ( p < end ) {
+    const char* start = p;
+    while ( p < end && !isspace(static_cast<unsigned char>(*p)) )
+      p++;
+
+    Token token = { start, static_cast<std::size_t>(p - start) };
+    tokens.push_back(token);
+
+    while ( p < end && isspace(static_cast<unsigned char>(*p)) )
+      p++;
+
+    if ( maxSplit && tokens.size() >= maxSplit && p < end ) {
+      Token rest = { p, static_cast<std::size_t>(end - p) };
+      tokens.push_back(rest);
+      break;
+    }
+  }
 }
 
 void APTLoader::throwExceptionIfStreamError(const sg_gzifstream& input_stream,
@@ -359,20 +396,20 @@ void APTLoader::finishAirport(const string& aptDat)
 // 'rowCode' is passed to avoid decoding it twice, since that work was already
 // done in order to detect the start of the new airport.
 void APTLoader::parseAirportLine(unsigned int rowCode,
-                                 const vector<string>& token)
+                                 const TokenList& token)
 {
-  // The algorithm in APTLoader::readAptDatFile() ensures this is at least 5.
-  vector<string>::size_type lastIndex = token.size() - 1;
-  const string& id(token[4]);
-  double elev = atof( token[1].c_str() );
+  // APTLoader::parseLine() ensures this is at least 5.
+  TokenList::size_type lastIndex = token.size() - 1;
+  const string id(token[4].str());
+  double elev = token[1].toDouble();
   last_apt_elev = elev;
 
   string name;
   // build the name
-  for ( vector<string>::size_type i = 5; i < lastIndex; ++i ) {
-    name += token[i] + " ";
+  for ( TokenList::size_type i = 5; i < lastIndex; ++i ) {
+    name += token[i].str() + " ";
   }
-  name += token[lastIndex];
+  name += token[lastIndex].str();
 
   // clear runway list for start of next airport
   rwy_lon_accum = 0.0;
@@ -384,7 +421,7 @@ void APTLoader::parseAirportLine(unsigned int rowCode,
 }
 
 void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
-                                   const vector<string>& token)
+                                   const TokenList& token)
 {
   if (token.size() < 11) {
     SG_LOG( SG_GENERAL, SG_WARN,
@@ -393,17 +430,17 @@ void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
     return;
   }
 
-  double lat = atof( token[1].c_str() );
-  double lon = atof( token[2].c_str() );
+  double lat = token[1].toDouble();
+  double lon = token[2].toDouble();
   rwy_lat_accum += lat;
   rwy_lon_accum += lon;
   rwy_count++;
 
-  const string& rwy_no(token[3]);
+  const string rwy_no(token[3].str());
 
-  double heading = atof( token[4].c_str() );
-  double length = atoi( token[5].c_str() );
-  double width = atoi( token[8].c_str() );
+  double heading = token[4].toDouble();
+  double length = token[5].toInt();
+  double width = token[8].toInt();
   length *= SG_FEET_TO_METER;
   width *= SG_FEET_TO_METER;
 
@@ -413,7 +450,7 @@ void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
 
   last_rwy_heading = heading;
 
-  int surface_code = atoi( token[10].c_str() );
+  int surface_code = token[10].toInt();
 
   if (rwy_no[0] == 'x') {  // Taxiway
     cache->insertRunway(
@@ -425,7 +462,7 @@ void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
                         heading, length, width, 0.0, 0.0, surface_code);
   } else {
     // (pair of) runways
-    string rwy_displ_threshold = token[6];
+    string rwy_displ_threshold = token[6].str();
     vector<string> displ
       = simgear::strutils::split( rwy_displ_threshold, "." );
     double displ_thresh1 = atof( displ[0].c_str() );
@@ -433,7 +470,7 @@ void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
     displ_thresh1 *= SG_FEET_TO_METER;
     displ_thresh2 *= SG_FEET_TO_METER;
 
-    string rwy_stopway = token[7];
+    string rwy_stopway = token[7].str();
     vector<string> stop
       = simgear::strutils::split( rwy_stopway, "." );
     double stopway1 = atof( stop[0].c_str() );
@@ -461,7 +498,7 @@ void APTLoader::parseRunwayLine810(const string& aptDat, unsigned int lineNum,
 }
 
 void APTLoader::parseRunwayLine850(const string& aptDat, unsigned int lineNum,
-                                   const vector<string>& token)
+                                   const TokenList& token)
 {
   if (token.size() < 26) {
     SG_LOG( SG_GENERAL, SG_WARN,
@@ -470,18 +507,18 @@ void APTLoader::parseRunwayLine850(const string& aptDat, unsigned int lineNum,
     return;
   }
 
-  double width = atof( token[1].c_str() );
-  int surface_code = atoi( token[2].c_str() );
+  double width = token[1].toDouble();
+  int surface_code = token[2].toInt();
 
-  double lat_1 = atof( token[9].c_str() );
-  double lon_1 = atof( token[10].c_str() );
+  double lat_1 = token[9].toDouble();
+  double lon_1 = token[10].toDouble();
   SGGeod pos_1(SGGeod::fromDegFt(lon_1, lat_1, 0.0));
   rwy_lat_accum += lat_1;
   rwy_lon_accum += lon_1;
   rwy_count++;
 
-  double lat_2 = atof( token[18].c_str() );
-  double lon_2 = atof( token[19].c_str() );
+  double lat_2 = token[18].toDouble();
+  double lon_2 = token[19].toDouble();
   SGGeod pos_2(SGGeod::fromDegFt(lon_2, lat_2, 0.0));
   rwy_lat_accum += lat_2;
   rwy_lon_accum += lon_2;
@@ -492,16 +529,16 @@ void APTLoader::parseRunwayLine850(const string& aptDat, unsigned int lineNum,
 
   last_rwy_heading = heading_1;
 
-  const string& rwy_no_1(token[8]);
-  const string& rwy_no_2(token[17]);
+  const string rwy_no_1(token[8].str());
+  const string rwy_no_2(token[17].str());
   if ( rwy_no_1.empty() || rwy_no_2.empty() ) // these tests are weird...
     return;
 
-  double displ_thresh1 = atof( token[11].c_str() );
-  double displ_thresh2 = atof( token[20].c_str() );
+  double displ_thresh1 = token[11].toDouble();
+  double displ_thresh2 = token[20].toDouble();
 
-  double stopway1 = atof( token[12].c_str() );
-  double stopway2 = atof( token[21].c_str() );
+  double stopway1 = token[12].toDouble();
+  double stopway2 = token[21].toDouble();
 
   PositionedID rwy = cache->insertRunway(FGPositioned::RUNWAY, rwy_no_1, pos_1,
                                          currentAirportPosID, heading_1, length,
@@ -520,7 +557,7 @@ void APTLoader::parseRunwayLine850(const string& aptDat, unsigned int lineNum,
 
 void APTLoader::parseWaterRunwayLine850(const string& aptDat,
                                         unsigned int lineNum,
-                                        const vector<string>& token)
+                                        const TokenList& token)
 {
   if (token.size() < 9) {
     SG_LOG( SG_GENERAL, SG_WARN,
@@ -529,17 +566,17 @@ void APTLoader::parseWaterRunwayLine850(const string& aptDat,
     return;
   }
 
-  double width = atof( token[1].c_str() );
+  double width = token[1].toDouble();
 
-  double lat_1 = atof( token[4].c_str() );
-  double lon_1 = atof( token[5].c_str() );
+  double lat_1 = token[4].toDouble();
+  double lon_1 = token[5].toDouble();
   SGGeod pos_1(SGGeod::fromDegFt(lon_1, lat_1, 0.0));
   rwy_lat_accum += lat_1;
   rwy_lon_accum += lon_1;
   rwy_count++;
 
-  double lat_2 = atof( token[7].c_str() );
-  double lon_2 = atof( token[8].c_str() );
+  double lat_2 = token[7].toDouble();
+  double lon_2 = token[8].toDouble();
   SGGeod pos_2(SGGeod::fromDegFt(lon_2, lat_2, 0.0));
   rwy_lat_accum += lat_2;
   rwy_lon_accum += lon_2;
@@ -550,8 +587,8 @@ void APTLoader::parseWaterRunwayLine850(const string& aptDat,
 
   last_rwy_heading = heading_1;
 
-  const string& rwy_no_1(token[3]);
-  const string& rwy_no_2(token[6]);
+  const string rwy_no_1(token[3].str());
+  const string rwy_no_2(token[6].str());
 
   PositionedID rwy = cache->insertRunway(FGPositioned::RUNWAY, rwy_no_1, pos_1,
                                          currentAirportPosID, heading_1, length,
@@ -567,7 +604,7 @@ void APTLoader::parseWaterRunwayLine850(const string& aptDat,
 }
 
 void APTLoader::parseHelipadLine850(const string& aptDat, unsigned int lineNum,
-                                    const vector<string>& token)
+                                    const TokenList& token)
 {
   if (token.size() < 12) {
     SG_LOG( SG_GENERAL, SG_WARN,
@@ -576,22 +613,22 @@ void APTLoader::parseHelipadLine850(const string& aptDat, unsigned int lineNum,
     return;
   }
 
-  double length = atof( token[5].c_str() );
-  double width = atof( token[6].c_str() );
+  double length = token[5].toDouble();
+  double width = token[6].toDouble();
 
-  double lat = atof( token[2].c_str() );
-  double lon = atof( token[3].c_str() );
+  double lat = token[2].toDouble();
+  double lon = token[3].toDouble();
   SGGeod pos(SGGeod::fromDegFt(lon, lat, 0.0));
   rwy_lat_accum += lat;
   rwy_lon_accum += lon;
   rwy_count++;
 
-  double heading = atof( token[4].c_str() );
+  double heading = token[4].toDouble();
 
   last_rwy_heading = heading;
 
-  const string& rwy_no(token[1]);
-  int surface_code = atoi( token[7].c_str() );
+  const string rwy_no(token[1].str());
+  int surface_code = token[7].toInt();
 
   cache->insertRunway(FGPositioned::HELIPAD, rwy_no, pos,
                       currentAirportPosID, heading, length,
@@ -599,25 +636,25 @@ void APTLoader::parseHelipadLine850(const string& aptDat, unsigned int lineNum,
 }
 
 void APTLoader::parseViewpointLine(const string& aptDat, unsigned int lineNum,
-                                   const vector<string>& token)
+                                   const TokenList& token)
 {
   if (token.size() < 5) {
     SG_LOG( SG_GENERAL, SG_WARN,
             aptDat << ":" << lineNum << ": invalid viewpoint line "
             "(row code 14): at least 5 fields are required" );
   } else {
-    double lat = atof(token[1].c_str());
-    double lon = atof(token[2].c_str());
-    double elev = atof(token[3].c_str());
+    double lat = token[1].toDouble();
+    double lon = token[2].toDouble();
+    double elev = token[3].toDouble();
     tower = SGGeod::fromDegFt(lon, lat, elev + last_apt_elev);
     cache->insertTower(currentAirportPosID, tower);
   }
 }
 
-void APTLoader::parsePavementLine850(const vector<string>& token)
+void APTLoader::parsePavementLine850(const TokenList& token)
 {
   if ( token.size() >= 5 ) {
-    pavement_ident = token[4];
+    pavement_ident = token[4].str();
     if ( !pavement_ident.empty() &&
          pavement_ident[pavement_ident.size()-1] == '\r' )
       pavement_ident.erase( pavement_ident.size()-1 );
@@ -628,7 +665,7 @@ void APTLoader::parsePavementLine850(const vector<string>& token)
 
 void APTLoader::parsePavementNodeLine850(const string& aptDat,
                                          unsigned int lineNum, int rowCode,
-                                         const vector<string>& token)
+                                         const TokenList& token)
 {
   static const unsigned int minNbTokens[] = {3, 5, 3, 5};
   assert(111 <= rowCode && rowCode <= 114);
@@ -641,8 +678,8 @@ void APTLoader::parsePavementNodeLine850(const string& aptDat,
     return;
   }
 
-  double lat = atof( token[1].c_str() );
-  double lon = atof( token[2].c_str() );
+  double lat = token[1].toDouble();
+  double lon = token[2].toDouble();
   SGGeod pos(SGGeod::fromDegFt(lon, lat, 0.0));
 
   FGPavement* pvt = 0;
@@ -654,8 +691,8 @@ void APTLoader::parsePavementNodeLine850(const string& aptDat,
     pvt = pavements.back();
   }
   if ( rowCode == 112 || rowCode == 114 ) {
-    double lat_b = atof( token[3].c_str() );
-    double lon_b = atof( token[4].c_str() );
+    double lat_b = token[3].toDouble();
+    double lon_b = token[4].toDouble();
     SGGeod pos_b(SGGeod::fromDegFt(lon_b, lat_b, 0.0));
     pvt->addBezierNode(pos, pos_b, rowCode == 114);
   } else {
@@ -665,7 +702,7 @@ void APTLoader::parsePavementNodeLine850(const string& aptDat,
 
 void APTLoader::parseCommLine(const string& aptDat,
                               unsigned int lineNum, unsigned int rowCode,
-                              const vector<string>& token)
+                              const TokenList& token)
 {
   if (token.size() < 3) {
     SG_LOG( SG_GENERAL, SG_WARN,
@@ -686,7 +723,7 @@ void APTLoader::parseCommLine(const string& aptDat,
                                  last_apt_elev);
 
   // short int representing tens of kHz:
-  int freqKhz = atoi(token[1].c_str()) * 10;
+  int freqKhz = token[1].toInt() * 10;
   int rangeNm = 50;
   FGPositioned::Type ty;
 
@@ -715,9 +752,9 @@ void APTLoader::parseCommLine(const string& aptDat,
 
   // Name can contain whitespace. All tokens after the second token are
   // part of the name.
-  string name = token[2];
+  string name = token[2].str();
   for (size_t i = 3; i < token.size(); ++i)
-    name += ' ' + token[i];
+    name += ' ' + token[i].str();
 
   cache->insertCommStation(ty, name, pos, freqKhz, rangeNm,
                            currentAirportPosID);
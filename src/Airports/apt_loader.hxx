@@ -25,9 +25,10 @@
 #ifndef _FG_APT_LOADER_HXX
 #define _FG_APT_LOADER_HXX
 
+#include <cstddef>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <unordered_set>
 
 #include <simgear/compiler.h>
 #include <simgear/structure/SGSharedPtr.hxx>
@@ -48,79 +49,84 @@ public:
   APTLoader();
   ~APTLoader();
 
-  // Read the specified apt.dat file into 'airportInfoMap'.
+  // Read the specified apt.dat file and load the airports it defines into
+  // the navdata cache. Files are read in priority order: an airport already
+  // loaded from an earlier file is skipped.
   // 'bytesReadSoFar' and 'totalSizeOfAllAptDatFiles' are used for progress
   // information.
   void readAptDatFile(const SGPath& aptdb_file, std::size_t bytesReadSoFar,
                       std::size_t totalSizeOfAllAptDatFiles);
-  // Read all airports gathered in 'airportInfoMap' and load them into the
-  // navdata cache (even in case of overlapping apt.dat files,
-  // 'airportInfoMap' has only one entry per airport).
+  // Finish loading after the last apt.dat file has been read.
   void loadAirports();
 
 private:
-  struct Line
+  // A whitespace-separated field of an apt.dat line. It points into the read
+  // buffer and is only valid while its line is being parsed. A field is
+  // always followed by whitespace or a NUL, so the numeric conversions stop
+  // at its end.
+  struct Token
   {
-    Line(unsigned int number_, unsigned int rowCode_, std::string str_)
-      : number(number_), rowCode(rowCode_), str(str_) { }
-
-    unsigned int number;
-    unsigned int rowCode;         // Terminology of the apt.dat spec
-    std::string str;
-  };
-
-  typedef std::vector<Line> LinesList;
-
-  struct RawAirportInfo
-  {
-    // apt.dat file where the airport was defined
-    SGPath file;
-    // Row code for the airport (1, 16 or 17)
-    unsigned int rowCode;
-    // Line number in the apt.dat file where the airport definition starts
-    unsigned int firstLineNum;
-    // The whitespace-separated strings comprising the first line of the airport
-    // definition
-    std::vector<std::string> firstLineTokens;
-    // Subsequent lines of the airport definition (one element per line)
-    LinesList otherLines;
+    const char* data;
+    std::size_t size;
+
+    bool empty() const { return size == 0; }
+    char operator[](std::size_t i) const { return data[i]; }
+    bool operator==(const char* s) const;
+    std::string str() const { return std::string(data, size); }
+    double toDouble() const;
+    int toInt() const;
   };
 
-  typedef std::unordered_map<std::string, RawAirportInfo> AirportInfoMapType;
+  typedef std::vector<Token> TokenList;
   typedef SGSharedPtr<FGPavement> FGPavementPtr;
 
   APTLoader(const APTLoader&);            // disable copy constructor
   APTLoader& operator=(const APTLoader&); // disable copy-assignment operator
 
   // Tell whether an apt.dat line is blank or a comment line
-  bool isBlankOrCommentLine(const std::string& line);
+  bool isBlankOrCommentLine(const char* begin, const char* end);
   // Return a copy of 'line' with trailing '\r' char(s) removed
-  std::string cleanLine(const std::string& line);
+  std::string cleanLine(const char* begin, const char* end);
+  // Split [begin, end) over whitespace into 'tokens', like
+  // simgear::strutils::split(): with a non-zero 'maxSplit', the rest of the
+  // line after that many fields is returned as one last field.
+  void tokenize(const char* begin, const char* end, std::size_t maxSplit = 0);
   void throwExceptionIfStreamError(const sg_gzifstream& input_stream,
                                    const SGPath& path);
-  void parseAirportLine(unsigned int rowCode,
-                        const std::vector<std::string>& token);
+  // Handle the line [begin, end) (without its terminator) of an apt.dat file
+  // after the header
+  void parseLine(const std::string& aptDat, unsigned int lineNum,
+                 const char* begin, const char* end);
+  void parseAirportLine(unsigned int rowCode, const TokenList& token);
   void finishAirport(const std::string& aptDat);
   void parseRunwayLine810(const std::string& aptDat, unsigned int lineNum,
-                          const std::vector<std::string>& token);
+                          const TokenList& token);
   void parseRunwayLine850(const std::string& aptDat, unsigned int lineNum,
-                          const std::vector<std::string>& token);
+                          const TokenList& token);
   void parseWaterRunwayLine850(const std::string& aptDat, unsigned int lineNum,
-                               const std::vector<std::string>& token);
+                               const TokenList& token);
   void parseHelipadLine850(const std::string& aptDat, unsigned int lineNum,
-                           const std::vector<std::string>& token);
+                           const TokenList& token);
   void parseViewpointLine(const std::string& aptDat, unsigned int lineNum,
-                          const std::vector<std::string>& token);
-  void parsePavementLine850(const std::vector<std::string>& token);
+                          const TokenList& token);
+  void parsePavementLine850(const TokenList& token);
   void parsePavementNodeLine850(
     const std::string& aptDat, unsigned int lineNum, int rowCode,
-    const std::vector<std::string>& token);
+    const TokenList& token);
   void parseCommLine(
     const std::string& aptDat, unsigned int lineNum, unsigned int rowCode,
-    const std::vector<std::string>& token);
-
-  std::vector<std::string> token;
-  AirportInfoMapType airportInfoMap;
+    const TokenList& token);
+
+  // Fields of the line being parsed; reused, so that it stops allocating
+  // once it has seen the longest line.
+  TokenList tokens;
+  // Identifiers of the airports found so far, in any apt.dat file
+  std::unordered_set<std::string> knownAirports;
+  // Lines of the current airport are skipped until the next airport header
+  // (bad header, or airport already defined in an earlier file). Also true
+  // before the first airport header.
+  bool skipAirport;
+  std::size_t nbLoadedAirports;
   double rwy_lat_accum;
   double rwy_lon_accum;
   double last_rwy_heading;
@@ -189,7 +189,9 @@ private:
 #if !defined(FG_TESTLIB)
         SGVec3d cartAirportPos = m_airport->cart();
         FGAIManager* aiManager = globals->get_subsystem<FGAIManager>();
-        for (auto ai : aiManager->get_ai_list()) {
+        std::vector<FGAIBase*> nearby;
+        aiManager->findObjectsInRange(cartAirportPos, 20000, nearby);
+        for (auto ai : nearby) {
             const auto cart = ai->getCartPos();
 
             // 20km cutoff from airport centre
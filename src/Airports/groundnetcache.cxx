@@ -0,0 +1,390 @@
+// groundnetcache.cxx - binary copies of parsed groundnet.xml files
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "groundnetcache.hxx"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/iostreams/sgstream.hxx>
+
+#include <Main/globals.hxx>
+
+#include "airport.hxx"
+#include "groundnetwork.hxx"
+
+using std::string;
+
+namespace {
+
+const uint32_t entryMagic = 0x43474746;  // "FGGC", also detects byte order
+const uint32_t entryFormat = 1;
+
+enum NodeFlags {
+    NODE_PARKING = 1 << 0,
+    NODE_ON_RUNWAY = 1 << 1
+};
+
+class Writer
+{
+public:
+    template <class T>
+    void put(T value)
+    {
+        const char* p = reinterpret_cast<const char*>(&value);
+        _data.insert(_data.end(), p, p + sizeof(T));
+    }
+
+    void putString(const string& s)
+    {
+        put<uint32_t>(s.size());
+        _data.insert(_data.end(), s.begin(), s.end());
+    }
+
+    void putInts(const intVec& v)
+    {
+        put<uint32_t>(v.size());
+        for (int i : v) {
+            put<int32_t>(i);
+        }
+    }
+
+    const std::vector<char>& data() const { return _data; }
+
+private:
+    std::vector<char> _data;
+};
+
+/// Reads from an entry in memory. Running past its end sets failed() and
+/// returns zeros from then on, so a truncated entry is only checked once.
+class Reader
+{
+public:
+    Reader(const char* begin, const char* end) :
+        _p(begin), _end(end), _failed(false)
+    { }
+
+    template <class T>
+    T get()
+    {
+        T value = T();
+        if (!have(sizeof(T))) {
+            return value;
+        }
+        memcpy(&value, _p, sizeof(T));
+        _p += sizeof(T);
+        return value;
+    }
+
+    string getString()
+    {
+        uint32_t n = get<uint32_t>();
+        if (!have(n)) {
+            return string();
+        }
+        string s(_p, n);
+        _p += n;
+        return s;
+    }
+
+    void getInts(intVec& v)
+    {
+        uint32_t n = get<uint32_t>();
+        if (!have(size_t(n) * sizeof(int32_t))) {
+            return;
+        }
+        v.resize(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            v[i] = get<int32_t>();
+        }
+    }
+
+    /// check a count read from the entry against the bytes left, before
+    /// allocating anything for it
+    bool haveItems(uint32_t n, size_t minItemSize)
+    { return have(size_t(n) * minItemSize); }
+
+    bool failed() const { return _failed; }
+    void fail() { _failed = true; }
+
+private:
+    bool have(size_t n)
+    {
+        if (_failed || size_t(_end - _p) < n) {
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const char* _p;
+    const char* _end;
+    bool _failed;
+};
+
+} // of anonymous namespace
+
+FGGroundNetCache::FGGroundNetCache(const SGPath& dir) :
+    _dir(dir)
+{
+}
+
+SGPath FGGroundNetCache::defaultDir()
+{
+    return globals->get_fg_home() / "GroundNetCache";
+}
+
+SGPath FGGroundNetCache::entryPath(const FGGroundNetwork* net) const
+{
+    return _dir / (net->airport()->ident() + ".groundnet.bin");
+}
+
+void FGGroundNetCache::save(const SGPath& source, const FGGroundNetwork* net) const
+{
+    // all nodes the network refers to: first the ones it lists, then the
+    // push-back points of parkings which are not on any segment
+    std::vector<FGTaxiNode*> table;
+    std::map<const FGTaxiNode*, uint32_t> tableIndex;
+    for (const FGTaxiNodeRef& node : net->m_nodes) {
+        tableIndex.insert(std::make_pair(node.ptr(), table.size()));
+        table.push_back(node.ptr());
+    }
+
+    for (size_t i = 0; i < table.size(); ++i) {
+        FGParking* parking = dynamic_cast<FGParking*>(table[i]);
+        FGTaxiNode* pushBack = parking ? parking->getPushBackPoint().ptr() : 0;
+        if (pushBack && tableIndex.find(pushBack) == tableIndex.end()) {
+            tableIndex.insert(std::make_pair(pushBack, table.size()));
+            table.push_back(pushBack);
+        }
+    }
+
+    Writer w;
+    w.put<uint32_t>(entryMagic);
+    w.put<uint32_t>(entryFormat);
+    w.putString(source.utf8Str());
+    w.put<uint64_t>(source.sizeInBytes());
+    w.put<int64_t>(source.modTime());
+
+    w.put<int32_t>(net->version);
+    w.putInts(net->freqAwos);
+    w.putInts(net->freqUnicom);
+    w.putInts(net->freqClearance);
+    w.putInts(net->freqGround);
+    w.putInts(net->freqTower);
+    w.putInts(net->freqApproach);
+
+    w.put<uint32_t>(table.size());
+    w.put<uint32_t>(net->m_nodes.size());
+    for (FGTaxiNode* node : table) {
+        FGParking* parking = dynamic_cast<FGParking*>(node);
+        uint8_t flags = (parking ? NODE_PARKING : 0) |
+                        (node->getIsOnRunway() ? NODE_ON_RUNWAY : 0);
+        w.put<uint8_t>(flags);
+        w.put<int32_t>(node->getIndex());
+        w.put<int32_t>(node->getHoldPointType());
+        w.put<double>(node->geod().getLongitudeRad());
+        w.put<double>(node->geod().getLatitudeRad());
+        w.put<double>(node->geod().getElevationM());
+
+        if (parking) {
+            w.put<double>(parking->getHeading());
+            w.put<double>(parking->getRadius());
+            w.putString(parking->getName());
+            w.putString(parking->getType());
+            w.putString(parking->getCodes());
+            FGTaxiNode* pushBack = parking->getPushBackPoint().ptr();
+            w.put<int32_t>(pushBack ? int32_t(tableIndex[pushBack]) : -1);
+        }
+    }
+
+    w.put<uint32_t>(net->m_parkings.size());
+    for (const FGParkingRef& parking : net->m_parkings) {
+        w.put<uint32_t>(tableIndex[parking.ptr()]);
+    }
+
+    w.put<uint32_t>(net->segments.size());
+    for (const FGTaxiSegment* seg : net->segments) {
+        w.put<uint32_t>(tableIndex[seg->getStart().ptr()]);
+        w.put<uint32_t>(tableIndex[seg->getEnd().ptr()]);
+    }
+
+    // write a temporary file and rename it, so a reader never sees a
+    // partial entry
+    SGPath path = entryPath(net);
+    SGPath tmpPath = path;
+    tmpPath.concat(".tmp");
+    if (!_dir.exists()) {
+        // creates the directory part of the path
+        tmpPath.create_dir(0755);
+    }
+
+    {
+        sg_ofstream out(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(&w.data()[0], w.data().size());
+        if (!out) {
+            SG_LOG(SG_NAVAID, SG_WARN, "failed to write groundnet cache " << tmpPath);
+            return;
+        }
+    }
+
+    if (path.exists()) {
+        path.remove();
+    }
+    if (!tmpPath.rename(path)) {
+        SG_LOG(SG_NAVAID, SG_WARN, "failed to write groundnet cache " << path);
+        tmpPath.remove();
+    }
+}
+
+bool FGGroundNetCache::load(const SGPath& source, FGGroundNetwork* net) const
+{
+    SGPath path = entryPath(net);
+    if (!path.exists()) {
+        return false;
+    }
+
+    std::vector<char> data(path.sizeInBytes());
+    {
+        sg_ifstream in(path, std::ios::in | std::ios::binary);
+        if (data.empty() || !in.read(&data[0], data.size())) {
+            return false;
+        }
+    }
+
+    Reader r(&data[0], &data[0] + data.size());
+    if ((r.get<uint32_t>() != entryMagic) || (r.get<uint32_t>() != entryFormat)) {
+        return false;
+    }
+
+    // same file, unchanged since the entry was made?
+    if ((r.getString() != source.utf8Str()) ||
+        (r.get<uint64_t>() != source.sizeInBytes()) ||
+        (r.get<int64_t>() != int64_t(source.modTime())) || r.failed())
+    {
+        return false;
+    }
+
+    int version = r.get<int32_t>();
+    intVec freqs[6];
+    for (int i = 0; i < 6; ++i) {
+        r.getInts(freqs[i]);
+    }
+
+    // the smallest node: flags, index, hold type and position
+    const size_t minNodeSize = 1 + 2 * 4 + 3 * 8;
+    uint32_t tableSize = r.get<uint32_t>();
+    uint32_t numNodes = r.get<uint32_t>();
+    if (!r.haveItems(tableSize, minNodeSize) || (numNodes > tableSize)) {
+        return false;
+    }
+
+    FGTaxiNodeVector table(tableSize);
+    std::vector<std::pair<FGParking*, int32_t> > pushBacks;
+    for (uint32_t i = 0; i < tableSize && !r.failed(); ++i) {
+        uint8_t flags = r.get<uint8_t>();
+        int index = r.get<int32_t>();
+        int holdType = r.get<int32_t>();
+        double lon = r.get<double>();
+        double lat = r.get<double>();
+        double elevM = r.get<double>();
+        SGGeod pos(SGGeod::fromRadM(lon, lat, elevM));
+
+        if (flags & NODE_PARKING) {
+            double heading = r.get<double>();
+            double radius = r.get<double>();
+            string name = r.getString();
+            string type = r.getString();
+            string codes = r.getString();
+            FGParking* parking = new FGParking(index, pos, heading, radius,
+                                               name, type, codes);
+            table[i] = parking;
+            pushBacks.push_back(std::make_pair(parking, r.get<int32_t>()));
+        } else {
+            table[i] = new FGTaxiNode(index, pos, (flags & NODE_ON_RUNWAY) != 0,
+                                      holdType);
+        }
+    }
+
+    // fixup: turn the indices back into references
+    for (size_t i = 0; i < pushBacks.size() && !r.failed(); ++i) {
+        int32_t j = pushBacks[i].second;
+        if (j >= int32_t(tableSize)) {
+            r.fail();
+        } else if (j >= 0) {
+            pushBacks[i].first->setPushBackPoint(table[j]);
+        }
+    }
+
+    FGParkingList parkings;
+    uint32_t numParkings = r.get<uint32_t>();
+    if (r.haveItems(numParkings, 4)) {
+        for (uint32_t i = 0; i < numParkings; ++i) {
+            uint32_t j = r.get<uint32_t>();
+            FGParking* parking = (j < tableSize) ?
+                dynamic_cast<FGParking*>(table[j].ptr()) : 0;
+            if (!parking) {
+                r.fail();
+                break;
+            }
+            parkings.push_back(parking);
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t> > segments;
+    uint32_t numSegments = r.get<uint32_t>();
+    if (r.haveItems(numSegments, 8)) {
+        for (uint32_t i = 0; i < numSegments; ++i) {
+            uint32_t from = r.get<uint32_t>();
+            uint32_t to = r.get<uint32_t>();
+            if ((from >= numNodes) || (to >= numNodes)) {
+                r.fail();
+                break;
+            }
+            segments.push_back(std::make_pair(from, to));
+        }
+    }
+
+    if (r.failed()) {
+        SG_LOG(SG_NAVAID, SG_WARN, "ignoring damaged groundnet cache " << path);
+        return false;
+    }
+
+    // everything could be read, hand it over
+    net->version = version;
+    net->freqAwos.swap(freqs[0]);
+    net->freqUnicom.swap(freqs[1]);
+    net->freqClearance.swap(freqs[2]);
+    net->freqGround.swap(freqs[3]);
+    net->freqTower.swap(freqs[4]);
+    net->freqApproach.swap(freqs[5]);
+    net->m_nodes.assign(table.begin(), table.begin() + numNodes);
+    net->m_parkings.swap(parkings);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        net->segments.push_back(new FGTaxiSegment(table[segments[i].first].ptr(),
+                                                  table[segments[i].second].ptr()));
+    }
+
+    return true;
+}
@@ -0,0 +1,62 @@
+// groundnetcache.hxx - binary copies of parsed groundnet.xml files
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _GROUNDNET_CACHE_HXX_
+#define _GROUNDNET_CACHE_HXX_
+
+#include <simgear/misc/sg_path.hxx>
+
+class FGGroundNetwork;
+
+/**
+ * Directory of ground networks as the XML loader left them, one file per
+ * airport: the nodes, parkings and segments in their original order, with
+ * references replaced by indices. Loading an entry reads the file in one go
+ * and rebuilds the objects, without any XML parsing.
+ *
+ * An entry records the path, size and modification time of the groundnet
+ * file it was made from, and is only used while all three still match.
+ *
+ * Does not touch any global state, so it may be used from a loader thread.
+ */
+class FGGroundNetCache
+{
+public:
+    explicit FGGroundNetCache(const SGPath& dir);
+
+    /**
+     * Fill the empty network 'net' from the entry made from 'source'.
+     * Returns false if there is no such entry, or it is out of date or
+     * unreadable.
+     */
+    bool load(const SGPath& source, FGGroundNetwork* net) const;
+
+    /**
+     * Store the network 'net', just loaded from 'source'. Failures are
+     * logged and otherwise ignored.
+     */
+    void save(const SGPath& source, const FGGroundNetwork* net) const;
+
+    /// $FG_HOME/GroundNetCache, for the main thread to pass on
+    static SGPath defaultDir();
+
+private:
+    SGPath entryPath(const FGGroundNetwork* net) const;
+
+    SGPath _dir;
+};
+
+#endif
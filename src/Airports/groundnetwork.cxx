@@ -203,6 +203,9 @@ void FGGroundNetwork::init()
         opp->oppositeDirection = segment;
       }
     }
+
+    m_segmentOccupants.resize(segments.size() + 1);
+    m_segmentReservations.resize(segments.size() + 1);
   
     networkInitialized = true;
 }
@@ -429,6 +432,119 @@ void FGGroundNetwork::blockSegmentsEndingAt(FGTaxiSegment *seg, int blockId, tim
     }
 }
 
+static void removeId(intVec& ids, int id)
+{
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+}
+
+void FGGroundNetwork::addToIndex(int id, const Occupancy& occ)
+{
+    const int numSlots = m_segmentOccupants.size();
+    if ((occ.currentPos > 0) && (occ.currentPos < numSlots)) {
+        m_segmentOccupants[occ.currentPos].push_back(id);
+    }
+
+    intVec::const_iterator it;
+    for (it = occ.intentions.begin(); it != occ.intentions.end(); ++it) {
+        if ((*it > 0) && (*it < numSlots)) {
+            intVec& reservations = m_segmentReservations[*it];
+            // routes may visit a segment twice, store the id once only
+            if (std::find(reservations.begin(), reservations.end(), id) == reservations.end()) {
+                reservations.push_back(id);
+            }
+        }
+    }
+}
+
+void FGGroundNetwork::removeFromIndex(int id, const Occupancy& occ)
+{
+    const int numSlots = m_segmentOccupants.size();
+    if ((occ.currentPos > 0) && (occ.currentPos < numSlots)) {
+        removeId(m_segmentOccupants[occ.currentPos], id);
+    }
+
+    intVec::const_iterator it;
+    for (it = occ.intentions.begin(); it != occ.intentions.end(); ++it) {
+        if ((*it > 0) && (*it < numSlots)) {
+            removeId(m_segmentReservations[*it], id);
+        }
+    }
+}
+
+void FGGroundNetwork::updateOccupancy(int id, int currentPos, const intVec& intentions)
+{
+    OccupancyMap::iterator it = m_occupancy.find(id);
+    if (it != m_occupancy.end()) {
+        Occupancy& occ = it->second;
+        // most updates leave the position and the route ahead as they were
+        if ((occ.currentPos == currentPos) && (occ.intentions == intentions)) {
+            return;
+        }
+
+        removeFromIndex(id, occ);
+    } else {
+        it = m_occupancy.insert(std::make_pair(id, Occupancy())).first;
+    }
+
+    it->second.currentPos = currentPos;
+    it->second.intentions = intentions;
+    addToIndex(id, it->second);
+}
+
+void FGGroundNetwork::removeOccupancy(int id)
+{
+    OccupancyMap::iterator it = m_occupancy.find(id);
+    if (it == m_occupancy.end()) {
+        return;
+    }
+
+    removeFromIndex(id, it->second);
+    m_occupancy.erase(it);
+}
+
+const intVec& FGGroundNetwork::occupantsOf(int segIndex) const
+{
+    static const intVec empty;
+    if ((segIndex <= 0) || (segIndex >= (int) m_segmentOccupants.size())) {
+        return empty;
+    }
+
+    return m_segmentOccupants[segIndex];
+}
+
+const intVec& FGGroundNetwork::reservationsOf(int segIndex) const
+{
+    static const intVec empty;
+    if ((segIndex <= 0) || (segIndex >= (int) m_segmentReservations.size())) {
+        return empty;
+    }
+
+    return m_segmentReservations[segIndex];
+}
+
+void FGGroundNetwork::findTrafficAhead(int id, intVec& result) const
+{
+    result.clear();
+    OccupancyMap::const_iterator it = m_occupancy.find(id);
+    if (it == m_occupancy.end()) {
+        return;
+    }
+
+    const Occupancy& occ = it->second;
+    const intVec& here = occupantsOf(occ.currentPos);
+    std::copy(here.begin(), here.end(), std::back_inserter(result));
+
+    intVec::const_iterator ivi;
+    for (ivi = occ.intentions.begin(); ivi != occ.intentions.end(); ++ivi) {
+        const intVec& ahead = occupantsOf(*ivi);
+        std::copy(ahead.begin(), ahead.end(), std::back_inserter(result));
+    }
+
+    removeId(result, id);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
 FGTaxiNodeRef FGGroundNetwork::findNodeByIndex(int index) const
 {
    FGTaxiNodeVector::const_iterator it;
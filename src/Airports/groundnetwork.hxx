@@ -27,6 +27,7 @@
 #include <simgear/compiler.h>
 
 #include <string>
+#include <map>
 
 #include "gnnode.hxx"
 #include "parking.hxx"
@@ -178,6 +179,7 @@ class FGGroundNetwork
 {
 private:
     friend class FGGroundNetXMLLoader;
+    friend class FGGroundNetCache;
 
     bool hasNetwork;
     bool networkInitialized;
@@ -193,6 +195,25 @@ private:
 
     FGTaxiNodeRef findNodeByIndex(int index) const;
 
+    /**
+     * Live occupancy of the network: for every segment, the ids of the
+     * aircraft currently taxiing on it and of those which intend to use it
+     * later on. Both vectors are indexed by segment index, slot 0 is unused.
+     * Maintained by the ground controller through updateOccupancy().
+     */
+    struct Occupancy {
+        int currentPos;
+        intVec intentions;
+    };
+    typedef std::map<int, Occupancy> OccupancyMap;
+
+    std::vector<intVec> m_segmentOccupants;
+    std::vector<intVec> m_segmentReservations;
+    OccupancyMap m_occupancy;
+
+    void addToIndex(int id, const Occupancy& occ);
+    void removeFromIndex(int id, const Occupancy& occ);
+
     //void printRoutingError(string);
 
     void checkSpeedAdjustment(int id, double lat, double lon,
@@ -276,6 +297,33 @@ public:
     void addVersion(int v) {version = v; };
     void unblockAllSegments(time_t now);
 
+    /**
+     * Record the current segment and the remaining taxi route of an
+     * aircraft. Cheap to call every frame, the index is only touched
+     * when the aircraft moved on to another segment.
+     */
+    void updateOccupancy(int id, int currentPos, const intVec& intentions);
+    void removeOccupancy(int id);
+
+    /**
+     * Ids of the aircraft currently on the given segment.
+     */
+    const intVec& occupantsOf(int segIndex) const;
+
+    /**
+     * Ids of the aircraft which will use the given segment later on
+     * their route.
+     */
+    const intVec& reservationsOf(int segIndex) const;
+
+    /**
+     * Collect the ids of all aircraft, except id itself, currently
+     * positioned on the segment the aircraft is on or any segment of its
+     * remaining route, i.e. the aircraft for which
+     * FGTrafficRecord::checkPositionAndIntentions() holds while on the network.
+     */
+    void findTrafficAhead(int id, intVec& result) const;
+
     const intVec& getTowerFrequencies() const;
     const intVec& getGroundFrequencies() const;
     
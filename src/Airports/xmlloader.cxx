@@ -18,7 +18,9 @@
 #endif
 
 #include <cstdio>
+#include <sstream>
 
+#include <simgear/io/iostreams/sgstream.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/xml/easyxml.hxx>
 #include <simgear/misc/strutils.hxx>
@@ -28,7 +30,10 @@
 #include <Main/fg_props.hxx>
 
 #include "xmlloader.hxx"
+#include "airportdynamicsmanager.hxx"
+#include "airportprefetcher.hxx"
 #include "dynamicloader.hxx"
+#include "groundnetcache.hxx"
 #include "runwayprefloader.hxx"
 
 #include "dynamics.hxx"
@@ -49,17 +54,42 @@ void XMLLoader::load(FGGroundNetwork* net)
     return;
   }
 
-  SG_LOG(SG_NAVAID, SG_INFO, "reading groundnet data from " << path);
+  SGPath cacheDir;
+  if (fgGetBool("/sim/airport/groundnet-cache", true)) {
+    cacheDir = FGGroundNetCache::defaultDir();
+  }
+  loadGroundNet(net, path, cacheDir);
+}
+
+void XMLLoader::loadGroundNet(FGGroundNetwork* net, const SGPath& path,
+  const SGPath& cacheDir)
+{
   SGTimeStamp t;
   t.stamp();
+
+  if (!cacheDir.isNull()) {
+    FGGroundNetCache cache(cacheDir);
+    if (cache.load(path, net)) {
+      SG_LOG(SG_NAVAID, SG_INFO, "reading cached groundnet data of " << path
+             << " took " << t.elapsedMSec());
+      return;
+    }
+  }
+
+  SG_LOG(SG_NAVAID, SG_INFO, "reading groundnet data from " << path);
   try {
       FGGroundNetXMLLoader visitor(net);
       readXML(path, visitor);
   } catch (sg_exception& e) {
     SG_LOG(SG_NAVAID, SG_INFO, "parsing groundnet XML failed:" << e.getFormattedMessage());
+    return;
   }
 
   SG_LOG(SG_NAVAID, SG_INFO, "parsing groundnet XML took " << t.elapsedMSec());
+
+  if (!cacheDir.isNull()) {
+    FGGroundNetCache(cacheDir).save(path, net);
+  }
 }
 
 void XMLLoader::load(FGRunwayPreference* p) {
@@ -69,13 +99,18 @@ void XMLLoader::load(FGRunwayPreference* p) {
 
 bool XMLLoader::findAirportData(const std::string& aICAO, 
     const std::string& aFileName, SGPath& aPath)
+{
+  return findAirportData(aICAO, aFileName, globals->get_fg_scenery(), aPath);
+}
+
+bool XMLLoader::findAirportData(const std::string& aICAO,
+    const std::string& aFileName, const PathList& sc, SGPath& aPath)
 {
   string fileName(aFileName);
   if (!simgear::strutils::ends_with(aFileName, ".xml")) {
     fileName.append(".xml");
   }
   
-  PathList sc = globals->get_fg_scenery();
   char buffer[128];
   ::snprintf(buffer, 128, "%c/%c/%c/%s.%s", 
     aICAO[0], aICAO[1], aICAO[2], 
@@ -110,3 +145,27 @@ bool XMLLoader::loadAirportXMLDataIntoVisitor(const string& aICAO,
   return true;
 }
 
+bool XMLLoader::readAirportData(const FGAirport* aAirport,
+    const string& aFileName, SGPath& aPath, string& aContents)
+{
+  flightgear::AirportPrefetcher* prefetcher = flightgear::AirportDynamicsManager::prefetcher();
+  bool found;
+  if (prefetcher &&
+      prefetcher->takeFile(aAirport, aFileName, found, aPath, aContents)) {
+    return found;
+  }
+
+  if (!findAirportData(aAirport->ident(), aFileName, aPath)) {
+    return false;
+  }
+
+  sg_ifstream in(aPath, std::ios::in | std::ios::binary);
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  if (!in) {
+    SG_LOG(SG_NAVAID, SG_WARN, "unable to read " << aPath);
+    return false;
+  }
+  aContents = contents.str();
+  return true;
+}
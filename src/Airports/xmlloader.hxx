@@ -16,6 +16,10 @@
 #ifndef _XML_LOADER_HXX_
 #define _XML_LOADER_HXX_
 
+#include <string>
+
+#include <simgear/misc/sg_path.hxx>
+
 #include "airports_fwd.hxx"
 
 class XMLVisitor; // ffrom easyxml.hxx
@@ -47,6 +51,27 @@ public:
    */
   static bool findAirportData(const std::string& aICAO, 
     const std::string& aFileName, SGPath& aPath);
+
+  /**
+   * As above, searching the given scenery paths instead of the global
+   * ones, so it can be used from a loader thread.
+   */
+  static bool findAirportData(const std::string& aICAO,
+    const std::string& aFileName, const PathList& aSceneryPaths, SGPath& aPath);
+
+  /**
+   * The XML file found by findAirportData, read into 'aContents'. Uses the
+   * data the airport prefetcher read already, if there is any.
+   */
+  static bool readAirportData(const FGAirport* aAirport,
+    const std::string& aFileName, SGPath& aPath, std::string& aContents);
+
+  /**
+   * Fill 'net' from the groundnet file 'aPath', through the groundnet cache
+   * in 'aCacheDir' unless that is null. Thread-safe, does not call init().
+   */
+  static void loadGroundNet(FGGroundNetwork* net, const SGPath& aPath,
+    const SGPath& aCacheDir);
 };
 
 #endif
@@ -506,7 +506,7 @@ void FGRouteMgr::update( double dt )
   }
   
   // use RoutePath to compute location of active WP
-  RoutePath path(_plan);
+  const RoutePath& path(_plan->routePath());
   SGGeod wpPos = path.positionForIndex(_plan->currentIndex());
   double courseDeg, az2, distanceM;
   SGGeodesy::inverse(currentPos, wpPos, courseDeg, az2, distanceM);
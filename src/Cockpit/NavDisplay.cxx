@@ -183,7 +183,8 @@ private:
 class SymbolRule
 {
 public:
-  SymbolRule() : enabled(false)
+  SymbolRule() : enabled(false), requiredStates(0), excludedStates(0),
+    matchable(true)
     {
         
     }
@@ -205,9 +206,13 @@ public:
         while (node->hasChild("state", n)) {
             string m = node->getChild("state", n++)->getStringValue();
             if (m[0] == '!') {
-                excluded_states.insert(m.substr(1));
+                excludedStates |= owner->internState(m.substr(1));
             } else {
-                required_states.insert(m);
+                SymbolStateMask bit = owner->internState(m);
+                if (!bit) {
+                    matchable = false; // state table overflowed
+                }
+                requiredStates |= bit;
             }
         } // of matches parsing
         
@@ -223,21 +228,11 @@ public:
     SymbolDef* getDefinition() const
     { return definition; }
     
-    bool matches(const string_set& states) const
+    bool matches(SymbolStateMask states) const
     {
-        BOOST_FOREACH(const string& s, required_states) {
-            if (states.count(s) == 0) {
-                return false;
-            }
-        }
-        
-        BOOST_FOREACH(const string& s, excluded_states) {
-            if (states.count(s) != 0) {
-                return false;
-            }
-        }
-        
-        return true;
+        return matchable &&
+            ((states & requiredStates) == requiredStates) &&
+            ((states & excludedStates) == 0);
     }
     
   // return if the enabled state changed (needs a cache update)
@@ -262,8 +257,9 @@ private:
     SymbolDef* definition;
     
     std::unique_ptr<SGCondition> enable;
-    string_set required_states;
-    string_set excluded_states;
+    SymbolStateMask requiredStates;
+    SymbolStateMask excludedStates;
+    bool matchable;
 };
 
 class SymbolDef
@@ -383,6 +379,15 @@ public:
         props(vars)
     { }
     
+    void reset(const osg::Vec2& p, double h, SymbolDef* def, SGPropertyNode* vars)
+    {
+        pos = p;
+        endPos = osg::Vec2();
+        headingDeg = h;
+        definition = def;
+        props = vars;
+    }
+    
     osg::Vec2 pos; // projected position
     osg::Vec2 endPos;
     double headingDeg;
@@ -442,7 +447,8 @@ NavDisplay::NavDisplay(SGPropertyNode *node) :
     _font_size(0),
     _font_spacing(0),
     _rangeNm(0),
-    _maxSymbols(100)
+    _maxSymbols(100),
+    _symbolPoolUsed(0)
 {
     _Instrument = fgGetNode(string("/instrumentation/" + _name).c_str(), _num, true);
     _font_node = _Instrument->getNode("font", true);
@@ -496,11 +502,15 @@ NavDisplay::NavDisplay(SGPropertyNode *node) :
         addRule(r);
     }
     
+    compileRules();
 }
 
 
 NavDisplay::~NavDisplay()
 {
+  BOOST_FOREACH(SymbolInstance* si, _symbolPool) {
+      delete si;
+  }
   delete _odg;
 }
 
@@ -717,10 +727,8 @@ NavDisplay::update (double delta_time_sec)
   _texCoords->clear();
   _textGeode->removeDrawables(0, _textGeode->getNumDrawables());
   
-  BOOST_FOREACH(SymbolInstance* si, _symbols) {
-      delete si;
-  }
   _symbols.clear();
+  _symbolPoolUsed = 0;
   
   BOOST_FOREACH(SymbolDef* d, _definitions) {
     d->instanceCount = 0;
@@ -1004,6 +1012,16 @@ void NavDisplay::findItems()
             // re-query next frame, to load incrementally
             _cachedItemsValid = false;
         }
+        
+      // drop the property nodes of items which went out of range
+        std::map<FGPositioned*, SGPropertyNode_ptr> keep;
+        BOOST_FOREACH(FGPositioned* pos, _itemsInRange) {
+            std::map<FGPositioned*, SGPropertyNode_ptr>::iterator it = _positionedVars.find(pos);
+            if (it != _positionedVars.end()) {
+                keep.insert(*it);
+            }
+        }
+        _positionedVars.swap(keep);
     }
     
   // sort by distance from pos, so symbol limits are accurate
@@ -1018,37 +1036,37 @@ void NavDisplay::processRoute()
 {
     _routeSources.clear();
     flightgear::FlightPlan* fp = _route->flightPlan();
-    RoutePath path(fp);
+    const RoutePath& path(fp->routePath());
     int current = _route->currentIndex();
+    const SymbolRuleVector* waypointRules = rulesForType("waypoint");
     
     for (int l=0; l<fp->numLegs(); ++l) {
         flightgear::FlightPlan::Leg* leg = fp->legAtIndex(l);
         flightgear::WayptRef wpt(leg->waypoint());
         _routeSources.insert(wpt->source());
         
-        string_set state;
-        state.insert("on-active-route");
+        SymbolStateMask state = _known.onActiveRoute;
         
         if (l < current) {
-            state.insert("passed");
+            state |= _known.passed;
         }
         
         if (l == current) {
-            state.insert("current-wp");
+            state |= _known.currentWp;
         }
         
         if (l > current) {
-            state.insert("future");
+            state |= _known.future;
         }
         
         if (l == (current + 1)) {
-            state.insert("next-wp");
+            state |= _known.nextWp;
         }
         
         SymbolRuleVector rules;
-        findRules("waypoint" , state, rules);
+        findRules(waypointRules, state, rules);
         if (rules.empty()) {
-            return; // no rules matched, we can skip this item
+            continue; // no rules matched, we can skip this item
         }
 
         SGGeod g = path.positionForIndex(l);
@@ -1113,12 +1131,13 @@ FGNavRecord* NavDisplay::processNavRadio(const SGPropertyNode_ptr& radio)
 
 bool NavDisplay::anyRuleForType(const string& type) const
 {
-    BOOST_FOREACH(SymbolRule* r, _rules) {
-        if (!r->enabled) {
-            continue;
-        }
+    const SymbolRuleVector* candidates = rulesForType(type);
+    if (!candidates) {
+        return false;
+    }
     
-        if (r->type == type) {
+    BOOST_FOREACH(SymbolRule* r, *candidates) {
+        if (r->enabled) {
             return true;
         }
     }
@@ -1126,14 +1145,29 @@ bool NavDisplay::anyRuleForType(const string& type) const
     return false;
 }
 
-void NavDisplay::findRules(const string& type, const string_set& states, SymbolRuleVector& rules)
+const SymbolRuleVector* NavDisplay::rulesForType(const string& type) const
 {
-    BOOST_FOREACH(SymbolRule* candidate, _rules) {
-        if (!candidate->enabled || (candidate->type != type)) {
-            continue;
-        }
-        
-        if (candidate->matches(states)) {
+    std::map<string, SymbolRuleVector>::const_iterator it = _rulesByType.find(type);
+    if (it == _rulesByType.end()) {
+        return NULL;
+    }
+    
+    return &it->second;
+}
+
+void NavDisplay::findRules(const string& type, SymbolStateMask states, SymbolRuleVector& rules)
+{
+    findRules(rulesForType(type), states, rules);
+}
+
+void NavDisplay::findRules(const SymbolRuleVector* candidates, SymbolStateMask states, SymbolRuleVector& rules)
+{
+    if (!candidates) {
+        return;
+    }
+    
+    BOOST_FOREACH(SymbolRule* candidate, *candidates) {
+        if (candidate->enabled && candidate->matches(states)) {
             rules.push_back(candidate);
         }
     }
@@ -1148,16 +1182,16 @@ bool NavDisplay::isPositionedShown(FGPositioned* pos)
 
 void NavDisplay::isPositionedShownInner(FGPositioned* pos, SymbolRuleVector& rules)
 {
-  string type = FGPositioned::nameForType(pos->type());
-  boost::to_lower(type);
-  if (!anyRuleForType(type)) {
-    return; // not diplayed at all, we're done
+  const SymbolRuleVector* candidates = NULL;
+  if (pos->type() < FGPositioned::LAST_TYPE) {
+    candidates = _positionedRules[pos->type()];
   }
   
-  string_set states;
-  computePositionedState(pos, states);
+  if (!candidates) {
+    return; // not diplayed at all, we're done
+  }
   
-  findRules(type, states, rules);
+  findRules(candidates, computePositionedState(pos), rules);
 }
 
 void NavDisplay::foundPositionedItem(FGPositioned* pos)
@@ -1172,7 +1206,11 @@ void NavDisplay::foundPositionedItem(FGPositioned* pos)
       return;
     }
   
-    SGPropertyNode_ptr vars(new SGPropertyNode);
+    SGPropertyNode_ptr& vars = _positionedVars[pos];
+    if (!vars) {
+        vars = new SGPropertyNode;
+    }
+    
     double heading;
     computePositionedPropsAndHeading(pos, vars, heading);
     
@@ -1236,10 +1274,11 @@ void NavDisplay::computePositionedPropsAndHeading(FGPositioned* pos, SGPropertyN
     }
 }
 
-void NavDisplay::computePositionedState(FGPositioned* pos, string_set& states)
+SymbolStateMask NavDisplay::computePositionedState(FGPositioned* pos)
 {
+    SymbolStateMask states = 0;
     if (_routeSources.count(pos) != 0) {
-        states.insert("on-active-route");
+        states |= _known.onActiveRoute;
     }
     
     flightgear::FlightPlan* fp = _route->flightPlan();
@@ -1247,13 +1286,11 @@ void NavDisplay::computePositionedState(FGPositioned* pos, string_set& states)
     case FGPositioned::VOR:
     case FGPositioned::LOC:
         if (pos == _nav1Station) {
-            states.insert("tuned");
-            states.insert("nav1");
+            states |= _known.tuned | _known.nav1;
         }
         
         if (pos == _nav2Station) {
-            states.insert("tuned");
-            states.insert("nav2");
+            states |= _known.tuned | _known.nav2;
         }
         break;
     
@@ -1264,21 +1301,21 @@ void NavDisplay::computePositionedState(FGPositioned* pos, string_set& states)
         // once the FMS system has some way to tell us about them, of course
         
         if (pos == fp->departureAirport()) {
-            states.insert("departure");
+            states |= _known.departure;
         }
         
         if (pos == fp->destinationAirport()) {
-            states.insert("destination");
+            states |= _known.destination;
         }
         break;
     
     case FGPositioned::RUNWAY:
         if (pos == fp->departureRunway()) {
-            states.insert("departure");
+            states |= _known.departure;
         }
         
         if (pos == fp->destinationRunway()) {
-            states.insert("destination");
+            states |= _known.destination;
         }
         break;
     
@@ -1298,6 +1335,8 @@ void NavDisplay::computePositionedState(FGPositioned* pos, string_set& states)
     default:
         break;
     } // FGPositioned::Type switch
+    
+    return states;
 }
 
 static string mapAINodeToType(SGPropertyNode* model)
@@ -1321,12 +1360,15 @@ void NavDisplay::processAI()
         
     // prefix types with 'ai-', to avoid any chance of namespace collisions
     // with fg-positioned.
-        string_set ss;
-        computeAIStates(model, ss);        
+        const SymbolRuleVector* candidates = rulesForType(mapAINodeToType(model));
+        if (!candidates) {
+            continue; // no rules for this kind of model at all
+        }
+        
         SymbolRuleVector rules;
-        findRules(mapAINodeToType(model), ss, rules);
+        findRules(candidates, computeAIStates(model), rules);
         if (rules.empty()) {
-            return; // no rules matched, we can skip this item
+            continue; // no rules matched, we can skip this item
         }
 
         double heading = model->getDoubleValue("orientation/true-heading-deg");
@@ -1344,24 +1386,30 @@ void NavDisplay::processAI()
     } // of ai models iteration
 }
 
-void NavDisplay::computeAIStates(const SGPropertyNode* ai, string_set& states)
+SymbolStateMask NavDisplay::computeAIStates(const SGPropertyNode* ai)
 {
     int threatLevel = ai->getIntValue("tcas/threat-level",-1);
     if (threatLevel < 1)
       threatLevel = 0;
   
-    states.insert("tcas");
+    SymbolStateMask states = _known.tcas;
   
-    std::ostringstream os;
-    os << "tcas-threat-level-" << threatLevel;
-    states.insert(os.str());
+    if (threatLevel < 4) {
+        states |= _known.tcasThreatLevel[threatLevel];
+    } else {
+        std::ostringstream os;
+        os << "tcas-threat-level-" << threatLevel;
+        states |= stateBit(os.str());
+    }
 
     double vspeed = ai->getDoubleValue("velocities/vertical-speed-fps");
     if (vspeed < -3.0) {
-        states.insert("descending");
+        states |= _known.descending;
     } else if (vspeed > 3.0) {
-        states.insert("climbing");
+        states |= _known.climbing;
     }
+    
+    return states;
 }
 
 SymbolInstance* NavDisplay::addSymbolInstance(const osg::Vec2& proj, double heading, SymbolDef* def, SGPropertyNode* vars)
@@ -1375,7 +1423,16 @@ SymbolInstance* NavDisplay::addSymbolInstance(const osg::Vec2& proj, double head
     }
   
     ++def->instanceCount;
-    SymbolInstance* sym = new SymbolInstance(proj, heading, def, vars);
+    SymbolInstance* sym;
+    if (_symbolPoolUsed < _symbolPool.size()) {
+        sym = _symbolPool[_symbolPoolUsed];
+        sym->reset(proj, heading, def, vars);
+    } else {
+        sym = new SymbolInstance(proj, heading, def, vars);
+        _symbolPool.push_back(sym);
+    }
+    
+    ++_symbolPoolUsed;
     _symbols.push_back(sym);
     return sym;
 }
@@ -1391,9 +1448,9 @@ bool NavDisplay::isProjectedClipped(const osg::Vec2& projected) const
 
 void NavDisplay::addTestSymbol(const std::string& type, const std::string& states, const SGGeod& pos, double heading, SGPropertyNode* vars)
 {
-  string_set stateSet;
+  SymbolStateMask stateSet = 0;
   BOOST_FOREACH(std::string s, simgear::strutils::split(states, ",")) {
-    stateSet.insert(s);
+    stateSet |= stateBit(s);
   }
   
   SymbolRuleVector rules;
@@ -1443,13 +1500,74 @@ void NavDisplay::addTestSymbols()
 void NavDisplay::addRule(SymbolRule* r)
 {
     _rules.push_back(r);
+    _rulesByType[r->type].push_back(r);
+}
+
+SymbolStateMask NavDisplay::internState(const string& state)
+{
+    std::map<string, unsigned int>::const_iterator it = _stateBits.find(state);
+    if (it != _stateBits.end()) {
+        return SymbolStateMask(1) << it->second;
+    }
+    
+    unsigned int bit = _stateBits.size();
+    if (bit >= sizeof(SymbolStateMask) * 8) {
+        SG_LOG(SG_INSTR, SG_WARN, "ND: too many distinct symbol states, ignoring:" << state);
+        return 0;
+    }
+    
+    _stateBits[state] = bit;
+    return SymbolStateMask(1) << bit;
+}
+
+SymbolStateMask NavDisplay::stateBit(const string& state) const
+{
+    std::map<string, unsigned int>::const_iterator it = _stateBits.find(state);
+    if (it == _stateBits.end()) {
+        return 0; // no rule cares about this state
+    }
+    
+    return SymbolStateMask(1) << it->second;
 }
 
-void NavDisplay::computeCustomSymbolStates(const SGPropertyNode* sym, string_set& states)
+// once all rules are loaded: resolve FGPositioned types to their rule lists
+// and look up the bits of the states we compute ourselves, so the per item
+// work is a table lookup and a few mask operations.
+void NavDisplay::compileRules()
 {
+    for (int t = 0; t < FGPositioned::LAST_TYPE; ++t) {
+        string type = FGPositioned::nameForType(static_cast<FGPositioned::Type>(t));
+        boost::to_lower(type);
+        _positionedRules[t] = rulesForType(type);
+    }
+    
+    _known.onActiveRoute = stateBit("on-active-route");
+    _known.passed = stateBit("passed");
+    _known.currentWp = stateBit("current-wp");
+    _known.future = stateBit("future");
+    _known.nextWp = stateBit("next-wp");
+    _known.tuned = stateBit("tuned");
+    _known.nav1 = stateBit("nav1");
+    _known.nav2 = stateBit("nav2");
+    _known.departure = stateBit("departure");
+    _known.destination = stateBit("destination");
+    _known.tcas = stateBit("tcas");
+    for (int i = 0; i < 4; ++i) {
+        std::ostringstream os;
+        os << "tcas-threat-level-" << i;
+        _known.tcasThreatLevel[i] = stateBit(os.str());
+    }
+    _known.descending = stateBit("descending");
+    _known.climbing = stateBit("climbing");
+}
+
+SymbolStateMask NavDisplay::computeCustomSymbolStates(const SGPropertyNode* sym)
+{
+  SymbolStateMask states = 0;
   BOOST_FOREACH(SGPropertyNode* st, sym->getChildren("state")) {
-    states.insert(st->getStringValue());
+    states |= stateBit(st->getStringValue());
   }
+  return states;
 }
 
 void NavDisplay::processCustomSymbols()
@@ -1459,12 +1577,15 @@ void NavDisplay::processCustomSymbols()
     if (!symNode->nChildren()) {
       continue;
     }
-    string_set ss;
-    computeCustomSymbolStates(symNode, ss);
+    const SymbolRuleVector* candidates = rulesForType(symNode->getName());
+    if (!candidates) {
+      continue; // no rules for this kind of symbol at all
+    }
+    
     SymbolRuleVector rules;
-    findRules(symNode->getName(), ss, rules);
+    findRules(candidates, computeCustomSymbolStates(symNode), rules);
     if (rules.empty()) {
-      return; // no rules matched, we can skip this item
+      continue; // no rules matched, we can skip this item
     }
     
     double heading = symNode->getDoubleValue("true-heading-deg", 0.0);
@@ -32,6 +32,8 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 
+#include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <memory>
@@ -51,8 +53,8 @@ namespace flightgear
     class Waypt;
 }
 
-typedef std::set<std::string> string_set;
 typedef std::vector<SymbolRule*> SymbolRuleVector;
+typedef uint64_t SymbolStateMask; ///< one bit per state used by any rule
 typedef std::vector<SymbolDef*> SymbolDefVector;
 
 class NavDisplay : public SGSubsystem
@@ -104,6 +106,14 @@ private:
     friend class SymbolDef;
   
     void addRule(SymbolRule*);
+    void compileRules();
+    
+    /// bit for a state name, allocated on first use while loading rules.
+    /// Zero if the state table is full.
+    SymbolStateMask internState(const std::string& state);
+    /// bit for a state name, zero if no rule refers to it
+    SymbolStateMask stateBit(const std::string& state) const;
+    const SymbolRuleVector* rulesForType(const std::string& type) const;
   
     void addSymbolsToScene();
     void addSymbolToScene(SymbolInstance* sym);
@@ -113,18 +123,19 @@ private:
     void isPositionedShownInner(FGPositioned* pos, SymbolRuleVector& rules);
     void foundPositionedItem(FGPositioned* pos);
     void computePositionedPropsAndHeading(FGPositioned* pos, SGPropertyNode* nd, double& heading);
-    void computePositionedState(FGPositioned* pos, string_set& states);
+    SymbolStateMask computePositionedState(FGPositioned* pos);
     void processRoute();
     void computeWayptPropsAndHeading(flightgear::Waypt* wpt, const SGGeod& pos, SGPropertyNode* nd, double& heading);
     void processNavRadios();
     FGNavRecord* processNavRadio(const SGPropertyNode_ptr& radio);
     void processAI();
-    void computeAIStates(const SGPropertyNode* ai, string_set& states);
+    SymbolStateMask computeAIStates(const SGPropertyNode* ai);
     
-    void computeCustomSymbolStates(const SGPropertyNode* sym, string_set& states);
+    SymbolStateMask computeCustomSymbolStates(const SGPropertyNode* sym);
     void processCustomSymbols();
     
-    void findRules(const std::string& type, const string_set& states, SymbolRuleVector& rules);
+    void findRules(const std::string& type, SymbolStateMask states, SymbolRuleVector& rules);
+    void findRules(const SymbolRuleVector* candidates, SymbolStateMask states, SymbolRuleVector& rules);
     
     SymbolInstance* addSymbolInstance(const osg::Vec2& proj, double heading, SymbolDef* def, SGPropertyNode* vars);
     void addLine(osg::Vec2 a, osg::Vec2 b, const osg::Vec4& color);
@@ -185,9 +196,25 @@ private:
     
     SymbolDefVector _definitions;
     SymbolRuleVector _rules;
+    std::map<std::string, unsigned int> _stateBits;
+    std::map<std::string, SymbolRuleVector> _rulesByType;
+    const SymbolRuleVector* _positionedRules[FGPositioned::LAST_TYPE];
+    
+    /// bits of the states computed here rather than read from properties
+    struct KnownStates {
+        SymbolStateMask onActiveRoute, passed, currentWp, future, nextWp;
+        SymbolStateMask tuned, nav1, nav2, departure, destination;
+        SymbolStateMask tcas, tcasThreatLevel[4], descending, climbing;
+    } _known;
+    
     FGNavRecord* _nav1Station;
     FGNavRecord* _nav2Station;
     std::vector<SymbolInstance*> _symbols;
+    /// instances are recycled from frame to frame, _symbols points into here
+    std::vector<SymbolInstance*> _symbolPool;
+    size_t _symbolPoolUsed;
+    /// per item property nodes, kept while the item stays in range
+    std::map<FGPositioned*, SGPropertyNode_ptr> _positionedVars;
     std::set<FGPositioned*> _routeSources;
     
     bool _cachedItemsValid;
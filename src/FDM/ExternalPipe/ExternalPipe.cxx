@@ -46,6 +46,12 @@
 
 #include "ExternalPipe.hxx"
 
+#ifdef FG_HAVE_SHM_FDM
+#  include <fcntl.h>            // O_* constants
+#  include <sys/mman.h>         // shm_open(), mmap()
+#  include <new>                // placement new
+#endif
+
 using std::cout;
 using std::endl;
 
@@ -57,11 +63,38 @@ FGExternalPipe::FGExternalPipe( double dt, string name, string protocol ) {
     last_cg_offset = -9999.9;
 
     buf = new char[MAX_BUF];
+    pd1 = NULL;
+    pd2 = NULL;
 
     // clear property request list
     property_names.clear();
     nodes.clear();
 
+#ifdef FG_HAVE_SHM_FDM
+    shm = NULL;
+    memset( &shm_init, 0, sizeof(shm_init) );
+    shm_frame = 0;
+    shm_applied_frame = 0;
+#endif
+
+    _protocol = protocol;
+
+    if ( _protocol != "binary" && _protocol != "property"
+         && _protocol != "shm" ) {
+        SG_LOG( SG_IO, SG_ALERT, "Constructor(): Unknown ExternalPipe protocol."
+                << "  Must be 'binary', 'property' or 'shm'."
+                << "  (assuming binary)" );
+        _protocol = "binary";
+    }
+
+    if ( _protocol == "shm" ) {
+        // no fifos, everything goes through one shared memory segment
+        if ( !open_shm( name ) ) {
+            valid = false;
+        }
+        return;
+    }
+
 #ifdef HAVE_MKFIFO
     fifo_name_1 = name + "1";
     fifo_name_2 = name + "2";
@@ -95,15 +128,6 @@ FGExternalPipe::FGExternalPipe( double dt, string name, string protocol ) {
         valid = false;
     }
 #endif
-
-    _protocol = protocol;
-
-    if ( _protocol != "binary" && _protocol != "property" ) {
-        SG_LOG( SG_IO, SG_ALERT, "Constructor(): Unknown ExternalPipe protocol."
-                << "  Must be 'binary' or 'property'."
-                << "  (assuming binary)" );
-        _protocol = "binary";
-    }
 }
 
 
@@ -111,6 +135,11 @@ FGExternalPipe::~FGExternalPipe() {
     delete [] buf;
 
     SG_LOG( SG_IO, SG_INFO, "Closing up the ExternalPipe." );
+
+    if ( _protocol == "shm" ) {
+        close_shm();
+        return;
+    }
     
 #ifdef HAVE_MKFIFO
     // close
@@ -219,9 +248,11 @@ void FGExternalPipe::init() {
         init_binary();
     } else if ( _protocol == "property" ) {
         init_property();
+    } else if ( _protocol == "shm" ) {
+        init_shm();
     } else {
         SG_LOG( SG_IO, SG_ALERT, "Init():  Unknown ExternalPipe protocol."
-                << "  Must be 'binary' or 'property'."
+                << "  Must be 'binary', 'property' or 'shm'."
                 << "  (assuming binary)" );
     }
 }
@@ -364,9 +395,11 @@ void FGExternalPipe::update( double dt ) {
         update_binary(dt);
     } else if ( _protocol == "property" ) {
         update_property(dt);
+    } else if ( _protocol == "shm" ) {
+        update_shm(dt);
     } else {
         SG_LOG( SG_IO, SG_ALERT, "Init():  Unknown ExternalPipe protocol."
-                << "  Must be 'binary' or 'property'."
+                << "  Must be 'binary', 'property' or 'shm'."
                 << "  (assuming binary)" );
     }
 }
@@ -582,3 +615,161 @@ void FGExternalPipe::update_property( double dt ) {
 }
 
 
+// Create the shared memory segment the external FDM attaches to.
+bool FGExternalPipe::open_shm( const string& name ) {
+#ifdef FG_HAVE_SHM_FDM
+    shm_name = fgShmFDMName( name );
+
+    // a segment left behind by a crashed session would have stale state
+    shm_unlink( shm_name.c_str() );
+
+    int fd = shm_open( shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+    if ( fd == -1 ) {
+        SG_LOG( SG_IO, SG_ALERT, "Unable to create shared memory segment "
+                << shm_name << ": " << strerror(errno) );
+        return false;
+    }
+
+    if ( ftruncate( fd, sizeof(FGShmFDMSegment) ) == -1 ) {
+        SG_LOG( SG_IO, SG_ALERT, "Unable to size shared memory segment "
+                << shm_name << ": " << strerror(errno) );
+        ::close( fd );
+        shm_unlink( shm_name.c_str() );
+        return false;
+    }
+
+    void *p = mmap( NULL, sizeof(FGShmFDMSegment), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( p == MAP_FAILED ) {
+        SG_LOG( SG_IO, SG_ALERT, "Unable to map shared memory segment "
+                << shm_name << ": " << strerror(errno) );
+        shm_unlink( shm_name.c_str() );
+        return false;
+    }
+
+    // the new segment is zero filled, which is a valid initial state
+    shm = new (p) FGShmFDMSegment;
+    shm->version = FG_SHM_FDM_VERSION;
+    shm->ctrls_version = FG_NET_CTRLS_VERSION;
+    shm->fdm_version = FG_NET_FDM_VERSION;
+    shm->segment_size = sizeof(FGShmFDMSegment);
+    shm->lockstep = fgGetBool( "/sim/fdm/external-pipe/lockstep", true );
+    shm->magic.store( FG_SHM_FDM_MAGIC, std::memory_order_release );
+
+    SG_LOG( SG_IO, SG_ALERT, "ExternalPipe shared memory segment " << shm_name
+            << ( shm->lockstep ? " (lockstep)" : " (free running)" ) );
+    return true;
+#else
+    SG_LOG( SG_IO, SG_ALERT, "The ExternalPipe 'shm' protocol is not "
+            "available on this platform." );
+    return false;
+#endif
+}
+
+
+void FGExternalPipe::close_shm() {
+#ifdef FG_HAVE_SHM_FDM
+    if ( shm == NULL ) {
+        return;
+    }
+
+    // tell a waiting model we are gone
+    shm->magic.store( 0, std::memory_order_release );
+    shm->input_frame.store( 0, std::memory_order_release );
+    fgShmFutexWake( &shm->input_frame );
+
+    munmap( shm, sizeof(FGShmFDMSegment) );
+    shm_unlink( shm_name.c_str() );
+    shm = NULL;
+#endif
+}
+
+
+// Initialize the ExternalPipe flight model using the shared memory
+// protocol.  The initial conditions go out with the next frame.
+void FGExternalPipe::init_shm() {
+#ifdef FG_HAVE_SHM_FDM
+    double weight = fgGetDouble( "/sim/aircraft-weight-lbs" );
+    double cg_offset = fgGetDouble( "/sim/aircraft-cg-offset-inches" );
+
+    shm_init.longitude_deg = fgGetDouble( "/sim/presets/longitude-deg" );
+    shm_init.latitude_deg = fgGetDouble( "/sim/presets/latitude-deg" );
+    shm_init.altitude_ft = fgGetDouble( "/sim/presets/altitude-ft" );
+    shm_init.ground_m = get_Runway_altitude_m();
+    shm_init.speed_kts = fgGetDouble( "/sim/presets/airspeed-kt" );
+    shm_init.heading_deg = fgGetDouble( "/sim/presets/heading-deg" );
+    shm_init.weight_lbs = weight;
+    shm_init.cg_offset_inches = cg_offset;
+    shm_init.reset = fgGetBool( "/sim/presets/onground" )
+        ? FGShmFDMInit::RESET_GROUND : FGShmFDMInit::RESET_AIR;
+    shm_init.generation++;
+
+    last_weight = weight;
+    last_cg_offset = cg_offset;
+#endif
+}
+
+
+// Run an iteration of the EOM.  The controls are written straight into
+// the shared input block, in lockstep mode the model state is read in
+// place as the model is waiting for the next frame.
+void FGExternalPipe::update_shm( double dt ) {
+#ifdef FG_HAVE_SHM_FDM
+    if ( shm == NULL || is_suspended() ) {
+        return;
+    }
+
+    int iterations = _calc_multiloop(dt);
+
+    double weight = fgGetDouble( "/sim/aircraft-weight-lbs" );
+    double cg_offset = fgGetDouble( "/sim/aircraft-cg-offset-inches" );
+    if ( fabs( weight - last_weight ) > 0.01
+         || fabs( cg_offset - last_cg_offset ) > 0.01 ) {
+        shm_init.weight_lbs = weight;
+        shm_init.cg_offset_inches = cg_offset;
+        shm_init.reset = FGShmFDMInit::RESET_NONE;
+        shm_init.generation++;
+    }
+    last_weight = weight;
+    last_cg_offset = cg_offset;
+
+    FGShmFDMInput& input = shm->input.beginWrite();
+    input.frame = ++shm_frame;
+    input.iterations = iterations;
+    input.dt = dt;
+    input.init = shm_init;
+    FGProps2NetCtrls( &input.ctrls, true, false );
+    shm->input.endWrite();
+
+    shm->input_frame.store( shm_frame, std::memory_order_release );
+    fgShmFutexWake( &shm->input_frame );
+
+    if ( shm->lockstep ) {
+        uint32_t seen;
+        while ( (seen = shm->output_frame.load(std::memory_order_acquire))
+                != shm_frame ) {
+            if ( !fgShmFutexWait( &shm->output_frame, seen, 1000 ) ) {
+                SG_LOG( SG_IO, SG_WARN, "ExternalPipe: no answer from the "
+                        "external FDM for frame " << shm_frame );
+                return;
+            }
+        }
+        FGNetFDM2Props( &shm->output.data.fdm, false );
+        shm_applied_frame = shm_frame;
+    } else {
+        uint32_t latest = shm->output_frame.load( std::memory_order_acquire );
+        if ( latest != shm_applied_frame ) {
+            FGShmFDMOutput output;
+            if ( shm->output.read( output ) ) {
+                FGNetFDM2Props( &output.fdm, false );
+                shm_applied_frame = output.frame;
+            } else {
+                // keep the last state, the model may have died mid-write
+                SG_LOG( SG_IO, SG_DEBUG, "ExternalPipe: external FDM output "
+                        "busy, skipping frame " << shm_frame );
+            }
+        }
+    }
+#endif
+}
@@ -31,6 +31,8 @@
 #include <Network/net_fdm.hxx>
 #include <FDM/flight.hxx>
 
+#include "shm_segment.hxx"
+
 
 class FGExternalPipe: public FGInterface {
 
@@ -54,13 +56,26 @@ private:
     std::vector <std::string> property_names;
     std::vector <SGPropertyNode_ptr> nodes;
 
+#ifdef FG_HAVE_SHM_FDM
+    std::string shm_name;
+    FGShmFDMSegment *shm;
+    FGShmFDMInit shm_init;
+    uint32_t shm_frame;
+    uint32_t shm_applied_frame;
+#endif
+
     // Protocol specific init routines
     void init_binary();
     void init_property();
+    void init_shm();
 
     // Protocol specific update routines
     void update_binary( double dt );
     void update_property( double dt );
+    void update_shm( double dt );
+
+    bool open_shm( const std::string& name );
+    void close_shm();
 
     void process_set_command( const string_list &tokens );
 public:
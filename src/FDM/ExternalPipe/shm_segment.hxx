@@ -0,0 +1,212 @@
+// shm_segment.hxx -- shared memory layout of the ExternalPipe "shm" protocol
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+// This header is shared with external flight models and only depends on
+// the FGNetCtrls and FGNetFDM structures, see utils/fgshmfdm for a
+// reference peer.
+
+#ifndef _FG_SHM_SEGMENT_HXX
+#define _FG_SHM_SEGMENT_HXX
+
+#if defined(__linux__)
+#  define FG_HAVE_SHM_FDM 1
+#endif
+
+#ifdef FG_HAVE_SHM_FDM
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <Network/net_ctrls.hxx>
+#include <Network/net_fdm.hxx>
+
+const uint32_t FG_SHM_FDM_MAGIC = 0x46475348; // "FGSH"
+const uint32_t FG_SHM_FDM_VERSION = 1;
+
+// Initial conditions, sent with every frame. The model (re)applies them
+// whenever the generation changes.
+struct FGShmFDMInit {
+    enum { RESET_NONE = 0, RESET_GROUND, RESET_AIR };
+
+    double longitude_deg;
+    double latitude_deg;
+    double altitude_ft;
+    double ground_m;
+    double speed_kts;
+    double heading_deg;
+    double weight_lbs;
+    double cg_offset_inches;
+    int32_t reset;              // RESET_NONE if only weight or cg changed
+    uint32_t generation;        // bumped on every change
+};
+
+// simulator to model, once per frame
+struct FGShmFDMInput {
+    uint32_t frame;             // counts up from 1
+    int32_t iterations;         // model steps to run for this frame
+    double dt;                  // seconds per step
+    FGShmFDMInit init;
+    FGNetCtrls ctrls;           // host byte order
+};
+
+// model to simulator, once per frame
+struct FGShmFDMOutput {
+    uint32_t frame;             // the input frame this is the answer to
+    uint32_t padding;
+    FGNetFDM fdm;               // host byte order
+};
+
+/**
+ * A block with a single writer. The sequence number is odd while a
+ * write is in progress, readers retry until they copied the block
+ * between two reads of the same even sequence number.
+ */
+template<class T>
+struct FGShmSeqBlock {
+    alignas(64) std::atomic<uint32_t> seq;
+    T data;
+
+    /// writer: fill in the returned data in place, then call endWrite()
+    T& beginWrite()
+    {
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return data;
+    }
+
+    void endWrite()
+    {
+        seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// reader: a consistent copy of the last complete write. Gives up
+    /// and returns false if the writer does not finish a write in time,
+    /// say because its process died in the middle of one.
+    bool read(T& out, unsigned maxTries = 1000) const
+    {
+        for (unsigned tries = 0; tries < maxTries; ++tries) {
+            if (tries > 0) {
+                sched_yield();
+            }
+            const uint32_t before = seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            memcpy(&out, &data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+struct FGShmFDMSegment {
+    // written once by the simulator before anything else
+    std::atomic<uint32_t> magic; // FG_SHM_FDM_MAGIC once initialised
+    uint32_t version;           // FG_SHM_FDM_VERSION
+    uint32_t ctrls_version;     // FG_NET_CTRLS_VERSION
+    uint32_t fdm_version;       // FG_NET_FDM_VERSION
+    uint32_t segment_size;      // sizeof(FGShmFDMSegment)
+    uint32_t lockstep;          // the simulator waits for every frame
+
+    FGShmSeqBlock<FGShmFDMInput> input;
+    FGShmSeqBlock<FGShmFDMOutput> output;
+
+    // the last frame published in each direction, also used as futex
+    // words to sleep on
+    alignas(64) std::atomic<uint32_t> input_frame;
+    alignas(64) std::atomic<uint32_t> output_frame;
+};
+
+/// the shm_open() name for a --fdm=pipe,<name>,shm path: a leading slash
+/// and no further ones
+inline std::string fgShmFDMName(const std::string& name)
+{
+    std::string result = "/" + name;
+    for (std::string::size_type i = 1; i < result.size(); ++i) {
+        if (result[i] == '/') {
+            result[i] = '_';
+        }
+    }
+    return result;
+}
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(int),
+              "futex words must be plain 32 bit integers");
+
+inline void fgShmFutexWake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAKE, INT_MAX,
+            NULL, NULL, 0);
+}
+
+/**
+ * Wait until the word no longer holds value. Spins briefly first, since
+ * at kHz rates the answer is usually there before a sleep would pay off.
+ * Returns false if the timeout expired.
+ */
+inline bool fgShmFutexWait(std::atomic<uint32_t>* word, uint32_t value,
+                           int timeoutMSec)
+{
+    for (int spin = 0; spin < 2000; ++spin) {
+        if (word->load(std::memory_order_acquire) != value) {
+            return true;
+        }
+    }
+
+    timespec now, deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMSec / 1000;
+    deadline.tv_nsec += (timeoutMSec % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (word->load(std::memory_order_acquire) == value) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timespec left;
+        left.tv_sec = deadline.tv_sec - now.tv_sec;
+        left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+        if (left.tv_nsec < 0) {
+            left.tv_sec -= 1;
+            left.tv_nsec += 1000000000L;
+        }
+        if (left.tv_sec < 0) {
+            return false;
+        }
+        // FUTEX_WAIT, not the private variant: the word is shared
+        // between processes
+        syscall(SYS_futex, reinterpret_cast<int*>(word), FUTEX_WAIT, value,
+                &left, NULL, 0);
+    }
+    return true;
+}
+
+#endif // FG_HAVE_SHM_FDM
+
+#endif // _FG_SHM_SEGMENT_HXX
@@ -43,6 +43,8 @@
 #include <Aircraft/controls.hxx>
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
+#include <Main/snapshot.hxx>
 
 #include "JSBSim.hxx"
 #include <FDM/JSBSim/FGFDMExec.h>
@@ -539,6 +541,7 @@ void FGJSBsim::update( double dt )
     trimmed->setBoolValue(false);
 
     for ( int i=0; i < multiloop; i++ ) {
+      flightgear::ProfileScope scope("fdm", "jsbsim-iteration");
       if (!fdmex->Run()) {
         // The property fdm/jsbsim/simulation/terminate has been set to true
         // by the user. The sim is considered crashed.
@@ -597,6 +600,57 @@ void FGJSBsim::resume()
 
 /******************************************************************************/
 
+void FGJSBsim::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+  FGInterface::saveSnapshot(w);
+
+  const FGPropagate::VehicleState& vstate = Propagate->GetVState();
+  w.put<double>(fdmex->GetSimTime());
+  w.put<double>(vstate.vLocation.GetEPA());
+  for (unsigned int i = 1; i <= 3; i++) {
+    w.put<double>(vstate.vLocation(i));
+    w.put<double>(vstate.vUVW(i));
+    w.put<double>(vstate.vPQR(i));
+    w.put<double>(vstate.vInertialPosition(i));
+  }
+  for (unsigned int i = 1; i <= 4; i++)
+    w.put<double>(vstate.qAttitudeECI(i));
+}
+
+/******************************************************************************/
+
+bool FGJSBsim::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+  SnapshotState state;
+  if (!readSnapshot(r, state))
+    return false;
+
+  // start from the current state, which has the ellipsoid of the location
+  FGPropagate::VehicleState vstate = Propagate->GetVState();
+  double simTime = r.get<double>();
+  vstate.vLocation.SetEarthPositionAngle(r.get<double>());
+  for (unsigned int i = 1; i <= 3; i++) {
+    vstate.vLocation(i) = r.get<double>();
+    vstate.vUVW(i) = r.get<double>();
+    vstate.vPQR(i) = r.get<double>();
+    vstate.vInertialPosition(i) = r.get<double>();
+  }
+  for (unsigned int i = 1; i <= 4; i++)
+    vstate.qAttitudeECI(i) = r.get<double>();
+
+  if (r.failed())
+    return false;
+
+  applySnapshot(state);
+  fdmex->Setsim_time(simTime);
+  Propagate->SetVState(vstate);
+  // the integrators have no history for the restored state
+  Propagate->InitializeDerivatives();
+  return true;
+}
+
+/******************************************************************************/
+
 // Convert from the FGInterface struct to the JSBsim generic_ struct
 
 bool FGJSBsim::copy_to_JSBsim()
@@ -215,6 +215,10 @@ public:
         @param dt delta time in seconds. */
     void update(double dt);
 
+    // Snapshots: the integrator state on top of the flight state
+    virtual void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    virtual bool restoreSnapshot(flightgear::SnapshotReader& r);
+
     bool ToggleDataLogging(bool state);
     bool ToggleDataLogging(void);
 
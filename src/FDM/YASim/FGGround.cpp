@@ -51,6 +51,31 @@ void FGGround::getGroundPlane(const double pos[3],
     for(int i=0; i<3; i++) vel[i] = dvel[i];
 }
 
+void FGGround::getGroundPlanes(int n, const double* pos,
+                               double* planes, float* vel,
+                               const simgear::BVHMaterial **materials)
+{
+    // Return values for the callback.
+    _agl.resize(12*n);
+    _ids.resize(n);
+    double* cp = &_agl[0];
+    double* normal = &_agl[3*n];
+    double* dvel = &_agl[6*n];
+    double* dangvel = &_agl[9*n];
+    _iface->get_agl_m(_toff, n, pos, 2, cp, normal, dvel, dangvel,
+                      materials, &_ids[0]);
+
+    for(int j=0; j<n; j++) {
+        double* plane = planes + 4*j;
+        for(int i=0; i<3; i++) plane[i] = normal[3*j+i];
+
+        // The plane below the actual contact point.
+        plane[3] = plane[0]*cp[3*j] + plane[1]*cp[3*j+1] + plane[2]*cp[3*j+2];
+
+        for(int i=0; i<3; i++) vel[3*j+i] = dvel[3*j+i];
+    }
+}
+
 bool FGGround::caughtWire(const double pos[4][3])
 {
     return _iface->caught_wire_m(_toff, pos);
@@ -1,6 +1,10 @@
 #ifndef _FGGROUND_HPP
 #define _FGGROUND_HPP
 
+#include <vector>
+
+#include <simgear/bvh/BVHNode.hxx>
+
 #include "Ground.hpp"
 
 class FGInterface;
@@ -25,6 +29,10 @@ public:
                                 double plane[4], float vel[3],
                                 const simgear::BVHMaterial **material);
 
+    virtual void getGroundPlanes(int n, const double* pos,
+                                 double* planes, float* vel,
+                                 const simgear::BVHMaterial **materials);
+
     virtual bool caughtWire(const double pos[4][3]);
 
     virtual bool getWire(double end[2][3], float vel[2][3]);
@@ -39,6 +47,11 @@ public:
 private:
     FGInterface *_iface;
     double _toff;
+
+    // scratch space of getGroundPlanes(): contact points, normals,
+    // velocities and angular velocities
+    std::vector<double> _agl;
+    std::vector<simgear::BVHNode::Id> _ids;
 };
 
 }; // namespace yasim
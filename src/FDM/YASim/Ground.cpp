@@ -40,6 +40,16 @@ void Ground::getGroundPlane(const double pos[3],
     getGroundPlane(pos,plane,vel);
 }
 
+void Ground::getGroundPlanes(int n, const double* pos,
+                             double* planes, float* vel,
+                             const simgear::BVHMaterial **materials)
+{
+    for(int i=0; i<n; i++) {
+        materials[i] = 0;
+        getGroundPlane(pos + 3*i, planes + 4*i, vel + 3*i, materials + i);
+    }
+}
+
 bool Ground::caughtWire(const double pos[4][3])
 {
     return false;
@@ -18,6 +18,13 @@ public:
                                 double plane[4], float vel[3],
                                 const simgear::BVHMaterial **material);
 
+    // The ground planes below n points at once: pos, plane and vel
+    // hold 3, 4 and 3 values per point.  The default asks for one
+    // point after the other.
+    virtual void getGroundPlanes(int n, const double* pos,
+                                 double* planes, float* vel,
+                                 const simgear::BVHMaterial **materials);
+
     virtual bool caughtWire(const double pos[4][3]);
 
     virtual bool getWire(double end[2][3], float vel[2][3]);
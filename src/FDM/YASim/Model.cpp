@@ -187,12 +187,22 @@ void Model::setGroundEffect(const float* pos, float span, float mul)
 
 void Model::updateGround(State* s)
 {
-    float dummy[3];
-    _ground_cb->getGroundPlane(s->pos, _global_ground, dummy);
+    // Ask for the ground below all points at once: the aircraft
+    // itself, the gear contact points, the hitches and the tips of
+    // hook and launchbar, in that order.
+    int nGears = _gears.size();
+    int nHitches = _hitches.size();
+    int n = 1 + nGears + nHitches + (_hook ? 1 : 0) + (_launchbar ? 1 : 0);
+    _groundPos.resize(3*n);
+    _groundPlanes.resize(4*n);
+    _groundVel.resize(3*n);
+    _groundMaterials.resize(n);
+
+    int i, j = 1;
+    for(i=0; i<3; i++)
+        _groundPos[i] = s->pos[i];
 
-    int i;
-    // The landing gear
-    for(i=0; i<_gears.size(); i++) {
+    for(i=0; i<nGears; i++, j++) {
 	Gear* g = (Gear*)_gears.get(i);
 
 	// Get the point of ground contact
@@ -204,18 +214,10 @@ void Model::updateGround(State* s)
 	Math::add3(cmpr, pos, pos);
         // Transform the local coordinates of the contact point to
         // global coordinates.
-        double pt[3];
-        s->posLocalToGlobal(pos, pt);
-
-        // Ask for the ground plane in the global coordinate system
-        double global_ground[4];
-        float global_vel[3];
-        const simgear::BVHMaterial* material;
-        _ground_cb->getGroundPlane(pt, global_ground, global_vel, &material);
-        g->setGlobalGround(global_ground, global_vel, pt[0], pt[1], material);
+        s->posLocalToGlobal(pos, &_groundPos[3*j]);
     }
 
-    for(i=0; i<_hitches.size(); i++) {
+    for(i=0; i<nHitches; i++, j++) {
         Hitch* h = (Hitch*)_hitches.get(i);
 
         // Get the point of interest
@@ -224,14 +226,33 @@ void Model::updateGround(State* s)
 
         // Transform the local coordinates of the contact point to
         // global coordinates.
-        double pt[3];
-        s->posLocalToGlobal(pos, pt);
-
-        // Ask for the ground plane in the global coordinate system
-        double global_ground[4];
-        float global_vel[3];
-        _ground_cb->getGroundPlane(pt, global_ground, global_vel);
-        h->setGlobalGround(global_ground, global_vel);
+        s->posLocalToGlobal(pos, &_groundPos[3*j]);
+    }
+
+    if(_hook)
+        _hook->getTipGlobalPosition(s, &_groundPos[3*j++]);
+    if(_launchbar)
+        _launchbar->getTipGlobalPosition(s, &_groundPos[3*j++]);
+
+    // Ask for the ground planes in the global coordinate system
+    _ground_cb->getGroundPlanes(n, &_groundPos[0], &_groundPlanes[0],
+                                &_groundVel[0], &_groundMaterials[0]);
+
+    for(i=0; i<4; i++)
+        _global_ground[i] = _groundPlanes[i];
+    j = 1;
+
+    // The landing gear
+    for(i=0; i<nGears; i++, j++) {
+	Gear* g = (Gear*)_gears.get(i);
+        const double* pt = &_groundPos[3*j];
+        g->setGlobalGround(&_groundPlanes[4*j], &_groundVel[3*j],
+                           pt[0], pt[1], _groundMaterials[j]);
+    }
+
+    for(i=0; i<nHitches; i++, j++) {
+        Hitch* h = (Hitch*)_hitches.get(i);
+        h->setGlobalGround(&_groundPlanes[4*j], &_groundVel[3*j]);
     }
 
     for(i=0; i<_rotorgear.getRotors()->size(); i++) {
@@ -240,22 +261,12 @@ void Model::updateGround(State* s)
     }
 
     // The arrester hook
-    if(_hook) {
-        double pt[3];
-        _hook->getTipGlobalPosition(s, pt);
-        double global_ground[4];
-        _ground_cb->getGroundPlane(pt, global_ground, dummy);
-        _hook->setGlobalGround(global_ground);
-    }
+    if(_hook)
+        _hook->setGlobalGround(&_groundPlanes[4*j++]);
 
     // The launchbar/holdback
-    if(_launchbar) {
-        double pt[3];
-        _launchbar->getTipGlobalPosition(s, pt);
-        double global_ground[4];
-        _ground_cb->getGroundPlane(pt, global_ground, dummy);
-        _launchbar->setGlobalGround(global_ground);
-    }
+    if(_launchbar)
+        _launchbar->setGlobalGround(&_groundPlanes[4*j++]);
 }
 
 void Model::calcForces(State* s)
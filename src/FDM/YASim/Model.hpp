@@ -10,6 +10,12 @@
 #include "Atmosphere.hpp"
 #include <simgear/props/props.hxx>
 
+#include <vector>
+
+namespace simgear {
+class BVHMaterial;
+}
+
 namespace yasim {
 
 // Declare the types whose pointers get passed around here
@@ -103,6 +109,11 @@ private:
 
     Ground* _ground_cb;
     double _global_ground[4] {0,0,1, -1e5};
+    // the points updateGround() asks the ground for, and the answers
+    std::vector<double> _groundPos;
+    std::vector<double> _groundPlanes;
+    std::vector<float> _groundVel;
+    std::vector<const simgear::BVHMaterial*> _groundMaterials;
     Atmosphere _atmo;
     float _wind[3] {0,0,0};
     
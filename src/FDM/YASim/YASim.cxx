@@ -14,6 +14,8 @@
 
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
+#include <Main/snapshot.hxx>
 
 #include "yasim-common.hpp"
 #include "FGFDM.hpp"
@@ -266,6 +268,7 @@ void YASim::update(double dt)
 
     int i;
     for(i=0; i<iterations; i++) {
+        flightgear::ProfileScope scope("fdm", "yasim-iteration");
         gr->setTimeOffset(_simTime + i*_dt);
         copyToYASim(false);
         _fdm->iterate(_dt);
@@ -277,6 +280,36 @@ void YASim::update(double dt)
     gr->setTimeOffset(_simTime);
 }
 
+void YASim::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+    FGInterface::saveSnapshot(w);
+
+    Model* model = _fdm->getAirplane()->getModel();
+    w.put<double>(_simTime);
+    w.put<State>(*model->getState());
+    w.put<uint8_t>(model->isCrashed());
+}
+
+bool YASim::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+    SnapshotState state;
+    if (!readSnapshot(r, state))
+        return false;
+
+    double simTime = r.get<double>();
+    State s = r.get<State>();
+    bool crashed = r.get<uint8_t>() != 0;
+    if (r.failed())
+        return false;
+
+    applySnapshot(state);
+    Model* model = _fdm->getAirplane()->getModel();
+    _simTime = simTime;
+    model->setState(&s);
+    model->setCrashed(crashed);
+    return true;
+}
+
 void YASim::copyToYASim(bool copyState)
 {
     // Physical state
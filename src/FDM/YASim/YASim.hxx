@@ -19,6 +19,10 @@ public:
     // Run an iteration
     virtual void update(double dt);
 
+    // Snapshots: the integrator state on top of the flight state
+    virtual void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    virtual bool restoreSnapshot(flightgear::SnapshotReader& r);
+
  private:
 
     void report();
@@ -33,6 +33,7 @@
 #include <Aircraft/replay.hxx>
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
 #include <Scenery/scenery.hxx>
 #include "AIModel/AIManager.hxx"
 #include "AIModel/AIAircraft.hxx"
@@ -199,15 +200,19 @@ void FDMShell::update(double dt)
 
   // AI aerodynamic wake interaction
   if (_ai_wake_enabled->getBoolValue()) {
-      for (FGAIBase* base : _ai_mgr->get_ai_list()) {
+      SGVec3d pos = _impl->getCartPosition();
+      double maxRangeM = _max_radius_nm->getDoubleValue()*SG_NM_TO_METER;
+      std::vector<FGAIBase*> nearby;
+      _ai_mgr->findObjectsInRange(pos, maxRangeM, nearby);
+
+      for (FGAIBase* base : nearby) {
           try {
               if (base->isa(FGAIBase::otAircraft) ) {
-                  SGVec3d pos = _impl->getCartPosition();
                   const SGSharedPtr<FGAIAircraft> aircraft = dynamic_cast<FGAIAircraft*>(base);
                   double range = _ai_mgr->calcRangeFt(pos, aircraft)*SG_FEET_TO_METER;
 
                   if (!aircraft->onGround() && aircraft->getSpeed() > 0.0
-                      && range < _max_radius_nm->getDoubleValue()*SG_NM_TO_METER) {
+                      && range < maxRangeM) {
                       _impl->add_ai_wake(aircraft);
                   }
               }
@@ -248,7 +253,10 @@ void FDMShell::update(double dt)
   {
       case 0:
           // normal FDM operation
-          _impl->update(dt);
+          {
+              flightgear::ProfileScope scope("fdm", "fdm-update");
+              _impl->update(dt);
+          }
           break;
       case 3:
           // resume FDM operation at current replay position
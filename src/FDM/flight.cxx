@@ -35,6 +35,7 @@
 #include <Scenery/scenery.hxx>
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/snapshot.hxx>
 #include <FDM/groundcache.hxx>
 
 
@@ -443,6 +444,34 @@ FGInterface::update (double dt)
     SG_LOG(SG_FLIGHT, SG_ALERT, "dummy update() ... SHOULDN'T BE CALLED!");
 }
 
+void FGInterface::saveSnapshot(flightgear::SnapshotWriter& w) const
+{
+    w.put<uint32_t>(sizeof(FlightState));
+    w.put<FlightState>(_state);
+}
+
+bool FGInterface::readSnapshot(flightgear::SnapshotReader& r,
+                               SnapshotState& state) const
+{
+    if (r.get<uint32_t>() != sizeof(FlightState)) {
+        return false;
+    }
+
+    state = r.get<FlightState>();
+    return !r.failed();
+}
+
+bool FGInterface::restoreSnapshot(flightgear::SnapshotReader& r)
+{
+    SnapshotState state;
+    if (!readSnapshot(r, state)) {
+        return false;
+    }
+
+    applySnapshot(state);
+    return true;
+}
+
 bool FGInterface::readState(SGIOChannel* io)
 {
     FlightState buf;
@@ -752,6 +781,32 @@ FGInterface::get_agl_m(double t, const double pt[3], double max_altoff,
   return ret;
 }
 
+void
+FGInterface::get_agl_m(double t, size_t n, const double* pt, double max_altoff,
+                       double* contact, double* normal, double* linearVel,
+                       double* angularVel, simgear::BVHMaterial const** material,
+                       simgear::BVHNode::Id* id)
+{
+  _aglQueries.resize(n);
+  for (size_t i = 0; i < n; ++i)
+    _aglQueries[i].pt = SGVec3d(pt + 3*i) - max_altoff*ground_cache.get_down();
+
+  ground_cache.get_agl(t, n ? &_aglQueries[0] : 0, n);
+
+  for (size_t i = 0; i < n; ++i) {
+    const FGGroundCache::AglQuery& q = _aglQueries[i];
+    // as in get_agl_m for a single point, the velocity at the contact point
+    SGVec3d vel = q.linearVel + cross(q.angularVel, q.contact - q.pt);
+
+    assign(contact + 3*i, q.contact);
+    assign(normal + 3*i, q.normal);
+    assign(linearVel + 3*i, vel);
+    assign(angularVel + 3*i, q.angularVel);
+    material[i] = q.material;
+    id[i] = q.id;
+  }
+}
+
 bool
 FGInterface::get_agl_ft(double t, const double pt[3], double max_altoff,
                         double contact[3], double normal[3],
@@ -89,6 +89,11 @@ class BVHMaterial;
 class SGIOChannel;
 class FGAIAircraft;
 
+namespace flightgear {
+class SnapshotWriter;
+class SnapshotReader;
+}
+
 /**
  * A little helper class to update the track if
  * the position has changed. In the constructor, 
@@ -209,6 +214,8 @@ class FGInterface : public SGSubsystem {
 
     // the ground cache object itself.
     FGGroundCache ground_cache;
+    // scratch space of the batched get_agl_m()
+    std::vector<FGGroundCache::AglQuery> _aglQueries;
 
     AIWakeGroup wake_group;
 
@@ -226,6 +233,13 @@ protected:
 
     int _calc_multiloop (double dt);
 
+    // For models which add their own state to a snapshot: read the flight
+    // state with readSnapshot(), then the rest, and only once nothing
+    // failed apply it all, the flight state with applySnapshot().
+    typedef FlightState SnapshotState;
+    bool readSnapshot(flightgear::SnapshotReader& r, SnapshotState& state) const;
+    void applySnapshot(const SnapshotState& state) { _state = state; }
+
 
 				// deliberately not virtual so that
 				// FGInterface constructor will call
@@ -400,6 +414,14 @@ public:
 
     bool readState(SGIOChannel* io);
     bool writeState(SGIOChannel* io);
+
+    // Snapshots of the model state, see Main/snapshot.hxx. The default
+    // keeps the flight state of FGInterface, which is all there is for
+    // models without an integrator of their own; those that have one
+    // add its state. restoreSnapshot() reads everything before it
+    // changes anything, and returns false if the data was damaged.
+    virtual void saveSnapshot(flightgear::SnapshotWriter& w) const;
+    virtual bool restoreSnapshot(flightgear::SnapshotReader& r);
     
     // Define the various supported flight models (many not yet implemented)
     enum {
@@ -720,6 +742,13 @@ public:
                     double contact[3], double normal[3], double linearVel[3],
                     double angularVel[3], simgear::BVHMaterial const*& material,
                     simgear::BVHNode::Id& id);
+    // get_agl_m() for n points at once, pt, contact, normal, linearVel and
+    // angularVel holding three values per point. Asking for the same points
+    // in the same order every time is fastest.
+    void get_agl_m(double t, size_t n, const double* pt, double max_altoff,
+                   double* contact, double* normal, double* linearVel,
+                   double* angularVel, simgear::BVHMaterial const** material,
+                   simgear::BVHNode::Id* id);
     double get_groundlevel_m(double lat, double lon, double alt);
     double get_groundlevel_m(const SGGeod& geod);
 
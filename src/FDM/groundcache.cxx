@@ -26,6 +26,8 @@
 
 #include "groundcache.hxx"
 
+#include <cassert>
+#include <thread>
 #include <utility>
 
 #include <osg/Drawable>
@@ -62,10 +64,14 @@
 
 #ifdef GROUNDCACHE_DEBUG
 #include <simgear/scene/model/BVHDebugCollectVisitor.hxx>
-#include <Main/fg_props.hxx>
 #endif
 
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/timing/timestamp.hxx>
+
 #include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
 #include <Scenery/scenery.hxx>
 
 #include "flight.hxx"
@@ -292,6 +298,280 @@ private:
     bool _haveHit;
 };
 
+namespace {
+
+// how many seconds of flight a prefetched sphere covers
+const double prefetchLookaheadSec = 4.0;
+// margin around the predicted path, meters
+const double prefetchMarginM = 100.0;
+// scenery loaded meanwhile is picked up at least this often, seconds
+const double prefetchMaxAgeSec = 10.0;
+const unsigned maxBuilderThreads = 3;
+
+}
+
+/**
+ * Finds the bounding volume trees of the terrain below a sphere, each one
+ * with the transforms above it. Uses the same traversal rules as
+ * CacheFill, but does not look into the trees: that is what makes it
+ * cheap enough to do on the main thread, the only place the scene graph
+ * may be traversed.
+ */
+class FGGroundCache::TileFinder : public osg::NodeVisitor {
+public:
+    TileFinder(const SGVec3d& center, const SGVec3d& down, double radius) :
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN),
+        _center(center),
+        _down(down),
+        _radius(radius),
+        _maxDown(SGGeod::fromCart(center).getElevationM() + 9999),
+        _dynamic(false)
+    {
+        setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
+    }
+    virtual void apply(osg::Node& node)
+    {
+        if (!testBoundingSphere(node.getBound()))
+            return;
+
+        addBoundingVolume(node);
+    }
+
+    virtual void apply(osg::Group& group)
+    {
+        if (!testBoundingSphere(group.getBound()))
+            return;
+
+        traverse(group);
+        addBoundingVolume(group);
+    }
+
+    virtual void apply(osg::Transform& transform)
+    { handleTransform(transform); }
+    virtual void apply(osg::Camera& camera)
+    {
+        if (camera.getRenderOrder() != osg::Camera::NESTED_RENDER)
+            return;
+        handleTransform(camera);
+    }
+    virtual void apply(osg::CameraView& transform)
+    { handleTransform(transform); }
+    virtual void apply(osg::MatrixTransform& transform)
+    { handleTransform(transform); }
+    virtual void apply(osg::PositionAttitudeTransform& transform)
+    { handleTransform(transform); }
+
+    void handleTransform(osg::Transform& transform)
+    {
+        if (transform.getReferenceFrame() != osg::Transform::RELATIVE_RF)
+            return;
+
+        if (!testBoundingSphere(transform.getBound()))
+            return;
+
+        SGSceneUserData* userData = SGSceneUserData::getSceneUserData(&transform);
+        if (userData && userData->getVelocity()) {
+            // moving, like a carrier deck: only valid for one cache
+            _dynamic = true;
+            return;
+        }
+
+        osg::Matrix inverseMatrix;
+        if (!transform.computeWorldToLocalMatrix(inverseMatrix, this))
+            return;
+        osg::Matrix matrix;
+        if (!transform.computeLocalToWorldMatrix(matrix, this))
+            return;
+
+        SGVec3d center = _center;
+        SGVec3d down = _down;
+        osg::Matrix toWorld = _toWorld;
+
+        _center = toSG(inverseMatrix.preMult(toOsg(_center)));
+        _down = toSG(osg::Matrix::transform3x3(toOsg(_down), inverseMatrix));
+        _toWorld = matrix * _toWorld;
+
+        addBoundingVolume(transform);
+        traverse(transform);
+
+        _center = center;
+        _down = down;
+        _toWorld = toWorld;
+    }
+
+    void addBoundingVolume(osg::Node& node)
+    {
+        SGSceneUserData* userData = SGSceneUserData::getSceneUserData(&node);
+        simgear::BVHNode* bvNode = userData ? userData->getBVHNode() : 0;
+        if (!bvNode)
+            return;
+
+        if (_toWorld.isIdentity()) {
+            _tiles.push_back(bvNode);
+        } else {
+            simgear::BVHTransform* bvhTransform = new simgear::BVHTransform;
+            bvhTransform->setToWorldTransform(SGMatrixd(_toWorld.ptr()));
+            bvhTransform->addChild(bvNode);
+            _tiles.push_back(bvhTransform);
+        }
+    }
+
+    bool testBoundingSphere(const osg::BoundingSphere& bound) const
+    {
+        if (!bound.valid())
+            return false;
+
+        SGLineSegmentd downSeg(_center, _center + _maxDown*_down);
+        double maxDist = bound._radius + _radius;
+        SGVec3d boundCenter(toVec3d(toSG(bound._center)));
+        return distSqr(downSeg, boundCenter) <= maxDist*maxDist;
+    }
+
+    std::vector<SGSharedPtr<simgear::BVHNode> >& getTiles()
+    { return _tiles; }
+    bool getDynamic() const
+    { return _dynamic; }
+
+private:
+    SGVec3d _center;
+    SGVec3d _down;
+    double _radius;
+    double _maxDown;
+    osg::Matrix _toWorld;
+    bool _dynamic;
+    std::vector<SGSharedPtr<simgear::BVHNode> > _tiles;
+};
+
+/**
+ * Threads extracting the geometry within a prefetch sphere from the tiles
+ * the TileFinder found, one tile per task. Bounding volume trees do not
+ * change once attached to the scene graph, and are kept alive by the
+ * prefetch holding them, so this needs no other synchronisation.
+ */
+class FGGroundCache::Builder {
+public:
+    Builder() :
+        _job(0),
+        _next(0),
+        _remaining(0),
+        _finished(0),
+        _stopping(false)
+    {
+        // leave one processor to the main thread
+        unsigned n = std::thread::hardware_concurrency();
+        n = SGMisc<unsigned>::clip(n ? n - 1 : 1, 1, maxBuilderThreads);
+        for (unsigned i = 0; i < n; ++i) {
+            _workers.push_back(new Worker(this));
+            _workers.back()->start();
+        }
+    }
+
+    ~Builder()
+    {
+        {
+            SGGuard<SGMutex> g(_lock);
+            _stopping = true;
+            _changed.broadcast();
+        }
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            _workers[i]->join();
+            delete _workers[i];
+        }
+    }
+
+    /// start building, only one prefetch is built at a time
+    void submit(Prefetch* p)
+    {
+        SGGuard<SGMutex> g(_lock);
+        assert(!_job && !_finished);
+        p->parts.resize(p->tiles.size());
+        _job = p;
+        _next = 0;
+        _remaining = p->tiles.size();
+        _started.stamp();
+        if (_remaining == 0) {
+            finish();
+        }
+        _changed.broadcast();
+    }
+
+    /// the prefetch done building, if there is one
+    Prefetch* takeFinished(bool wait)
+    {
+        SGGuard<SGMutex> g(_lock);
+        while (wait && _job) {
+            _changed.wait(_lock);
+        }
+        Prefetch* p = _finished;
+        _finished = 0;
+        return p;
+    }
+
+private:
+    class Worker : public SGThread {
+    public:
+        Worker(Builder* builder) : _builder(builder) {}
+    protected:
+        virtual void run()
+        { _builder->run(); }
+    private:
+        Builder* _builder;
+    };
+
+    void run()
+    {
+        for (;;) {
+            Prefetch* p;
+            size_t i;
+            {
+                SGGuard<SGMutex> g(_lock);
+                while (!_stopping && (!_job || _next == _job->tiles.size())) {
+                    _changed.wait(_lock);
+                }
+                if (_stopping)
+                    return;
+                p = _job;
+                i = _next++;
+            }
+
+            simgear::BVHSubTreeCollector collector(SGSphered(p->center, p->radius));
+            p->tiles[i]->accept(collector);
+            p->parts[i] = collector.getNode();
+
+            SGGuard<SGMutex> g(_lock);
+            if (--_remaining == 0) {
+                finish();
+                _changed.broadcast();
+            }
+        }
+    }
+
+    // called with the lock held
+    void finish()
+    {
+        simgear::BVHGroup* group = new simgear::BVHGroup;
+        for (size_t i = 0; i < _job->parts.size(); ++i) {
+            if (_job->parts[i])
+                group->addChild(_job->parts[i].ptr());
+        }
+        _job->parts.clear();
+        _job->tree = group;
+        _job->buildMs = (SGTimeStamp::now() - _started).toMSecs();
+        _finished = _job;
+        _job = 0;
+    }
+
+    SGMutex _lock;
+    SGWaitCondition _changed;
+    Prefetch* _job;
+    size_t _next;
+    size_t _remaining;
+    Prefetch* _finished;
+    SGTimeStamp _started;
+    bool _stopping;
+    std::vector<Worker*> _workers;
+};
+
 FGGroundCache::FGGroundCache() :
     _altitude(0),
     _material(0),
@@ -301,8 +581,17 @@ FGGroundCache::FGGroundCache() :
     reference_wgs84_point(SGVec3d(0, 0, 0)),
     reference_vehicle_radius(0),
     down(0.0, 0.0, 0.0),
-    found_ground(false)
+    found_ground(false),
+    _lastPoint(0, 0, 0),
+    _lastTime(0),
+    _velocity(0, 0, 0)
 {
+    _prefetchEnabledNode = fgGetNode("/fdm/groundcache/prefetch", true);
+    if (_prefetchEnabledNode->getType() == simgear::props::NONE)
+        _prefetchEnabledNode->setBoolValue(true);
+    _prepareMsNode = fgGetNode("/fdm/groundcache/prepare-ms", true);
+    _prefetchBuildMsNode = fgGetNode("/fdm/groundcache/prefetch-build-ms", true);
+
 #ifdef GROUNDCACHE_DEBUG
     _lookupTime = SGTimeStamp::fromSec(0.0);
     _lookupCount = 0;
@@ -313,6 +602,102 @@ FGGroundCache::FGGroundCache() :
 
 FGGroundCache::~FGGroundCache()
 {
+    // the builder may still be working on the pending prefetch
+    _builder.reset();
+}
+
+bool
+FGGroundCache::contains(const Prefetch& p, const SGVec3d& pt, double rad)
+{
+    double d = p.radius - rad;
+    return (0 <= d) && (distSqr(p.center, pt) <= d*d);
+}
+
+void
+FGGroundCache::requestPrefetch(double simTime, const SGVec3d& pt, double rad)
+{
+    // cover the next seconds of flight along the current velocity
+    SGVec3d ahead = (0.5*prefetchLookaheadSec)*_velocity;
+    std::unique_ptr<Prefetch> p(new Prefetch);
+    p->center = pt + ahead;
+    p->radius = rad + norm(ahead) + prefetchMarginM;
+    p->requestTime = simTime;
+
+    // missing tiles would look like missing ground, so only use scenery
+    // which is there already
+    if (!globals->get_scenery()->scenery_available(SGGeod::fromCart(p->center),
+                                                   p->radius))
+        return;
+
+    SGGeod geodCenter = SGGeod::fromCart(p->center);
+    SGVec3d pdown = SGQuatd::fromLonLat(geodCenter).rotate(SGVec3d(0, 0, 1));
+    TileFinder tileFinder(p->center, pdown, p->radius);
+    globals->get_scenery()->get_scene_graph()->accept(tileFinder);
+    p->dynamic = tileFinder.getDynamic();
+    p->tiles.swap(tileFinder.getTiles());
+
+    simgear::BVHGroup* tileTree = new simgear::BVHGroup;
+    for (size_t i = 0; i < p->tiles.size(); ++i)
+        tileTree->addChild(p->tiles[i].ptr());
+    p->tileTree = tileTree;
+
+    if (p->dynamic) {
+        // nothing to build, but remember not to look again right away
+        _prefetch = std::move(p);
+        return;
+    }
+
+    if (!_builder)
+        _builder.reset(new Builder);
+    _builder->submit(p.get());
+    _pendingPrefetch = std::move(p);
+}
+
+bool
+FGGroundCache::updatePrefetch(double simTime, const SGVec3d& pt, double rad)
+{
+    // the velocity, from the positions the cache was asked for
+    double dt = simTime - _lastTime;
+    if ((0 < dt) && (dt < 1)) {
+        SGVec3d velocity = (pt - _lastPoint)/dt;
+        // a jump, the position was reset
+        if (norm(velocity) < 2000)
+            _velocity = velocity;
+        else
+            _velocity = SGVec3d::zeros();
+    }
+    _lastPoint = pt;
+    _lastTime = simTime;
+
+    if (!_prefetchEnabledNode->getBoolValue()) {
+        if (_builder)
+            _builder->takeFinished(true);
+        _pendingPrefetch.reset();
+        _prefetch.reset();
+        return false;
+    }
+
+    if (_pendingPrefetch) {
+        // wait for the pending one only if it is needed right now
+        bool wait = (!_prefetch || !contains(*_prefetch, pt, rad)) &&
+            contains(*_pendingPrefetch, pt, rad);
+        if (_builder->takeFinished(wait)) {
+            _prefetch = std::move(_pendingPrefetch);
+            _prefetchBuildMsNode->setDoubleValue(_prefetch->buildMs);
+        }
+    }
+
+    bool usable = _prefetch && contains(*_prefetch, pt, rad);
+    if (!_pendingPrefetch) {
+        double age = usable ? simTime - _prefetch->requestTime : 0;
+        bool moving = 1 < norm(_velocity);
+        // half way through the current one, the next is due
+        if (!usable || (age < 0) || (prefetchMaxAgeSec < age) ||
+            (moving && 0.5*prefetchLookaheadSec < age))
+            requestPrefetch(simTime, pt, rad);
+    }
+
+    return usable && !_prefetch->dynamic;
 }
 
 bool
@@ -324,9 +709,7 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
         rad = 10000.0;
     }
     
-#ifdef GROUNDCACHE_DEBUG
     SGTimeStamp t0 = SGTimeStamp::now();
-#endif
 
     // Empty cache.
     found_ground = false;
@@ -356,19 +739,40 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
     down = hlToEc.rotate(SGVec3d(0, 0, 1));
     
     // Get the ground cache, that is a local collision tree of the environment
+    bool usePrefetch = updatePrefetch(startSimTime, pt, rad);
     startSimTime += cache_time_offset;
     endSimTime += cache_time_offset;
-    CacheFill subtreeCollector(pt, down, rad, startSimTime, endSimTime);
-    globals->get_scenery()->get_scene_graph()->accept(subtreeCollector);
-    _localBvhTree = subtreeCollector.getBVHNode();
-
-    if (subtreeCollector.getHaveElevationBelowCache()) {
-        // Use the altitude value below the cache that we gathered during
-        // cache collection
-        _altitude = subtreeCollector.getElevationBelowCache();
-        _material = subtreeCollector.getMaterialBelowCache();
-        found_ground = true;
-    } else if (_localBvhTree) {
+    if (usePrefetch) {
+        // Everything within our sphere is in the prefetched tree already
+        simgear::BVHSubTreeCollector collector(SGSphered(pt, rad));
+        _prefetch->tree->accept(collector);
+        _localBvhTree = collector.getNode();
+
+        // The ground below can be far outside of the prefetched sphere
+        double maxDown = geodPt.getElevationM() + 9999;
+        SGLineSegmentd line(pt + rad*down, pt + maxDown*down);
+        simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, startSimTime);
+        _prefetch->tileTree->accept(lineSegmentVisitor);
+        if (!lineSegmentVisitor.empty()) {
+            _altitude = SGGeod::fromCart(lineSegmentVisitor.getPoint()).getElevationM();
+            _material = lineSegmentVisitor.getMaterial();
+            found_ground = true;
+        }
+    } else {
+        CacheFill subtreeCollector(pt, down, rad, startSimTime, endSimTime);
+        globals->get_scenery()->get_scene_graph()->accept(subtreeCollector);
+        _localBvhTree = subtreeCollector.getBVHNode();
+
+        if (subtreeCollector.getHaveElevationBelowCache()) {
+            // Use the altitude value below the cache that we gathered during
+            // cache collection
+            _altitude = subtreeCollector.getElevationBelowCache();
+            _material = subtreeCollector.getMaterialBelowCache();
+            found_ground = true;
+        }
+    }
+
+    if (!found_ground && _localBvhTree) {
         // We have nothing below us, so try starting with the lowest point
         // upwards for a croase altitude value
         SGLineSegmentd line(pt + reference_vehicle_radius*down, pt - 1e3*down);
@@ -398,6 +802,8 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
         SG_LOG(SG_FLIGHT, SG_WARN, "prepare_ground_cache(): trying to build "
                "cache without any scenery below the aircraft");
 
+    _prepareMsNode->setDoubleValue((SGTimeStamp::now() - t0).toMSecs());
+
 #ifdef GROUNDCACHE_DEBUG
     t0 = SGTimeStamp::now() - t0;
     _buildTime += t0;
@@ -728,22 +1134,83 @@ FGGroundCache::get_agl(double t, const SGVec3d& pt, SGVec3d& contact,
 
         return true;
     } else {
-        // Whenever we did not have a ground triangle for the requested point,
-        // take the ground level we found during the current cache build.
-        // This is as good as what we had before for agl.
-        SGGeod geodPt = SGGeod::fromCart(pt);
-        geodPt.setElevationM(_altitude);
-        contact = SGVec3d::fromGeod(geodPt);
-        normal = -down;
-        linearVel = SGVec3d(0, 0, 0);
-        angularVel = SGVec3d(0, 0, 0);
-        material = _material;
-        id = 0;
-
-        return found_ground;
+        return get_agl_below_cache(pt, contact, normal, linearVel,
+                                   angularVel, id, material);
     }
 }
 
+void
+FGGroundCache::get_agl(double t, AglQuery* queries, size_t n)
+{
+#ifdef GROUNDCACHE_DEBUG
+    SGTimeStamp t0 = SGTimeStamp::now();
+#endif
+
+    // The hints of the last hits are only valid for the tree they are from
+    if (_aglBatchTree.get() != _localBvhTree.get()) {
+        _aglBatch.clearHints();
+        _aglBatchTree = _localBvhTree;
+    }
+
+    _aglBatch.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const SGVec3d& pt = queries[i].pt;
+        _aglBatch[i].lineSegment =
+            SGLineSegmentd(pt, pt + 10*reference_vehicle_radius*down);
+        _aglBatch[i].haveHit = false;
+    }
+    t += cache_time_offset;
+    if (_localBvhTree)
+        _aglBatch.run(*_localBvhTree, t);
+
+#ifdef GROUNDCACHE_DEBUG
+    t0 = SGTimeStamp::now() - t0;
+    _lookupTime += t0;
+    _lookupCount += n;
+#endif
+
+    for (size_t i = 0; i < n; ++i) {
+        AglQuery& q = queries[i];
+        const FGGroundQueryBatch::Query& hit = _aglBatch[i];
+        if (!hit.haveHit) {
+            q.found = get_agl_below_cache(q.pt, q.contact, q.normal, q.linearVel,
+                                          q.angularVel, q.id, q.material);
+            continue;
+        }
+
+        q.contact = hit.point;
+        q.normal = hit.normal;
+        if (0 < dot(q.normal, down))
+            q.normal = -q.normal;
+        q.linearVel = hit.linearVelocity;
+        q.angularVel = hit.angularVelocity;
+        q.material = hit.material;
+        q.id = hit.id;
+        q.found = true;
+    }
+}
+
+bool
+FGGroundCache::get_agl_below_cache(const SGVec3d& pt, SGVec3d& contact,
+                                   SGVec3d& normal, SGVec3d& linearVel,
+                                   SGVec3d& angularVel, simgear::BVHNode::Id& id,
+                                   const simgear::BVHMaterial*& material)
+{
+    // Whenever we did not have a ground triangle for the requested point,
+    // take the ground level we found during the current cache build.
+    // This is as good as what we had before for agl.
+    SGGeod geodPt = SGGeod::fromCart(pt);
+    geodPt.setElevationM(_altitude);
+    contact = SGVec3d::fromGeod(geodPt);
+    normal = -down;
+    linearVel = SGVec3d(0, 0, 0);
+    angularVel = SGVec3d(0, 0, 0);
+    material = _material;
+    id = 0;
+
+    return found_ground;
+}
+
 
 bool
 FGGroundCache::get_nearest(double t, const SGVec3d& pt, double maxDist,
@@ -29,6 +29,12 @@
 #include <simgear/math/SGGeometry.hxx>
 #include <simgear/bvh/BVHNode.hxx>
 #include <simgear/structure/SGSharedPtr.hxx>
+#include <simgear/props/propsfwd.hxx>
+
+#include <memory>
+#include <vector>
+
+#include "groundquery.hxx"
 
 // #define GROUNDCACHE_DEBUG
 #ifdef GROUNDCACHE_DEBUG
@@ -92,6 +98,25 @@ public:
                  simgear::BVHNode::Id& id,
                  const simgear::BVHMaterial*& material);
 
+    // One point of a batched get_agl(): pt is given, the rest is what
+    // get_agl() returns for it, found being its return value.
+    struct AglQuery {
+        SGVec3d pt;
+        SGVec3d contact;
+        SGVec3d normal;
+        SGVec3d linearVel;
+        SGVec3d angularVel;
+        simgear::BVHNode::Id id;
+        const simgear::BVHMaterial* material;
+        bool found;
+    };
+
+    // The same as get_agl() for each of the n queries, with a single
+    // traversal of the cache for all of them. Callers asking for the same
+    // contact points in the same order every time have the triangle each
+    // point hit last tested first.
+    void get_agl(double t, AglQuery* queries, size_t n);
+
     bool get_nearest(double t, const SGVec3d& pt, double maxDist,
                      SGVec3d& contact, SGVec3d& linearVel, SGVec3d& angularVel,
                      simgear::BVHNode::Id& id,
@@ -113,6 +138,8 @@ public:
 
 private:
     class CacheFill;
+    class TileFinder;
+    class Builder;
     class BodyFinder;
     class CatapultFinder;
     class WireIntersector;
@@ -140,6 +167,56 @@ private:
 
     SGSharedPtr<simgear::BVHNode> _localBvhTree;
 
+    /**
+     * A sphere ahead of the vehicle which the cache is filled from while the
+     * vehicle stays within it, instead of traversing the scene graph. The
+     * scene graph is only ever traversed on the main thread, to find the
+     * tiles below the sphere; extracting their geometry within the sphere
+     * is done on the builder threads, one tile at a time, and the result
+     * is swapped in once it is complete.
+     */
+    struct Prefetch {
+        Prefetch() : radius(0), requestTime(0), dynamic(false), buildMs(0) {}
+        SGVec3d center;
+        double radius;
+        double requestTime;
+        /// moving geometry below the sphere, which has to be collected
+        /// anew for every cache
+        bool dynamic;
+        /// the complete tile trees, for finding the ground below the cache
+        std::vector<SGSharedPtr<simgear::BVHNode> > tiles;
+        SGSharedPtr<simgear::BVHNode> tileTree;
+        /// results of the builder, one per tile, and all of them
+        std::vector<SGSharedPtr<simgear::BVHNode> > parts;
+        SGSharedPtr<simgear::BVHNode> tree;
+        double buildMs;
+    };
+
+    bool updatePrefetch(double simTime, const SGVec3d& pt, double rad);
+    void requestPrefetch(double simTime, const SGVec3d& pt, double rad);
+    static bool contains(const Prefetch& p, const SGVec3d& pt, double rad);
+
+    // get_agl() for a point without ground below it in the cache
+    bool get_agl_below_cache(const SGVec3d& pt, SGVec3d& contact,
+                             SGVec3d& normal, SGVec3d& linearVel,
+                             SGVec3d& angularVel, simgear::BVHNode::Id& id,
+                             const simgear::BVHMaterial*& material);
+
+    std::unique_ptr<Prefetch> _prefetch;
+    std::unique_ptr<Prefetch> _pendingPrefetch;
+    std::unique_ptr<Builder> _builder;
+    SGVec3d _lastPoint;
+    double _lastTime;
+    SGVec3d _velocity;
+
+    // the batched get_agl() queries, and the tree their hints are from
+    FGGroundQueryBatch _aglBatch;
+    SGSharedPtr<simgear::BVHNode> _aglBatchTree;
+
+    SGPropertyNode_ptr _prefetchEnabledNode;
+    SGPropertyNode_ptr _prepareMsNode;
+    SGPropertyNode_ptr _prefetchBuildMsNode;
+
 #ifdef GROUNDCACHE_DEBUG
     SGTimeStamp _lookupTime;
     unsigned _lookupCount;
@@ -0,0 +1,631 @@
+// groundquery.cxx -- ground intersections of many points in one traversal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "groundquery.hxx"
+
+#include <cmath>
+#include <deque>
+
+#include <simgear/bvh/BVHVisitor.hxx>
+#include <simgear/bvh/BVHGroup.hxx>
+#include <simgear/bvh/BVHPageNode.hxx>
+#include <simgear/bvh/BVHTransform.hxx>
+#include <simgear/bvh/BVHMotionTransform.hxx>
+#include <simgear/bvh/BVHLineGeometry.hxx>
+#include <simgear/bvh/BVHStaticGeometry.hxx>
+#include <simgear/bvh/BVHStaticData.hxx>
+#include <simgear/bvh/BVHStaticBinary.hxx>
+#include <simgear/bvh/BVHStaticTriangle.hxx>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#  define GROUNDQUERY_SSE
+#  include <xmmintrin.h>
+#endif
+
+using namespace simgear;
+
+namespace {
+
+// the tolerance of BVHLineSegmentVisitor for hits on triangle edges
+const float triangleEps = 1e-4f;
+// slack in meters for boxes, so rounding does not lose a triangle lying
+// on the face of its box
+const float boxEps = 1e-3f;
+
+}
+
+/**
+ * The segments of all queries are kept as four-wide packets of floats in
+ * the coordinates of the current transform, relative to an origin near
+ * them so that they keep their precision. Their parameter along the
+ * segment is the same in every frame, so the end of the search range,
+ * tmax, is shared by all frames.
+ *
+ * Each level of the traversal has a mask per packet of the segments which
+ * passed the bounds of the node at that level.
+ */
+class FGGroundQueryBatch::Visitor : public BVHVisitor {
+public:
+    struct Hit {
+        /// the triangle hit, in the coordinates of frame 'frame'
+        SGVec3d vertex[3];
+        SGVec3d linearVelocity;
+        SGVec3d angularVelocity;
+        BVHNode::Id id;
+        const BVHMaterial* material;
+        unsigned frame;
+        bool moving;
+    };
+
+    Visitor() :
+        _count(0),
+        _packets(0),
+        _frame(0),
+        _level(0),
+        _time(0)
+    { }
+
+    void start(const std::vector<Query>& queries, double time)
+    {
+        _count = queries.size();
+        _packets = (_count + 3)/4;
+        _time = time;
+        _frame = 0;
+        _level = 0;
+
+        _tmax.assign(4*_packets, -1.0f);
+        _haveHit.assign(_count, 0);
+        _hits.resize(_count);
+
+        Frame& f = frame(0);
+        f.segments.resize(_count);
+        std::vector<unsigned char>& m = mask(0);
+        m.assign(_packets, 0);
+        for (size_t i = 0; i < _count; ++i) {
+            f.segments[i] = queries[i].lineSegment;
+            _tmax[i] = 1.0f;
+            m[i >> 2] |= 1u << (i & 3);
+        }
+        loadFrame(f, m);
+    }
+
+    /// Start query i with a hit at t on a triangle of the tree root.
+    void setHint(size_t i, double t, const SGVec3d vertex[3],
+                 const BVHMaterial* material)
+    {
+        _tmax[i] = float(t);
+        _haveHit[i] = 1;
+        Hit& h = _hits[i];
+        for (unsigned k = 0; k < 3; ++k)
+            h.vertex[k] = vertex[k];
+        h.linearVelocity = SGVec3d::zeros();
+        h.angularVelocity = SGVec3d::zeros();
+        h.id = 0;
+        h.material = material;
+        h.frame = 0;
+        h.moving = false;
+    }
+
+    const Hit* getHit(size_t i) const
+    { return _haveHit[i] ? &_hits[i] : 0; }
+
+    virtual void apply(BVHGroup& group)
+    {
+        if (pushSphereMask(group.getBoundingSphere()))
+            group.traverse(*this);
+        popMask();
+    }
+    virtual void apply(BVHPageNode& page)
+    {
+        if (pushSphereMask(page.getBoundingSphere()))
+            page.traverse(*this);
+        popMask();
+    }
+    virtual void apply(BVHTransform& transform)
+    {
+        if (!pushSphereMask(transform.getBoundingSphere())) {
+            popMask();
+            return;
+        }
+
+        const std::vector<unsigned char>& m = _masks[_level];
+        unsigned parent = _frame;
+        Frame& f = frame(++_frame);
+        f.segments.resize(_count);
+        for (size_t i = 0; i < _count; ++i) {
+            if (active(m, i))
+                f.segments[i] =
+                    transform.lineSegmentToLocal(_frames[parent].segments[i]);
+        }
+        loadFrame(f, m);
+
+        transform.traverse(*this);
+
+        for (size_t i = 0; i < _count; ++i) {
+            if (!_haveHit[i] || _hits[i].frame != _frame)
+                continue;
+            Hit& h = _hits[i];
+            for (unsigned k = 0; k < 3; ++k)
+                h.vertex[k] = transform.ptToWorld(h.vertex[k]);
+            h.linearVelocity = transform.vecToWorld(h.linearVelocity);
+            h.angularVelocity = transform.vecToWorld(h.angularVelocity);
+            h.frame = parent;
+        }
+        _frame = parent;
+        popMask();
+    }
+    virtual void apply(BVHMotionTransform& transform)
+    {
+        if (!pushSphereMask(transform.getBoundingSphere())) {
+            popMask();
+            return;
+        }
+
+        SGMatrixd toLocal = transform.getToLocalTransform(_time);
+        SGMatrixd toWorld = transform.getToWorldTransform(_time);
+
+        const std::vector<unsigned char>& m = _masks[_level];
+        unsigned parent = _frame;
+        Frame& f = frame(++_frame);
+        f.segments.resize(_count);
+        for (size_t i = 0; i < _count; ++i) {
+            if (active(m, i))
+                f.segments[i] = _frames[parent].segments[i].transform(toLocal);
+        }
+        loadFrame(f, m);
+
+        transform.traverse(*this);
+
+        for (size_t i = 0; i < _count; ++i) {
+            if (!_haveHit[i] || _hits[i].frame != _frame)
+                continue;
+            Hit& h = _hits[i];
+            const SGLineSegmentd& segment = _frames[_frame].segments[i];
+            SGVec3d point = segment.getStart() + double(_tmax[i])*segment.getDirection();
+            h.linearVelocity += transform.getLinearVelocityAt(point);
+            h.angularVelocity += transform.getAngularVelocity();
+            h.linearVelocity = toWorld.xformVec(h.linearVelocity);
+            h.angularVelocity = toWorld.xformVec(h.angularVelocity);
+            for (unsigned k = 0; k < 3; ++k)
+                h.vertex[k] = toWorld.xformPt(h.vertex[k]);
+            if (!h.id)
+                h.id = transform.getId();
+            h.moving = true;
+            h.frame = parent;
+        }
+        _frame = parent;
+        popMask();
+    }
+    virtual void apply(BVHLineGeometry&)
+    { }
+    virtual void apply(BVHStaticGeometry& node)
+    {
+        if (pushSphereMask(node.getBoundingSphere()))
+            node.traverse(*this);
+        popMask();
+    }
+
+    virtual void apply(const BVHStaticBinary& node, const BVHStaticData& data)
+    {
+        const Frame& f = _frames[_frame];
+        const SGBoxf& box = node.getBoundingBox();
+        SGVec3d boxMin = SGVec3d(box.getMin()) - f.origin;
+        SGVec3d boxMax = SGVec3d(box.getMax()) - f.origin;
+        float lo[3], hi[3];
+        for (unsigned a = 0; a < 3; ++a) {
+            lo[a] = float(boxMin[a]) - boxEps;
+            hi[a] = float(boxMax[a]) + boxEps;
+        }
+
+        const std::vector<unsigned char>& parent = _masks[_level];
+        std::vector<unsigned char>& m = mask(++_level);
+        m.resize(_packets);
+        bool any = false;
+        for (size_t p = 0; p < _packets; ++p) {
+            m[p] = parent[p] ? (parent[p] & boxMask(f, p, lo, hi)) : 0;
+            any = any || m[p];
+        }
+
+        if (any) {
+            // enter the child nearer to the start of the segments first,
+            // hits there shorten the search in the other one
+            if (0 < f.direction[node.getSplitAxis()]) {
+                node.getLeftChild()->accept(*this, data);
+                node.getRightChild()->accept(*this, data);
+            } else {
+                node.getRightChild()->accept(*this, data);
+                node.getLeftChild()->accept(*this, data);
+            }
+        }
+        --_level;
+    }
+
+    virtual void apply(const BVHStaticTriangle& triangle, const BVHStaticData& data)
+    {
+        const Frame& f = _frames[_frame];
+        SGTrianglef tri = triangle.getTriangle(data);
+        SGVec3d base = SGVec3d(tri.getBaseVertex()) - f.origin;
+        float v0[3], e1[3], e2[3];
+        for (unsigned a = 0; a < 3; ++a) {
+            v0[a] = float(base[a]);
+            e1[a] = tri.getEdge(0)[a];
+            e2[a] = tri.getEdge(1)[a];
+        }
+
+        const std::vector<unsigned char>& m = _masks[_level];
+        for (size_t p = 0; p < _packets; ++p) {
+            if (!m[p])
+                continue;
+            float t[4];
+            unsigned hits = m[p] & triangleMask(f, p, v0, e1, e2, t);
+            for (unsigned lane = 0; hits; ++lane, hits >>= 1) {
+                if (!(hits & 1))
+                    continue;
+                size_t i = 4*p + lane;
+                _tmax[i] = t[lane];
+                _haveHit[i] = 1;
+                Hit& h = _hits[i];
+                h.vertex[0] = SGVec3d(tri.getBaseVertex());
+                h.vertex[1] = SGVec3d(tri.getBaseVertex() + tri.getEdge(0));
+                h.vertex[2] = SGVec3d(tri.getBaseVertex() + tri.getEdge(1));
+                h.linearVelocity = SGVec3d::zeros();
+                h.angularVelocity = SGVec3d::zeros();
+                h.id = 0;
+                h.material = data.getMaterial(triangle.getMaterialIndex());
+                h.frame = _frame;
+                h.moving = false;
+            }
+        }
+    }
+
+private:
+    struct Frame {
+        /// of each query, for the whole segment
+        std::vector<SGLineSegmentd> segments;
+        /// the packets, relative to origin
+        std::vector<float> start[3];
+        std::vector<float> dir[3];
+        std::vector<float> invDir[3];
+        SGVec3d origin;
+        /// of one of the segments, to order the children of a node
+        SGVec3f direction;
+    };
+
+    static bool active(const std::vector<unsigned char>& m, size_t i)
+    { return (m[i >> 2] >> (i & 3)) & 1; }
+
+    Frame& frame(unsigned n)
+    {
+        // a deque keeps the references of the outer frames valid
+        while (_frames.size() <= n)
+            _frames.push_back(Frame());
+        return _frames[n];
+    }
+
+    std::vector<unsigned char>& mask(unsigned n)
+    {
+        while (_masks.size() <= n)
+            _masks.push_back(std::vector<unsigned char>());
+        return _masks[n];
+    }
+
+    void loadFrame(Frame& f, const std::vector<unsigned char>& m)
+    {
+        for (unsigned a = 0; a < 3; ++a) {
+            f.start[a].assign(4*_packets, 0.0f);
+            f.dir[a].assign(4*_packets, 0.0f);
+            f.invDir[a].assign(4*_packets, 0.0f);
+        }
+
+        bool haveOrigin = false;
+        for (size_t i = 0; i < _count; ++i) {
+            if (!active(m, i))
+                continue;
+            const SGLineSegmentd& segment = f.segments[i];
+            if (!haveOrigin) {
+                f.origin = segment.getStart();
+                f.direction = SGVec3f(segment.getDirection());
+                haveOrigin = true;
+            }
+            SGVec3d start = segment.getStart() - f.origin;
+            SGVec3d dir = segment.getDirection();
+            for (unsigned a = 0; a < 3; ++a) {
+                f.start[a][i] = float(start[a]);
+                f.dir[a][i] = float(dir[a]);
+                // finite, so that the slab test never sees 0*inf
+                float d = f.dir[a][i];
+                if (std::fabs(d) < 1e-20f)
+                    d = (d < 0) ? -1e-20f : 1e-20f;
+                f.invDir[a][i] = 1/d;
+            }
+        }
+    }
+
+    /// Compute the mask of the next level from the bounding sphere of a node
+    /// in the current frame. Returns false if no segment passes it; the
+    /// caller pops the level in any case.
+    bool pushSphereMask(const SGSphered& sphere)
+    {
+        const Frame& f = _frames[_frame];
+        const std::vector<unsigned char>& parent = _masks[_level];
+        std::vector<unsigned char>& m = mask(++_level);
+        m.assign(_packets, 0);
+        if (sphere.empty())
+            return false;
+
+        bool any = false;
+        for (size_t i = 0; i < _count; ++i) {
+            if (!active(parent, i))
+                continue;
+            const SGLineSegmentd& segment = f.segments[i];
+            SGLineSegmentd range(segment.getStart(), segment.getStart() +
+                                 double(_tmax[i])*segment.getDirection());
+            if (intersects(range, sphere)) {
+                m[i >> 2] |= 1u << (i & 3);
+                any = true;
+            }
+        }
+        return any;
+    }
+
+    void popMask()
+    { --_level; }
+
+    /// the segments of packet p which pass through the box lo/hi before tmax
+    unsigned boxMask(const Frame& f, size_t p, const float lo[3], const float hi[3]) const
+    {
+        const size_t j = 4*p;
+#ifdef GROUNDQUERY_SSE
+        __m128 tNear = _mm_setzero_ps();
+        __m128 tFar = _mm_loadu_ps(&_tmax[j]);
+        for (unsigned a = 0; a < 3; ++a) {
+            __m128 start = _mm_loadu_ps(&f.start[a][j]);
+            __m128 invDir = _mm_loadu_ps(&f.invDir[a][j]);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(lo[a]), start), invDir);
+            __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(hi[a]), start), invDir);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+        }
+        return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+        unsigned bits = 0;
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            float tNear = 0;
+            float tFar = _tmax[j + lane];
+            for (unsigned a = 0; a < 3; ++a) {
+                float t1 = (lo[a] - f.start[a][j + lane])*f.invDir[a][j + lane];
+                float t2 = (hi[a] - f.start[a][j + lane])*f.invDir[a][j + lane];
+                tNear = SGMiscf::max(tNear, SGMiscf::min(t1, t2));
+                tFar = SGMiscf::min(tFar, SGMiscf::max(t1, t2));
+            }
+            if (tNear <= tFar)
+                bits |= 1u << lane;
+        }
+        return bits;
+#endif
+    }
+
+    /// The segments of packet p hitting the triangle v0, v0 + e1, v0 + e2
+    /// before tmax, and where. Moeller-Trumbore, four segments at a time.
+    unsigned triangleMask(const Frame& f, size_t p, const float v0[3],
+                          const float e1[3], const float e2[3], float t[4]) const
+    {
+        const size_t j = 4*p;
+#ifdef GROUNDQUERY_SSE
+        __m128 dx = _mm_loadu_ps(&f.dir[0][j]);
+        __m128 dy = _mm_loadu_ps(&f.dir[1][j]);
+        __m128 dz = _mm_loadu_ps(&f.dir[2][j]);
+        __m128 e1x = _mm_set1_ps(e1[0]), e1y = _mm_set1_ps(e1[1]), e1z = _mm_set1_ps(e1[2]);
+        __m128 e2x = _mm_set1_ps(e2[0]), e2y = _mm_set1_ps(e2[1]), e2z = _mm_set1_ps(e2[2]);
+
+        // p = d x e2, det = e1.p
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)),
+                                _mm_mul_ps(e1z, pz));
+        __m128 absDet = _mm_max_ps(det, _mm_sub_ps(_mm_setzero_ps(), det));
+        __m128 valid = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-30f));
+        __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        // s = start - v0, u = s.p/det
+        __m128 sx = _mm_sub_ps(_mm_loadu_ps(&f.start[0][j]), _mm_set1_ps(v0[0]));
+        __m128 sy = _mm_sub_ps(_mm_loadu_ps(&f.start[1][j]), _mm_set1_ps(v0[1]));
+        __m128 sz = _mm_sub_ps(_mm_loadu_ps(&f.start[2][j]), _mm_set1_ps(v0[2]));
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)),
+                                         _mm_mul_ps(sz, pz)), inv);
+
+        // q = s x e1, v = d.q/det, t = e2.q/det
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)),
+                                         _mm_mul_ps(dz, qz)), inv);
+        __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)),
+                                          _mm_mul_ps(e2z, qz)), inv);
+
+        __m128 minusEps = _mm_set1_ps(-triangleEps);
+        __m128 onePlusEps = _mm_set1_ps(1 + triangleEps);
+        __m128 hit = _mm_and_ps(valid, _mm_cmpge_ps(u, minusEps));
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(v, minusEps));
+        hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), onePlusEps));
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(tt, _mm_setzero_ps()));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(tt, _mm_loadu_ps(&_tmax[j])));
+        _mm_storeu_ps(t, tt);
+        return _mm_movemask_ps(hit);
+#else
+        unsigned bits = 0;
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            const size_t i = j + lane;
+            float d[3] = { f.dir[0][i], f.dir[1][i], f.dir[2][i] };
+            float pv[3] = { d[1]*e2[2] - d[2]*e2[1],
+                            d[2]*e2[0] - d[0]*e2[2],
+                            d[0]*e2[1] - d[1]*e2[0] };
+            float det = e1[0]*pv[0] + e1[1]*pv[1] + e1[2]*pv[2];
+            if (std::fabs(det) <= 1e-30f)
+                continue;
+            float inv = 1/det;
+            float s[3] = { f.start[0][i] - v0[0], f.start[1][i] - v0[1],
+                           f.start[2][i] - v0[2] };
+            float u = (s[0]*pv[0] + s[1]*pv[1] + s[2]*pv[2])*inv;
+            float q[3] = { s[1]*e1[2] - s[2]*e1[1],
+                           s[2]*e1[0] - s[0]*e1[2],
+                           s[0]*e1[1] - s[1]*e1[0] };
+            float v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2])*inv;
+            t[lane] = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2])*inv;
+            if (u < -triangleEps || v < -triangleEps || 1 + triangleEps < u + v)
+                continue;
+            if (t[lane] < 0 || _tmax[i] <= t[lane])
+                continue;
+            bits |= 1u << lane;
+        }
+        return bits;
+#endif
+    }
+
+    size_t _count;
+    size_t _packets;
+    std::deque<Frame> _frames;
+    unsigned _frame;
+    std::deque<std::vector<unsigned char> > _masks;
+    unsigned _level;
+    double _time;
+
+    /// end of the search range of each query, -1 for the padding
+    std::vector<float> _tmax;
+    std::vector<char> _haveHit;
+    std::vector<Hit> _hits;
+};
+
+namespace {
+
+/// where segment hits the triangle v, in double precision
+bool intersectsTriangle(const SGLineSegmentd& segment, const SGVec3d v[3], double& t)
+{
+    SGVec3d e1 = v[1] - v[0];
+    SGVec3d e2 = v[2] - v[0];
+    SGVec3d d = segment.getDirection();
+    SGVec3d p = cross(d, e2);
+    double det = dot(e1, p);
+    if (std::fabs(det) <= SGLimitsd::min())
+        return false;
+    double inv = 1/det;
+    SGVec3d s = segment.getStart() - v[0];
+    double u = dot(s, p)*inv;
+    if (u < 0 || 1 < u)
+        return false;
+    SGVec3d q = cross(s, e1);
+    double w = dot(d, q)*inv;
+    if (w < 0 || 1 < u + w)
+        return false;
+    t = dot(e2, q)*inv;
+    return 0 <= t && t <= 1;
+}
+
+}
+
+FGGroundQueryBatch::Query::Query() :
+    haveHit(false),
+    point(SGVec3d::zeros()),
+    normal(SGVec3d::zeros()),
+    linearVelocity(SGVec3d::zeros()),
+    angularVelocity(SGVec3d::zeros()),
+    id(0),
+    material(0)
+{
+}
+
+FGGroundQueryBatch::FGGroundQueryBatch() :
+    _visitor(new Visitor),
+    _hintHits(0)
+{
+}
+
+FGGroundQueryBatch::~FGGroundQueryBatch()
+{
+}
+
+void FGGroundQueryBatch::resize(size_t n)
+{
+    _queries.resize(n);
+    _hints.resize(n);
+}
+
+void FGGroundQueryBatch::clearHints()
+{
+    for (size_t i = 0; i < _hints.size(); ++i)
+        _hints[i].valid = false;
+}
+
+void FGGroundQueryBatch::run(simgear::BVHNode& tree, double t)
+{
+    _visitor->start(_queries, t);
+
+    // start from the last hits, the traversal then only has to look at
+    // what is in front of them
+    _hintHits = 0;
+    for (size_t i = 0; i < _queries.size(); ++i) {
+        const Hint& hint = _hints[i];
+        double hintT;
+        if (hint.valid &&
+            intersectsTriangle(_queries[i].lineSegment, hint.vertex, hintT)) {
+            _visitor->setHint(i, hintT, hint.vertex, hint.material);
+            ++_hintHits;
+        }
+    }
+
+    tree.accept(*_visitor);
+
+    for (size_t i = 0; i < _queries.size(); ++i) {
+        Query& q = _queries[i];
+        Hint& hint = _hints[i];
+        const Visitor::Hit* hit = _visitor->getHit(i);
+        q.haveHit = (hit != 0);
+        if (!hit) {
+            hint.valid = false;
+            continue;
+        }
+
+        // The point and normal from the triangle in double precision, the
+        // packets only had floats
+        SGVec3d normal = cross(hit->vertex[1] - hit->vertex[0],
+                               hit->vertex[2] - hit->vertex[0]);
+        double len = norm(normal);
+        if (len > 0)
+            normal /= len;
+        SGVec3d d = q.lineSegment.getDirection();
+        double denom = dot(normal, d);
+        double s = 0;
+        if (std::fabs(denom) > SGLimitsd::min())
+            s = dot(normal, hit->vertex[0] - q.lineSegment.getStart())/denom;
+        q.point = q.lineSegment.getStart() + SGMiscd::clip(s, 0, 1)*d;
+        q.normal = normal;
+        q.linearVelocity = hit->linearVelocity;
+        q.angularVelocity = hit->angularVelocity;
+        q.id = hit->id;
+        q.material = hit->material;
+
+        // moving triangles are somewhere else next time
+        hint.valid = !hit->moving;
+        for (unsigned k = 0; k < 3; ++k)
+            hint.vertex[k] = hit->vertex[k];
+        hint.material = hit->material;
+    }
+}
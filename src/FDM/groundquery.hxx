@@ -0,0 +1,105 @@
+// groundquery.hxx -- ground intersections of many points in one traversal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _GROUNDQUERY_HXX
+#define _GROUNDQUERY_HXX
+
+#include <memory>
+#include <vector>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/math/SGGeometry.hxx>
+#include <simgear/bvh/BVHNode.hxx>
+
+namespace simgear {
+class BVHMaterial;
+}
+
+/**
+ * Intersects a batch of line segments with a BVH tree, giving for each one
+ * what simgear::BVHLineSegmentVisitor gives for it on its own: the first
+ * hit from the start of the segment, with the velocities of the geometry
+ * that was hit.
+ *
+ * The tree is traversed once for all segments. A node is entered with the
+ * segments which pass its bounds, and boxes and triangles are tested against
+ * four segments at a time (SSE where available).
+ *
+ * Each query slot remembers the static triangle it hit last. The next run
+ * tests that triangle first and only looks for hits closer than it, which
+ * culls most of the tree for a point that stays on the same ground. Since
+ * the triangle must still be part of the tree, hints have to be cleared
+ * whenever a different tree is queried.
+ */
+class FGGroundQueryBatch {
+public:
+    struct Query {
+        Query();
+
+        /// the segment to intersect, in the coordinates of the tree root
+        SGLineSegmentd lineSegment;
+
+        // results, valid if haveHit
+        bool haveHit;
+        SGVec3d point;
+        SGVec3d normal;
+        SGVec3d linearVelocity;
+        SGVec3d angularVelocity;
+        simgear::BVHNode::Id id;
+        const simgear::BVHMaterial* material;
+    };
+
+    FGGroundQueryBatch();
+    ~FGGroundQueryBatch();
+
+    /// Set the number of queries. Hints of the slots kept stay valid.
+    void resize(size_t n);
+    size_t size() const
+    { return _queries.size(); }
+
+    Query& operator[](size_t i)
+    { return _queries[i]; }
+    const Query& operator[](size_t i) const
+    { return _queries[i]; }
+
+    /// Intersect all queries with 'tree' at time t.
+    void run(simgear::BVHNode& tree, double t);
+
+    /// Forget the last hits, needed when the tree changes.
+    void clearHints();
+
+    /// queries of the last run whose result came from the hint
+    unsigned getHintHits() const
+    { return _hintHits; }
+
+private:
+    class Visitor;
+
+    /// the last triangle a slot hit, in tree root coordinates
+    struct Hint {
+        Hint() : valid(false), material(0) {}
+        bool valid;
+        SGVec3d vertex[3];
+        const simgear::BVHMaterial* material;
+    };
+
+    std::vector<Query> _queries;
+    std::vector<Hint> _hints;
+    std::unique_ptr<Visitor> _visitor;
+    unsigned _hintHits;
+};
+
+#endif
@@ -134,6 +134,16 @@ private:
 
 //////////////////////////////////////////////////////////////////////////////
 
+// waypoints the flight plan owns tell it about altitude changes
+// themselves, others (e.g. made by Nasal) need their leg marked
+static void altitudeChanged(WaypointList::Model* model, int index)
+{
+  FlightPlan* fp = model->flightplan();
+  if (fp && (model->waypointAt(index)->owner() != fp)) {
+    fp->legAtIndex(index)->markModified();
+  }
+}
+
 static void drawClippedString(puFont& font, const char* s, int x, int y, int maxWidth)
 {
   int fullWidth = font.getStringWidth(s);
@@ -379,7 +389,7 @@ void WaypointList::draw( int dx, int dy )
   
   _arrowWidth = legendFont.getStringWidth(">");
   
-  RoutePath path(_model->flightplan());
+  const RoutePath& path(_model->flightplan()->routePath());
   
   for ( ; row <= final; ++row, y += rowHeight) {
     drawRow(dx, dy, row, y, path);
@@ -763,6 +773,7 @@ int WaypointList::checkKey (int key, int updown )
         } else {
           wp->setAltitude((curAlt - 10) * 100, wp->altitudeRestriction());
         }
+        altitudeChanged(_model, getSelected());
       }
     }
     break;
@@ -780,6 +791,7 @@ int WaypointList::checkKey (int key, int updown )
         int curAlt = (static_cast<int>(wp->altitudeFt()) + 50) / 100;
         wp->setAltitude((curAlt + 10) * 100, wp->altitudeRestriction());
       }
+      altitudeChanged(_model, getSelected());
     }
     break;
   
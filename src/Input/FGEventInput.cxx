@@ -301,6 +301,12 @@ void FGInputDevice::HandleEvent( FGEventData & eventData )
   }
 }
 
+FGInputEvent * FGInputDevice::GetHandledEvent( const string & eventName )
+{
+  std::map<std::string,FGInputEvent_ptr>::iterator it = handledEvents.find( eventName );
+  return it == handledEvents.end() ? NULL : it->second.ptr();
+}
+
 void FGInputDevice::SetName( string name )
 {
   this->name = name; 
@@ -241,6 +241,12 @@ public:
 
   void HandleEvent( FGEventData & eventData );
 
+  /*
+   * the configured event for eventName, or NULL if the device has none.
+   * Lets implementations resolve events once instead of on every event.
+   */
+  FGInputEvent * GetHandledEvent( const std::string & eventName );
+
   virtual void AddHandledEvent( FGInputEvent_ptr handledEvent ) {
     if( handledEvents.count( handledEvent->GetName() ) == 0 )
       handledEvents[handledEvent->GetName()] = handledEvent;
@@ -35,8 +35,16 @@ extern "C" {
 #include <poll.h>
 #include <linux/input.h>
 #include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <time.h>
 
 #include <string.h>
+#include <cerrno>
+#include <cstdint>
+
+#include <Main/fg_props.hxx>
+#include <simgear/threads/SGThread.hxx>
 
 struct TypeCode {
   unsigned type;
@@ -263,7 +271,8 @@ static EventTypeByName EVENT_TYPE_BY_NAME;
 FGLinuxInputDevice::FGLinuxInputDevice( std::string aName, std::string aDevname ) :
   FGInputDevice(aName),
   devname( aDevname ),
-  fd(-1)
+  fd(-1),
+  clock(CLOCK_REALTIME)
 {
 }
 
@@ -277,7 +286,8 @@ FGLinuxInputDevice::~FGLinuxInputDevice()
 }
 
 FGLinuxInputDevice::FGLinuxInputDevice() :
-  fd(-1)
+  fd(-1),
+  clock(CLOCK_REALTIME)
 {
 }
 
@@ -297,6 +307,14 @@ void FGLinuxInputDevice::Open()
     SG_LOG( SG_INPUT, SG_WARN, "Can't grab " << devname << " for exclusive access" );
   }
 
+#ifdef EVIOCSCLOCKID
+  // stamp events with the clock the latency is measured against, so
+  // wall clock adjustments don't show up as input lag
+  int monotonic = CLOCK_MONOTONIC;
+  if( ioctl( fd, EVIOCSCLOCKID, &monotonic ) == 0 )
+    clock = CLOCK_MONOTONIC;
+#endif
+
   {
     unsigned char buf[ABS_CNT/sizeof(unsigned char)/8];
     // get axes maximums
@@ -449,17 +467,219 @@ const char * FGLinuxInputDevice::TranslateEventName( FGEventData & eventData )
   return EVENT_NAME_BY_TYPE[typeCode];
 }
 
+void FGLinuxInputDevice::HandleQueuedEvent( FGLinuxEventData & eventData )
+{
+  if( GetDebugEvents() ) {
+    HandleEvent( eventData );
+    return;
+  }
+
+  TypeCode typeCode;
+  typeCode.type = eventData.type;
+  typeCode.code = eventData.code;
+  std::unordered_map<unsigned,FGInputEvent*>::iterator it = eventsByTypeCode.find( typeCode.hashCode() );
+  if( it == eventsByTypeCode.end() ) {
+    FGInputEvent * handledEvent = GetHandledEvent( TranslateEventName( eventData ) );
+    it = eventsByTypeCode.insert( std::make_pair( (unsigned)typeCode.hashCode(), handledEvent ) ).first;
+  }
+
+  if( it->second )
+    it->second->fire( eventData );
+}
+
 void FGLinuxInputDevice::SetDevname( const std::string & name )
 {
   this->devname = name; 
 }
 
-FGLinuxEventInput::FGLinuxEventInput()
+FGLinuxEventQueue::FGLinuxEventQueue( size_t capacity ) :
+  slots(capacity),
+  head(0),
+  tail(0)
+{
+}
+
+bool FGLinuxEventQueue::push( const Entry & entry )
+{
+  size_t h = head.load(std::memory_order_relaxed);
+  if( h - tail.load(std::memory_order_acquire) >= slots.size() )
+    return false;
+  slots[h % slots.size()] = entry;
+  head.store(h + 1, std::memory_order_release);
+  return true;
+}
+
+bool FGLinuxEventQueue::pop( Entry & entry )
+{
+  size_t t = tail.load(std::memory_order_relaxed);
+  if( t == head.load(std::memory_order_acquire) )
+    return false;
+  entry = slots[t % slots.size()];
+  tail.store(t + 1, std::memory_order_release);
+  return true;
+}
+
+static inline bool isAxis( const struct input_event & event )
+{
+  return event.type == EV_ABS || event.type == EV_REL;
+}
+
+/*
+ * Reads all devices as soon as the kernel has events for them, so input
+ * does not wait for the next frame, and hands the events to the main loop
+ * through the queue. Axis motion within one read is coalesced, all other
+ * events are passed on in order.
+ */
+class FGLinuxEventInput::InputThread : public SGThread {
+public:
+  InputThread( FGLinuxEventQueue & aQueue ) :
+    queue( aQueue ),
+    wakeup(-1),
+    running(false),
+    dropped(0)
+  {
+  }
+
+  bool init( const std::map<int,FGInputDevice*> & devices )
+  {
+    if( (wakeup = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC )) == -1 ) {
+      SG_LOG( SG_INPUT, SG_WARN, "Can't create the input thread wakeup event: " << strerror(errno) );
+      return false;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = wakeup;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    fds.push_back( pfd );
+    fdDevices.push_back( NULL );
+
+    std::map<int,FGInputDevice*>::const_iterator it;
+    for( it = devices.begin(); it != devices.end(); ++it ) {
+      FGLinuxInputDevice * device = (FGLinuxInputDevice*)it->second;
+      pfd.fd = device->GetFd();
+      fds.push_back( pfd );
+      fdDevices.push_back( device );
+    }
+
+    running = true;
+    start();
+    return true;
+  }
+
+  void stop()
+  {
+    running = false;
+    uint64_t one = 1;
+    if( ::write( wakeup, &one, sizeof(one) ) != sizeof(one) )
+      SG_LOG( SG_INPUT, SG_WARN, "Can't wake the input thread" );
+    join();
+    ::close( wakeup );
+    wakeup = -1;
+  }
+
+  unsigned getDropped() const { return dropped; }
+
+protected:
+  virtual void run()
+  {
+    while( running ) {
+      if( ::poll( &fds[0], fds.size(), -1 ) < 0 ) {
+        if( errno == EINTR )
+          continue;
+        SG_LOG( SG_INPUT, SG_ALERT, "Input thread poll failed: " << strerror(errno) );
+        return;
+      }
+
+      if( fds[0].revents & POLLIN ) {
+        uint64_t value;
+        if( ::read( wakeup, &value, sizeof(value) ) < 0 ) {
+          // nothing to do, running is checked below
+        }
+        continue;
+      }
+
+      batch.clear();
+      for( size_t i = 1; i < fds.size(); i++ ) {
+        if( fds[i].revents & (POLLERR | POLLHUP | POLLNVAL) ) {
+          SG_LOG( SG_INPUT, SG_WARN, "Lost input device " << fdDevices[i]->GetName() );
+          fds[i].fd = -1; // poll() ignores negative descriptors
+        } else if( fds[i].revents & POLLIN ) {
+          readDevice( i );
+        }
+      }
+
+      for( size_t i = 0; i < batch.size(); i++ ) {
+        if( !queue.push( batch[i] ) )
+          dropped++;
+      }
+    }
+  }
+
+private:
+  void readDevice( size_t index )
+  {
+    struct input_event events[64];
+    ssize_t bytes = ::read( fds[index].fd, events, sizeof(events) );
+    if( bytes < 0 ) {
+      if( errno != EAGAIN && errno != EINTR ) {
+        SG_LOG( SG_INPUT, SG_WARN, "Can't read " << fdDevices[index]->GetName() << ": " << strerror(errno) );
+        fds[index].fd = -1;
+      }
+      return;
+    }
+
+    const size_t first = batch.size();
+    for( size_t i = 0; i < bytes / sizeof(events[0]); i++ ) {
+      const struct input_event & event = events[i];
+      if( event.type == EV_SYN ) {
+        if( event.code == SYN_DROPPED )
+          SG_LOG( SG_INPUT, SG_DEBUG, "Kernel dropped events of " << fdDevices[index]->GetName() );
+        continue;
+      }
+
+      if( isAxis( event ) ) {
+        // keep the latest absolute value or the sum of the relative motion,
+        // stamped with the time of the oldest event
+        size_t j = first;
+        while( j < batch.size() &&
+               !(batch[j].event.type == event.type && batch[j].event.code == event.code) )
+          j++;
+        if( j < batch.size() ) {
+          if( event.type == EV_ABS )
+            batch[j].event.value = event.value;
+          else
+            batch[j].event.value += event.value;
+          continue;
+        }
+      }
+
+      FGLinuxEventQueue::Entry entry;
+      entry.device = fdDevices[index];
+      entry.event = event;
+      batch.push_back( entry );
+    }
+  }
+
+  FGLinuxEventQueue & queue;
+  int wakeup;
+  std::atomic<bool> running;
+  std::atomic<unsigned> dropped;
+
+  std::vector<struct pollfd> fds;
+  std::vector<FGLinuxInputDevice*> fdDevices;
+  std::vector<FGLinuxEventQueue::Entry> batch;
+};
+
+FGLinuxEventInput::FGLinuxEventInput() :
+  inputThread(NULL),
+  queue(4096)
 {
 }
 
 FGLinuxEventInput::~FGLinuxEventInput()
 {
+  stopThread();
 }
 
 void FGLinuxEventInput::postinit()
@@ -491,11 +711,112 @@ void FGLinuxEventInput::postinit()
 
   udev_unref(udev);
 
+  latencyNode = fgGetNode( "/input/event/latency-ms", true );
+  droppedNode = fgGetNode( "/input/event/dropped-events", true );
+  if( fgGetBool( "/input/event/use-thread", true ) )
+    startThread();
+}
+
+void FGLinuxEventInput::shutdown()
+{
+  stopThread();
+  FGEventInput::shutdown();
+}
+
+void FGLinuxEventInput::startThread()
+{
+  if( inputThread || input_devices.empty() )
+    return;
+
+  inputThread = new InputThread( queue );
+  if( !inputThread->init( input_devices ) ) {
+    delete inputThread;
+    inputThread = NULL;
+    return;
+  }
+  SG_LOG( SG_INPUT, SG_INFO, "Reading " << input_devices.size() << " event input devices on a thread" );
+}
+
+void FGLinuxEventInput::stopThread()
+{
+  if( !inputThread )
+    return;
+
+  inputThread->stop();
+  delete inputThread;
+  inputThread = NULL;
+
+  // drop what the thread read last, the devices are about to go away
+  FGLinuxEventQueue::Entry entry;
+  while( queue.pop( entry ) ) {
+  }
+}
+
+void FGLinuxEventInput::updateFromThread( double dt )
+{
+  pending.clear();
+  FGLinuxEventQueue::Entry entry;
+  while( queue.pop( entry ) )
+    pending.push_back( entry );
+
+  droppedNode->setIntValue( inputThread->getDropped() );
+  if( pending.empty() )
+    return;
+
+  // the thread may have queued several reads since the last frame. Only
+  // apply the latest value of each absolute axis and the summed motion of
+  // each relative one, at the position of the last event for that axis.
+  std::map<std::pair<FGLinuxInputDevice*,unsigned>,size_t> kept;
+  for( size_t i = pending.size(); i-- > 0; ) {
+    FGLinuxEventQueue::Entry & e = pending[i];
+    if( !isAxis( e.event ) )
+      continue;
+
+    std::pair<FGLinuxInputDevice*,unsigned> key( e.device, (unsigned)e.event.type << 16 | e.event.code );
+    std::map<std::pair<FGLinuxInputDevice*,unsigned>,size_t>::iterator it = kept.find( key );
+    if( it == kept.end() ) {
+      kept[key] = i;
+      continue;
+    }
+
+    FGLinuxEventQueue::Entry & last = pending[it->second];
+    if( e.event.type == EV_REL )
+      last.event.value += e.event.value;
+    last.event.time = e.event.time; // the oldest one
+    e.device = NULL;
+  }
+
+  int modifiers = fgGetKeyModifiers();
+  double maxLatency = 0.0;
+  for( size_t i = 0; i < pending.size(); i++ ) {
+    FGLinuxEventQueue::Entry & e = pending[i];
+    if( !e.device )
+      continue;
+
+    FGLinuxEventData eventData( e.event, dt, modifiers );
+    if( e.event.type == EV_ABS )
+      eventData.value = e.device->Normalize( e.event );
+    e.device->HandleQueuedEvent( eventData );
+
+    struct timespec now;
+    clock_gettime( e.device->GetClock(), &now );
+    double latency = (now.tv_sec - e.event.time.tv_sec) +
+      (now.tv_nsec / 1000 - e.event.time.tv_usec) * 1e-6;
+    if( latency > maxLatency )
+      maxLatency = latency;
+  }
+
+  latencyNode->setDoubleValue( maxLatency * 1000.0 );
 }
 
 void FGLinuxEventInput::update( double dt )
 {
   FGEventInput::update( dt );
+  if( inputThread ) {
+    updateFromThread( dt );
+    return;
+  }
+
   // index the input devices by the associated fd and prepare
   // the pollfd array by filling in the file descriptor
   struct pollfd fds[input_devices.size()];
@@ -26,6 +26,10 @@
 #include "FGEventInput.hxx"
 #include <linux/input.h>
 
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
 struct FGLinuxEventData : public FGEventData {
   FGLinuxEventData( struct input_event & event, double dt, int modifiers ) :
     FGEventData( (double)event.value, dt, modifiers ),
@@ -56,11 +60,48 @@ public:
   int GetFd() { return fd; }
 
   double Normalize( struct input_event & event );
+
+  /*
+   * dispatch an event read by the input thread. Unlike HandleEvent(), the
+   * event is resolved by type and code, its name is only translated and
+   * looked up the first time.
+   */
+  void HandleQueuedEvent( FGLinuxEventData & eventData );
+
+  /// the clock the kernel stamps this device's events with
+  clockid_t GetClock() const { return clock; }
 private:
   std::string devname;
   int fd;
+  clockid_t clock;
 
   std::map<unsigned int,input_absinfo> absinfo;
+
+  // (type << 16 | code) to the configured event, NULL for unhandled ones
+  std::unordered_map<unsigned,FGInputEvent*> eventsByTypeCode;
+};
+
+/*
+ * Single producer, single consumer queue of events read from the devices
+ */
+class FGLinuxEventQueue {
+public:
+  struct Entry {
+    FGLinuxInputDevice * device;
+    struct input_event event;
+  };
+
+  explicit FGLinuxEventQueue( size_t capacity );
+
+  /// producer: false if the queue is full
+  bool push( const Entry & entry );
+  /// consumer: false if the queue is empty
+  bool pop( Entry & entry );
+
+private:
+  std::vector<Entry> slots;
+  std::atomic<size_t> head; // next slot to fill
+  std::atomic<size_t> tail; // next slot to consume
 };
 
 class FGLinuxEventInput : public FGEventInput {
@@ -69,8 +110,21 @@ public:
   virtual ~ FGLinuxEventInput();
   virtual void update (double dt);
   virtual void postinit();
+  virtual void shutdown();
 
 protected:
+  class InputThread;
+
+  void startThread();
+  void stopThread();
+  void updateFromThread( double dt );
+
+  InputThread * inputThread;
+  FGLinuxEventQueue queue;
+  std::vector<FGLinuxEventQueue::Entry> pending;
+
+  SGPropertyNode_ptr latencyNode;
+  SGPropertyNode_ptr droppedNode;
 };
 
 #endif
@@ -59,17 +59,34 @@ public:
   virtual ~AtisSpeaker();
   virtual void valueChanged(SGPropertyNode * node);
   virtual void SoundSampleReady(SGSharedPtr<SGSoundSample>);
+  virtual void SoundSampleChunkReady(SGSharedPtr<SGSoundSample>, unsigned index, unsigned count, unsigned id);
+  virtual bool needsWholeSample() const { return false; }
+
+  // one sentence of the atis, index 0 starts a new message
+  struct SpokenChunk {
+    SpokenChunk() : index(0), count(0), utterance(0) {}
+    SGSharedPtr<SGSoundSample> sample;
+    unsigned index;
+    unsigned count;
+    unsigned utterance;
+  };
 
   bool hasSpokenAtis()
   {
     return _spokenAtis.empty() == false;
   }
 
-  SGSharedPtr<SGSoundSample> getSpokenAtis()
+  SpokenChunk getSpokenAtis()
   {
     return _spokenAtis.pop();
   }
 
+  // the chunks of any earlier atis are stale
+  unsigned currentUtterance() const
+  {
+    return _synthesizeRequest.id;
+  }
+
   void setStationId(const string & stationId)
   {
     _stationId = stationId;
@@ -78,7 +95,7 @@ public:
 
 private:
   SynthesizeRequest _synthesizeRequest;
-  SGLockedQueue<SGSharedPtr<SGSoundSample> > _spokenAtis;
+  SGLockedQueue<SpokenChunk> _spokenAtis;
   string _stationId;
 };
 
@@ -102,6 +119,7 @@ void AtisSpeaker::valueChanged(SGPropertyNode * node)
   if (_synthesizeRequest.text == newText) return;
 
   _synthesizeRequest.text = newText;
+  _synthesizeRequest.id++;
 
   string voice = "cmu_us_arctic_slt";
 
@@ -144,9 +162,19 @@ void AtisSpeaker::valueChanged(SGPropertyNode * node)
 }
 
 void AtisSpeaker::SoundSampleReady(SGSharedPtr<SGSoundSample> sample)
+{
+  // nothing to do, the radio loops over the sentences it already got
+}
+
+void AtisSpeaker::SoundSampleChunkReady(SGSharedPtr<SGSoundSample> sample, unsigned index, unsigned count, unsigned id)
 {
   // we are now in the synthesizers worker thread!
-  _spokenAtis.push(sample);
+  SpokenChunk chunk;
+  chunk.sample = sample;
+  chunk.index = index;
+  chunk.count = count;
+  chunk.utterance = id;
+  _spokenAtis.push(chunk);
 }
 #endif
 
@@ -495,6 +523,10 @@ private:
   flightgear::CommStationRef _commStationForFrequency;
   #if defined(ENABLE_FLITE)
   SGSharedPtr<SGSampleGroup> _sampleGroup;
+  std::vector<SGSharedPtr<SGSoundSample> > _atisChunks;
+  unsigned _atisChunksExpected;
+  unsigned _atisChunksReceived;
+  size_t _nextAtisChunk;
   #endif
 
   PropertyObject<bool> _serviceable;
@@ -517,6 +549,11 @@ CommRadioImpl::CommRadioImpl(SGPropertyNode_ptr node)
         _stationTTL(0.0),
         _frequency(-1.0),
         _commStationForFrequency(NULL),
+#if defined(ENABLE_FLITE)
+        _atisChunksExpected(0),
+        _atisChunksReceived(0),
+        _nextAtisChunk(0),
+#endif
 
         _serviceable(_rootNode->getNode("serviceable", true)),
         _power_btn(_rootNode->getNode("power-btn", true)),
@@ -621,8 +658,33 @@ void CommRadioImpl::update(double dt)
     static const char * atisSampleRefName = "atis";
     static const char * noiseSampleRefName = "noise";
 
-    if (_atisSpeaker.hasSpokenAtis()) {
-      // the speaker has created a new atis sample
+    // collect the sentences synthesized so far
+    bool restartAtis = false;
+    while (_atisSpeaker.hasSpokenAtis()) {
+      AtisSpeaker::SpokenChunk chunk = _atisSpeaker.getSpokenAtis();
+      if (chunk.utterance != _atisSpeaker.currentUtterance()) {
+        // left over from an atis which has changed since
+        continue;
+      }
+      if (chunk.index == 0) {
+        _atisChunks.clear();
+        _atisChunksExpected = chunk.count;
+        _atisChunksReceived = 0;
+        _nextAtisChunk = 0;
+        restartAtis = true;
+      }
+      _atisChunksReceived++;
+      if (chunk.sample.valid()) {
+        _atisChunks.push_back(chunk.sample);
+      }
+    }
+
+    if (restartAtis && _sampleGroup.valid()) {
+      // remove previous atis sample
+      _sampleGroup->remove(atisSampleRefName);
+    }
+
+    if (!_atisChunks.empty()) {
       if (!_sampleGroup.valid()) {
         // create a sample group for our instrument on the fly
           SGSoundMgr * smgr = globals->get_subsystem<SGSoundMgr>();
@@ -636,12 +698,20 @@ void CommRadioImpl::update(double dt)
         }
 
       }
-      // remove previous atis sample
-      _sampleGroup->remove(atisSampleRefName);
-      // add and play the new atis sample
-      SGSharedPtr<SGSoundSample> sample = _atisSpeaker.getSpokenAtis();
-      _sampleGroup->add(sample, atisSampleRefName);
-      _sampleGroup->play_looped(atisSampleRefName);
+
+      // play the sentences one after the other, starting as soon as the
+      // first one is there, and loop once all have arrived
+      SGSoundSample * current = _sampleGroup->find(atisSampleRefName);
+      if (NULL == current || !current->is_playing()) {
+        if (_nextAtisChunk >= _atisChunks.size() && _atisChunksReceived >= _atisChunksExpected) {
+          _nextAtisChunk = 0;
+        }
+        if (_nextAtisChunk < _atisChunks.size()) {
+          _sampleGroup->remove(atisSampleRefName);
+          _sampleGroup->add(_atisChunks[_nextAtisChunk++], atisSampleRefName);
+          _sampleGroup->play_once(atisSampleRefName);
+        }
+      }
     }
 
     if (_sampleGroup.valid()) {
@@ -652,7 +722,9 @@ void CommRadioImpl::update(double dt)
         if ( NULL != s) {
           s->set_volume(1.0 - _signalQuality_norm);
           s = _sampleGroup->find(atisSampleRefName);
-          s->set_volume(_signalQuality_norm);
+          if ( NULL != s) {
+            s->set_volume(_signalQuality_norm);
+          }
         }
       }
       // master volume for radio, mute on bad signal quality
@@ -744,7 +744,7 @@ void GPS::computeTurnData()
   
   _turnStartBearing = _desiredCourse;
 // compute next leg course
-  RoutePath path(_route);
+  const RoutePath& path(_route->routePath());
   double crs = path.trackForIndex(_route->currentIndex() + 1);
 
 // compute offset bearing
@@ -0,0 +1,68 @@
+// binary_log.hxx - on-disk format of binary property logs.
+//
+// This file is in the Public Domain, and comes with no warranty.
+
+#ifndef __BINARY_LOG_HXX
+#define __BINARY_LOG_HXX 1
+
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * Layout of the files written by FGLogger in binary mode and read back by
+ * the fglogconvert utility. All integers and floating point values are
+ * stored in the byte order of the machine that wrote the file; the magic
+ * number doubles as byte order mark.
+ *
+ * File header:
+ *   char[8]   magic "FGLOGBIN"
+ *   uint32    byte order mark 0x01020304
+ *   uint32    format version
+ *   uint32    flags (FLAG_ZLIB)
+ *   uint32    number of columns, not counting the time column
+ *   per column:
+ *     uint8   ColumnType
+ *     uint16  title length, followed by the title bytes
+ *
+ * Followed by any number of blocks:
+ *   uint32    number of rows in the block
+ *   uint32    number of payload bytes on disk
+ *   uint32    number of payload bytes after decompression
+ *   payload   the time column as doubles, then each column in turn,
+ *             every column holding one value per row
+ */
+namespace flightgear
+{
+namespace binarylog
+{
+
+const char MAGIC[8] = { 'F', 'G', 'L', 'O', 'G', 'B', 'I', 'N' };
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t VERSION = 1;
+
+const uint32_t FLAG_ZLIB = 1 << 0;
+
+enum ColumnType {
+    COLUMN_BOOL = 0,   ///< uint8
+    COLUMN_INT = 1,    ///< int32
+    COLUMN_LONG = 2,   ///< int64
+    COLUMN_FLOAT = 3,  ///< float
+    COLUMN_DOUBLE = 4  ///< double
+};
+
+inline size_t columnSize(uint8_t type)
+{
+    switch (type) {
+    case COLUMN_BOOL:   return 1;
+    case COLUMN_INT:    return 4;
+    case COLUMN_LONG:   return 8;
+    case COLUMN_FLOAT:  return 4;
+    case COLUMN_DOUBLE: return 8;
+    default:            return 0;
+    }
+}
+
+} // of namespace binarylog
+} // of namespace flightgear
+
+#endif // __BINARY_LOG_HXX
@@ -44,6 +44,7 @@
 #include "util.hxx"
 #include "main.hxx"
 #include "positioninit.hxx"
+#include "snapshot.hxx"
 
 #include <boost/scoped_array.hpp>
 
@@ -304,6 +305,61 @@ do_save (const SGPropertyNode * arg, SGPropertyNode * root)
     }
 }
 
+/**
+ * Built-in command: take a snapshot of the simulation, for a quick reset
+ * with restore-snapshot.
+ *
+ * name (optional): the name to keep it in memory under.  Defaults to
+ *   "default".
+ * file (optional): a file to save it to as well.
+ */
+static bool
+do_save_snapshot (const SGPropertyNode * arg, SGPropertyNode * root)
+{
+    std::string name = arg->getStringValue("name", "default");
+    if (!arg->hasValue("file"))
+        return flightgear::saveSnapshot(name);
+
+    SGPath file(arg->getStringValue("file"));
+    if (file.extension() != "snapshot")
+        file.concat(".snapshot");
+
+    SGPath validated_path = fgValidatePath(file, true);
+    if (validated_path.isNull()) {
+        SG_LOG(SG_IO, SG_ALERT, "save-snapshot: writing '" << file << "' denied "
+                "(unauthorized access)");
+        return false;
+    }
+
+    return flightgear::saveSnapshot(name, validated_path);
+}
+
+/**
+ * Built-in command: put the simulation back into the state of a snapshot.
+ *
+ * name (optional): the snapshot kept in memory.  Defaults to "default".
+ * file (optional): read the snapshot from this file instead.
+ */
+static bool
+do_restore_snapshot (const SGPropertyNode * arg, SGPropertyNode * root)
+{
+    if (!arg->hasValue("file"))
+        return flightgear::restoreSnapshot(arg->getStringValue("name", "default"));
+
+    SGPath file(arg->getStringValue("file"));
+    if (file.extension() != "snapshot")
+        file.concat(".snapshot");
+
+    SGPath validated_path = fgValidatePath(file, false);
+    if (validated_path.isNull()) {
+        SG_LOG(SG_IO, SG_ALERT, "restore-snapshot: reading '" << file << "' denied "
+                "(unauthorized access)");
+        return false;
+    }
+
+    return flightgear::restoreSnapshotFile(validated_path);
+}
+
 /**
  * Built-in command: save flight recorder tape.
  *
@@ -928,6 +984,8 @@ static struct {
     { "pause", do_pause },
     { "load", do_load },
     { "save", do_save },
+    { "save-snapshot", do_save_snapshot },
+    { "restore-snapshot", do_restore_snapshot },
     { "save-tape", do_save_tape },
     { "load-tape", do_load_tape },
     { "view-cycle", do_view_cycle },
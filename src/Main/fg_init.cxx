@@ -142,6 +142,7 @@
 #include "fg_commands.hxx"
 #include "fg_props.hxx"
 #include "FGInterpolator.hxx"
+#include "frame_profiler.hxx"
 #include "options.hxx"
 #include "globals.hxx"
 #include "logger.hxx"
@@ -791,6 +792,7 @@ void fgCreateSubsystems(bool duringReset) {
     globals->add_subsystem("performance-mon",
             new SGPerformanceMonitor(globals->get_subsystem_mgr(),
                                      fgGetNode("/sim/performance-monitor", true)));
+    globals->add_new_subsystem<flightgear::FrameProfiler>();
 
     ////////////////////////////////////////////////////////////////////
     // Initialize the material property subsystem.
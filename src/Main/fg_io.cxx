@@ -70,6 +70,7 @@
 
 #include "globals.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 
 using std::atoi;
 using std::string;
@@ -82,7 +83,7 @@ FGIO::FGIO()
 
 FGIO::~FGIO()
 {
-
+    shutdown();
 }
 
 
@@ -315,6 +316,12 @@ FGIO::parse_port_config( const string& config )
         SG_LOG( SG_IO, SG_INFO, "  port = " << port );
         SG_LOG( SG_IO, SG_INFO, "  style = " << style );
 
+#ifdef FG_HAVE_IO_THREAD
+        if ( _ioThread ) {
+            io->set_io_channel( new FGThreadedSocket( _ioThread.get(),
+                                                      hostname, port, style ) );
+        } else
+#endif
         io->set_io_channel( new SGSocket( hostname, port, style ) );
     }
     else
@@ -338,6 +345,22 @@ FGIO::init()
 
     _realDeltaTime = fgGetNode("/sim/time/delta-realtime-sec");
 
+#ifdef FG_HAVE_IO_THREAD
+    if ( fgGetBool("/sim/io/thread/enabled") ) {
+        _ioThread.reset( new FGIOThread );
+        if ( _ioThread->init() ) {
+            _ioThreadDropped = fgGetNode("/sim/io/thread/dropped-records", true);
+            _ioThreadDelay = fgGetNode("/sim/io/thread/max-delay-ms", true);
+        } else {
+            _ioThread.reset();
+        }
+    }
+#else
+    if ( fgGetBool("/sim/io/thread/enabled") ) {
+        SG_LOG( SG_IO, SG_WARN, "The I/O thread is not available on this platform" );
+    }
+#endif
+
     // we could almost do this in a single step except pushing a valid
     // port onto the port list copies the structure and destroys the
     // original, which closes the port and frees up the fd ... doh!!!
@@ -368,6 +391,7 @@ void FGIO::add_channel(const string& config)
     }
 
     io_channels.push_back( p );
+    io_channel_names.push_back( flightgear::FrameProfiler::intern(config) );
 }
 
 void
@@ -395,6 +419,8 @@ FGIO::update( double /* delta_time_sec */ )
         p->dec_count_down( delta_time_sec );
         double dt = 1 / p->get_hz();
         if ( p->get_count_down() < 0.33 * dt ) {
+            flightgear::ProfileScope scope("io",
+                io_channel_names[i - io_channels.begin()]);
             p->process();
             p->inc_count();
             while ( p->get_count_down() < 0.33 * dt ) {
@@ -402,6 +428,19 @@ FGIO::update( double /* delta_time_sec */ )
             }
         } // of channel processing
     } // of io_channels iteration
+
+#ifdef FG_HAVE_IO_THREAD
+    if ( _ioThread ) {
+        // everything generated this frame goes out together
+        _ioThread->flush();
+
+        unsigned int dropped;
+        double delay;
+        _ioThread->getStats( dropped, delay );
+        _ioThreadDropped->setIntValue( dropped );
+        _ioThreadDelay->setDoubleValue( delay );
+    }
+#endif
 }
 
 void
@@ -420,6 +459,11 @@ FGIO::shutdown()
     }
 
     io_channels.clear();
+    io_channel_names.clear();
+
+#ifdef FG_HAVE_IO_THREAD
+    _ioThread.reset();
+#endif
 }
 
 void
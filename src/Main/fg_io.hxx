@@ -31,6 +31,9 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+
+#include <Network/io_thread.hxx>
 
 class FGProtocol;
 
@@ -60,8 +63,16 @@ private:
     
     typedef std::vector< FGProtocol* > ProtocolVec;
     ProtocolVec io_channels;
+    std::vector<const char*> io_channel_names; ///< for the frame profiler
     
     SGPropertyNode_ptr _realDeltaTime;
+
+#ifdef FG_HAVE_IO_THREAD
+    // optional thread servicing socket channels, see README.IO
+    std::unique_ptr<FGIOThread> _ioThread;
+    SGPropertyNode_ptr _ioThreadDropped;
+    SGPropertyNode_ptr _ioThreadDelay;
+#endif
 };
 
 
@@ -0,0 +1,421 @@
+// frame_profiler.cxx -- per thread timeline of where frame time goes
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "frame_profiler.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <set>
+#include <vector>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/iostreams/sgstream.hxx>
+#include <simgear/misc/sg_dir.hxx>
+#include <simgear/structure/commands.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/threads/SGQueue.hxx>
+#include <simgear/threads/SGThread.hxx>
+
+#include <Main/fg_props.hxx>
+#include <Main/globals.hxx>
+
+namespace flightgear
+{
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char* category;
+    const char* name;
+    int64_t begin;
+    int64_t end;
+};
+
+/**
+ * Events of one thread. Only the owning thread writes; dumps copy the
+ * ring concurrently and drop whatever was overwritten meanwhile.
+ */
+struct ThreadBuffer
+{
+    ThreadBuffer(unsigned int i, size_t capacity) :
+        id(i),
+        events(capacity),
+        head(0)
+    { }
+
+    unsigned int id;
+    std::string name;           ///< guarded by the registry mutex
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head; ///< total events ever recorded
+};
+
+// buffers are never freed, a thread's events stay available after it
+// exited and the thread_local pointer can't dangle
+struct Registry
+{
+    Registry() : capacity(1 << 16) { }
+
+    SGMutex mutex;
+    std::vector<ThreadBuffer*> buffers;
+    std::set<std::string> names;
+    std::atomic<size_t> capacity;
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+thread_local ThreadBuffer* t_buffer = NULL;
+thread_local const char* t_name = NULL;
+
+// created on the first event, so threads which never record cost nothing
+ThreadBuffer* threadBuffer()
+{
+    if (!t_buffer) {
+        Registry& r = registry();
+        SGGuard<SGMutex> g(r.mutex);
+        t_buffer = new ThreadBuffer(r.buffers.size(), r.capacity);
+        if (t_name) {
+            t_buffer->name = t_name;
+        }
+        r.buffers.push_back(t_buffer);
+    }
+    return t_buffer;
+}
+
+struct ThreadSnapshot
+{
+    unsigned int id;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+struct Snapshot
+{
+    SGPath path;
+    std::vector<ThreadSnapshot> threads;
+};
+
+void writeJSONString(std::ostream& os, const char* s)
+{
+    os << '"';
+    for (; *s; ++s) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (c < 0x20) {
+            char buf[8];
+            ::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            os << buf;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+} // of anonymous namespace
+
+/**
+ * Formats and writes the snapshots, so a dump does not add another
+ * spike to the frame it was triggered in.
+ */
+class FrameProfiler::Writer : public SGThread
+{
+public:
+    void push(Snapshot* s)
+    {
+        _queue.push(s);
+    }
+
+    void stop()
+    {
+        _queue.push(NULL);
+        join();
+    }
+
+protected:
+    virtual void run()
+    {
+        for (;;) {
+            Snapshot* s = _queue.pop();
+            if (!s) {
+                return;
+            }
+            write(*s);
+            delete s;
+        }
+    }
+
+private:
+    void write(const Snapshot& s)
+    {
+        sg_ofstream out(s.path, std::ios::out | std::ios::trunc);
+        if (!out) {
+            SG_LOG(SG_GENERAL, SG_ALERT, "frame profiler: unable to write " << s.path);
+            return;
+        }
+
+        int64_t origin = INT64_MAX;
+        size_t count = 0;
+        for (const ThreadSnapshot& t : s.threads) {
+            for (const TraceEvent& e : t.events) {
+                origin = std::min(origin, e.begin);
+            }
+            count += t.events.size();
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const ThreadSnapshot& t : s.threads) {
+            out << (first ? "\n" : ",\n")
+                << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << t.id
+                << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            writeJSONString(out, t.name.c_str());
+            out << "}}";
+            first = false;
+
+            for (const TraceEvent& e : t.events) {
+                out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << t.id
+                    << ",\"ts\":" << (e.begin - origin)
+                    << ",\"dur\":" << (e.end - e.begin)
+                    << ",\"cat\":";
+                writeJSONString(out, e.category);
+                out << ",\"name\":";
+                writeJSONString(out, e.name);
+                out << "}";
+            }
+        }
+        out << "\n]}\n";
+
+        if (!out) {
+            SG_LOG(SG_GENERAL, SG_ALERT, "frame profiler: error writing " << s.path);
+            return;
+        }
+
+        SG_LOG(SG_GENERAL, SG_INFO, "frame profiler: wrote " << count
+               << " events to " << s.path);
+    }
+
+    SGBlockingQueue<Snapshot*> _queue;
+};
+
+std::atomic<bool> FrameProfiler::s_enabled(false);
+FrameProfiler* FrameProfiler::s_instance = NULL;
+
+FrameProfiler::FrameProfiler() :
+    _frameStart(0),
+    _lastAutoDump(0),
+    _dumpCount(0)
+{
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    shutdown();
+}
+
+void FrameProfiler::init()
+{
+    SGPropertyNode* root = fgGetNode("/sim/profiler", true);
+    _enabledNode = root->getChild("enabled", 0, true);
+    _thresholdNode = root->getChild("frame-threshold-ms", 0, true);
+    _minDumpIntervalNode = root->getChild("min-dump-interval-sec", 0, true);
+    if (!_minDumpIntervalNode->hasValue()) {
+        _minDumpIntervalNode->setDoubleValue(10.0);
+    }
+    _dumpCountNode = root->getChild("dumps", 0, true);
+    _lastDumpNode = root->getChild("last-dump", 0, true);
+    _lastFrameNode = root->getChild("last-frame-ms", 0, true);
+
+    // events per thread, only affects threads which record for the first
+    // time after this
+    int capacity = root->getIntValue("buffer-events", 1 << 16);
+    registry().capacity = std::max(capacity, 1024);
+
+    setThreadName("main");
+
+    _writer.reset(new Writer);
+    _writer->start();
+
+    globals->get_commands()->addCommand("profiler-dump", this,
+                                        &FrameProfiler::commandDump);
+    s_instance = this;
+    update(0.0);
+}
+
+void FrameProfiler::shutdown()
+{
+    if (s_instance != this) {
+        return;
+    }
+
+    s_instance = NULL;
+    s_enabled = false;
+    globals->get_commands()->removeCommand("profiler-dump");
+
+    _writer->stop();
+    _writer.reset();
+}
+
+void FrameProfiler::update(double)
+{
+    bool enabled = _enabledNode->getBoolValue();
+    if (enabled && !isEnabled()) {
+        _frameStart = 0; // the frame in progress started untraced
+    }
+    s_enabled = enabled;
+}
+
+void FrameProfiler::record(const char* category, const char* name,
+                           int64_t beginUSec, int64_t endUSec)
+{
+    ThreadBuffer* b = threadBuffer();
+    uint64_t head = b->head.load(std::memory_order_relaxed);
+    TraceEvent& e = b->events[head % b->events.size()];
+    e.category = category;
+    e.name = name;
+    e.begin = beginUSec;
+    e.end = endUSec;
+    b->head.store(head + 1, std::memory_order_release);
+}
+
+const char* FrameProfiler::intern(const std::string& name)
+{
+    Registry& r = registry();
+    SGGuard<SGMutex> g(r.mutex);
+    return r.names.insert(name).first->c_str();
+}
+
+void FrameProfiler::setThreadName(const std::string& name)
+{
+    t_name = intern(name);
+    if (t_buffer) {
+        SGGuard<SGMutex> g(registry().mutex);
+        t_buffer->name = t_name;
+    }
+}
+
+void FrameProfiler::frameBoundary()
+{
+    if (s_instance && isEnabled()) {
+        s_instance->checkFrame(now());
+    }
+}
+
+void FrameProfiler::checkFrame(int64_t t)
+{
+    int64_t start = _frameStart;
+    _frameStart = t;
+    if (start == 0) {
+        return;
+    }
+
+    record("frame", "frame", start, t);
+    double frameMSec = (t - start) / 1000.0;
+    _lastFrameNode->setDoubleValue(frameMSec);
+
+    double threshold = _thresholdNode->getDoubleValue();
+    if ((threshold <= 0.0) || (frameMSec < threshold)) {
+        return;
+    }
+
+    double sinceLast = (t - _lastAutoDump) / 1e6;
+    if (_lastAutoDump && (sinceLast < _minDumpIntervalNode->getDoubleValue())) {
+        return;
+    }
+
+    _lastAutoDump = t;
+    SG_LOG(SG_GENERAL, SG_INFO, "frame profiler: frame took " << frameMSec
+           << "ms, dumping trace");
+    dump(nextDumpPath());
+}
+
+SGPath FrameProfiler::nextDumpPath() const
+{
+    SGPath dir = globals->get_fg_home() / "Export";
+    simgear::Dir d(dir);
+    if (!d.exists()) {
+        d.create(0755);
+    }
+
+    char stamp[32];
+    time_t t = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&t));
+
+    char name[64];
+    ::snprintf(name, sizeof(name), "fgtrace-%s-%d.json", stamp, _dumpCount);
+    return dir / name;
+}
+
+bool FrameProfiler::dump(const SGPath& path)
+{
+    if (!_writer) {
+        return false;
+    }
+
+    Snapshot* s = new Snapshot;
+    s->path = path;
+
+    Registry& r = registry();
+    SGGuard<SGMutex> g(r.mutex);
+    s->threads.resize(r.buffers.size());
+    for (size_t i = 0; i < r.buffers.size(); ++i) {
+        ThreadBuffer* b = r.buffers[i];
+        ThreadSnapshot& t = s->threads[i];
+        t.id = b->id;
+        t.name = b->name.empty() ? "thread " + std::to_string(b->id) : b->name;
+
+        const uint64_t capacity = b->events.size();
+        uint64_t head = b->head.load(std::memory_order_acquire);
+        uint64_t first = (head > capacity) ? head - capacity : 0;
+        for (uint64_t n = first; n < head; ++n) {
+            t.events.push_back(b->events[n % capacity]);
+        }
+
+        // the owner kept recording while we copied: anything it may have
+        // overwritten is unreliable
+        uint64_t after = b->head.load(std::memory_order_acquire);
+        if (after > capacity && (after - capacity) > first) {
+            size_t lost = std::min<uint64_t>(after - capacity - first, t.events.size());
+            t.events.erase(t.events.begin(), t.events.begin() + lost);
+        }
+    }
+
+    ++_dumpCount;
+    _dumpCountNode->setIntValue(_dumpCount);
+    _lastDumpNode->setStringValue(path.utf8Str());
+    _writer->push(s);
+    return true;
+}
+
+bool FrameProfiler::commandDump(const SGPropertyNode* arg, SGPropertyNode*)
+{
+    std::string path = arg->getStringValue("path");
+    return dump(path.empty() ? nextDumpPath() : SGPath::fromUtf8(path));
+}
+
+} // of namespace flightgear
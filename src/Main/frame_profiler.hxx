@@ -0,0 +1,138 @@
+// frame_profiler.hxx -- per thread timeline of where frame time goes
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_FRAME_PROFILER_HXX
+#define FG_FRAME_PROFILER_HXX
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/structure/subsystem_mgr.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+namespace flightgear
+{
+
+/**
+ * Low overhead tracing of the simulation loop. While enabled, every
+ * ProfileScope records its begin and end time into a ring buffer owned
+ * by the calling thread, so recording takes no lock and, once a thread
+ * has its buffer, never allocates. Disabled, a scope costs one relaxed
+ * atomic load.
+ *
+ * The buffers are written out as Chrome trace event JSON, to be opened
+ * in chrome://tracing or Perfetto, by the profiler-dump command or
+ * automatically after a frame longer than
+ * /sim/profiler/frame-threshold-ms.
+ *
+ * Names and categories are stored as pointers: pass string literals, or
+ * strings returned by intern().
+ */
+class FrameProfiler : public SGSubsystem
+{
+public:
+    FrameProfiler();
+    virtual ~FrameProfiler();
+
+    virtual void init();
+    virtual void shutdown();
+    virtual void update(double dt);
+
+    static const char* subsystemName() { return "frame-profiler"; }
+
+    static bool isEnabled()
+    { return s_enabled.load(std::memory_order_relaxed); }
+
+    static int64_t now()
+    { return SGTimeStamp::now().toUSecs(); }
+
+    /// append a complete event to the calling thread's buffer
+    static void record(const char* category, const char* name,
+                       int64_t beginUSec, int64_t endUSec);
+
+    /// A copy of name which lives as long as the process. This takes a
+    /// lock and the copy is never freed: intern a name once and keep the
+    /// pointer, rather than per event.
+    static const char* intern(const std::string& name);
+
+    /// label the calling thread in the trace
+    static void setThreadName(const std::string& name);
+
+    /// called by the main loop once per frame, between two frames
+    static void frameBoundary();
+
+    /// queue the current contents of all buffers for writing to path
+    bool dump(const SGPath& path);
+
+private:
+    class Writer;
+
+    void checkFrame(int64_t now);
+    SGPath nextDumpPath() const;
+    bool commandDump(const SGPropertyNode* arg, SGPropertyNode* root);
+
+    SGPropertyNode_ptr _enabledNode;
+    SGPropertyNode_ptr _thresholdNode;
+    SGPropertyNode_ptr _minDumpIntervalNode;
+    SGPropertyNode_ptr _dumpCountNode;
+    SGPropertyNode_ptr _lastDumpNode;
+    SGPropertyNode_ptr _lastFrameNode;
+
+    std::unique_ptr<Writer> _writer;
+    int64_t _frameStart;
+    int64_t _lastAutoDump;
+    int _dumpCount;
+
+    static std::atomic<bool> s_enabled;
+    static FrameProfiler* s_instance;
+};
+
+/**
+ * Records the lifetime of the scope as one event, if the profiler was
+ * enabled when the scope was entered.
+ */
+class ProfileScope
+{
+public:
+    ProfileScope(const char* category, const char* name) :
+        _category(category),
+        _name(FrameProfiler::isEnabled() ? name : NULL),
+        _begin(_name ? FrameProfiler::now() : 0)
+    { }
+
+    ~ProfileScope()
+    {
+        if (_name) {
+            FrameProfiler::record(_category, _name, _begin, FrameProfiler::now());
+        }
+    }
+
+private:
+    ProfileScope(const ProfileScope&);
+    ProfileScope& operator=(const ProfileScope&);
+
+    const char* _category;
+    const char* _name;
+    int64_t _begin;
+};
+
+} // of namespace flightgear
+
+#endif // FG_FRAME_PROFILER_HXX
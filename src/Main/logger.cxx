@@ -12,17 +12,281 @@
 #include <ios>
 #include <string>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#include <zlib.h>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/iostreams/sgstream.hxx>
+#include <simgear/math/sg_types.hxx>
 #include <simgear/misc/sg_path.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/timing/timestamp.hxx>
 
+#include "binary_log.hxx"
 #include "fg_props.hxx"
 #include "globals.hxx"
 #include "util.hxx"
 
 using std::string;
 using std::endl;
+
+namespace binarylog = flightgear::binarylog;
+
+////////////////////////////////////////////////////////////////////////
+// Implementation of FGLogger::BinaryWriter
+////////////////////////////////////////////////////////////////////////
+
+/**
+ * Background writer of a binary log. The simulation thread only copies
+ * typed values into a preallocated single producer / single consumer
+ * ring of rows; this thread transposes them into columnar blocks,
+ * optionally compresses them and does all the file I/O.
+ */
+class FGLogger::BinaryWriter : public SGThread
+{
+public:
+  BinaryWriter (const SGPath& path,
+                const std::vector<SGPropertyNode_ptr>& nodes,
+                const string_list& titles,
+                bool compress, size_t ringRows, size_t blockRows);
+  virtual ~BinaryWriter ();
+
+  bool good () const { return _good; }
+
+  /**
+   * Snapshot the current values of all nodes into the next free row.
+   * Called on the simulation thread; never blocks, allocates or does
+   * I/O. If the writer has fallen behind, the sample is dropped.
+   */
+  void sample (double sim_time_sec);
+
+protected:
+  virtual void run ();
+
+private:
+  bool drain ();
+  void writeBlock ();
+
+  sg_ofstream _output;
+  bool _good;
+  bool _compress;
+
+  const std::vector<SGPropertyNode_ptr> _nodes;
+  std::vector<uint8_t> _types;
+  std::vector<size_t> _offsets;   // of each column within a row
+  size_t _rowSize;
+
+  std::vector<unsigned char> _ring;
+  size_t _ringRows;
+  std::atomic<size_t> _head;      // next row to fill, written by sampler
+  std::atomic<size_t> _tail;      // next row to write, written by writer
+  std::atomic<bool> _stop;
+  std::atomic<unsigned long> _dropped;
+
+  // writer thread state
+  std::vector<unsigned char> _pending; // row major
+  size_t _pendingRows;
+  size_t _blockRows;
+  std::vector<unsigned char> _columns;
+  std::vector<unsigned char> _compressed;
+};
+
+FGLogger::BinaryWriter::BinaryWriter (const SGPath& path,
+                                      const std::vector<SGPropertyNode_ptr>& nodes,
+                                      const string_list& titles,
+                                      bool compress, size_t ringRows,
+                                      size_t blockRows)
+  : _output(path, std::ios_base::out | std::ios_base::binary),
+    _good(false),
+    _compress(compress),
+    _nodes(nodes),
+    _rowSize(sizeof(double)),
+    _ringRows(std::max<size_t>(ringRows, 16)),
+    _head(0),
+    _tail(0),
+    _stop(false),
+    _dropped(0),
+    _pendingRows(0),
+    _blockRows(std::max<size_t>(blockRows, 1))
+{
+  if (!_output)
+    return;
+
+  for (unsigned int i = 0; i < _nodes.size(); i++) {
+    uint8_t type;
+    switch (_nodes[i]->getType()) {
+    case simgear::props::BOOL:   type = binarylog::COLUMN_BOOL;   break;
+    case simgear::props::INT:    type = binarylog::COLUMN_INT;    break;
+    case simgear::props::LONG:   type = binarylog::COLUMN_LONG;   break;
+    case simgear::props::FLOAT:  type = binarylog::COLUMN_FLOAT;  break;
+    default:                     type = binarylog::COLUMN_DOUBLE; break;
+    }
+    _types.push_back(type);
+    _offsets.push_back(_rowSize);
+    _rowSize += binarylog::columnSize(type);
+  }
+
+  // everything the simulation thread touches is allocated up front
+  _ring.resize(_ringRows * _rowSize);
+  _pending.resize(_blockRows * _rowSize);
+  _columns.resize(_blockRows * _rowSize);
+
+  uint32_t flags = _compress ? binarylog::FLAG_ZLIB : 0;
+  uint32_t numColumns = _nodes.size();
+  _output.write(binarylog::MAGIC, sizeof(binarylog::MAGIC));
+  _output.write(reinterpret_cast<const char*>(&binarylog::BYTE_ORDER_MARK), 4);
+  _output.write(reinterpret_cast<const char*>(&binarylog::VERSION), 4);
+  _output.write(reinterpret_cast<const char*>(&flags), 4);
+  _output.write(reinterpret_cast<const char*>(&numColumns), 4);
+  for (unsigned int i = 0; i < _nodes.size(); i++) {
+    uint16_t length = std::min<size_t>(titles[i].size(), 0xffff);
+    _output.write(reinterpret_cast<const char*>(&_types[i]), 1);
+    _output.write(reinterpret_cast<const char*>(&length), 2);
+    _output.write(titles[i].data(), length);
+  }
+
+  _good = !!_output;
+}
+
+FGLogger::BinaryWriter::~BinaryWriter ()
+{
+  // the thread is started right after construction if the file is good
+  if (!_good)
+    return;
+
+  _stop = true;
+  join();
+
+  if (_dropped > 0) {
+    SG_LOG(SG_GENERAL, SG_WARN, "Binary logger dropped " << _dropped
+           << " samples because the writer could not keep up");
+  }
+}
+
+void
+FGLogger::BinaryWriter::sample (double sim_time_sec)
+{
+  size_t head = _head.load(std::memory_order_relaxed);
+  if (head - _tail.load(std::memory_order_acquire) >= _ringRows) {
+    ++_dropped;
+    return;
+  }
+
+  unsigned char* row = &_ring[(head % _ringRows) * _rowSize];
+  memcpy(row, &sim_time_sec, sizeof(double));
+  for (unsigned int i = 0; i < _nodes.size(); i++) {
+    unsigned char* field = row + _offsets[i];
+    switch (_types[i]) {
+    case binarylog::COLUMN_BOOL: {
+      uint8_t v = _nodes[i]->getBoolValue();
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case binarylog::COLUMN_INT: {
+      int32_t v = _nodes[i]->getIntValue();
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case binarylog::COLUMN_LONG: {
+      int64_t v = _nodes[i]->getLongValue();
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    case binarylog::COLUMN_FLOAT: {
+      float v = _nodes[i]->getFloatValue();
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    default: {
+      double v = _nodes[i]->getDoubleValue();
+      memcpy(field, &v, sizeof(v));
+      break;
+    }
+    }
+  }
+
+  _head.store(head + 1, std::memory_order_release);
+}
+
+bool
+FGLogger::BinaryWriter::drain ()
+{
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t head = _head.load(std::memory_order_acquire);
+  bool any = tail != head;
+  while (tail != head && _pendingRows < _blockRows) {
+    memcpy(&_pending[_pendingRows * _rowSize],
+           &_ring[(tail % _ringRows) * _rowSize], _rowSize);
+    ++_pendingRows;
+    ++tail;
+  }
+  _tail.store(tail, std::memory_order_release);
+  return any;
+}
+
+void
+FGLogger::BinaryWriter::writeBlock ()
+{
+  if (_pendingRows == 0)
+    return;
+
+  // transpose the pending rows into one contiguous run per column
+  unsigned char* out = &_columns[0];
+  for (size_t r = 0; r < _pendingRows; r++, out += sizeof(double))
+    memcpy(out, &_pending[r * _rowSize], sizeof(double));
+  for (unsigned int i = 0; i < _types.size(); i++) {
+    size_t size = binarylog::columnSize(_types[i]);
+    for (size_t r = 0; r < _pendingRows; r++, out += size)
+      memcpy(out, &_pending[r * _rowSize + _offsets[i]], size);
+  }
+
+  uint32_t numRows = _pendingRows;
+  uint32_t rawSize = out - &_columns[0];
+  const unsigned char* payload = &_columns[0];
+  uint32_t payloadSize = rawSize;
+
+  if (_compress) {
+    uLongf compressedSize = compressBound(rawSize);
+    if (_compressed.size() < compressedSize)
+      _compressed.resize(compressedSize);
+    if (compress2(&_compressed[0], &compressedSize, payload, rawSize,
+                  Z_BEST_SPEED) == Z_OK) {
+      payload = &_compressed[0];
+      payloadSize = compressedSize;
+    } else {
+      SG_LOG(SG_GENERAL, SG_ALERT, "Binary logger: compression failed");
+    }
+  }
+
+  _output.write(reinterpret_cast<const char*>(&numRows), 4);
+  _output.write(reinterpret_cast<const char*>(&payloadSize), 4);
+  _output.write(reinterpret_cast<const char*>(&rawSize), 4);
+  _output.write(reinterpret_cast<const char*>(payload), payloadSize);
+  _pendingRows = 0;
+}
+
+void
+FGLogger::BinaryWriter::run ()
+{
+  while (!_stop) {
+    bool any = drain();
+    if (_pendingRows == _blockRows)
+      writeBlock();
+    else if (!any)
+      SGTimeStamp::sleepForMSec(20);
+  }
+
+  // pick up whatever the simulation thread logged before stopping
+  while (drain()) {
+    if (_pendingRows == _blockRows)
+      writeBlock();
+  }
+  writeBlock();
+  _output.flush();
+}
 
 ////////////////////////////////////////////////////////////////////////
 // Implementation of FGLogger
@@ -75,23 +339,23 @@ FGLogger::init ()
         delimiter = ",";
         child->setStringValue("delimiter", delimiter.c_str());
     }
+
+    string format = child->getStringValue("format", "csv");
+    if (format != "csv" && format != "binary") {
+      SG_LOG(SG_GENERAL, SG_ALERT, "Unknown log format '" << format
+             << "' for " << filename << ", using csv");
+      format = "csv";
+    }
         
     log.interval_ms = child->getLongValue("interval-ms");
     log.last_time_ms = globals->get_sim_time_sec() * 1000;
     log.delimiter = delimiter.c_str()[0];
-    // Security: use the return value of fgValidatePath()
-    log.output.reset(new sg_ofstream(authorizedPath, std::ios_base::out));
-    if ( !(*log.output) ) {
-      SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
-      _logs.pop_back();
-      continue;
-    }
 
     //
     // Process the individual entries (Time is automatic).
     //
+    string_list titles;
     std::vector<SGPropertyNode_ptr> entries = child->getChildren("entry");
-    (*log.output) << "Time";
     for (unsigned int j = 0; j < entries.size(); j++) {
       SGPropertyNode * entry = entries[j];
 
@@ -108,9 +372,42 @@ FGLogger::init ()
 
       SGPropertyNode * node =
 	fgGetNode(entry->getStringValue("property"), true);
+      if (format == "binary" && node->getType() == simgear::props::STRING) {
+        SG_LOG(SG_GENERAL, SG_WARN, "Binary log " << filename
+               << " cannot hold the string property " << node->getPath()
+               << ", leaving it out");
+        continue;
+      }
       log.nodes.push_back(node);
-      (*log.output) << log.delimiter
-		    << entry->getStringValue("title", node->getPath().c_str());
+      titles.push_back(entry->getStringValue("title", node->getPath().c_str()));
+    }
+
+    if (format == "binary") {
+      // Security: use the return value of fgValidatePath()
+      log.binary.reset(new BinaryWriter(authorizedPath, log.nodes, titles,
+                                        child->getBoolValue("compress", false),
+                                        child->getIntValue("buffer-rows", 8192),
+                                        child->getIntValue("block-rows", 1024)));
+      if (!log.binary->good()) {
+        SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
+        _logs.pop_back();
+        continue;
+      }
+      log.binary->start();
+      continue;
+    }
+
+    // Security: use the return value of fgValidatePath()
+    log.output.reset(new sg_ofstream(authorizedPath, std::ios_base::out));
+    if ( !(*log.output) ) {
+      SG_LOG(SG_GENERAL, SG_ALERT, "Cannot write log to " << filename);
+      _logs.pop_back();
+      continue;
+    }
+
+    (*log.output) << "Time";
+    for (unsigned int j = 0; j < titles.size(); j++) {
+      (*log.output) << log.delimiter << titles[j];
     }
     (*log.output) << endl;
   }
@@ -139,20 +436,30 @@ FGLogger::update (double dt)
     double sim_time_sec = globals->get_sim_time_sec();
     double sim_time_ms = sim_time_sec * 1000;
     for (unsigned int i = 0; i < _logs.size(); i++) {
-        while ((sim_time_ms - _logs[i]->last_time_ms) >= _logs[i]->interval_ms) {
-            _logs[i]->last_time_ms += _logs[i]->interval_ms;
-            (*_logs[i]->output) << sim_time_sec;
-            for (unsigned int j = 0; j < _logs[i]->nodes.size(); j++) {
-                (*_logs[i]->output) << _logs[i]->delimiter
-                                    << _logs[i]->nodes[j]->getStringValue();
+        Log &log = *_logs[i];
+        while ((sim_time_ms - log.last_time_ms) >= log.interval_ms) {
+            log.last_time_ms += log.interval_ms;
+            if (log.binary) {
+                log.binary->sample(sim_time_sec);
+            } else {
+                writeCSVRow(log, sim_time_sec);
             }
-            (*_logs[i]->output) << endl;
         }
     }
 }
 
+void
+FGLogger::writeCSVRow (Log &log, double sim_time_sec)
+{
+    (*log.output) << sim_time_sec;
+    for (unsigned int j = 0; j < log.nodes.size(); j++) {
+        (*log.output) << log.delimiter << log.nodes[j]->getStringValue();
+    }
+    (*log.output) << endl;
+}
+
+
 
-
 ////////////////////////////////////////////////////////////////////////
 // Implementation of FGLogger::Log
 ////////////////////////////////////////////////////////////////////////
@@ -164,4 +471,8 @@ FGLogger::Log::Log ()
 {
 }
 
+FGLogger::Log::~Log ()
+{
+}
+
 // end of logger.cxx
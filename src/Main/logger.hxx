@@ -15,7 +15,8 @@
 #include <simgear/props/props.hxx>
 
 /**
- * Log any property values to any number of CSV files.
+ * Log any property values to any number of CSV files, or to compact
+ * binary files written by a background thread (see binary_log.hxx).
  */
 class FGLogger : public SGSubsystem
 {
@@ -29,19 +30,25 @@ public:
 
 private:
 
+  class BinaryWriter;
+
   /**
    * A single instance of a log file (the logger can contain many).
    */
   struct Log {
     Log ();
+    ~Log ();
 
     std::vector<SGPropertyNode_ptr> nodes;
     std::unique_ptr<sg_ofstream> output;
+    std::unique_ptr<BinaryWriter> binary;
     long interval_ms;
     double last_time_ms;
     char delimiter;
   };
 
+  void writeCSVRow (Log &log, double sim_time_sec);
+
   std::vector< std::unique_ptr<Log> > _logs;
 
 };
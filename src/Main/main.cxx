@@ -71,6 +71,7 @@ extern bool global_crashRptEnabled;
 
 #include "fg_commands.hxx"
 #include "fg_io.hxx"
+#include "frame_profiler.hxx"
 #include "main.hxx"
 #include "util.hxx"
 #include "fg_init.hxx"
@@ -118,9 +119,26 @@ static void fgMainLoop( void )
     timeMgr->computeTimeDeltas(sim_dt, real_dt);
 
     // update all subsystems
-    globals->get_subsystem_mgr()->update(sim_dt);
+    SGSubsystemMgr* mgr = globals->get_subsystem_mgr();
+    if (FrameProfiler::isEnabled()) {
+        // the same as SGSubsystemMgr::update(), but timing each group
+        static const char* groupNames[SGSubsystemMgr::MAX_GROUPS] = {
+            "init", "general", "fdm", "post-fdm", "display", "sound"
+        };
+        for (int g = 0; g < SGSubsystemMgr::MAX_GROUPS; ++g) {
+            ProfileScope scope("subsystem", groupNames[g]);
+            mgr->get_group(static_cast<SGSubsystemMgr::GroupType>(g))->update(sim_dt);
+        }
+    } else {
+        mgr->update(sim_dt);
+    }
+
+    {
+        ProfileScope scope("main", "atomic-change-listeners");
+        simgear::AtomicChangeListener::fireChangeListeners();
+    }
 
-    simgear::AtomicChangeListener::fireChangeListeners();
+    FrameProfiler::frameBoundary();
 }
 
 static void initTerrasync()
@@ -0,0 +1,510 @@
+// snapshot.cxx - binary snapshots of the simulator state for fast resets
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "snapshot.hxx"
+
+#include <map>
+#include <sstream>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/io/iostreams/sgstream.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <AIModel/AIManager.hxx>
+#include <Aircraft/replay.hxx>
+#include <FDM/fdm_shell.hxx>
+#include <FDM/flight.hxx>
+
+#include "fg_props.hxx"
+#include "globals.hxx"
+
+using std::string;
+
+namespace flightgear
+{
+
+namespace {
+
+const uint32_t snapshotMagic = 0x4e534746;  // "FGSN", also detects byte order
+const uint32_t snapshotFormat = 2;
+
+enum SectionTag {
+    SECTION_PROPERTIES = 1,
+    SECTION_FDM,
+    SECTION_AI,
+    SECTION_REPLAY
+};
+
+// the subtrees saved unless /sim/snapshot/property-root says otherwise.
+// The position, orientation and velocities are tied to the FDM, which
+// saves them itself.
+const char* defaultPropertyRoots[] = {
+    "/autopilot",
+    "/consumables",
+    "/controls",
+    "/engines",
+    "/environment",
+    "/fdm",
+    "/gear",
+    "/instrumentation",
+    "/surface-positions",
+    "/systems",
+    0
+};
+
+typedef std::map<string, string> SnapshotDict;
+SnapshotDict snapshots;
+
+FGInterface* currentFDM()
+{
+    FDMShell* shell = static_cast<FDMShell*>(globals->get_subsystem("flight"));
+    FGInterface* fdm = shell ? shell->getInterface() : 0;
+    return (fdm && fdm->get_inited()) ? fdm : 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+// properties
+////////////////////////////////////////////////////////////////////////
+
+// Tied values belong to a subsystem, which keeps them itself; setting
+// them could also have side effects, like repositioning the FDM.
+bool isSavedProperty(const SGPropertyNode* node)
+{
+    if (node->isTied() || node->isAlias() ||
+        !node->getAttribute(SGPropertyNode::READ) ||
+        !node->getAttribute(SGPropertyNode::WRITE))
+    {
+        return false;
+    }
+
+    switch (node->getType()) {
+    case simgear::props::BOOL:
+    case simgear::props::INT:
+    case simgear::props::LONG:
+    case simgear::props::FLOAT:
+    case simgear::props::DOUBLE:
+    case simgear::props::STRING:
+    case simgear::props::UNSPECIFIED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void collectProperties(SGPropertyNode* node, std::vector<SGPropertyNode*>& leaves)
+{
+    int n = node->nChildren();
+    if (n == 0) {
+        if (isSavedProperty(node)) {
+            leaves.push_back(node);
+        }
+        return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        collectProperties(node->getChild(i), leaves);
+    }
+}
+
+void saveProperties(SnapshotWriter& w)
+{
+    std::vector<SGPropertyNode*> leaves;
+    SGPropertyNode* config = fgGetNode("/sim/snapshot", true);
+    if (config->hasChild("property-root")) {
+        for (SGPropertyNode* root : config->getChildren("property-root")) {
+            SGPropertyNode* node = fgGetNode(root->getStringValue());
+            if (node) {
+                collectProperties(node, leaves);
+            }
+        }
+    } else {
+        for (int i = 0; defaultPropertyRoots[i]; ++i) {
+            SGPropertyNode* node = fgGetNode(defaultPropertyRoots[i]);
+            if (node) {
+                collectProperties(node, leaves);
+            }
+        }
+    }
+
+    w.put<uint32_t>(leaves.size());
+    for (SGPropertyNode* node : leaves) {
+        simgear::props::Type type = node->getType();
+        w.putString(node->getPath());
+        w.put<uint8_t>(type);
+        switch (type) {
+        case simgear::props::BOOL:
+            w.put<uint8_t>(node->getBoolValue());
+            break;
+        case simgear::props::INT:
+            w.put<int32_t>(node->getIntValue());
+            break;
+        case simgear::props::LONG:
+            w.put<int64_t>(node->getLongValue());
+            break;
+        case simgear::props::FLOAT:
+            w.put<float>(node->getFloatValue());
+            break;
+        case simgear::props::DOUBLE:
+            w.put<double>(node->getDoubleValue());
+            break;
+        default:
+            w.putString(node->getStringValue());
+            break;
+        }
+    }
+}
+
+struct PropertyValue
+{
+    string path;
+    uint8_t type;
+    int64_t intValue;
+    double doubleValue;
+    string stringValue;
+};
+
+bool restoreProperties(SnapshotReader& r)
+{
+    // the smallest entry: an empty path, its type and a bool
+    uint32_t n = r.get<uint32_t>();
+    if (!r.haveItems(n, 4 + 1 + 1)) {
+        return false;
+    }
+
+    std::vector<PropertyValue> values(n);
+    for (PropertyValue& v : values) {
+        v.path = r.getString();
+        v.type = r.get<uint8_t>();
+        v.intValue = 0;
+        v.doubleValue = 0;
+        switch (v.type) {
+        case simgear::props::BOOL:
+            v.intValue = r.get<uint8_t>();
+            break;
+        case simgear::props::INT:
+            v.intValue = r.get<int32_t>();
+            break;
+        case simgear::props::LONG:
+            v.intValue = r.get<int64_t>();
+            break;
+        case simgear::props::FLOAT:
+            v.doubleValue = r.get<float>();
+            break;
+        case simgear::props::DOUBLE:
+            v.doubleValue = r.get<double>();
+            break;
+        case simgear::props::STRING:
+        case simgear::props::UNSPECIFIED:
+            v.stringValue = r.getString();
+            break;
+        default:
+            r.fail();
+            break;
+        }
+    }
+
+    if (r.failed()) {
+        return false;
+    }
+
+    // only set what changed, so listeners of the others stay quiet
+    for (const PropertyValue& v : values) {
+        SGPropertyNode* node = fgGetNode(v.path.c_str(), true);
+        if (node->isTied() || node->isAlias() ||
+            !node->getAttribute(SGPropertyNode::WRITE))
+        {
+            continue;
+        }
+
+        bool sameType = (node->getType() == simgear::props::Type(v.type));
+        switch (v.type) {
+        case simgear::props::BOOL:
+            if (!sameType || node->getBoolValue() != (v.intValue != 0))
+                node->setBoolValue(v.intValue != 0);
+            break;
+        case simgear::props::INT:
+            if (!sameType || node->getIntValue() != v.intValue)
+                node->setIntValue(v.intValue);
+            break;
+        case simgear::props::LONG:
+            if (!sameType || node->getLongValue() != v.intValue)
+                node->setLongValue(v.intValue);
+            break;
+        case simgear::props::FLOAT:
+            if (!sameType || node->getFloatValue() != float(v.doubleValue))
+                node->setFloatValue(v.doubleValue);
+            break;
+        case simgear::props::DOUBLE:
+            if (!sameType || node->getDoubleValue() != v.doubleValue)
+                node->setDoubleValue(v.doubleValue);
+            break;
+        case simgear::props::STRING:
+            if (!sameType || v.stringValue != node->getStringValue())
+                node->setStringValue(v.stringValue);
+            break;
+        default:
+            if (!sameType || v.stringValue != node->getStringValue())
+                node->setUnspecifiedValue(v.stringValue.c_str());
+            break;
+        }
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// the whole snapshot
+////////////////////////////////////////////////////////////////////////
+
+bool makeSnapshot(string& data)
+{
+    FGInterface* fdm = currentFDM();
+    if (!fdm) {
+        SG_LOG(SG_GENERAL, SG_WARN, "snapshot: no FDM running, nothing to save");
+        return false;
+    }
+
+    SnapshotWriter w;
+    w.put<uint32_t>(snapshotMagic);
+    w.put<uint32_t>(snapshotFormat);
+    w.putString(fgGetString("/sim/aircraft"));
+    w.putString(fgGetString("/sim/flight-model"));
+
+    w.beginSection(SECTION_PROPERTIES);
+    saveProperties(w);
+    w.endSection();
+
+    w.beginSection(SECTION_FDM);
+    fdm->saveSnapshot(w);
+    w.endSection();
+
+    FGAIManager* ai = globals->get_subsystem<FGAIManager>();
+    if (ai) {
+        w.beginSection(SECTION_AI);
+        ai->saveSnapshot(w);
+        w.endSection();
+    }
+
+    FGReplay* replay = (FGReplay*) globals->get_subsystem("replay");
+    if (replay) {
+        w.beginSection(SECTION_REPLAY);
+        w.put<double>(replay->getRecordTime());
+        w.endSection();
+    }
+
+    data = w.data();
+    return true;
+}
+
+void warnDamaged(const char* what, const string& source)
+{
+    SG_LOG(SG_GENERAL, SG_WARN, "snapshot " << source << ": could not restore "
+           << what << ", the data is damaged");
+}
+
+bool applySnapshot(const string& data, const string& source)
+{
+    SGTimeStamp st;
+    st.stamp();
+
+    SnapshotReader r(data.data(), data.data() + data.size());
+    if ((r.get<uint32_t>() != snapshotMagic) ||
+        (r.get<uint32_t>() != snapshotFormat))
+    {
+        SG_LOG(SG_GENERAL, SG_WARN, "snapshot " << source << " has an unknown format");
+        return false;
+    }
+
+    string aircraft = r.getString();
+    string flightModel = r.getString();
+    if (r.failed()) {
+        warnDamaged("anything", source);
+        return false;
+    }
+
+    if ((aircraft != fgGetString("/sim/aircraft")) ||
+        (flightModel != fgGetString("/sim/flight-model")))
+    {
+        SG_LOG(SG_GENERAL, SG_WARN, "snapshot " << source << " was taken with "
+               << aircraft << " (" << flightModel << "), not the current aircraft");
+        return false;
+    }
+
+    FGInterface* fdm = currentFDM();
+    if (!fdm) {
+        SG_LOG(SG_GENERAL, SG_WARN, "snapshot " << source << ": no FDM running");
+        return false;
+    }
+
+    if (fgGetInt("/sim/freeze/replay-state") != 0) {
+        SG_LOG(SG_GENERAL, SG_WARN, "snapshot " << source << ": not restored during replay");
+        return false;
+    }
+
+    // find all sections first, so a truncated snapshot is not half applied
+    std::map<uint32_t, SnapshotReader> sections;
+    uint32_t tag;
+    SnapshotReader section;
+    while (r.nextSection(tag, section)) {
+        sections[tag] = section;
+    }
+
+    if (r.failed() || !r.atEnd()) {
+        warnDamaged("anything", source);
+        return false;
+    }
+
+    // properties first: the FDM takes fuel and controls from there
+    std::map<uint32_t, SnapshotReader>::iterator it;
+    it = sections.find(SECTION_PROPERTIES);
+    if ((it != sections.end()) && !restoreProperties(it->second)) {
+        warnDamaged("the properties", source);
+    }
+
+    it = sections.find(SECTION_FDM);
+    if ((it != sections.end()) && !fdm->restoreSnapshot(it->second)) {
+        warnDamaged("the FDM state", source);
+    }
+
+    FGAIManager* ai = globals->get_subsystem<FGAIManager>();
+    it = sections.find(SECTION_AI);
+    if (ai && (it != sections.end()) && !ai->restoreSnapshot(it->second)) {
+        warnDamaged("the AI objects", source);
+    }
+
+    FGReplay* replay = (FGReplay*) globals->get_subsystem("replay");
+    it = sections.find(SECTION_REPLAY);
+    if (replay && (it != sections.end())) {
+        double recordTime = it->second.get<double>();
+        if (it->second.failed()) {
+            warnDamaged("the replay buffer", source);
+        } else {
+            replay->rewindTo(recordTime);
+        }
+    }
+
+    SG_LOG(SG_GENERAL, SG_INFO, "restored snapshot " << source << " in "
+           << (SGTimeStamp::now() - st).toMSecs() << " ms");
+    return true;
+}
+
+} // of anonymous namespace
+
+void SnapshotWriter::beginSection(uint32_t tag)
+{
+    put<uint32_t>(tag);
+    _openSections.push_back(_data.size());
+    put<uint32_t>(0); // the length, known at endSection()
+}
+
+void SnapshotWriter::endSection()
+{
+    size_t start = _openSections.back();
+    _openSections.pop_back();
+    uint32_t length = _data.size() - start - sizeof(uint32_t);
+    memcpy(&_data[start], &length, sizeof(uint32_t));
+}
+
+string SnapshotReader::getString()
+{
+    uint32_t n = get<uint32_t>();
+    if (!have(n)) {
+        return string();
+    }
+    string s(_p, n);
+    _p += n;
+    return s;
+}
+
+bool SnapshotReader::nextSection(uint32_t& tag, SnapshotReader& section)
+{
+    if (_failed || atEnd()) {
+        return false;
+    }
+
+    tag = get<uint32_t>();
+    uint32_t length = get<uint32_t>();
+    if (!have(length)) {
+        return false;
+    }
+
+    section = SnapshotReader(_p, _p + length);
+    _p += length;
+    return true;
+}
+
+bool saveSnapshot(const string& name)
+{
+    string data;
+    if (!makeSnapshot(data)) {
+        return false;
+    }
+
+    SG_LOG(SG_GENERAL, SG_INFO, "saved snapshot '" << name << "', "
+           << data.size() << " bytes");
+    snapshots[name].swap(data);
+    return true;
+}
+
+bool saveSnapshot(const string& name, const SGPath& file)
+{
+    if (!saveSnapshot(name)) {
+        return false;
+    }
+
+    const string& data = snapshots[name];
+    sg_ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+    if (!out) {
+        SG_LOG(SG_GENERAL, SG_ALERT, "failed to write snapshot " << file);
+        return false;
+    }
+
+    SG_LOG(SG_GENERAL, SG_INFO, "saved snapshot to " << file);
+    return true;
+}
+
+bool restoreSnapshot(const string& name)
+{
+    SnapshotDict::const_iterator it = snapshots.find(name);
+    if (it == snapshots.end()) {
+        SG_LOG(SG_GENERAL, SG_WARN, "no snapshot named '" << name << "'");
+        return false;
+    }
+
+    return applySnapshot(it->second, "'" + name + "'");
+}
+
+bool restoreSnapshotFile(const SGPath& file)
+{
+    sg_ifstream in(file, std::ios::in | std::ios::binary);
+    std::ostringstream data;
+    data << in.rdbuf();
+    if (!in) {
+        SG_LOG(SG_GENERAL, SG_WARN, "failed to read snapshot " << file);
+        return false;
+    }
+
+    return applySnapshot(data.str(), file.utf8Str());
+}
+
+} // of namespace flightgear
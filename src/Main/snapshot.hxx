@@ -0,0 +1,146 @@
+// snapshot.hxx - binary snapshots of the simulator state for fast resets
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_SNAPSHOT_HXX
+#define FG_SNAPSHOT_HXX
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class SGPath;
+
+namespace flightgear
+{
+
+/**
+ * Builds a snapshot in memory. Values are stored in the byte order of the
+ * machine, since a snapshot is only meant to be restored by the same build
+ * which made it.
+ *
+ * Sections group the data of one part of the simulator. Each one starts
+ * with a tag and its length, so a reader can skip the ones it does not
+ * know or cannot use. Sections may be nested.
+ */
+class SnapshotWriter
+{
+public:
+    template <class T>
+    void put(T value)
+    {
+        const char* p = reinterpret_cast<const char*>(&value);
+        _data.append(p, sizeof(T));
+    }
+
+    void putString(const std::string& s)
+    {
+        put<uint32_t>(s.size());
+        _data.append(s);
+    }
+
+    void beginSection(uint32_t tag);
+    void endSection();
+
+    const std::string& data() const { return _data; }
+
+private:
+    std::string _data;
+    std::vector<size_t> _openSections;
+};
+
+/**
+ * Reads a snapshot, or one of its sections. Running past the end sets
+ * failed() and returns zeros from then on, so the data of a section can
+ * be read first and checked once before any of it is applied.
+ */
+class SnapshotReader
+{
+public:
+    SnapshotReader() :
+        _p(0), _end(0), _failed(false)
+    { }
+
+    SnapshotReader(const char* begin, const char* end) :
+        _p(begin), _end(end), _failed(false)
+    { }
+
+    template <class T>
+    T get()
+    {
+        T value = T();
+        if (!have(sizeof(T))) {
+            return value;
+        }
+        memcpy(&value, _p, sizeof(T));
+        _p += sizeof(T);
+        return value;
+    }
+
+    std::string getString();
+
+    /// Read the next section into 'section' and skip past it. Returns
+    /// false at the end of the data, or if it is damaged.
+    bool nextSection(uint32_t& tag, SnapshotReader& section);
+
+    /// check a count read from the snapshot against the bytes left, before
+    /// allocating anything for it
+    bool haveItems(uint32_t n, size_t minItemSize)
+    { return have(size_t(n) * minItemSize); }
+
+    bool atEnd() const { return _p == _end; }
+    bool failed() const { return _failed; }
+    void fail() { _failed = true; }
+
+private:
+    bool have(size_t n)
+    {
+        if (_failed || size_t(_end - _p) < n) {
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const char* _p;
+    const char* _end;
+    bool _failed;
+};
+
+/**
+ * Take a snapshot of the simulation: the untied values of the property
+ * subtrees listed in /sim/snapshot/property-root (or a default set of
+ * them), the state of the FDM, the kinematics of the AI objects and the
+ * head of the replay buffer.
+ *
+ * Snapshots are kept in memory under a name. Saving to a file as well
+ * keeps it beyond the session, for the same aircraft and FDM.
+ */
+bool saveSnapshot(const std::string& name);
+bool saveSnapshot(const std::string& name, const SGPath& file);
+
+/**
+ * Put the simulation back into the state of a snapshot kept in memory,
+ * or read from a file. Fails without changing anything if the snapshot
+ * is missing, truncated or was taken with a different aircraft or FDM.
+ * Not allowed during a replay, which owns the state then.
+ */
+bool restoreSnapshot(const std::string& name);
+bool restoreSnapshotFile(const SGPath& file);
+
+} // of namespace flightgear
+
+#endif // of FG_SNAPSHOT_HXX
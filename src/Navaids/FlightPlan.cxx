@@ -26,6 +26,7 @@
 #include <map>
 #include <fstream>
 #include <cassert>
+#include <limits>
 
 // Boost
 #include <boost/algorithm/string/case_conv.hpp>
@@ -69,7 +70,9 @@ FlightPlan::FlightPlan() :
   _sid(NULL),
   _star(NULL),
   _approach(NULL),
-  _totalDistance(0.0)
+  _totalDistance(0.0),
+  _routePathPrefix(std::numeric_limits<int>::max()),
+  _routePathSuffix(std::numeric_limits<int>::max())
 {
   _departureChanged = _arrivalChanged = _waypointsChanged = _currentWaypointChanged = false;
   
@@ -185,6 +188,7 @@ void FlightPlan::insertWayptsAtIndex(const WayptVec& wps, int aIndex)
   
   lockDelegates();
   _waypointsChanged = true;
+  legsChanged(index, 0);
   _legs.insert(it, newLegs.begin(), newLegs.end());
   unlockDelegates();
 }
@@ -203,6 +207,7 @@ void FlightPlan::deleteIndex(int aIndex)
   
   lockDelegates();
   _waypointsChanged = true;
+  legsChanged(index, 1);
   
   LegVec::iterator it = _legs.begin();
   it += index;
@@ -235,6 +240,7 @@ void FlightPlan::clear()
   _departureChanged = true;
   
   _currentIndex = -1;
+  allLegsChanged();
   for (Leg* l : _legs) {
     delete l;
   }
@@ -295,6 +301,17 @@ int FlightPlan::clearWayptsWithFlag(WayptFlag flag)
         _currentIndex = -1;
     }
   
+// the range of legs affected, for the route path
+  int firstFlagged = -1, lastFlagged = -1;
+  for (int i=0; i<numLegs(); ++i) {
+    if (_legs[i]->waypoint()->flag(flag)) {
+      if (firstFlagged < 0) {
+        firstFlagged = i;
+      }
+      lastFlagged = i;
+    }
+  }
+
 // now delete and remove
   RemoveWithFlag rf(flag);
   LegVec::iterator it = std::remove_if(_legs.begin(), _legs.end(), rf);
@@ -304,6 +321,7 @@ int FlightPlan::clearWayptsWithFlag(WayptFlag flag)
   
   lockDelegates();
   _waypointsChanged = true;
+  legsChanged(firstFlagged, lastFlagged - firstFlagged + 1);
   if ((count > 0) || currentIsBeingCleared) {
     _currentWaypointChanged = true;
   }
@@ -412,6 +430,18 @@ FlightPlan::Leg* FlightPlan::legAtIndex(int index) const
   return _legs[index];
 }
   
+void FlightPlan::waypointModified(Waypt* aWpt)
+{
+  // the route path reads the altitude and speed of hdgToAlt legs and
+  // the like, so the legs of the waypoint have to be recomputed
+  for (Leg* l : _legs) {
+    if (l->waypoint() == aWpt) {
+      l->markModified();
+      return; // delegates may have changed the legs
+    }
+  }
+}
+
 int FlightPlan::findLegIndex(const Leg *l) const
 {
   for (unsigned int i=0; i<_legs.size(); ++i) {
@@ -680,6 +710,7 @@ bool FlightPlan::load(const SGPath& path)
   
   bool Status = false;
   lockDelegates();
+  allLegsChanged();
 
   // try different file formats
   if (loadGpxFormat(path)) // GPX format
@@ -1197,6 +1228,7 @@ void FlightPlan::activate()
       WayptVec wps = via->expandToWaypoints(preceeding);
       
       // delete the VIA leg
+      legsChanged(i, 1);
       LegVec::iterator it = _legs.begin();
       it += i;
       Leg* l = *it;
@@ -1326,6 +1358,19 @@ void FlightPlan::Leg::setAltitude(RouteRestriction ty, int altFt)
   _altitudeFt = altFt;
 }
 
+void FlightPlan::Leg::markModified()
+{
+  int i = _parent->findLegIndex(this);
+  if (i < 0) {
+    return;
+  }
+
+  _parent->lockDelegates();
+  _parent->_waypointsChanged = true;
+  _parent->legsChanged(i, 1);
+  _parent->unlockDelegates();
+}
+
 double FlightPlan::Leg::courseDeg() const
 {
   return _courseDeg;
@@ -1345,7 +1390,7 @@ void FlightPlan::rebuildLegData()
 {
   _totalDistance = 0.0;
   double totalDistanceIncludingMissed = 0.0;
-  RoutePath path(this);
+  const RoutePath& path(routePath());
   
   for (unsigned int l=0; l<_legs.size(); ++l) {
     _legs[l]->_courseDeg = path.trackForIndex(l);
@@ -1365,8 +1410,27 @@ void FlightPlan::rebuildLegData()
   
 SGGeod FlightPlan::pointAlongRoute(int aIndex, double aOffsetNm) const
 {
-    RoutePath rp(this);
-    return rp.positionForDistanceFrom(aIndex, aOffsetNm * SG_NM_TO_METER);
+    return routePath().positionForDistanceFrom(aIndex, aOffsetNm * SG_NM_TO_METER);
+}
+
+const RoutePath& FlightPlan::routePath() const
+{
+    if (!_routePath) {
+        _routePath.reset(new RoutePath(this));
+    } else if (_routePathRevision != _revision) {
+        _routePath->update(this, _routePathPrefix, _routePathSuffix);
+    }
+
+    _routePathRevision = _revision;
+    _routePathPrefix = _routePathSuffix = std::numeric_limits<int>::max();
+    return *_routePath;
+}
+
+void FlightPlan::legsChanged(int index, int count)
+{
+    _routePathPrefix = std::min(_routePathPrefix, index);
+    _routePathSuffix = std::min(_routePathSuffix, numLegs() - (index + count));
+    ++_revision;
 }
     
 void FlightPlan::lockDelegates()
@@ -1475,6 +1539,9 @@ FlightPlan::Delegate::~Delegate()
 
 void FlightPlan::setFollowLegTrackToFixes(bool tf)
 {
+    if (tf != _followLegTrackToFix) {
+        ++_revision; // the route path recomputes all legs itself
+    }
     _followLegTrackToFix = tf;
 }
 
@@ -1500,6 +1567,9 @@ void FlightPlan::setIcaoAircraftCategory(const std::string& cat)
         throw sg_range_exception("Invalid ICAO aircraft category:", cat);
     }
 
+    if (cat[0] != _aircraftCategory) {
+        ++_revision; // the route path recomputes all legs itself
+    }
     _aircraftCategory = cat[0];
 }
 
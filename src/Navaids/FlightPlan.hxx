@@ -24,9 +24,13 @@
 #ifndef FG_FLIGHTPLAN_HXX
 #define FG_FLIGHTPLAN_HXX
 
+#include <memory>
+
 #include <Navaids/route.hxx>
 #include <Airports/airport.hxx>
 
+class RoutePath;
+
 namespace flightgear
 {
 
@@ -50,6 +54,8 @@ public:
   virtual std::string ident() const;
   void setIdent(const std::string& s);
 
+  virtual void waypointModified(Waypt* aWpt);
+
     // propogate the GPS/FMS setting for this through to the RoutePath
     void setFollowLegTrackToFixes(bool tf);
     bool followLegTrackToFixes() const;
@@ -90,6 +96,12 @@ public:
     void setSpeed(RouteRestriction ty, double speed);
     void setAltitude(RouteRestriction ty, int altFt);
 
+    /**
+     * the waypoint of this leg was modified in place, e.g. its flags:
+     * recompute the route path around it and notify the delegates
+     */
+    void markModified();
+
     double courseDeg() const;
     double distanceNm() const;
     double distanceAlongRoute() const;
@@ -230,6 +242,20 @@ public:
    */
   SGGeod pointAlongRoute(int aIndex, double aOffsetNm) const;
 
+  /**
+   * the route path of the legs, cached: after a change, only the legs
+   * around it are recomputed on the next call. The reference stays valid
+   * for the lifetime of the plan.
+   */
+  const RoutePath& routePath() const;
+
+  /**
+   * incremented whenever the legs or the settings affecting the route
+   * path change, for users caching data derived from it
+   */
+  unsigned int revision() const
+  { return _revision; }
+
   /**
    * Create a WayPoint from a string in the following format:
    *  - simple identifier
@@ -259,6 +285,12 @@ private:
   void unlockDelegates();
 
   void notifyCleared();
+
+  /// legs [index, index + count) are about to be modified or removed, or
+  /// new legs inserted at index when count is 0
+  void legsChanged(int index, int count);
+  void allLegsChanged()
+  { legsChanged(0, _legs.size()); }
     
   unsigned int _delegateLock = 0;
   bool _arrivalChanged,
@@ -295,6 +327,12 @@ private:
   typedef std::vector<Leg*> LegVec;
   LegVec _legs;
 
+  unsigned int _revision = 0;
+  mutable std::unique_ptr<RoutePath> _routePath;
+  mutable unsigned int _routePathRevision = 0;
+  // legs untouched since _routePath was last updated, at the start and end
+  mutable int _routePathPrefix, _routePathSuffix;
+
     std::vector<Delegate*> _delegates;
 };
 
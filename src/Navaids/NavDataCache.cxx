@@ -28,6 +28,8 @@
 // std
 #include <cstddef>  // for std::size_t
 #include <map>
+#include <unordered_map>
+#include <algorithm>
 #include <cassert>
 #include <stdint.h> // for int64_t
 #include <sstream>  // for std::ostringstream
@@ -247,7 +249,8 @@ public:
     cacheHits(0),
     cacheMisses(0),
     transactionLevel(0),
-    transactionAborted(false)
+    transactionAborted(false),
+    freqIndexValid(false)
   {
   }
 
@@ -328,6 +331,7 @@ public:
     }
     prepared.clear();
     sqlite3_close(db);
+    invalidateFreqIndex();
   }
 
   void checkCacheFile()
@@ -554,17 +558,13 @@ public:
     findClosestWithIdent = prepare("SELECT rowid FROM positioned WHERE ident=?1 "
                                    AND_TYPED " ORDER BY distanceCartSqr(cart_x, cart_y, cart_z, ?4, ?5, ?6)");
 
-    findCommByFreq = prepare("SELECT positioned.rowid FROM positioned, comm WHERE "
-                             "positioned.rowid=comm.rowid AND freq_khz=?1 "
-                             AND_TYPED " ORDER BY distanceCartSqr(cart_x, cart_y, cart_z, ?4, ?5, ?6)");
+    loadCommFreqIndex = prepare("SELECT positioned.rowid, freq_khz, type, cart_x, cart_y, cart_z "
+                                "FROM positioned, comm WHERE positioned.rowid=comm.rowid "
+                                "ORDER BY positioned.rowid");
 
-    findNavsByFreq = prepare("SELECT positioned.rowid FROM positioned, navaid WHERE "
-                             "positioned.rowid=navaid.rowid "
-                             "AND navaid.freq=?1 " AND_TYPED
-                             " ORDER BY distanceCartSqr(cart_x, cart_y, cart_z, ?4, ?5, ?6)");
-
-    findNavsByFreqNoPos = prepare("SELECT positioned.rowid FROM positioned, navaid WHERE "
-                                  "positioned.rowid=navaid.rowid AND freq=?1 " AND_TYPED);
+    loadNavFreqIndex = prepare("SELECT positioned.rowid, freq, type, cart_x, cart_y, cart_z "
+                               "FROM positioned, navaid WHERE positioned.rowid=navaid.rowid "
+                               "ORDER BY positioned.rowid");
 
     findNavaidForRunway = prepare("SELECT positioned.rowid FROM positioned, navaid WHERE "
                                   "positioned.rowid=navaid.rowid AND runway=?1 AND type=?2");
@@ -845,6 +845,88 @@ public:
     deferredOctreeUpdates.clear();
   }
 
+  void invalidateFreqIndex()
+  {
+    freqIndexValid = false;
+    navFreqIndex.clear();
+    commFreqIndex.clear();
+  }
+
+  void loadFreqIndex(sqlite3_stmt_ptr query, FreqIndex& index)
+  {
+    while (stepSelect(query)) {
+      FreqIndexEntry entry;
+      entry.id = sqlite3_column_int64(query, 0);
+      entry.type = static_cast<FGPositioned::Type>(sqlite3_column_int(query, 2));
+      entry.cart = SGVec3d(sqlite3_column_double(query, 3),
+                           sqlite3_column_double(query, 4),
+                           sqlite3_column_double(query, 5));
+      index[sqlite3_column_int(query, 1)].push_back(entry);
+    }
+    reset(query);
+  }
+
+  /**
+   * (re)load the frequency index if anything invalidated it. Radios search
+   * by frequency every few hundred milliseconds, and far more often while
+   * the knob is being turned, so these lookups should not touch sqlite.
+   */
+  void validateFreqIndex()
+  {
+    if (freqIndexValid) {
+      return;
+    }
+
+    SGTimeStamp st;
+    st.stamp();
+    loadFreqIndex(loadNavFreqIndex, navFreqIndex);
+    loadFreqIndex(loadCommFreqIndex, commFreqIndex);
+    freqIndexValid = true;
+    SG_LOG(SG_NAVCACHE, SG_DEBUG, "built frequency index for " << navFreqIndex.size()
+           << " navaid and " << commFreqIndex.size() << " comm frequencies in "
+           << st.elapsedMSec() << "msec");
+  }
+
+  /**
+   * ids of all stations on freqKhz within the type range, in rowid order,
+   * or sorted by distance if pos is given
+   */
+  PositionedIDVec findInFreqIndex(const FreqIndex& index, int freqKhz,
+                                  FGPositioned::Type minType, FGPositioned::Type maxType,
+                                  const SGVec3d* pos)
+  {
+    PositionedIDVec result;
+    FreqIndex::const_iterator it = index.find(freqKhz);
+    if (it == index.end()) {
+      return result;
+    }
+
+    if (!pos) {
+      BOOST_FOREACH(const FreqIndexEntry& entry, it->second) {
+        if ((entry.type >= minType) && (entry.type <= maxType)) {
+          result.push_back(entry.id);
+        }
+      }
+      return result;
+    }
+
+    typedef std::pair<double, PositionedID> DistanceId;
+    std::vector<DistanceId> ranked;
+    BOOST_FOREACH(const FreqIndexEntry& entry, it->second) {
+      if ((entry.type >= minType) && (entry.type <= maxType)) {
+        ranked.push_back(DistanceId(distSqr(entry.cart, *pos), entry.id));
+      }
+    }
+
+    // ties are broken by rowid, so results are stable between calls
+    std::sort(ranked.begin(), ranked.end());
+    result.reserve(ranked.size());
+    BOOST_FOREACH(const DistanceId& r, ranked) {
+      result.push_back(r.second);
+    }
+    return result;
+  }
+
   void removePositionedWithIdent(FGPositioned::Type ty, const std::string& aIdent)
   {
     sqlite3_bind_int(removePOIQuery, 1, ty);
@@ -864,6 +946,21 @@ public:
   PositionedCache cache;
   unsigned int cacheHits, cacheMisses;
 
+  struct FreqIndexEntry
+  {
+    PositionedID id;
+    FGPositioned::Type type;
+    SGVec3d cart;
+  };
+
+  typedef std::vector<FreqIndexEntry> FreqIndexEntryVec;
+  typedef std::unordered_map<int, FreqIndexEntryVec> FreqIndex;
+
+  /// in-memory copy of the navaid and comm frequencies, built on first use
+  /// and dropped whenever a navaid or comm station is added or moved
+  FreqIndex navFreqIndex, commFreqIndex;
+  bool freqIndexValid;
+
   /**
    * record the levels of open transaction objects we have
    */
@@ -893,8 +990,7 @@ public:
     getOctreeLeafChildren;
 
   sqlite3_stmt_ptr searchAirports, getAllAirports;
-  sqlite3_stmt_ptr findCommByFreq, findNavsByFreq,
-  findNavsByFreqNoPos, findNavaidForRunway;
+  sqlite3_stmt_ptr loadCommFreqIndex, loadNavFreqIndex, findNavaidForRunway;
   sqlite3_stmt_ptr getAirportItems, getAirportItemByIdent;
   sqlite3_stmt_ptr findAirportRunway,
     findILS;
@@ -1709,6 +1805,7 @@ void NavDataCache::abortTransaction()
   }
 
   d->transactionAborted = true;
+  d->invalidateFreqIndex(); // rows inserted since the index was built are gone
 }
 
 FGPositionedRef NavDataCache::loadById(PositionedID rowid)
@@ -1790,6 +1887,7 @@ void NavDataCache::updatePosition(PositionedID item, const SGGeod &pos)
 
 
   d->execUpdate(d->setAirportPos);
+  d->invalidateFreqIndex();
 }
 
 void NavDataCache::insertTower(PositionedID airportId, const SGGeod& pos)
@@ -1865,6 +1963,7 @@ NavDataCache::insertNavaid(FGPositioned::Type ty, const string& ident,
   sqlite3_bind_double(d->insertNavaid, 4, multiuse);
   sqlite3_bind_int64(d->insertNavaid, 5, runway);
   sqlite3_bind_int64(d->insertNavaid, 6, 0);
+  d->invalidateFreqIndex();
   return d->execInsert(d->insertNavaid);
 }
 
@@ -1890,6 +1989,7 @@ PositionedID NavDataCache::insertCommStation(FGPositioned::Type ty,
   sqlite3_bind_int64(d->insertCommStation, 1, rowId);
   sqlite3_bind_int(d->insertCommStation, 2, freq);
   sqlite3_bind_int(d->insertCommStation, 3, range);
+  d->invalidateFreqIndex();
   return d->execInsert(d->insertCommStation);
 }
 
@@ -1907,6 +2007,7 @@ PositionedID NavDataCache::createPOI(FGPositioned::Type ty, const std::string& i
 bool NavDataCache::removePOI(FGPositioned::Type ty, const std::string& aIdent)
 {
   d->removePositionedWithIdent(ty, aIdent);
+  d->invalidateFreqIndex();
   // should remove from the live cache too?
 
     return true;
@@ -2081,68 +2182,57 @@ char** NavDataCache::searchAirportNamesAndIdents(const std::string& aFilter)
 FGPositionedRef
 NavDataCache::findCommByFreq(int freqKhz, const SGGeod& aPos, FGPositioned::Filter* aFilter)
 {
-  sqlite3_bind_int(d->findCommByFreq, 1, freqKhz);
+  FGPositioned::Type minType = FGPositioned::FREQ_GROUND,
+    maxType = FGPositioned::FREQ_UNICOM; // full type range
   if (aFilter) {
-    sqlite3_bind_int(d->findCommByFreq, 2, aFilter->minType());
-    sqlite3_bind_int(d->findCommByFreq, 3, aFilter->maxType());
-  } else { // full type range
-    sqlite3_bind_int(d->findCommByFreq, 2, FGPositioned::FREQ_GROUND);
-    sqlite3_bind_int(d->findCommByFreq, 3, FGPositioned::FREQ_UNICOM);
+    minType = aFilter->minType();
+    maxType = aFilter->maxType();
   }
 
+  d->validateFreqIndex();
   SGVec3d cartPos(SGVec3d::fromGeod(aPos));
-  sqlite3_bind_double(d->findCommByFreq, 4, cartPos.x());
-  sqlite3_bind_double(d->findCommByFreq, 5, cartPos.y());
-  sqlite3_bind_double(d->findCommByFreq, 6, cartPos.z());
-  FGPositionedRef result;
+  PositionedIDVec ids(d->findInFreqIndex(d->commFreqIndex, freqKhz,
+                                         minType, maxType, &cartPos));
 
-  while (d->execSelect(d->findCommByFreq)) {
-    FGPositionedRef p = loadById(sqlite3_column_int64(d->findCommByFreq, 0));
+  BOOST_FOREACH(PositionedID id, ids) {
+    FGPositionedRef p = loadById(id);
     if (aFilter && !aFilter->pass(p)) {
       continue;
     }
 
-    result = p;
-    break;
+    return p;
   }
 
-  d->reset(d->findCommByFreq);
-  return result;
+  return FGPositionedRef();
 }
 
 PositionedIDVec
 NavDataCache::findNavaidsByFreq(int freqKhz, const SGGeod& aPos, FGPositioned::Filter* aFilter)
 {
-  sqlite3_bind_int(d->findNavsByFreq, 1, freqKhz);
+  FGPositioned::Type minType = FGPositioned::NDB,
+    maxType = FGPositioned::GS; // full type range
   if (aFilter) {
-    sqlite3_bind_int(d->findNavsByFreq, 2, aFilter->minType());
-    sqlite3_bind_int(d->findNavsByFreq, 3, aFilter->maxType());
-  } else { // full type range
-    sqlite3_bind_int(d->findNavsByFreq, 2, FGPositioned::NDB);
-    sqlite3_bind_int(d->findNavsByFreq, 3, FGPositioned::GS);
+    minType = aFilter->minType();
+    maxType = aFilter->maxType();
   }
 
+  d->validateFreqIndex();
   SGVec3d cartPos(SGVec3d::fromGeod(aPos));
-  sqlite3_bind_double(d->findNavsByFreq, 4, cartPos.x());
-  sqlite3_bind_double(d->findNavsByFreq, 5, cartPos.y());
-  sqlite3_bind_double(d->findNavsByFreq, 6, cartPos.z());
-
-  return d->selectIds(d->findNavsByFreq);
+  return d->findInFreqIndex(d->navFreqIndex, freqKhz, minType, maxType, &cartPos);
 }
 
 PositionedIDVec
 NavDataCache::findNavaidsByFreq(int freqKhz, FGPositioned::Filter* aFilter)
 {
-  sqlite3_bind_int(d->findNavsByFreqNoPos, 1, freqKhz);
+  FGPositioned::Type minType = FGPositioned::NDB,
+    maxType = FGPositioned::GS; // full type range
   if (aFilter) {
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 2, aFilter->minType());
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 3, aFilter->maxType());
-  } else { // full type range
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 2, FGPositioned::NDB);
-    sqlite3_bind_int(d->findNavsByFreqNoPos, 3, FGPositioned::GS);
+    minType = aFilter->minType();
+    maxType = aFilter->maxType();
   }
 
-  return d->selectIds(d->findNavsByFreqNoPos);
+  d->validateFreqIndex();
+  return d->findInFreqIndex(d->navFreqIndex, freqKhz, minType, maxType, NULL);
 }
 
 PositionedIDVec
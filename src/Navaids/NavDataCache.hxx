@@ -227,7 +227,9 @@ public:
 
   /**
    * Find all navaids matching a particular frequency, sorted by range from the
-   * supplied position. Type-range will be determined from the filter
+   * supplied position. Type-range will be determined from the filter.
+   * Answered from an in-memory frequency index rather than sqlite, so this
+   * is cheap enough to call on every radio search.
    */
   PositionedIDVec findNavaidsByFreq(int freqKhz, const SGGeod& pos, FGPositioned::Filter* filt);
 
@@ -118,14 +118,28 @@ bool Waypt::matches(const SGGeod& aPos) const
 
 void Waypt::setAltitude(double aAlt, RouteRestriction aRestrict)
 {
+  if ((aAlt == _altitudeFt) && (aRestrict == _altRestrict)) {
+    return;
+  }
+
   _altitudeFt = aAlt;
   _altRestrict = aRestrict;
+  if (_owner) {
+    _owner->waypointModified(this);
+  }
 }
 
 void Waypt::setSpeed(double aSpeed, RouteRestriction aRestrict)
 {
+  if ((aSpeed == _speed) && (aRestrict == _speedRestrict)) {
+    return;
+  }
+
   _speed = aSpeed;
   _speedRestrict = aRestrict;
+  if (_owner) {
+    _owner->waypointModified(this);
+  }
 }
 
 double Waypt::speedKts() const
@@ -379,11 +393,23 @@ void RouteBase::dumpRouteToKMLLineString(const std::string& aIdent,
 }
 
 void RouteBase::loadAirportProcedures(const SGPath& aPath, FGAirport* aApt)
+{
+  sg_ifstream input(aPath);
+  if (!input) {
+    SG_LOG(SG_NAVAID, SG_WARN, "failure opening procedures: " << aPath);
+    return;
+  }
+
+  loadAirportProcedures(aPath, input, aApt);
+}
+
+void RouteBase::loadAirportProcedures(const SGPath& aPath, std::istream& aStream,
+                                      FGAirport* aApt)
 {
   assert(aApt);
   try {
     NavdataVisitor visitor(aApt, aPath);
-      readXML(aPath, visitor);
+      readXML(aStream, visitor, aPath.utf8Str());
   } catch (sg_io_exception& ex) {
     SG_LOG(SG_NAVAID, SG_WARN, "failure parsing procedures: " << aPath <<
       "\n\t" << ex.getMessage() << "\n\tat:" << ex.getLocation().asString());
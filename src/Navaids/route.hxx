@@ -222,8 +222,21 @@ public:
    *
    */
   virtual std::string ident() const = 0;
+
+  /**
+   * One of the waypoints owned by this route changed its altitude or
+   * speed in place. Routes caching data derived from them override this.
+   */
+  virtual void waypointModified(Waypt* aWpt)
+    { }
   
   static void loadAirportProcedures(const SGPath& aPath, FGAirport* aApt);
+
+  /**
+   * As above, with the file contents already read into 'aStream'
+   */
+  static void loadAirportProcedures(const SGPath& aPath, std::istream& aStream,
+                                    FGAirport* aApt);
   
   static void dumpRouteToKML(const WayptVec& aRoute, const std::string& aName);
   
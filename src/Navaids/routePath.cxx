@@ -4,6 +4,7 @@
 #endif
 
 #include <algorithm>
+#include <limits>
 
 #include <Navaids/routePath.hxx>
 
@@ -228,6 +229,13 @@ TurnInfo turnCenterAndAngleFromExit(const SGGeod& pt, double outHeadingDeg,
     return r;
 }
 
+static bool sameGeod(const SGGeod& a, const SGGeod& b)
+{
+  return (a.getLongitudeRad() == b.getLongitudeRad()) &&
+    (a.getLatitudeRad() == b.getLatitudeRad()) &&
+    (a.getElevationM() == b.getElevationM());
+}
+
 class WayptData
 {
 public:
@@ -576,6 +584,35 @@ public:
       theta = copysign(theta, turnEntryAngle);
       return pointOnEntryTurnFromHeading(legCourseTrue + theta);
   }
+
+  /**
+   * exact comparison, used to detect when recomputing after a change
+   * produces the same data as before
+   */
+  bool sameAs(const WayptData& o) const
+  {
+    if ((wpt != o.wpt) || (hasEntry != o.hasEntry) || (posValid != o.posValid) ||
+        (legCourseValid != o.legCourseValid) || (skipped != o.skipped) ||
+        (flyOver != o.flyOver))
+    {
+      return false;
+    }
+
+    if (!sameGeod(pos, o.pos) || !sameGeod(turnEntryPos, o.turnEntryPos) ||
+        !sameGeod(turnExitPos, o.turnExitPos) ||
+        !sameGeod(turnEntryCenter, o.turnEntryCenter) ||
+        !sameGeod(turnExitCenter, o.turnExitCenter))
+    {
+      return false;
+    }
+
+    return (turnEntryAngle == o.turnEntryAngle) &&
+      (turnExitAngle == o.turnExitAngle) && (turnRadius == o.turnRadius) &&
+      (legCourseTrue == o.legCourseTrue) && (pathDistanceM == o.pathDistanceM) &&
+      (turnPathDistanceM == o.turnPathDistanceM) &&
+      (overflightCompensationAngle == o.overflightCompensationAngle) &&
+      (viaWaypoints == o.viaWaypoints);
+  }
   
   WayptRef wpt;
   bool hasEntry, posValid, legCourseValid, skipped;
@@ -585,6 +622,8 @@ public:
   double turnPathDistanceM; // for flyBy, this is half the distance; for flyOver it's the complete distance
   double overflightCompensationAngle;
   bool flyOver;
+  // for a VIA, the airway expanded from the previous waypoint
+  WayptVec viaWaypoints;
 };
 
 typedef std::vector<WayptData> WayptDataVec;
@@ -617,8 +656,19 @@ bool isDescentWaypoint(const WayptRef& wpt)
 class RoutePath::RoutePathPrivate
 {
 public:
+    RoutePathPrivate() :
+      aircraftCategory(0),
+      pathTurnRate(3.0),
+      constrainLegCourses(false)
+    { }
+
     WayptDataVec waypoints;
 
+    // the waypoints after pass 0 and 1, and just before their own step of
+    // the leg computation; kept to recompute only what a change affects
+    WayptDataVec initial;
+    WayptDataVec staged;
+
     char aircraftCategory;
     PerformanceBracketVec perf;
     double pathTurnRate;
@@ -885,6 +935,7 @@ public:
   
   void initPerfData()
   {
+      perf.clear();
       pathTurnRate = 3.0; // 3 deg/sec = 180deg/min = standard rate turn
       switch (aircraftCategory) {
       case ICAO_AIRCRAFT_CATEGORY_A:
@@ -937,6 +988,12 @@ public:
     }
 
 
+    int previousValidIndex(int index)
+    {
+        auto it = previousValidWaypoint(index);
+        return (it == waypoints.end()) ? 0 : std::distance(waypoints.begin(), it);
+    }
+
     WayptDataVec::iterator nextValidWaypoint(int index)
     {
         return nextValidWaypoint(waypoints.begin() + index);
@@ -959,75 +1016,207 @@ public:
 RoutePath::RoutePath(const flightgear::FlightPlan* fp) :
   d(new RoutePathPrivate)
 {
+    update(fp, 0, 0);
+}
+
+RoutePath::~RoutePath()
+{
+}
+
+void RoutePath::update(const flightgear::FlightPlan* fp, int unchangedPrefix, int unchangedSuffix)
+{
+    char category = fp->icaoAircraftCategory()[0];
+    bool constrain = fp->followLegTrackToFixes();
+    if ((category != d->aircraftCategory) || (constrain != d->constrainLegCourses)) {
+        // turns change everywhere
+        d->aircraftCategory = category;
+        d->constrainLegCourses = constrain;
+        d->initPerfData();
+        unchangedPrefix = unchangedSuffix = 0;
+    }
+
+    WayptVec wpts;
     for (int l=0; l<fp->numLegs(); ++l) {
         Waypt *wpt = fp->legAtIndex(l)->waypoint();
         if (!wpt) {
             SG_LOG(SG_NAVAID, SG_DEV_ALERT, "Waypoint " << l << " of " << fp->numLegs() << "is NULL");
             break;
         }
-        d->waypoints.push_back(WayptData(wpt));
+        wpts.push_back(wpt);
     }
 
-    d->aircraftCategory = fp->icaoAircraftCategory()[0];
-    d->constrainLegCourses = fp->followLegTrackToFixes();
-    commonInit();
-}
+    const int n = wpts.size();
+    const int oldN = d->initial.size();
+    const int prefix = std::min(std::min(unchangedPrefix, n), oldN);
+    const int suffix = std::min(std::min(unchangedSuffix, n - prefix), oldN - prefix);
+    if ((prefix == n) && (n == oldN)) {
+        return; // nothing changed
+    }
 
-RoutePath::~RoutePath()
-{
+    // legs in the unchanged suffix were at index + shift before
+    const int shift = oldN - n;
+    const int suffixStart = n - suffix;
+
+    // pass 0 and 1 only look at the neighbours: redo them from the leg
+    // before the change, until a leg of the suffix comes out as before
+    WayptDataVec initial;
+    initial.reserve(n);
+    const int begin = std::max(prefix - 1, 0);
+    initial.insert(initial.end(), d->initial.begin(), d->initial.begin() + begin);
+
+    int firstChanged = prefix;
+    int lastChanged = -1;
+    for (int i = begin; i < n; ++i) {
+        if (i == begin) {
+            initial.push_back(WayptData(wpts[i]));
+            initial.back().initPass0();
+        }
+
+        if ((i + 1) < n) {
+            initial.push_back(WayptData(wpts[i + 1]));
+            initial.back().initPass0();
+        }
+
+        if (i > 0) {
+            WayptData* nextPtr = ((i + 1) < n) ? &initial[i + 1] : 0;
+            initial[i].initPass1(initial[i - 1], nextPtr);
+        }
+
+        int old = (i < prefix) ? i : ((i >= suffixStart) ? i + shift : -1);
+        if ((old < 0) || !initial[i].sameAs(d->initial[old])) {
+            firstChanged = std::min(firstChanged, i);
+            lastChanged = i;
+        } else if (i >= suffixStart) {
+            initial.erase(initial.begin() + i + 1, initial.end());
+            initial.insert(initial.end(), d->initial.begin() + i + 1 + shift, d->initial.end());
+            break;
+        }
+    }
+
+    WayptDataVec oldFinal, oldStaged;
+    oldFinal.swap(d->waypoints);
+    oldStaged.swap(d->staged);
+    d->waypoints = initial;
+    d->staged = initial;
+
+    // the step of each leg updates the next valid one: start with the step
+    // of the leg preceding the change
+    int start = (firstChanged > 0) ? d->previousValidIndex(firstChanged) : 0;
+
+    // a descending heading-to-altitude leg looks ahead for the next known
+    // altitude, which may be at or past the change
+    for (int k = 1; k < firstChanged; ++k) {
+        if ((initial[k].wpt->type() != "hdgToAlt") || !isDescentWaypoint(initial[k - 1].wpt)) {
+            continue;
+        }
+
+        int known = d->findNextKnownAltitude(k - 1);
+        if ((known < 0) || (known >= firstChanged)) {
+            start = std::min(start, d->previousValidIndex(k));
+            break;
+        }
+    }
+
+    for (int i = 0; i < start; ++i) {
+        d->waypoints[i] = oldFinal[i];
+        d->staged[i] = oldStaged[i];
+    }
+
+    if (start < firstChanged) {
+        d->waypoints[start] = oldStaged[start];
+    }
+
+    // a climbing heading-to-altitude leg reads the distances back to the
+    // preceding known altitude: the first leg read by any leg after i
+    std::vector<int> vnavReadFrom(n + 1, std::numeric_limits<int>::max());
+    for (int k = n - 1; k > start; --k) {
+        vnavReadFrom[k] = vnavReadFrom[k + 1];
+        if ((initial[k].wpt->type() != "hdgToAlt") || isDescentWaypoint(initial[k - 1].wpt)) {
+            continue;
+        }
+
+        int known = d->findPreceedingKnownAltitude(k - 1);
+        if (known >= 0) {
+            vnavReadFrom[k] = std::min(vnavReadFrom[k], known + 1);
+        }
+    }
+
+    double alt = 0.0; // FIXME
+    double gs = d->groundSpeedForAltitude(alt);
+    double radiusM = ((360.0 / d->pathTurnRate) * gs * SG_KT_TO_MPS) / SGMiscd::twopi();
+
+    for (int i = start; i < n; ++i) {
+        d->staged[i] = d->waypoints[i];
+        computeWaypoint(i, radiusM);
+
+        // past the change, a leg coming out as before, handing on the
+        // same data to the next one, means the rest would too
+        if ((i < suffixStart) || (i <= lastChanged) || (vnavReadFrom[i + 1] <= i)) {
+            continue;
+        }
+
+        if (!d->waypoints[i].sameAs(oldFinal[i + shift])) {
+            continue;
+        }
+
+        auto nextIt = d->nextValidWaypoint(i);
+        if (nextIt != d->waypoints.end()) {
+            int next = std::distance(d->waypoints.begin(), nextIt);
+            if (!nextIt->sameAs(oldStaged[next + shift])) {
+                continue;
+            }
+        }
+
+        for (int j = i + 1; j < n; ++j) {
+            d->waypoints[j] = oldFinal[j + shift];
+            d->staged[j] = oldStaged[j + shift];
+        }
+        break;
+    }
+
+    d->initial.swap(initial);
 }
 
-void RoutePath::commonInit()
+void RoutePath::computeWaypoint(int i, double radiusM)
 {
-  d->initPerfData();
-  
-  WayptDataVec::iterator it;
-  for (it = d->waypoints.begin(); it != d->waypoints.end(); ++it) {
-    it->initPass0();
-  }
-  
-  for (unsigned int i=1; i<d->waypoints.size(); ++i) {
-    WayptData* nextPtr = ((i + 1) < d->waypoints.size()) ? &d->waypoints[i+1] : 0;
-    d->waypoints[i].initPass1(d->waypoints[i-1], nextPtr);
+  if (d->waypoints[i].skipped) {
+      return;
   }
 
-  for (unsigned int i=0; i<d->waypoints.size(); ++i) {
-      if (d->waypoints[i].skipped) {
-          continue;
-      }
+  if (i > 0) {
+      auto prevIt = d->previousValidWaypoint(i);
+      assert(prevIt != d->waypoints.end());
+      d->waypoints[i].computeLegCourse(*prevIt, radiusM);
+      d->computeDynamicPosition(i);
+  }
 
-      double alt = 0.0; // FIXME
-      double gs = d->groundSpeedForAltitude(alt);
-      double radiusM = ((360.0 / d->pathTurnRate) * gs * SG_KT_TO_MPS) / SGMiscd::twopi();
+  auto nextIt = d->nextValidWaypoint(i);
+  if (nextIt != d->waypoints.end()) {
+      nextIt->computeLegCourse(d->waypoints[i], radiusM);
 
-      if (i > 0) {
-          auto prevIt = d->previousValidWaypoint(i);
-          assert(prevIt != d->waypoints.end());
-          d->waypoints[i].computeLegCourse(*prevIt, radiusM);
-          d->computeDynamicPosition(i);
+      if (nextIt->legCourseValid) {
+          d->waypoints[i].computeTurn(radiusM, d->constrainLegCourses, *nextIt);
+      } else {
+        // next waypoint has indeterminate course. Let's create a sharp turn
+        // this can happen when the following point is ATC vectors, for example.
+        d->waypoints[i].turnEntryPos = d->waypoints[i].pos;
+        d->waypoints[i].turnExitPos = d->waypoints[i].pos;
       }
+  } else {
+    // final waypt, fix up some data
+    d->waypoints[i].turnExitPos = d->waypoints[i].pos;
+    d->waypoints[i].turnEntryPos = d->waypoints[i].pos;
+  }
 
-      auto nextIt = d->nextValidWaypoint(i);
-      if (nextIt != d->waypoints.end()) {
-          nextIt->computeLegCourse(d->waypoints[i], radiusM);
-
-          if (nextIt->legCourseValid) {
-              d->waypoints[i].computeTurn(radiusM, d->constrainLegCourses, *nextIt);
-          } else {
-            // next waypoint has indeterminate course. Let's create a sharp turn
-            // this can happen when the following point is ATC vectors, for example.
-            d->waypoints[i].turnEntryPos = d->waypoints[i].pos;
-            d->waypoints[i].turnExitPos = d->waypoints[i].pos;
-          }
-    } else {
-      // final waypt, fix up some data
-      d->waypoints[i].turnExitPos = d->waypoints[i].pos;
-      d->waypoints[i].turnEntryPos = d->waypoints[i].pos;
-    }
-    
-    // now turn is computed, can resolve distances
-    d->waypoints[i].pathDistanceM = computeDistanceForIndex(i);
+  if ((i > 0) && (d->waypoints[i].wpt->type() == "via")) {
+      // expand once here, rather than for every distance and path query
+      auto prevIt = d->previousValidWaypoint(i);
+      Via* via = static_cast<Via*>(d->waypoints[i].wpt.get());
+      d->waypoints[i].viaWaypoints = via->expandToWaypoints(prevIt->wpt);
   }
+
+  // now turn is computed, can resolve distances
+  d->waypoints[i].pathDistanceM = computeDistanceForIndex(i);
 }
 
 SGGeodVec RoutePath::pathForIndex(int index) const
@@ -1050,7 +1239,7 @@ SGGeodVec RoutePath::pathForIndex(int index) const
   }
 
   if (ty == "via") {
-      return pathForVia(static_cast<Via*>(d->waypoints[index].wpt.get()), index);
+      return pathForVia(index);
   }
   
   if (ty== "hold") {
@@ -1113,7 +1302,7 @@ SGGeod RoutePath::positionForIndex(int index) const
   return d->waypoints[index].pos;
 }
 
-SGGeodVec RoutePath::pathForVia(Via* via, int index) const
+SGGeodVec RoutePath::pathForVia(int index) const
 {
     // previous waypoint must be valid for a VIA
     auto prevIt = d->previousValidWaypoint(index);
@@ -1122,7 +1311,7 @@ SGGeodVec RoutePath::pathForVia(Via* via, int index) const
 
     }
 
-    WayptVec enrouteWaypoints = via->expandToWaypoints(prevIt->wpt);
+    const WayptVec& enrouteWaypoints(d->waypoints[index].viaWaypoints);
     SGGeodVec r;
 
     WayptVec::const_iterator it;
@@ -1190,7 +1379,7 @@ double RoutePath::computeDistanceForIndex(int index) const
     }
 
     if (it->wpt->type() == "via") {
-        return distanceForVia(static_cast<Via*>(it->wpt.get()), index);
+        return distanceForVia(index);
     }
 
     auto prevIt = d->previousValidWaypoint(index);
@@ -1207,19 +1396,16 @@ double RoutePath::computeDistanceForIndex(int index) const
     return dist;
 }
 
-double RoutePath::distanceForVia(Via* via, int index) const
+double RoutePath::distanceForVia(int index) const
 {
     auto prevIt = d->previousValidWaypoint(index);
     if (prevIt == d->waypoints.end()) {
         return 0.0;
     }
 
-    WayptVec enrouteWaypoints = via->expandToWaypoints(prevIt->wpt);
     double dist = 0.0;
-
-    WayptVec::const_iterator it;
     SGGeod legStart = prevIt->wpt->position();
-    for (auto wp : enrouteWaypoints) {
+    for (auto wp : d->waypoints[index].viaWaypoints) {
         dist += SGGeodesy::distanceM(legStart, wp->position());
         legStart = wp->position();
     }
@@ -42,6 +42,14 @@ public:
   RoutePath(const flightgear::FlightPlan* fp);
   ~RoutePath();
 
+  /**
+   * Recompute after the legs of the flight plan changed. The first
+   * unchangedPrefix and the last unchangedSuffix legs are the same as when
+   * the path was last computed: computation starts at the change and stops
+   * once the following legs come out as before.
+   */
+  void update(const flightgear::FlightPlan* fp, int unchangedPrefix, int unchangedSuffix);
+
   SGGeodVec pathForIndex(int index) const;
   
   SGGeod positionForIndex(int index) const;
@@ -57,15 +65,15 @@ public:
 private:
   class RoutePathPrivate;
   
-  void commonInit();
+  void computeWaypoint(int index, double radiusM);
   
   double computeDistanceForIndex(int index) const;
 
-  double distanceForVia(flightgear::Via *via, int index) const;
+  double distanceForVia(int index) const;
 
 
   SGGeodVec pathForHold(flightgear::Hold* hold) const;
-  SGGeodVec pathForVia(flightgear::Via* via, int index) const;
+  SGGeodVec pathForVia(int index) const;
   SGGeod positionAlongVia(flightgear::Via* via, int previousIndex, double distanceM) const;
   
   void interpolateGreatCircle(const SGGeod& aFrom, const SGGeod& aTo, SGGeodVec& r) const;
@@ -27,6 +27,8 @@
 #include <string.h>                // strstr()
 #include <stdlib.h>                // strtod(), atoi()
 #include <cstdio>
+#include <cfloat>
+#include <cmath>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/iochannel.hxx>
@@ -265,9 +267,212 @@ union u64 {
     double doubleVal;
 };
 
+namespace {
+
+inline void swap16(char* p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    v = sg_bswap_16(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+inline void swap32(char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    v = sg_bswap_32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+inline void swap64(char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    v = sg_bswap_64(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+// append at most end - p characters, like the snprintf() truncation
+inline char* appendText(char* p, char* end, const char* s, size_t n)
+{
+    if (n > (size_t)(end - p)) {
+        n = end - p;
+    }
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// %d, without going through the locale and format parsing of printf
+int formatInt(char* out, int value)
+{
+    char digits[16];
+    int n = 0;
+    unsigned int u = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[n++] = '0' + (u % 10);
+        u /= 10;
+    } while (u);
+
+    int len = 0;
+    if (value < 0) {
+        out[len++] = '-';
+    }
+    while (n) {
+        out[len++] = digits[--n];
+    }
+    return len;
+}
+
+// %.<precision>f for precision 0 to 9. Returns -1 if the value can't be
+// rounded exactly the way printf does, leaving those to snprintf().
+int formatFixedPoint(char* out, double value, int precision)
+{
+    static const double scales[] = {
+        1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+    };
+
+    double a = fabs(value);
+    if (!(a < 1e15)) {
+        return -1; // NaN, infinity or too many digits
+    }
+
+    // the fraction of a double below 1e15 is exact, its scaled version
+    // is off by a few ulps at most
+    double whole = floor(a);
+    double scaled = (a - whole) * scales[precision];
+    double digits = floor(scaled);
+    double rest = scaled - digits;
+    if (fabs(rest - 0.5) <= (scaled + 1.0) * 4 * DBL_EPSILON) {
+        return -1; // too close to call
+    }
+    if (rest > 0.5) {
+        digits += 1.0;
+        if (digits >= scales[precision]) {
+            digits -= scales[precision];
+            whole += 1.0;
+        }
+    }
+
+    char tmp[32];
+    int n = 0;
+    uint64_t u = (uint64_t)whole;
+    do {
+        tmp[n++] = '0' + (u % 10);
+        u /= 10;
+    } while (u);
+
+    int len = 0;
+    if (std::signbit(value)) {
+        out[len++] = '-';
+    }
+    while (n) {
+        out[len++] = tmp[--n];
+    }
+
+    if (precision > 0) {
+        out[len++] = '.';
+        uint32_t f = (uint32_t)digits;
+        for (int i = precision - 1; i >= 0; --i) {
+            out[len + i] = '0' + (f % 10);
+            f /= 10;
+        }
+        len += precision;
+    }
+    return len;
+}
+
+} // anonymous namespace
+
 // generate the message
 bool FGGeneric::gen_message_binary() {
-    string generic_sentence;
+    if (!_out_plan.fixed) {
+        gen_message_binary_fields();
+    } else {
+        const _binary_plan& plan = _out_plan;
+        double val;
+
+        for (int i : plan.bools) {
+            const _serial_prot& chunk = _out_message[i];
+            buf[chunk.byte_offset] = (char) (chunk.prop->getBoolValue() ? true : false);
+        }
+
+        for (int i : plan.ints) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            int32_t intVal = val;
+            memcpy(&buf[chunk.byte_offset], &intVal, sizeof(int32_t));
+        }
+
+        for (int i : plan.fixeds) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            int32_t fixed = (int)(val * 65536.0f);
+            memcpy(&buf[chunk.byte_offset], &fixed, sizeof(int32_t));
+        }
+
+        for (int i : plan.floats) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            float floatVal = static_cast<float>(val);
+            memcpy(&buf[chunk.byte_offset], &floatVal, sizeof(float));
+        }
+
+        for (int i : plan.doubles) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
+            memcpy(&buf[chunk.byte_offset], &val, sizeof(double));
+        }
+
+        for (int i : plan.bytes) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            int8_t byteVal = val;
+            memcpy(&buf[chunk.byte_offset], &byteVal, sizeof(int8_t));
+        }
+
+        for (int i : plan.words) {
+            const _serial_prot& chunk = _out_message[i];
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            int16_t wordVal = val;
+            memcpy(&buf[chunk.byte_offset], &wordVal, sizeof(int16_t));
+        }
+
+        // the byte order of the whole record in one go
+        for (int offset : plan.swap16) swap16(&buf[offset]);
+        for (int offset : plan.swap32) swap32(&buf[offset]);
+        for (int offset : plan.swap64) swap64(&buf[offset]);
+
+        length = plan.length;
+    }
+
+    // add the footer to the packet ("line")
+    switch (binary_footer_type) {
+        case FOOTER_LENGTH:
+            binary_footer_value = length;
+            break;
+
+        case FOOTER_MAGIC:
+        case FOOTER_NONE:
+            break;
+    }
+
+    if (binary_footer_type != FOOTER_NONE) {
+        int32_t intValue = binary_footer_value;
+        if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
+            intValue = sg_bswap_32(binary_footer_value);
+        }
+        memcpy(&buf[length], &intValue, sizeof(int32_t));
+        length += sizeof(int32_t);
+    }
+
+    if( wrapper ) length = wrapper->wrap( length, reinterpret_cast<uint8_t*>(buf) );
+
+    return true;
+}
+
+// field by field encoding, for records which contain strings
+bool FGGeneric::gen_message_binary_fields() {
     length = 0;
 
     double val;
@@ -351,6 +556,9 @@ bool FGGeneric::gen_message_binary() {
             val = _out_message[i].offset +
                   _out_message[i].prop->getFloatValue() * _out_message[i].factor;
             int16_t wordVal = val;
+            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
+                wordVal = (int16_t) sg_bswap_16((uint16_t)wordVal);
+            }
             memcpy(&buf[length], &wordVal, sizeof(int16_t));
             length += sizeof(int16_t);
             break;
@@ -367,10 +575,11 @@ bool FGGeneric::gen_message_binary() {
             /* Format for strings is 
              * [length as int, 4 bytes][ASCII data, length bytes]
              */
+            int32_t wirelength = strlength;
             if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                strlength = sg_bswap_32(strlength);
+                wirelength = sg_bswap_32(strlength);
             }
-            memcpy(&buf[length], &strlength, sizeof(int32_t));
+            memcpy(&buf[length], &wirelength, sizeof(int32_t));
             length += sizeof(int32_t);
             strncpy(&buf[length], strdata, strlength);
             length += strlength; 
@@ -382,92 +591,114 @@ bool FGGeneric::gen_message_binary() {
         }
     }
 
-    // add the footer to the packet ("line")
-    switch (binary_footer_type) {
-        case FOOTER_LENGTH:
-            binary_footer_value = length;
-            break;
-
-        case FOOTER_MAGIC:
-        case FOOTER_NONE:
-            break;
-    }
-
-    if (binary_footer_type != FOOTER_NONE) {
-        int32_t intValue = binary_footer_value;
-        if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-            intValue = sg_bswap_32(binary_footer_value);
-        }
-        memcpy(&buf[length], &intValue, sizeof(int32_t));
-        length += sizeof(int32_t);
-    }
-
-    if( wrapper ) length = wrapper->wrap( length, reinterpret_cast<uint8_t*>(buf) );
-
     return true;
 }
 
 bool FGGeneric::gen_message_ascii() {
-    string generic_sentence;
-    char tmp[255];
-    length = 0;
+    char* p = buf;
+    char* const end = buf + FG_MAX_MSG_SIZE;
 
     double val;
     for (unsigned int i = 0; i < _out_message.size(); i++) {
+        const _serial_prot& chunk = _out_message[i];
 
         if (i > 0) {
-            generic_sentence += var_separator;
+            p = appendText(p, end, var_separator.data(), var_separator.size());
         }
-        
-        string format = simgear::strutils::sanitizePrintfFormat(_out_message[i].format);
 
-        switch (_out_message[i].type) {
-        case FG_BYTE:
-        case FG_WORD:
-        case FG_INT:
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (int)val);
-            break;
+        // each field is limited to what snprintf(tmp, 255, ...) would give
+        char tmp[255];
+        char* field = tmp;
+        char* const field_end = tmp + sizeof(tmp) - 1;
+        int n = -1;
 
-        case FG_BOOL:
-            snprintf(tmp, 255, format.c_str(),
-                               _out_message[i].prop->getBoolValue());
-            break;
-
-        case FG_FIXED:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (float)val);
+        switch (chunk.ascii_kind) {
+        case ASCII_INT:
+        {
+            char digits[16];
+            if (chunk.type == FG_BOOL) {
+                n = formatInt(digits, chunk.prop->getBoolValue());
+            } else {
+                val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+                n = formatInt(digits, (int)val);
+            }
+            field = appendText(field, field_end, chunk.ascii_prefix.data(), chunk.ascii_prefix.size());
+            field = appendText(field, field_end, digits, n);
+            field = appendText(field, field_end, chunk.ascii_suffix.data(), chunk.ascii_suffix.size());
             break;
+        }
 
-        case FG_FLOAT:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (float)val);
+        case ASCII_FIXED_POINT:
+        {
+            char digits[32];
+            if (chunk.type == FG_DOUBLE) {
+                val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
+            } else {
+                val = (float)(chunk.offset + chunk.prop->getFloatValue() * chunk.factor);
+            }
+            n = formatFixedPoint(digits, val, chunk.precision);
+            if (n >= 0) {
+                field = appendText(field, field_end, chunk.ascii_prefix.data(), chunk.ascii_prefix.size());
+                field = appendText(field, field_end, digits, n);
+                field = appendText(field, field_end, chunk.ascii_suffix.data(), chunk.ascii_suffix.size());
+            } else {
+                snprintf(tmp, 255, chunk.format.c_str(), val);
+            }
             break;
+        }
 
-        case FG_DOUBLE:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (double)val);
+        case ASCII_STRING:
+        {
+            const char* str = chunk.prop->getStringValue();
+            n = 0;
+            field = appendText(field, field_end, chunk.ascii_prefix.data(), chunk.ascii_prefix.size());
+            field = appendText(field, field_end, str, strlen(str));
+            field = appendText(field, field_end, chunk.ascii_suffix.data(), chunk.ascii_suffix.size());
             break;
+        }
 
-        default: // SG_STRING
-            snprintf(tmp, 255, format.c_str(),
-                                   _out_message[i].prop->getStringValue());
+        default:
+            switch (chunk.type) {
+            case FG_BYTE:
+            case FG_WORD:
+            case FG_INT:
+                val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+                snprintf(tmp, 255, chunk.format.c_str(), (int)val);
+                break;
+
+            case FG_BOOL:
+                snprintf(tmp, 255, chunk.format.c_str(), chunk.prop->getBoolValue());
+                break;
+
+            case FG_FIXED:
+            case FG_FLOAT:
+                val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+                snprintf(tmp, 255, chunk.format.c_str(), (float)val);
+                break;
+
+            case FG_DOUBLE:
+                val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
+                snprintf(tmp, 255, chunk.format.c_str(), (double)val);
+                break;
+
+            default: // SG_STRING
+                snprintf(tmp, 255, chunk.format.c_str(), chunk.prop->getStringValue());
+            }
         }
 
-        generic_sentence += tmp;
+        if (n >= 0) {
+            p = appendText(p, end, tmp, field - tmp);
+        } else {
+            p = appendText(p, end, tmp, strlen(tmp));
+        }
     }
 
     /* After each lot of variables has been added, put the line separator
      * char/string
      */
-    generic_sentence += line_separator;
+    p = appendText(p, end, line_separator.data(), line_separator.size());
 
-    length =  generic_sentence.length();
-    strncpy( buf, generic_sentence.c_str(), length );
+    length = p - buf;
 
     return true;
 }
@@ -481,84 +712,74 @@ bool FGGeneric::gen_message() {
 }
 
 bool FGGeneric::parse_message_binary(int length) {
-    char *p2, *p1 = buf;
-    int32_t tmp32;
-    int i = -1;
+    const _binary_plan& plan = _in_plan;
 
-    p2 = p1 + length;
-    while ((++i < (int)_in_message.size()) && (p1  < p2)) {
+    // convert the byte order of the whole record in place first
+    for (int offset : plan.swap16) if (offset < length) swap16(&buf[offset]);
+    for (int offset : plan.swap32) if (offset < length) swap32(&buf[offset]);
+    for (int offset : plan.swap64) if (offset < length) swap64(&buf[offset]);
 
-        switch (_in_message[i].type) {
+    for (unsigned int i = 0; i < _in_message.size(); i++) {
+        _serial_prot& chunk = _in_message[i];
+        const char* p = &buf[chunk.byte_offset];
+        if (chunk.byte_offset >= length) {
+            break;
+        }
+
+        switch (chunk.type) {
         case FG_INT:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_32(*(int32_t *)p1);
-            } else {
-                tmp32 = *(int32_t *)p1;
-            }
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int32_t);
+        {
+            int32_t intVal;
+            memcpy(&intVal, p, sizeof(int32_t));
+            updateValue(chunk, (int)intVal);
             break;
+        }
 
         case FG_BOOL:
-            updateValue(_in_message[i], p1[0] != 0);
-            p1 += 1;
+            updateValue(chunk, p[0] != 0);
             break;
 
         case FG_FIXED:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_32(*(int32_t *)p1);
-            } else {
-                tmp32 = *(int32_t *)p1;
-            }
-            updateValue(_in_message[i], (float)tmp32 / 65536.0f);
-            p1 += sizeof(int32_t);
+        {
+            int32_t fixed;
+            memcpy(&fixed, p, sizeof(int32_t));
+            updateValue(chunk, (float)fixed / 65536.0f);
             break;
+        }
 
         case FG_FLOAT:
-            u32 tmpun32;
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmpun32.intVal = sg_bswap_32(*(uint32_t *)p1);
-            } else {
-                tmpun32.floatVal = *(float *)p1;
-            }
-            updateValue(_in_message[i], tmpun32.floatVal);
-            p1 += sizeof(int32_t);
+        {
+            float floatVal;
+            memcpy(&floatVal, p, sizeof(float));
+            updateValue(chunk, floatVal);
             break;
+        }
 
         case FG_DOUBLE:
-            u64 tmpun64;
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmpun64.longVal = sg_bswap_64(*(uint64_t *)p1);
-            } else {
-                tmpun64.doubleVal = *(double *)p1;
-            }
-            updateValue(_in_message[i], tmpun64.doubleVal);
-            p1 += sizeof(int64_t);
+        {
+            double doubleVal;
+            memcpy(&doubleVal, p, sizeof(double));
+            updateValue(chunk, doubleVal);
             break;
+        }
 
         case FG_BYTE:
-            tmp32 = *(int8_t *)p1;
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int8_t);
+            updateValue(chunk, (int)*(const int8_t *)p);
             break;
 
         case FG_WORD:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_16(*(int16_t *)p1);
-            } else {
-                tmp32 = *(int16_t *)p1;
-            }
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int16_t);
+        {
+            int16_t wordVal;
+            memcpy(&wordVal, p, sizeof(int16_t));
+            updateValue(chunk, (int)wordVal);
             break;
+        }
 
-        default: // SG_STRING
-            SG_LOG( SG_IO, SG_ALERT, "Generic protocol: "
-                    "Ignoring unsupported binary input chunk type.");
+        default: // SG_STRING, rejected by compile_plan()
             break;
         }
     }
-    
+
     return true;
 }
 
@@ -778,6 +999,7 @@ FGGeneric::reinit()
                 // bad configuration
                 return;
             }
+            compile_plan(_out_message, _out_plan, false);
         }
     } else if (direction == "in") {
         SGPropertyNode *input = root.getNode("generic/input");
@@ -788,6 +1010,7 @@ FGGeneric::reinit()
                 // bad configuration
                 return;
             }
+            compile_plan(_in_message, _in_plan, true);
             if (!binary_mode && (line_separator.empty() ||
                 *line_separator.rbegin() != '\n')) {
 
@@ -923,6 +1146,9 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
         chunk.max = chunks[i]->getDoubleValue("max");
         chunk.wrap = chunks[i]->getBoolValue("wrap");
         chunk.rel = chunks[i]->getBoolValue("relative");
+        chunk.byte_offset = 0;
+        chunk.ascii_kind = ASCII_PRINTF;
+        chunk.precision = 0;
 
         if( chunks[i]->hasChild("const") ) {
             chunk.prop = new SGPropertyNode();
@@ -990,6 +1216,158 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
     return true;
 }
 
+/**
+ * Work out everything about the message which does not change from one
+ * record to the next: where each binary field lives and which of them
+ * need their byte order converted, and which ascii fields can skip printf.
+ */
+void
+FGGeneric::compile_plan(vector<_serial_prot> &msg, _binary_plan &plan, bool input)
+{
+    plan = _binary_plan();
+
+    if (!binary_mode) {
+        for (unsigned int i = 0; i < msg.size(); i++) {
+            msg[i].format = simgear::strutils::sanitizePrintfFormat(msg[i].format);
+            if (!input) {
+                compile_ascii_format(msg[i]);
+            }
+        }
+        return;
+    }
+
+    plan.fixed = true;
+    const bool convert = binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION;
+
+    for (unsigned int i = 0; i < msg.size(); i++) {
+        _serial_prot& chunk = msg[i];
+        chunk.byte_offset = plan.length;
+
+        switch (chunk.type) {
+        case FG_BOOL:
+            plan.bools.push_back(i);
+            plan.length += 1;
+            break;
+
+        case FG_INT:
+            plan.ints.push_back(i);
+            if (convert) plan.swap32.push_back(plan.length);
+            plan.length += sizeof(int32_t);
+            break;
+
+        case FG_FIXED:
+            plan.fixeds.push_back(i);
+            if (convert) plan.swap32.push_back(plan.length);
+            plan.length += sizeof(int32_t);
+            break;
+
+        case FG_FLOAT:
+            plan.floats.push_back(i);
+            if (convert) plan.swap32.push_back(plan.length);
+            plan.length += sizeof(int32_t);
+            break;
+
+        case FG_DOUBLE:
+            plan.doubles.push_back(i);
+            if (convert) plan.swap64.push_back(plan.length);
+            plan.length += sizeof(int64_t);
+            break;
+
+        case FG_BYTE:
+            plan.bytes.push_back(i);
+            plan.length += sizeof(int8_t);
+            break;
+
+        case FG_WORD:
+            plan.words.push_back(i);
+            if (convert) plan.swap16.push_back(plan.length);
+            plan.length += sizeof(int16_t);
+            break;
+
+        default: // SG_STRING
+            if (input) {
+                SG_LOG( SG_IO, SG_ALERT, "Generic protocol: "
+                        "Ignoring unsupported binary input chunk type.");
+            } else {
+                // the length prefix moves everything after it around
+                plan.fixed = false;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Split a format with a single %d, %i, %f, %.Nf or %s conversion into
+ * the text around it, so gen_message_ascii() can format the value
+ * itself. Everything else keeps going through snprintf().
+ */
+void
+FGGeneric::compile_ascii_format(_serial_prot &chunk)
+{
+    chunk.ascii_kind = ASCII_PRINTF;
+
+    const string& format = chunk.format;
+    string::size_type percent = format.find('%');
+    if (percent == string::npos) {
+        return;
+    }
+
+    string::size_type pos = percent + 1;
+    int precision = 6;
+    if (pos < format.size() && format[pos] == '.') {
+        ++pos;
+        if (pos >= format.size() || format[pos] < '0' || format[pos] > '9') {
+            return;
+        }
+        precision = format[pos++] - '0';
+    }
+    if (pos >= format.size()) {
+        return;
+    }
+
+    const char conversion = format[pos];
+    const bool defaultPrecision = pos == percent + 1;
+    int kind;
+    switch (chunk.type) {
+    case FG_BOOL:
+    case FG_INT:
+    case FG_BYTE:
+    case FG_WORD:
+        if (!defaultPrecision || (conversion != 'd' && conversion != 'i')) {
+            return;
+        }
+        kind = ASCII_INT;
+        break;
+
+    case FG_FIXED:
+    case FG_FLOAT:
+    case FG_DOUBLE:
+        if (conversion != 'f') {
+            return;
+        }
+        kind = ASCII_FIXED_POINT;
+        break;
+
+    default: // SG_STRING
+        if (!defaultPrecision || conversion != 's') {
+            return;
+        }
+        kind = ASCII_STRING;
+        break;
+    }
+
+    // the remaining text must be plain, "%%" included
+    if (format.find('%', pos + 1) != string::npos) {
+        return;
+    }
+
+    chunk.ascii_prefix = format.substr(0, percent);
+    chunk.ascii_suffix = format.substr(pos + 1);
+    chunk.precision = precision;
+    chunk.ascii_kind = kind;
+}
+
 void FGGeneric::updateValue(FGGeneric::_serial_prot& prot, bool val)
 {
   if( prot.rel )
@@ -71,8 +71,28 @@ protected:
         bool wrap;
         bool rel;
         SGPropertyNode_ptr prop;
+
+        // filled in by compile_plan()
+        int byte_offset;        // binary: position within the record
+        int ascii_kind;         // ascii output: ASCII_PRINTF or a fast path
+        int precision;          // ascii output: digits after the point
+        string ascii_prefix;    // ascii output: literal text around the
+        string ascii_suffix;    //   value for the fast paths
     } _serial_prot;
 
+    enum { ASCII_PRINTF = 0, ASCII_INT, ASCII_FIXED_POINT, ASCII_STRING };
+
+    // Binary records with all fields at fixed offsets: fields grouped
+    // by type, and the offsets byte swapped in one pass afterwards.
+    struct _binary_plan {
+        _binary_plan() : fixed(false), length(0) {}
+
+        bool fixed;             // false if a string makes the length vary
+        int length;             // sum of the field sizes
+        vector<int> bools, ints, fixeds, floats, doubles, bytes, words;
+        vector<int> swap16, swap32, swap64;
+    };
+
 private:
 
     string file_name;
@@ -89,6 +109,8 @@ private:
     string line_sep_string;
     vector<_serial_prot> _out_message;
     vector<_serial_prot> _in_message;
+    _binary_plan _out_plan;
+    _binary_plan _in_plan;
 
     bool binary_mode;
     enum {FOOTER_NONE, FOOTER_LENGTH, FOOTER_MAGIC} binary_footer_type;
@@ -101,6 +123,9 @@ private:
     bool parse_message_ascii(int length);
     bool parse_message_binary(int length);
     bool read_config(SGPropertyNode *root, vector<_serial_prot> &msg);
+    void compile_plan(vector<_serial_prot> &msg, _binary_plan &plan, bool input);
+    void compile_ascii_format(_serial_prot &chunk);
+    bool gen_message_binary_fields();
     bool exitOnError;
     bool initOk;
 
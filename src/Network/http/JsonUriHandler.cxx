@@ -56,7 +56,9 @@ bool JsonUriHandler::handleRequest( const HTTPRequest & request, HTTPResponse &
       return true;
     } 
 
-    response.Content = JSON::toJsonString( indent, node, depth, timestamp ? fgGetDouble("/sim/time/elapsed-sec") : -1.0 );
+    response.Content.clear();
+    JSONWriter writer( response.Content, indent );
+    JSON::writeJson( writer, node, depth, timestamp ? fgGetDouble("/sim/time/elapsed-sec") : -1.0 );
 
     return true;
   }
@@ -22,10 +22,13 @@
 #include "jsonprops.hxx"
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <unordered_map>
 #include <set>
 
 #include <simgear/debug/logstream.hxx>
+#include <simgear/misc/stdint.hxx>
 #include <simgear/props/props.hxx>
 #include <simgear/structure/commands.hxx>
 
@@ -42,6 +45,113 @@ using std::string;
 
     typedef unsigned int PropertyId; // connection local property id
 
+    /*
+     * Binary mirror protocol, selected with ?format=binary on the websocket
+     * URI. Each poll sends one binary message:
+     *
+     *   message := u8 version (1), record*
+     *   record  := u8 op, then
+     *     1 created: id, parent id, index, position, name length, name, value
+     *     2 changed: id, value
+     *     3 removed: id
+     *   value   := u8 type, then
+     *     0 none, 1 false, 2 true: nothing
+     *     3 int, 4 long: zigzag varint
+     *     5 float: 4 bytes, 6 double: 8 bytes, little endian IEEE 754
+     *     7 string: length, bytes
+     *
+     * ids, indices, positions and lengths are LEB128 varints. Parents are
+     * always created before their children; parent id 0 is the mirrored
+     * root's parent, i.e. the node created with it is the root itself.
+     * Records come in the order created, removed, changed, as in JSON.
+     */
+    enum MirrorBinaryOp {
+        MIRROR_OP_CREATED = 1,
+        MIRROR_OP_CHANGED = 2,
+        MIRROR_OP_REMOVED = 3
+    };
+
+    enum MirrorBinaryType {
+        MIRROR_TYPE_NONE = 0,
+        MIRROR_TYPE_FALSE,
+        MIRROR_TYPE_TRUE,
+        MIRROR_TYPE_INT,
+        MIRROR_TYPE_LONG,
+        MIRROR_TYPE_FLOAT,
+        MIRROR_TYPE_DOUBLE,
+        MIRROR_TYPE_STRING
+    };
+
+    const char MIRROR_BINARY_VERSION = 1;
+
+    static void writeVarUInt(std::string& out, uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static void writeVarInt(std::string& out, int64_t v)
+    {
+        writeVarUInt(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    template <class T>
+    static void writeLittleEndian(std::string& out, T v)
+    {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &v, sizeof(T));
+        if (sgIsBigEndian()) {
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        out.append(bytes, sizeof(T));
+    }
+
+    static void writeBinaryValue(std::string& out, SGPropertyNode* prop)
+    {
+        if (!prop->hasValue()) {
+            out.push_back(MIRROR_TYPE_NONE);
+            return;
+        }
+
+        switch (prop->getType()) {
+        case simgear::props::BOOL:
+            out.push_back(prop->getBoolValue() ? MIRROR_TYPE_TRUE : MIRROR_TYPE_FALSE);
+            break;
+
+        case simgear::props::INT:
+            out.push_back(MIRROR_TYPE_INT);
+            writeVarInt(out, prop->getIntValue());
+            break;
+
+        case simgear::props::LONG:
+            out.push_back(MIRROR_TYPE_LONG);
+            writeVarInt(out, prop->getLongValue());
+            break;
+
+        case simgear::props::FLOAT:
+            out.push_back(MIRROR_TYPE_FLOAT);
+            writeLittleEndian(out, prop->getFloatValue());
+            break;
+
+        case simgear::props::DOUBLE:
+            out.push_back(MIRROR_TYPE_DOUBLE);
+            writeLittleEndian(out, prop->getDoubleValue());
+            break;
+
+        default: {
+            const char* str = prop->getStringValue();
+            const size_t len = strlen(str);
+            out.push_back(MIRROR_TYPE_STRING);
+            writeVarUInt(out, len);
+            out.append(str, len);
+            break;
+        }
+        }
+    }
+
     struct PropertyValue
     {
         PropertyValue(SGPropertyNode* cur = nullptr) :
@@ -225,66 +335,111 @@ using std::string;
             return it->second;
         }
 
-        cJSON* makeJSONData()
+        void makeJSONData(std::string& out)
         {
             SGTimeStamp st;
             st.stamp();
 
-            cJSON* result = cJSON_CreateObject();
+            out.clear();
+            JSONWriter writer(out);
+            writer.beginObject();
 
             int newSize = newNodes.size();
             int changedSize = changedNodes.size();
             int removedSize = removedNodes.size();
 
             if (!newNodes.empty()) {
-                cJSON * newNodesArray = cJSON_CreateArray();
+                writer.key("created");
+                writer.beginArray();
 
                 for (auto prop : newNodes) {
                     changedNodes.erase(prop); // avoid duplicate send
-                    cJSON* newPropData = cJSON_CreateObject();
-                    cJSON_AddItemToObject(newPropData, "path", cJSON_CreateString(prop->getPath(true).c_str()));
-                    cJSON_AddItemToObject(newPropData, "type", cJSON_CreateString(JSON::getPropertyTypeString(prop->getType())));
-                    cJSON_AddItemToObject(newPropData, "index", cJSON_CreateNumber(prop->getIndex()));
-                    cJSON_AddItemToObject(newPropData, "position", cJSON_CreateNumber(prop->getPosition()));
-                    cJSON_AddItemToObject(newPropData, "id", cJSON_CreateNumber(idForProperty(prop)));
+                    writer.beginObject();
+                    writer.key("path");
+                    writer.value(prop->getPath(true));
+                    writer.key("type");
+                    writer.value(JSON::getPropertyTypeString(prop->getType()));
+                    writer.key("index");
+                    writer.value(prop->getIndex());
+                    writer.key("position");
+                    writer.value(prop->getPosition());
+                    writer.key("id");
+                    writer.value(static_cast<double>(idForProperty(prop)));
                     if (prop->getType() != simgear::props::NONE) {
-                        cJSON_AddItemToObject(newPropData, "value", JSON::valueToJson(prop));
+                        writer.key("value");
+                        JSON::writeValue(writer, prop);
                     }
-                    cJSON_AddItemToArray(newNodesArray, newPropData);
+                    writer.endObject();
                 }
 
                 newNodes.clear();
-                cJSON_AddItemToObject(result, "created", newNodesArray);
+                writer.endArray();
             }
 
 
             if (!removedNodes.empty()) {
-                cJSON * deletedNodesArray = cJSON_CreateArray();
+                writer.key("removed");
+                writer.beginArray();
                 for (auto propId : removedNodes) {
-                    cJSON_AddItemToArray(deletedNodesArray, cJSON_CreateNumber(propId));
+                    writer.value(static_cast<double>(propId));
                 }
-                cJSON_AddItemToObject(result, "removed", deletedNodesArray);
+                writer.endArray();
                 removedNodes.clear();
             }
 
             if (!changedNodes.empty()) {
-                cJSON * changedNodesArray = cJSON_CreateArray();
+                writer.key("changed");
+                writer.beginArray();
 
                 for (auto prop : changedNodes) {
-                    cJSON* propData = cJSON_CreateArray();
-                    cJSON_AddItemToArray(propData, cJSON_CreateNumber(idForProperty(prop)));
-                    cJSON_AddItemToArray(propData, JSON::valueToJson(prop));
-                    cJSON_AddItemToArray(changedNodesArray, propData);
+                    writer.beginArray();
+                    writer.value(static_cast<double>(idForProperty(prop)));
+                    JSON::writeValue(writer, prop);
+                    writer.endArray();
                 }
 
                 changedNodes.clear();
-                cJSON_AddItemToObject(result, "changed", changedNodesArray);
+                writer.endArray();
             }
 
-            SG_LOG(SG_NETWORK, SG_INFO, "making JSON data took:" << st.elapsedMSec() << " for " << newSize << "/" << changedSize << "/" << removedSize);
+            writer.endObject();
+
+            SG_LOG(SG_NETWORK, SG_DEBUG, "making JSON data took:" << st.elapsedMSec() << " for " << newSize << "/" << changedSize << "/" << removedSize);
             recentlyRemoved.clear();
+        }
 
-            return result;
+        void makeBinaryData(std::string& out)
+        {
+            SGTimeStamp st;
+            st.stamp();
+
+            out.clear();
+            out.push_back(MIRROR_BINARY_VERSION);
+
+            int newSize = newNodes.size();
+            int changedSize = changedNodes.size();
+            int removedSize = removedNodes.size();
+
+            while (!newNodes.empty()) {
+                writeBinaryCreated(out, *newNodes.begin());
+            }
+
+            for (auto propId : removedNodes) {
+                out.push_back(MIRROR_OP_REMOVED);
+                writeVarUInt(out, propId);
+            }
+            removedNodes.clear();
+
+            for (auto prop : changedNodes) {
+                out.push_back(MIRROR_OP_CHANGED);
+                writeVarUInt(out, idForProperty(prop));
+                writeBinaryValue(out, prop);
+            }
+            changedNodes.clear();
+
+            SG_LOG(SG_NETWORK, SG_DEBUG, "making binary data took:" << st.elapsedMSec() << " for " << newSize << "/" << changedSize << "/" << removedSize
+                   << ", " << out.size() << " bytes");
+            recentlyRemoved.clear();
         }
 
         bool haveChangesToSend() const
@@ -292,6 +447,36 @@ using std::string;
             return !newNodes.empty() || !changedNodes.empty() || !removedNodes.empty();
         }
     private:
+        void writeBinaryCreated(std::string& out, SGPropertyNode* prop)
+        {
+            newNodes.erase(prop);
+            changedNodes.erase(prop); // avoid duplicate send
+
+            // the client needs the parent before it can attach the child
+            PropertyId parentId = 0;
+            SGPropertyNode* parent = prop->getParent();
+            if (parent) {
+                if (newNodes.count(parent)) {
+                    writeBinaryCreated(out, parent);
+                }
+
+                auto it = idHash.find(parent);
+                if (it != idHash.end()) {
+                    parentId = it->second;
+                }
+            }
+
+            out.push_back(MIRROR_OP_CREATED);
+            writeVarUInt(out, idForProperty(prop));
+            writeVarUInt(out, parentId);
+            writeVarUInt(out, prop->getIndex());
+            writeVarUInt(out, prop->getPosition());
+            const std::string& name = prop->getNameString();
+            writeVarUInt(out, name.size());
+            out.append(name);
+            writeBinaryValue(out, prop);
+        }
+
         PropertyId nextPropertyId = 1;
         std::unordered_map<SGPropertyNode*, PropertyId> idHash;
         std::vector<PropertyValue> previousValues;
@@ -357,10 +542,17 @@ static void handleExecCommand(cJSON* json)
 }
 #endif
 
-MirrorPropertyTreeWebsocket::MirrorPropertyTreeWebsocket(const std::string& path) :
+MirrorPropertyTreeWebsocket::MirrorPropertyTreeWebsocket(const std::string& path,
+                                                         const HTTPRequest& request) :
     _listener(new MirrorTreeListener),
-    _minSendInterval(100)
+    _minSendInterval(100),
+    _binary(request.RequestVariables.get("format") == "binary")
 {
+    const std::string interval = request.RequestVariables.get("interval");
+    if (!interval.empty()) {
+        _minSendInterval = std::max(0, atoi(interval.c_str()));
+    }
+
     _subtreeRoot = globals->get_props()->getNode(path, true);
     _subtreeRoot->addChangeListener(_listener.get());
     _listener->registerSubtree(_subtreeRoot);
@@ -453,11 +645,13 @@ void MirrorPropertyTreeWebsocket::poll(WebsocketWriter & writer)
     // okay, we will send now, update the send stamp
     _lastSendTime.stamp();
 
-    cJSON * json = _listener->makeJSONData();
-    char * jsonString = cJSON_PrintUnformatted( json );
-    writer.writeText( jsonString );
-    free( jsonString );
-    cJSON_Delete( json );
+    if (_binary) {
+        _listener->makeBinaryData(_sendBuffer);
+        writer.writeBinary(_sendBuffer.data(), _sendBuffer.size());
+    } else {
+        _listener->makeJSONData(_sendBuffer);
+        writer.writeText( _sendBuffer );
+    }
 }
 
 } // namespace http
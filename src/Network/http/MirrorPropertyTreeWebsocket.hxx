@@ -37,7 +37,12 @@ namespace http {
 class MirrorPropertyTreeWebsocket : public Websocket
 {
 public:
-    MirrorPropertyTreeWebsocket(const std::string& path);
+    /**
+     * Pass format=binary in the request's query to use the compact binary
+     * encoding described in the implementation instead of JSON, and
+     * interval=<msec> to change the minimum time between updates.
+     */
+    MirrorPropertyTreeWebsocket(const std::string& path, const HTTPRequest& request);
   virtual ~MirrorPropertyTreeWebsocket();
 
   virtual void close();
@@ -51,6 +56,8 @@ private:
     std::unique_ptr<MirrorTreeListener> _listener;
     int _minSendInterval;
     SGTimeStamp _lastSendTime;
+    bool _binary;
+    std::string _sendBuffer;
 };
 
 }
@@ -20,65 +20,216 @@
 
 #include "PropertyChangeObserver.hxx"
 
+#include <algorithm>
+#include <cmath>
+
 #include <Main/fg_props.hxx>
 using std::string;
 namespace flightgear {
 namespace http {
 
+// unused entries are only looked for every so many checks
+static const unsigned SWEEP_INTERVAL = 64;
 
+void PropertyChangeObserverEntry::valueChanged(SGPropertyNode* node)
+{
+  _observer->markDirty(this);
+}
 
-PropertyChangeObserver::PropertyChangeObserver()
+bool PropertyChangeObserverEntry::sample(double epsilon)
+{
+  simgear::props::Type type = _node->getType();
+  bool changed = _initial || (type != _type);
+  _initial = false;
+  _type = type;
+
+  switch (type) {
+  case simgear::props::BOOL:
+  case simgear::props::INT:
+  case simgear::props::LONG: {
+    long value = _node->getLongValue();
+    changed = changed || (value != _prevLong);
+    _prevLong = value;
+    break;
+  }
+  case simgear::props::FLOAT:
+  case simgear::props::DOUBLE: {
+    double value = _node->getDoubleValue();
+    // NaN compares unequal to itself, treat a NaN staying NaN as no change
+    if (std::isnan(value) || std::isnan(_prevDouble)) {
+      changed = changed || (std::isnan(value) != std::isnan(_prevDouble));
+    } else {
+      changed = changed || (std::fabs(value - _prevDouble) > epsilon);
+    }
+    if (changed)
+      _prevDouble = value;
+    break;
+  }
+  default:
+    // strings and anything else without a numeric representation
+    if (_prevValue != _node->getStringValue()) {
+      changed = true;
+      _prevValue = _node->getStringValue();
+    }
+    break;
+  }
+
+  return changed;
+}
+
+PropertyChangeObserver::PropertyChangeObserver() :
+  _epsilon(0.0),
+  _useListeners(false),
+  _checkCount(0)
 {
 }
 
 PropertyChangeObserver::~PropertyChangeObserver()
 {
-  //
+  clear();
 }
 
-void PropertyChangeObserver::check()
+void PropertyChangeObserver::clear()
 {
+  _changed.clear();
+  _changedNodes.clear();
+  _dirty.clear();
+  _tied.clear();
+  _entries.clear();
+}
+
+void PropertyChangeObserver::setUseListeners(bool useListeners)
+{
+  if (_useListeners == useListeners)
+    return;
 
+  _useListeners = useListeners;
+  _dirty.clear();
+  _tied.clear();
   for (Entries_t::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-    if (false == (*it)->_node.isShared()) {
+    PropertyChangeObserverEntry* entry = it->second.get();
+    entry->_dirty = false;
+    if (_useListeners) {
+      entry->_node->addChangeListener(entry);
+      if (entry->_node->isTied())
+        _tied.push_back(entry);
+      // catch up on whatever happened while we were not listening
+      markDirty(entry);
+    } else {
+      entry->_node->removeChangeListener(entry);
+    }
+  }
+}
+
+void PropertyChangeObserver::markDirty(PropertyChangeObserverEntry* entry)
+{
+  if (entry->_dirty)
+    return;
+
+  entry->_dirty = true;
+  _dirty.push_back(entry);
+}
+
+void PropertyChangeObserver::markChanged(PropertyChangeObserverEntry* entry)
+{
+  if (entry->_changed)
+    return;
+
+  entry->_changed = true;
+  _changed.push_back(entry);
+  _changedNodes.push_back(entry->_node.get());
+}
+
+void PropertyChangeObserver::removeUnused()
+{
+  _tied.clear();
+  _dirty.erase(std::remove_if(_dirty.begin(), _dirty.end(),
+                              [](PropertyChangeObserverEntry* e) { return !e->_node.isShared(); }),
+               _dirty.end());
+
+  Entries_t::iterator it = _entries.begin();
+  while (it != _entries.end()) {
+    PropertyChangeObserverEntry* entry = it->second.get();
+    if (false == entry->_node.isShared()) {
       // node is no longer used but by us - remove the entry
       it = _entries.erase(it);
       continue;
     }
+    if (_useListeners && entry->_node->isTied())
+      _tied.push_back(entry);
+    ++it;
+  }
+}
 
-    if( false == (*it)->_changed ) {
-      (*it)->_changed = (*it)->_prevValue != (*it)->_node->getStringValue();
-      if ((*it)->_changed)
-        (*it)->_prevValue = (*it)->_node->getStringValue();
-
+void PropertyChangeObserver::check()
+{
+  // called between uncheck() and the next check() only, so nobody holds
+  // pointers to entries that may go away here
+  if ((++_checkCount % SWEEP_INTERVAL) == 0)
+    removeUnused();
+
+  if (!_useListeners) {
+    for (Entries_t::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+      PropertyChangeObserverEntry* entry = it->second.get();
+      if (entry->sample(_epsilon))
+        markChanged(entry);
     }
+    return;
+  }
+
+  for (size_t i = 0; i < _tied.size(); ++i)
+    markDirty(_tied[i]);
+
+  for (size_t i = 0; i < _dirty.size(); ++i) {
+    PropertyChangeObserverEntry* entry = _dirty[i];
+    entry->_dirty = false;
+    if (entry->sample(_epsilon))
+      markChanged(entry);
   }
+  _dirty.clear();
 }
 
 void PropertyChangeObserver::uncheck()
 {
-  for (Entries_t::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-    (*it)->_changed = false;
+  for (size_t i = 0; i < _changed.size(); ++i) {
+    _changed[i]->_changed = false;
+  }
+  _changed.clear();
+  _changedNodes.clear();
+}
+
+void PropertyChangeObserver::addEntry(PropertyChangeObserverEntry* entry)
+{
+  _entries[entry->_node.get()] = entry;
+  // report the initial value right away and again on the next check
+  markChanged(entry);
+  if (_useListeners) {
+    entry->_node->addChangeListener(entry);
+    if (entry->_node->isTied())
+      _tied.push_back(entry);
+    markDirty(entry);
   }
 }
 
 const SGPropertyNode_ptr PropertyChangeObserver::addObservation( const string propertyName)
 {
-  for (Entries_t::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-    if (propertyName == (*it)->_node->getPath(true) ) {
+  try {
+    SGPropertyNode_ptr node = fgGetNode( propertyName, true );
+    Entries_t::iterator it = _entries.find(node.get());
+    if (it != _entries.end()) {
       // if a new observer is added to a property, mark it as changed to ensure the observer
       // gets notified on initial call. This also causes a notification for all other observers of this
       // property.
-      (*it)->_changed = true;
-      return (*it)->_node;
+      PropertyChangeObserverEntry* entry = it->second.get();
+      markChanged(entry);
+      entry->_initial = true;
+      if (_useListeners)
+        markDirty(entry);
+      return entry->_node;
     }
-  }
 
-  try {
-    PropertyChangeObserverEntryRef entry = new PropertyChangeObserverEntry();
-    entry->_node = fgGetNode( propertyName, true );
-    _entries.push_back( entry );
-    return entry->_node;
+    addEntry(new PropertyChangeObserverEntry(this, node));
+    return node;
   }
   catch( string & s ) {
     SG_LOG(SG_NETWORK,SG_WARN,"httpd: can't observer '" << propertyName << "'. Invalid name." );
@@ -88,17 +239,10 @@ const SGPropertyNode_ptr PropertyChangeObserver::addObservation( const string pr
   return empty;
 }
 
-bool PropertyChangeObserver::isChangedValue(const SGPropertyNode_ptr node)
+bool PropertyChangeObserver::isChangedValue(const SGPropertyNode_ptr node) const
 {
-  for (Entries_t::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-    PropertyChangeObserverEntryRef entry = *it;
-
-    if( entry->_node == node && entry->_changed ) {
-      return true;
-    }
-  }
-
-  return false;
+  Entries_t::const_iterator it = _entries.find(node.get());
+  return (it != _entries.end()) && it->second->_changed;
 }
 
 }  // namespace http
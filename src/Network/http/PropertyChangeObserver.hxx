@@ -24,39 +24,109 @@
 #include <simgear/props/props.hxx>
 #include <string>
 #include <vector>
+#include <unordered_map>
 
 namespace flightgear {
 namespace http {
 
-struct PropertyChangeObserverEntry : public SGReferenced {
-  PropertyChangeObserverEntry()
-      : _changed(true)
+class PropertyChangeObserver;
+
+/**
+ * One observed property. The last seen value is kept in its native type so
+ * that polling does not have to format numbers into strings.
+ */
+struct PropertyChangeObserverEntry : public SGReferenced, public SGPropertyChangeListener {
+  PropertyChangeObserverEntry(PropertyChangeObserver* observer, SGPropertyNode* node)
+      : _observer(observer),
+        _node(node),
+        _changed(false),
+        _initial(true),
+        _dirty(false),
+        _type(simgear::props::NONE),
+        _prevLong(0),
+        _prevDouble(0.0)
   {
   }
+
+  virtual void valueChanged(SGPropertyNode* node);
+
+  /**
+   * Compare the current value against the last seen one and remember
+   * it. Returns true if it differs by more than epsilon.
+   */
+  bool sample(double epsilon);
+
+  PropertyChangeObserver* _observer;
   SGPropertyNode_ptr _node;
-  std::string _prevValue;
   bool _changed;
+  bool _initial;      ///< never sampled or newly subscribed to
+  bool _dirty;        ///< listener fired since the last check
+  simgear::props::Type _type;
+  long _prevLong;     ///< BOOL, INT and LONG values
+  double _prevDouble; ///< FLOAT and DOUBLE values
+  std::string _prevValue;
 };
 
 typedef SGSharedPtr<PropertyChangeObserverEntry> PropertyChangeObserverEntryRef;
 
+/**
+ * Tracks which of the properties observed by any websocket changed since
+ * the last httpd update. check() is called before and uncheck() after the
+ * websockets are polled.
+ *
+ * By default every observed property is compared on each check(). In
+ * listener mode only properties whose change listener fired (plus tied
+ * properties, which never fire listeners) are compared, so the cost is
+ * proportional to the number of changed properties.
+ */
 class PropertyChangeObserver {
 public:
   PropertyChangeObserver();
   virtual ~PropertyChangeObserver();
 
   const SGPropertyNode_ptr addObservation( const std::string propertyName);
-  bool isChangedValue(const SGPropertyNode_ptr node);
+  bool isChangedValue(const SGPropertyNode_ptr node) const;
+
+  /**
+   * The nodes found changed by the last check().
+   */
+  const std::vector<SGPropertyNode*>& changedNodes() const { return _changedNodes; }
 
   void check();
   void uncheck();
 
-  void clear() { _entries.clear(); }
+  void clear();
+
+  /**
+   * Numeric changes smaller than this are not reported.
+   */
+  void setEpsilon(double epsilon) { _epsilon = epsilon; }
+
+  /**
+   * Use property listeners to find candidates for changes instead of
+   * comparing every observed property on each check().
+   */
+  void setUseListeners(bool useListeners);
 
 private:
-  typedef std::vector<PropertyChangeObserverEntryRef> Entries_t;
+  friend struct PropertyChangeObserverEntry;
+
+  void markDirty(PropertyChangeObserverEntry* entry);
+  void markChanged(PropertyChangeObserverEntry* entry);
+  void removeUnused();
+  void addEntry(PropertyChangeObserverEntry* entry);
+
+  typedef std::unordered_map<const SGPropertyNode*, PropertyChangeObserverEntryRef> Entries_t;
   Entries_t _entries;
 
+  std::vector<PropertyChangeObserverEntry*> _changed;
+  std::vector<SGPropertyNode*> _changedNodes;
+  std::vector<PropertyChangeObserverEntry*> _dirty;
+  std::vector<PropertyChangeObserverEntry*> _tied;
+
+  double _epsilon;
+  bool _useListeners;
+  unsigned _checkCount;
 };
 }  // namespace http
 }  // namespace flightgear
@@ -146,7 +146,10 @@ void PropertyChangeWebsocket::handleGetCommand(const string_list& nodes, Websock
       return;
     }
     
-    writer.writeText( JSON::toJsonString( false, n, 0, t ) );
+    _jsonBuffer.clear();
+    JSONWriter json(_jsonBuffer);
+    JSON::writeJson(json, n, 0, t);
+    writer.writeText( _jsonBuffer );
   } // of nodes iteration
 }
   
@@ -218,35 +221,51 @@ void PropertyChangeWebsocket::poll(WebsocketWriter & writer)
     _lastTrigger = now;
   }
 
-  for (WatchedNodesList::iterator it = _watchedNodes.begin(); it != _watchedNodes.end(); ++it) {
-    SGPropertyNode_ptr node = *it;
-
-    string newValue;
-    if (_propertyChangeObserver->isChangedValue(node)) {
-      string out = JSON::toJsonString( false, node, 0, now );
-      SG_LOG(SG_NETWORK, SG_DEBUG, "PropertyChangeWebsocket::poll() new Value for " << node->getPath(true) << " '" << node->getStringValue() << "' #" << id << ": " << out );
-      writer.writeText( out );
+  const std::vector<SGPropertyNode*>& changed = _propertyChangeObserver->changedNodes();
+  if (changed.size() < _watchedNodes.size()) {
+    // few changes among many watched nodes: look the changes up
+    for (std::vector<SGPropertyNode*>::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+      if (_watchedNodes.contains(*it))
+        sendChangedValue(*it, now, writer);
+    }
+  } else {
+    for (WatchedNodesList::iterator it = _watchedNodes.begin(); it != _watchedNodes.end(); ++it) {
+      if (_propertyChangeObserver->isChangedValue(*it))
+        sendChangedValue(*it, now, writer);
     }
   }
 }
 
+void PropertyChangeWebsocket::sendChangedValue(SGPropertyNode* node, double now, WebsocketWriter & writer)
+{
+  _jsonBuffer.clear();
+  JSONWriter json(_jsonBuffer);
+  JSON::writeJson(json, node, 0, now);
+  SG_LOG(SG_NETWORK, SG_DEBUG, "PropertyChangeWebsocket::poll() new Value for " << node->getPath(true) << " '" << node->getStringValue() << "' #" << id << ": " << _jsonBuffer );
+  writer.writeText( _jsonBuffer );
+}
+
 void PropertyChangeWebsocket::WatchedNodesList::handleCommand(const string & command, const string & node,
     PropertyChangeObserver * propertyChangeObserver)
 {
   if (command == "addListener") {
-    for (iterator it = begin(); it != end(); ++it) {
-      if (node == (*it)->getPath(true)) {
-        SG_LOG(SG_NETWORK, SG_WARN, "httpd: " << command << " '" << node << "' ignored (duplicate)");
-        return; // dupliate
-      }
+    SGPropertyNode* existing = fgGetNode(node);
+    if (existing && contains(existing)) {
+      SG_LOG(SG_NETWORK, SG_WARN, "httpd: " << command << " '" << node << "' ignored (duplicate)");
+      return; // dupliate
     }
     SGPropertyNode_ptr n = propertyChangeObserver->addObservation(node);
-    if (n.valid()) push_back(n);
+    if (n.valid()) {
+      push_back(n);
+      _index.insert(n.get());
+    }
     SG_LOG(SG_NETWORK, SG_INFO, "httpd: " << command << " '" << node << "' success");
 
   } else if (command == "removeListener") {
-    for (iterator it = begin(); it != end(); ++it) {
-      if (node == (*it)->getPath(true)) {
+    SGPropertyNode* existing = fgGetNode(node);
+    for (iterator it = begin(); existing && it != end(); ++it) {
+      if (existing == it->get()) {
+        _index.erase(existing);
         this->erase(it);
         SG_LOG(SG_NETWORK, SG_INFO, "httpd: " << command << " '" << node << "' success");
         return;
@@ -25,6 +25,7 @@
 #include <simgear/props/props.hxx>
 
 #include <vector>
+#include <unordered_set>
 
 namespace flightgear {
 namespace http {
@@ -48,11 +49,18 @@ private:
   class WatchedNodesList: public std::vector<SGPropertyNode_ptr> {
   public:
     void handleCommand(const std::string & command, const std::string & node, PropertyChangeObserver * propertyChangeObserver);
+    bool contains(const SGPropertyNode* node) const { return _index.count(node) > 0; }
+    void clear() { std::vector<SGPropertyNode_ptr>::clear(); _index.clear(); }
+  private:
+    std::unordered_set<const SGPropertyNode*> _index;
   };
 
+  void sendChangedValue(SGPropertyNode* node, double now, WebsocketWriter & writer);
+
   WatchedNodesList _watchedNodes;
   double _minTriggerInterval;
   double _lastTrigger;
+  std::string _jsonBuffer; ///< reused for every outgoing message
 };
 
 }
@@ -215,7 +215,7 @@ public:
     return _uriHandler.findHandler(uri);
   }
 
-  Websocket * newWebsocket(const string & uri);
+  Websocket * newWebsocket(const HTTPRequest & request);
 
 private:
   int poll(struct mg_connection * connection);
@@ -414,7 +414,7 @@ int WebsocketConnection::onConnect(struct mg_connection * connection)
   setConnection(connection);
   MongooseHTTPRequest request(connection);
   SG_LOG(SG_NETWORK, SG_INFO, "WebsocketConnection::connect for " << request.Uri);
-  if ( NULL == _websocket) _websocket = _httpd->newWebsocket(request.Uri);
+  if ( NULL == _websocket) _websocket = _httpd->newWebsocket(request);
   if ( NULL == _websocket) {
     SG_LOG(SG_NETWORK, SG_WARN, "httpd: unhandled websocket uri: " << request.Uri);
     return 0;
@@ -548,6 +548,9 @@ void MongooseHttpd::init()
 
   }
 
+  _propertyChangeObserver.setEpsilon(fgGetDouble("/sim/http/property-websocket/change-epsilon", 0.0));
+  _propertyChangeObserver.setUseListeners(fgGetBool("/sim/http/property-websocket/use-listeners", false));
+
   _configNode->setBoolValue("running",true);
 
 }
@@ -604,14 +607,15 @@ void MongooseHttpd::close(struct mg_connection * connection)
   c->close(connection);
   delete c;
 }
-Websocket * MongooseHttpd::newWebsocket(const string & uri)
+Websocket * MongooseHttpd::newWebsocket(const HTTPRequest & request)
 {
+  const string & uri = request.Uri;
   if (uri.find("/PropertyListener") == 0) {
     SG_LOG(SG_NETWORK, SG_INFO, "new PropertyChangeWebsocket for: " << uri);
     return new PropertyChangeWebsocket(&_propertyChangeObserver);
   } else if (uri.find("/PropertyTreeMirror/") == 0) {
       SG_LOG(SG_NETWORK, SG_INFO, "new MirrorPropertyTreeWebsocket for: " << uri);
-    return new MirrorPropertyTreeWebsocket(uri.substr(20));
+    return new MirrorPropertyTreeWebsocket(uri.substr(20), request);
   }
   return NULL;
 }
@@ -21,11 +21,164 @@
 #include "jsonprops.hxx"
 #include <simgear/misc/strutils.hxx>
 #include <simgear/math/SGMath.hxx>
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+
 namespace flightgear {
 namespace http {
 
 using std::string;
 
+JSONWriter::JSONWriter(std::string & buffer, bool indent) :
+    _buffer(buffer),
+    _indent(indent)
+{
+}
+
+void JSONWriter::appendTabs(size_t count)
+{
+  _buffer.append(count, '\t');
+}
+
+void JSONWriter::beginValue()
+{
+  if (_scopes.empty())
+    return;
+
+  Scope & scope = _scopes.back();
+  if (scope.isObject)
+    return; // key() wrote the separator already
+
+  if (scope.count++ > 0) {
+    _buffer += ',';
+    if (_indent) _buffer += ' ';
+  }
+}
+
+void JSONWriter::beginObject()
+{
+  beginValue();
+  _buffer += '{';
+  Scope scope = { true, 0 };
+  _scopes.push_back(scope);
+}
+
+void JSONWriter::endObject()
+{
+  _scopes.pop_back();
+  if (_indent) {
+    _buffer += '\n';
+    appendTabs(_scopes.size());
+  }
+  _buffer += '}';
+}
+
+void JSONWriter::beginArray()
+{
+  beginValue();
+  _buffer += '[';
+  Scope scope = { false, 0 };
+  _scopes.push_back(scope);
+}
+
+void JSONWriter::endArray()
+{
+  _scopes.pop_back();
+  _buffer += ']';
+}
+
+void JSONWriter::key(const char * name)
+{
+  Scope & scope = _scopes.back();
+  if (scope.count++ > 0)
+    _buffer += ',';
+  if (_indent) {
+    _buffer += '\n';
+    appendTabs(_scopes.size());
+  }
+  appendString(name);
+  _buffer += ':';
+  if (_indent) _buffer += '\t';
+}
+
+void JSONWriter::nullValue()
+{
+  beginValue();
+  _buffer.append("null", 4);
+}
+
+void JSONWriter::value(bool b)
+{
+  beginValue();
+  if (b) _buffer.append("true", 4);
+  else _buffer.append("false", 5);
+}
+
+void JSONWriter::value(double d)
+{
+  beginValue();
+
+  // same formatting rules as cJSON's print_number()
+  char buf[64];
+  int len;
+  if (d <= INT_MAX && d >= INT_MIN && std::fabs(static_cast<int>(d) - d) <= DBL_EPSILON)
+    len = snprintf(buf, sizeof(buf), "%d", static_cast<int>(d));
+  else if (std::fabs(std::floor(d) - d) <= DBL_EPSILON && std::fabs(d) < 1.0e60)
+    len = snprintf(buf, sizeof(buf), "%.0f", d);
+  else if (std::fabs(d) < 1.0e-6 || std::fabs(d) > 1.0e9)
+    len = snprintf(buf, sizeof(buf), "%e", d);
+  else
+    len = snprintf(buf, sizeof(buf), "%f", d);
+
+  if (len > 0)
+    _buffer.append(buf, std::min(len, static_cast<int>(sizeof(buf)) - 1));
+}
+
+void JSONWriter::value(const char * s)
+{
+  beginValue();
+  appendString(s);
+}
+
+void JSONWriter::appendString(const char * s)
+{
+  _buffer += '"';
+  if (s) {
+    // copy runs of characters not needing an escape in one go
+    const char * run = s;
+    for (; *s; ++s) {
+      unsigned char c = static_cast<unsigned char>(*s);
+      if (c > 31 && c != '"' && c != '\\')
+        continue;
+
+      _buffer.append(run, s - run);
+      run = s + 1;
+      _buffer += '\\';
+      switch (c) {
+        case '\\': _buffer += '\\'; break;
+        case '"':  _buffer += '"'; break;
+        case '\b': _buffer += 'b'; break;
+        case '\f': _buffer += 'f'; break;
+        case '\n': _buffer += 'n'; break;
+        case '\r': _buffer += 'r'; break;
+        case '\t': _buffer += 't'; break;
+        default: {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "u%04x", c);
+          _buffer.append(buf, 5);
+          break;
+        }
+      }
+    }
+    _buffer.append(run, s - run);
+  }
+  _buffer += '"';
+}
+
 const char * JSON::getPropertyTypeString(simgear::props::Type type)
 {
   switch (type) {
@@ -200,13 +353,85 @@ void JSON::addChildrenToProp(cJSON * json, SGPropertyNode_ptr n)
   }
 }
 
+void JSON::writeValue(JSONWriter & writer, SGPropertyNode * n)
+{
+  if( !n->hasValue() ) {
+    writer.nullValue();
+    return;
+  }
+
+  switch( n->getType() ) {
+    case simgear::props::BOOL:
+      writer.value(n->getBoolValue());
+      break;
+    case simgear::props::INT:
+    case simgear::props::LONG:
+    case simgear::props::FLOAT:
+    case simgear::props::DOUBLE: {
+      double val = n->getDoubleValue();
+      if (SGMiscd::isNaN(val))
+        writer.nullValue();
+      else
+        writer.value(val);
+      break;
+    }
+    default:
+      writer.value(n->getStringValue());
+      break;
+  }
+}
+
+// children extend the parent path instead of walking up the tree again
+static void writeJsonNode(JSONWriter & writer, SGPropertyNode * n, string & path,
+                          int depth, double timestamp)
+{
+  writer.beginObject();
+  writer.key("path");
+  writer.value(path);
+  writer.key("name");
+  writer.value(n->getName());
+  if( n->hasValue() ) {
+    writer.key("value");
+    JSON::writeValue(writer, n);
+  }
+  writer.key("type");
+  writer.value(JSON::getPropertyTypeString(n->getType()));
+  writer.key("index");
+  writer.value(n->getIndex());
+  if( timestamp >= 0.0 ) {
+    writer.key("ts");
+    writer.value(timestamp);
+  }
+  writer.key("nChildren");
+  writer.value(n->nChildren());
+
+  if (depth > 0 && n->nChildren() > 0) {
+    writer.key("children");
+    writer.beginArray();
+    const size_t pathLength = path.size();
+    for (int i = 0; i < n->nChildren(); i++) {
+      SGPropertyNode * child = n->getChild(i);
+      path += '/';
+      path += child->getDisplayName(true);
+      writeJsonNode(writer, child, path, depth - 1, timestamp);
+      path.resize(pathLength);
+    }
+    writer.endArray();
+  }
+  writer.endObject();
+}
+
+void JSON::writeJson(JSONWriter & writer, SGPropertyNode * n, int depth, double timestamp )
+{
+  string path = n->getPath(true);
+  writeJsonNode(writer, n, path, depth, timestamp);
+}
+
 string JSON::toJsonString(bool indent, SGPropertyNode_ptr n, int depth, double timestamp )
 {
-  cJSON * json = toJson( n, depth, timestamp );
-  char * jsonString = indent ? cJSON_Print( json ) : cJSON_PrintUnformatted( json );
-  string reply(jsonString);
-  free( jsonString );
-  cJSON_Delete( json );
+  string reply;
+  JSONWriter writer(reply, indent);
+  writeJson(writer, n, depth, timestamp);
   return reply;
 }
 
@@ -24,15 +24,62 @@
 #include <simgear/props/props.hxx>
 #include <3rdparty/cjson/cJSON.h>
 #include <string>
+#include <vector>
 
 namespace flightgear {
 namespace http {
 
+/**
+ * Streaming JSON writer appending to a caller owned buffer. The output
+ * matches what cJSON_Print / cJSON_PrintUnformatted produce for the same
+ * document, without building the intermediate cJSON tree. Keep the buffer
+ * around between calls to avoid reallocating it for every message.
+ */
+class JSONWriter {
+public:
+  JSONWriter(std::string & buffer, bool indent = false);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  /// write the member name of the next value, only valid inside objects
+  void key(const char * name);
+
+  void nullValue();
+  void value(bool b);
+  void value(int i) { value(static_cast<double>(i)); }
+  void value(double d);
+  void value(const char * s);
+  void value(const std::string & s) { value(s.c_str()); }
+
+private:
+  void beginValue();
+  void appendString(const char * s);
+  void appendTabs(size_t count);
+
+  struct Scope {
+    bool isObject;
+    unsigned int count;
+  };
+
+  std::string & _buffer;
+  bool _indent;
+  std::vector<Scope> _scopes;
+};
+
 class JSON {
 public:
   static cJSON * toJson(SGPropertyNode_ptr n, int depth, double timestamp = -1.0 );
   static std::string toJsonString(bool indent, SGPropertyNode_ptr n, int depth, double timestamp = -1.0 );
 
+  /**
+   * Stream the same document toJson() would build into @a writer.
+   */
+  static void writeJson(JSONWriter & writer, SGPropertyNode * n, int depth, double timestamp = -1.0 );
+  static void writeValue(JSONWriter & writer, SGPropertyNode * n);
+
   static const char * getPropertyTypeString(simgear::props::Type type);
   static cJSON * valueToJson(SGPropertyNode_ptr n);
 
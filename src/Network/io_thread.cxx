@@ -0,0 +1,520 @@
+// io_thread.cxx -- epoll driven I/O thread for socket channels
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "io_thread.hxx"
+
+#ifdef FG_HAVE_IO_THREAD
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include <Main/frame_profiler.hxx>
+
+#include "protocol.hxx"
+
+namespace {
+
+const size_t QUEUE_RECORDS = 256;
+
+bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // anonymous namespace
+
+FGIORecordQueue::FGIORecordQueue(size_t capacity) :
+    _slots(capacity),
+    _head(0),
+    _tail(0)
+{
+}
+
+FGIORecordQueue::Record* FGIORecordQueue::beginPush()
+{
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= _slots.size())
+        return NULL;
+    return &_slots[head % _slots.size()];
+}
+
+void FGIORecordQueue::endPush()
+{
+    _head.store(_head.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+FGIORecordQueue::Record* FGIORecordQueue::front()
+{
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+        return NULL;
+    return &_slots[tail % _slots.size()];
+}
+
+void FGIORecordQueue::pop()
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FGThreadedSocket::FGThreadedSocket(FGIOThread* thread, const std::string& host,
+                                   const std::string& port, const std::string& style) :
+    _thread(thread),
+    _host(host),
+    _port(port),
+    _tcp(style == "tcp"),
+    _listening(false),
+    _fd(-1),
+    _client(-1),
+    _haveReplyAddress(false),
+    _replyAddressLength(0),
+    _incoming(QUEUE_RECORDS),
+    _outgoing(QUEUE_RECORDS),
+    _dropped(0),
+    _pendingStart(0),
+    _maxDelayMSec(0.0)
+{
+    set_type(sgSocketType);
+    if (!_tcp && style != "udp") {
+        SG_LOG(SG_IO, SG_ALERT, "Error: socket style must be tcp or udp, not "
+               << style << "; assuming udp");
+    }
+}
+
+FGThreadedSocket::~FGThreadedSocket()
+{
+    close();
+}
+
+bool FGThreadedSocket::open(const SGProtocolDir d)
+{
+    set_dir(d);
+
+    // servers for input, clients for output, matching SGSocket
+    bool server = (d == SG_IO_IN) || (d == SG_IO_BI);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = _tcp ? SOCK_STREAM : SOCK_DGRAM;
+    hints.ai_flags = server ? AI_PASSIVE : 0;
+
+    struct addrinfo* addresses = NULL;
+    int err = getaddrinfo(_host.empty() ? NULL : _host.c_str(), _port.c_str(),
+                          &hints, &addresses);
+    if (err != 0) {
+        SG_LOG(SG_IO, SG_ALERT, "Can not resolve " << _host << ":" << _port
+               << ": " << gai_strerror(err));
+        return false;
+    }
+
+    _fd = socket(addresses->ai_family, addresses->ai_socktype, 0);
+    bool ok = _fd >= 0;
+    if (ok && server) {
+        int on = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        ok = bind(_fd, addresses->ai_addr, addresses->ai_addrlen) == 0;
+        if (ok && _tcp) {
+            ok = listen(_fd, 1) == 0;
+            _listening = true;
+        }
+    } else if (ok) {
+        ok = connect(_fd, addresses->ai_addr, addresses->ai_addrlen) == 0;
+        if (ok && _tcp) {
+            int on = 1;
+            setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (!ok || !setNonBlocking(_fd)) {
+        SG_LOG(SG_IO, SG_ALERT, "Error opening socket " << _host << ":" << _port
+               << ": " << strerror(errno));
+        close();
+        return false;
+    }
+
+    if (!_thread->add(this)) {
+        close();
+        return false;
+    }
+
+    set_valid(true);
+    return true;
+}
+
+bool FGThreadedSocket::close()
+{
+    if (_fd < 0)
+        return true;
+
+    _thread->remove(this);
+    if (_client >= 0)
+        ::close(_client);
+    ::close(_fd);
+    _client = _fd = -1;
+    set_valid(false);
+    return true;
+}
+
+bool FGThreadedSocket::fillPending()
+{
+    FGIORecordQueue::Record* record = _incoming.front();
+    if (!record)
+        return false;
+
+    if (_pendingStart == _pending.size()) {
+        _pending.clear();
+        _pendingStart = 0;
+    }
+    _pending.insert(_pending.end(), record->data.begin(), record->data.end());
+    _maxDelayMSec = std::max(_maxDelayMSec, record->stamp.elapsedMSec());
+    _incoming.pop();
+    return true;
+}
+
+int FGThreadedSocket::read(char* buf, int length)
+{
+    size_t available = _pending.size() - _pendingStart;
+    if (!_tcp && available == 0) {
+        // one datagram per read, truncated like recv() would
+        FGIORecordQueue::Record* record = _incoming.front();
+        if (!record)
+            return 0;
+        int n = std::min<int>(length, record->data.size());
+        std::copy(record->data.begin(), record->data.begin() + n, buf);
+        _maxDelayMSec = std::max(_maxDelayMSec, record->stamp.elapsedMSec());
+        _incoming.pop();
+        return n;
+    }
+
+    // streams only hand out complete records of the requested size
+    while (available < size_t(length) && fillPending())
+        available = _pending.size() - _pendingStart;
+
+    int n = std::min<int>(length, available);
+    if (_tcp && n < length)
+        return 0;
+    std::copy(_pending.begin() + _pendingStart,
+              _pending.begin() + _pendingStart + n, buf);
+    _pendingStart += n;
+    return n;
+}
+
+int FGThreadedSocket::readline(char* buf, int length)
+{
+    for (;;) {
+        std::vector<char>::iterator begin = _pending.begin() + _pendingStart;
+        std::vector<char>::iterator eol = std::find(begin, _pending.end(), '\n');
+        if (eol != _pending.end() || (_pending.end() - begin) >= length) {
+            int n = std::min<int>(length, (eol - begin) + (eol != _pending.end()));
+            std::copy(begin, begin + n, buf);
+            if (n < length)
+                buf[n] = 0;
+            _pendingStart += n;
+            return n;
+        }
+
+        if (!fillPending())
+            return 0;
+    }
+}
+
+int FGThreadedSocket::write(const char* buf, const int length)
+{
+    FGIORecordQueue::Record* record = _outgoing.beginPush();
+    if (!record) {
+        // the I/O thread is behind, stale data is of no use anyway
+        ++_dropped;
+        return length;
+    }
+
+    record->data.assign(buf, buf + length);
+    record->stamp.stamp();
+    _outgoing.endPush();
+    return length;
+}
+
+int FGThreadedSocket::writestring(const char* str)
+{
+    return write(str, strlen(str));
+}
+
+double FGThreadedSocket::take_max_delay_ms()
+{
+    double delay = _maxDelayMSec;
+    _maxDelayMSec = 0.0;
+    return delay;
+}
+
+void FGThreadedSocket::acceptClient()
+{
+    int client = accept(_fd, NULL, NULL);
+    if (client < 0)
+        return;
+
+    if (!setNonBlocking(client)) {
+        ::close(client);
+        return;
+    }
+
+    // like SGSocket a new connection replaces the previous one
+    if (_client >= 0)
+        ::close(_client);
+    _client = client;
+    _thread->watch(_client, this);
+    SG_LOG(SG_IO, SG_INFO, "Accepted connection on port " << _port);
+}
+
+void FGThreadedSocket::receive()
+{
+    if (_listening)
+        acceptClient();
+
+    int fd = dataFd();
+    if (fd < 0)
+        return;
+
+    char buf[FG_MAX_MSG_SIZE];
+    for (;;) {
+        ssize_t n;
+        if (!_tcp && get_dir() == SG_IO_BI) {
+            struct sockaddr_storage from;
+            socklen_t fromLength = sizeof(from);
+            n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr*) &from, &fromLength);
+            if (n >= 0 && fromLength <= sizeof(_replyAddress)) {
+                memcpy(_replyAddress, &from, fromLength);
+                _replyAddressLength = fromLength;
+                _haveReplyAddress = true;
+            }
+        } else {
+            n = recv(fd, buf, sizeof(buf), 0);
+        }
+
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                SG_LOG(SG_IO, SG_WARN, "Error reading socket: " << strerror(errno));
+            return;
+        }
+
+        if (n == 0 && _tcp) {
+            // peer closed the connection
+            if (fd == _client) {
+                ::close(_client);
+                _client = -1;
+            } else {
+                SG_LOG(SG_IO, SG_WARN, "Connection to " << _host << ":" << _port
+                       << " closed by peer");
+                _thread->unwatch(fd);
+            }
+            return;
+        }
+
+        FGIORecordQueue::Record* record = _incoming.beginPush();
+        if (!record) {
+            ++_dropped;
+            continue;
+        }
+        record->stamp.stamp();
+        record->data.assign(buf, buf + n);
+        _incoming.endPush();
+    }
+}
+
+void FGThreadedSocket::send()
+{
+    int fd = dataFd();
+    for (FGIORecordQueue::Record* record = _outgoing.front(); record;
+         record = _outgoing.front()) {
+        if (fd >= 0) {
+            ssize_t n;
+            if (!_tcp && get_dir() == SG_IO_BI) {
+                n = _haveReplyAddress ?
+                    sendto(fd, &record->data[0], record->data.size(), 0,
+                           (struct sockaddr*) _replyAddress, _replyAddressLength) :
+                    ssize_t(record->data.size());
+            } else {
+                n = ::send(fd, &record->data[0], record->data.size(), MSG_NOSIGNAL);
+            }
+            // a short or failed write of a realtime record is not retried
+            if (n != ssize_t(record->data.size()))
+                ++_dropped;
+        }
+        _outgoing.pop();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FGIOThread::FGIOThread() :
+    _epoll(-1),
+    _wakeup(-1),
+    _running(false)
+{
+}
+
+FGIOThread::~FGIOThread()
+{
+    shutdown();
+}
+
+bool FGIOThread::init()
+{
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    _wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_epoll < 0 || _wakeup < 0 || !watch(_wakeup, NULL)) {
+        SG_LOG(SG_IO, SG_ALERT, "Can not set up the I/O thread: " << strerror(errno));
+        shutdown();
+        return false;
+    }
+
+    _running = true;
+    start();
+    SG_LOG(SG_IO, SG_INFO, "Socket channels serviced by the I/O thread");
+    return true;
+}
+
+void FGIOThread::shutdown()
+{
+    if (_running) {
+        _running = false;
+        flush();
+        join();
+    }
+
+    if (_wakeup >= 0)
+        ::close(_wakeup);
+    if (_epoll >= 0)
+        ::close(_epoll);
+    _wakeup = _epoll = -1;
+}
+
+void FGIOThread::flush()
+{
+    uint64_t one = 1;
+    if (::write(_wakeup, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        SG_LOG(SG_IO, SG_WARN, "Can not wake the I/O thread: " << strerror(errno));
+    }
+}
+
+void FGIOThread::getStats(unsigned int& dropped, double& maxDelayMSec)
+{
+    SGGuard<SGMutex> lock(_mutex);
+    dropped = 0;
+    maxDelayMSec = 0.0;
+    for (size_t i = 0; i < _sockets.size(); ++i) {
+        dropped += _sockets[i]->get_dropped();
+        maxDelayMSec = std::max(maxDelayMSec, _sockets[i]->take_max_delay_ms());
+    }
+}
+
+bool FGIOThread::watch(int fd, FGThreadedSocket* socket)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = socket;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        SG_LOG(SG_IO, SG_ALERT, "Can not watch socket: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void FGIOThread::unwatch(int fd)
+{
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, NULL);
+}
+
+bool FGIOThread::add(FGThreadedSocket* socket)
+{
+    SGGuard<SGMutex> lock(_mutex);
+    if (!watch(socket->_fd, socket))
+        return false;
+    _sockets.push_back(socket);
+    return true;
+}
+
+void FGIOThread::remove(FGThreadedSocket* socket)
+{
+    SGGuard<SGMutex> lock(_mutex);
+    unwatch(socket->_fd);
+    if (socket->_client >= 0)
+        unwatch(socket->_client);
+    _sockets.erase(std::remove(_sockets.begin(), _sockets.end(), socket),
+                   _sockets.end());
+}
+
+void FGIOThread::run()
+{
+    const int maxEvents = 16;
+    struct epoll_event events[maxEvents];
+    flightgear::FrameProfiler::setThreadName("io");
+
+    while (_running) {
+        int count = epoll_wait(_epoll, events, maxEvents, 100);
+        if (count < 0) {
+            if (errno != EINTR)
+                SG_LOG(SG_IO, SG_WARN, "epoll_wait failed: " << strerror(errno));
+            continue;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        flightgear::ProfileScope scope("io", "io-thread-events");
+        SGGuard<SGMutex> lock(_mutex);
+        for (int i = 0; i < count; ++i) {
+            FGThreadedSocket* socket = static_cast<FGThreadedSocket*>(events[i].data.ptr);
+            if (!socket) {
+                uint64_t value;
+                while (::read(_wakeup, &value, sizeof(value)) > 0) { }
+
+                for (size_t s = 0; s < _sockets.size(); ++s)
+                    _sockets[s]->send();
+                continue;
+            }
+
+            // the socket may have been closed since epoll_wait returned
+            if (std::find(_sockets.begin(), _sockets.end(), socket) != _sockets.end())
+                socket->receive();
+        }
+    }
+}
+
+#endif // FG_HAVE_IO_THREAD
@@ -0,0 +1,167 @@
+// io_thread.hxx -- epoll driven I/O thread for socket channels
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_IO_THREAD_HXX
+#define _FG_IO_THREAD_HXX
+
+#include <simgear/compiler.h>
+
+#if defined(__linux__)
+#  define FG_HAVE_IO_THREAD 1
+#endif
+
+#ifdef FG_HAVE_IO_THREAD
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <simgear/io/iochannel.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+class FGIOThread;
+
+/**
+ * Fixed size queue of timestamped records between exactly one producer
+ * and one consumer thread. Slots keep their buffers, so once warmed up
+ * pushing and popping does not allocate.
+ */
+class FGIORecordQueue {
+public:
+    struct Record {
+        SGTimeStamp stamp;
+        std::vector<char> data;
+    };
+
+    explicit FGIORecordQueue(size_t capacity);
+
+    /// producer: the slot to fill next, or NULL if the queue is full
+    Record* beginPush();
+    void endPush();
+
+    /// consumer: the oldest record, or NULL if the queue is empty
+    Record* front();
+    void pop();
+
+private:
+    std::vector<Record> _slots;
+    std::atomic<size_t> _head; ///< next slot to fill
+    std::atomic<size_t> _tail; ///< next slot to consume
+};
+
+/**
+ * Socket I/O channel serviced by an FGIOThread. The protocol running on
+ * the simulation thread reads records the I/O thread has already
+ * received and writes into a queue the I/O thread sends from, so
+ * process() never blocks in or loops over socket calls.
+ *
+ * Takes the same hostname, port and style (tcp or udp) as SGSocket.
+ */
+class FGThreadedSocket : public SGIOChannel {
+public:
+    FGThreadedSocket(FGIOThread* thread, const std::string& host,
+                     const std::string& port, const std::string& style);
+    virtual ~FGThreadedSocket();
+
+    virtual bool open(const SGProtocolDir d);
+    virtual int read(char* buf, int length);
+    virtual int readline(char* buf, int length);
+    virtual int write(const char* buf, const int length);
+    virtual int writestring(const char* str);
+    virtual bool close();
+
+    /// records lost because a queue was full
+    unsigned int get_dropped() const { return _dropped; }
+
+    /// longest time a record waited for the simulation thread since the
+    /// last call, in milliseconds
+    double take_max_delay_ms();
+
+private:
+    friend class FGIOThread;
+
+    // I/O thread side
+    void receive();
+    void send();
+    void acceptClient();
+    int dataFd() const { return _tcp && _listening ? _client : _fd; }
+
+    // simulation thread side
+    bool fillPending();
+
+    FGIOThread* _thread;
+    std::string _host;
+    std::string _port;
+    bool _tcp;
+    bool _listening;
+
+    int _fd;                    ///< bound, connected or listening socket
+    int _client;                ///< accepted connection of a tcp server
+    bool _haveReplyAddress;     ///< udp bi: reply to the last sender
+    char _replyAddress[128];
+    unsigned int _replyAddressLength;
+
+    FGIORecordQueue _incoming;
+    FGIORecordQueue _outgoing;
+    std::atomic<unsigned int> _dropped;
+
+    std::vector<char> _pending; ///< received bytes not yet consumed
+    size_t _pendingStart;
+    double _maxDelayMSec;
+};
+
+/**
+ * Thread multiplexing all FGThreadedSockets with epoll. Incoming data is
+ * queued as soon as it arrives, outgoing data is sent when the
+ * simulation thread calls flush() once per frame.
+ */
+class FGIOThread : public SGThread {
+public:
+    FGIOThread();
+    virtual ~FGIOThread();
+
+    /// create the epoll set and start the thread
+    bool init();
+    void shutdown();
+
+    /// wake the thread to send everything queued this frame
+    void flush();
+
+    void getStats(unsigned int& dropped, double& maxDelayMSec);
+
+protected:
+    virtual void run();
+
+private:
+    friend class FGThreadedSocket;
+
+    bool add(FGThreadedSocket* socket);
+    void remove(FGThreadedSocket* socket);
+    bool watch(int fd, FGThreadedSocket* socket);
+    void unwatch(int fd);
+
+    int _epoll;
+    int _wakeup;                ///< eventfd used by flush() and shutdown()
+    std::atomic<bool> _running;
+
+    SGMutex _mutex;             ///< guards _sockets against the I/O thread
+    std::vector<FGThreadedSocket*> _sockets;
+};
+
+#endif // FG_HAVE_IO_THREAD
+
+#endif // _FG_IO_THREAD_HXX
@@ -24,6 +24,8 @@
 #include <algorithm>
 #include <functional>
 
+#include <Main/frame_profiler.hxx>
+
 using namespace osg;
 using namespace flightgear;
 
@@ -96,6 +98,7 @@ void SceneryPager::PagerRequest::doRequest(SceneryPager* pager)
 void SceneryPager::signalEndFrame()
 {
     using namespace std;
+    ProfileScope scope("scenery", "pager-end-frame");
     bool areDeleteRequests = false;
     bool arePagerRequests = false;
     if (!_deleteRequests.empty()) {
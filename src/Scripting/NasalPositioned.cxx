@@ -605,6 +605,9 @@ static void legGhostSetMember(naContext c, void* g, naRef field, naRef value)
   FlightPlan::Leg* leg = (FlightPlan::Leg*) g;
     
   waypointCommonSetMember(c, leg->waypoint(), fieldName, value);
+  if (!strcmp(fieldName, "fly_type")) {
+    leg->markModified(); // changes the turn at this waypoint
+  }
 }
 
 static const char* flightplanGhostGetMember(naContext c, void* g, naRef field, naRef* out)
@@ -2645,7 +2648,7 @@ static naRef f_leg_path(naContext c, naRef me, int argc, naRef* args)
     naRuntimeError(c, "leg.setAltitude called on non-flightplan-leg object");
   }
   
-  RoutePath path(leg->owner());
+  const RoutePath& path(leg->owner()->routePath());
   SGGeodVec gv(path.pathForIndex(leg->index()));
 
   naRef result = naNewVector(c);
@@ -2670,7 +2673,7 @@ static naRef f_leg_courseAndDistanceFrom(naContext c, naRef me, int argc, naRef*
     SGGeod pos;
     geodFromArgs(args, 0, argc, pos);
   
-    RoutePath path(leg->owner());
+    const RoutePath& path(leg->owner()->routePath());
     SGGeod wpPos = path.positionForIndex(leg->index());
     double courseDeg, az2, distanceM;
     SGGeodesy::inverse(pos, wpPos, courseDeg, az2, distanceM);
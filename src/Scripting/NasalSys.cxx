@@ -53,6 +53,7 @@
 #include <Main/globals.hxx>
 #include <Main/util.hxx>
 #include <Main/fg_props.hxx>
+#include <Main/frame_profiler.hxx>
 
 using std::map;
 using std::string;
@@ -167,6 +168,7 @@ public:
       // event manager).
       _isRunning = false;
 
+    flightgear::ProfileScope scope("nasal", "maketimer");
     naRef *args = NULL;
     _sys->callMethod(_func, _self, 0, args, naNil() /* locals */);
   }
@@ -1359,6 +1361,7 @@ void FGNasalSys::setTimer(naContext c, int argc, naRef* args)
 
 void FGNasalSys::handleTimer(NasalTimer* t)
 {
+    flightgear::ProfileScope scope("nasal", "settimer");
     call(t->handler, 0, 0, naNil());
     gcRelease(t->gcKey);
 }
@@ -1499,7 +1502,8 @@ FGNasalListener::FGNasalListener(SGPropertyNode *node, naRef code,
     _active(0),
     _dead(false),
     _last_int(0L),
-    _last_float(0.0)
+    _last_float(0.0),
+    _profileName(NULL)
 {
     if(_type == 0 && !_init)
         changed(node);
@@ -1514,6 +1518,9 @@ FGNasalListener::~FGNasalListener()
 void FGNasalListener::call(SGPropertyNode* which, naRef mode)
 {
     if(_active || _dead) return;
+    if(!_profileName && flightgear::FrameProfiler::isEnabled())
+        _profileName = flightgear::FrameProfiler::intern("listener " + _node->getPath());
+    flightgear::ProfileScope scope("nasal", _profileName);
     _active++;
     naRef arg[4];
     arg[0] = _nas->propNodeGhost(which);
@@ -47,6 +47,7 @@ private:
     long _last_int;
     double _last_float;
     std::string _last_string;
+    const char* _profileName; ///< interned once the profiler needs it
 };
 
 
@@ -23,7 +23,15 @@
 #include <simgear/debug/logstream.hxx>
 #include <simgear/sound/readwav.hxx>
 #include <simgear/misc/sg_path.hxx>
-#include <simgear/threads/SGThread.hxx>
+#include <simgear/misc/strutils.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <unordered_map>
 
 #include <flite_hts_engine.h>
 
@@ -34,6 +42,193 @@ static const char * VOICE_FILES[] = {
   "cstr_uk_female-1.0.htsvoice"
 };
 
+namespace {
+
+// mono16 samples of one synthesized sentence
+struct PhraseSamples {
+  std::vector<short> samples;
+  int rate;
+};
+typedef std::shared_ptr<const PhraseSamples> PhraseSamplesRef;
+
+/**
+ * Least recently used cache of synthesized sentences, keyed by voice,
+ * text, volume, speed and pitch. Shared by all synthesizers and their
+ * worker threads.
+ */
+class PhraseCache {
+public:
+  static PhraseCache * instance()
+  {
+    static PhraseCache cache;
+    return &cache;
+  }
+
+  void setCapacity( size_t bytes )
+  {
+    SGGuard<SGMutex> g(_lock);
+    _capacity = bytes;
+    evict();
+  }
+
+  PhraseSamplesRef get( const string & key )
+  {
+    SGGuard<SGMutex> g(_lock);
+    Index::iterator it = _index.find(key);
+    if( it == _index.end() ) {
+      ++_misses;
+      return PhraseSamplesRef();
+    }
+
+    ++_hits;
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return it->second->second;
+  }
+
+  void put( const string & key, PhraseSamplesRef samples )
+  {
+    SGGuard<SGMutex> g(_lock);
+    if( _index.find(key) != _index.end() ) return; // another worker was faster
+
+    _lru.push_front(Entry(key, samples));
+    _index[key] = _lru.begin();
+    _bytes += size(samples);
+    evict();
+  }
+
+  void logStats()
+  {
+    SGGuard<SGMutex> g(_lock);
+    SG_LOG(SG_SOUND, SG_INFO, "FLITE phrase cache: " << _lru.size() << " phrases, "
+        << _bytes / 1024 << "kB, " << _hits << " hits, " << _misses << " misses");
+  }
+
+private:
+  typedef std::pair<string, PhraseSamplesRef> Entry;
+  typedef std::list<Entry> EntryList;
+  typedef std::unordered_map<string, EntryList::iterator> Index;
+
+  PhraseCache() : _bytes(0), _capacity(8 * 1024 * 1024), _hits(0), _misses(0) {}
+
+  static size_t size( const PhraseSamplesRef & samples )
+  {
+    return samples->samples.size() * sizeof(short);
+  }
+
+  void evict()
+  {
+    // always keep the newest entry, even if it is bigger than the cache
+    while( _bytes > _capacity && _lru.size() > 1 ) {
+      _bytes -= size(_lru.back().second);
+      _index.erase(_lru.back().first);
+      _lru.pop_back();
+    }
+  }
+
+  SGMutex _lock;
+  EntryList _lru;
+  Index _index;
+  size_t _bytes;
+  size_t _capacity;
+  unsigned int _hits, _misses;
+};
+
+// split text at sentence ends, so each sentence can be synthesized,
+// played and cached on its own. "29.92" stays in one piece.
+string_list splitSentences( const string & text )
+{
+  string_list result;
+  string::size_type start = 0;
+  for( string::size_type i = 0; i <= text.size(); ++i ) {
+    bool end = (i == text.size()) || (text[i] == '\n');
+    if( !end && (text[i] == '.' || text[i] == '!' || text[i] == '?' || text[i] == ';') ) {
+      end = (i + 1 == text.size()) || isspace((unsigned char) text[i + 1]);
+    }
+    if( !end ) continue;
+
+    string sentence = simgear::strutils::strip(text.substr(start, i + 1 - start));
+    start = i + 1;
+    for( string::size_type c = 0; c < sentence.size(); ++c ) {
+      if( isalnum((unsigned char) sentence[c]) ) {
+        result.push_back(sentence);
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+string cacheKey( const string & voice, const string & text, double volume, double speed, double pitch )
+{
+  char params[64];
+  snprintf(params, sizeof(params), "|%.2f|%.3f|%.3f|", volume, speed, pitch);
+  return voice + params + text;
+}
+
+// synthesize one sentence with engine, or take it from the cache
+PhraseSamplesRef synthesizePhrase( struct _Flite_HTS_Engine * engine, const string & voice,
+                                   const string & text, double volume, double speed, double pitch )
+{
+  const string key = cacheKey(voice, text, volume, speed, pitch);
+  PhraseSamplesRef cached = PhraseCache::instance()->get(key);
+  if( cached ) return cached;
+
+  HTS_Engine_set_volume( &engine->engine, volume );
+  HTS_Engine_set_speed( &engine->engine, 0.8 + 0.4 * speed );
+  HTS_Engine_add_half_tone(&engine->engine, -4.0 + 8.0 * pitch );
+
+  void* data;
+  int rate, count;
+  if ( FALSE == Flite_HTS_Engine_synthesize_samples_mono16(engine, text.c_str(), &data, &count, &rate)) {
+    return PhraseSamplesRef();
+  }
+
+  std::shared_ptr<PhraseSamples> phrase(new PhraseSamples);
+  phrase->rate = rate;
+  phrase->samples.assign((short*) data, (short*) data + count);
+  free(data);
+
+  PhraseCache::instance()->put(key, phrase);
+  return phrase;
+}
+
+// join phrases into one sample, which owns a malloc()ed copy of the data
+SGSoundSample * makeSample( const std::vector<PhraseSamplesRef> & phrases )
+{
+  size_t count = 0;
+  int rate = 0;
+  for( size_t i = 0; i < phrases.size(); ++i ) {
+    if( !phrases[i] ) continue;
+    count += phrases[i]->samples.size();
+    rate = phrases[i]->rate;
+  }
+  if( count == 0 ) return NULL;
+
+  void* data = malloc(count * sizeof(short));
+  short* dst = static_cast<short*>(data);
+  for( size_t i = 0; i < phrases.size(); ++i ) {
+    if( !phrases[i] ) continue;
+    memcpy(dst, phrases[i]->samples.data(), phrases[i]->samples.size() * sizeof(short));
+    dst += phrases[i]->samples.size();
+  }
+
+  return new SGSoundSample(&data, count * sizeof(short), rate, SG_SAMPLE_MONO16);
+}
+
+} // of anonymous namespace
+
+struct FLITEVoiceSynthesizer::Utterance
+{
+  SynthesizeRequest request;
+  string_list sentences;
+
+  SGMutex lock; // guards everything below
+  std::vector<PhraseSamplesRef> phrases;
+  std::vector<bool> done;
+  unsigned delivered; // sentences passed to the listener so far
+  bool cancelled; // superseded by a newer request of the listener
+};
+
 class FLITEVoiceSynthesizer::WorkerThread : public SGThread
 {
 public:
@@ -48,28 +243,63 @@ private:
 
 void FLITEVoiceSynthesizer::WorkerThread::run()
 {
+  Flite_HTS_Engine engine;
+  Flite_HTS_Engine_initialize(&engine);
+  Flite_HTS_Engine_load(&engine, _synthesizer->_voice.c_str());
+
   for (;;) {
-    SynthesizeRequest request = _synthesizer->_requests.pop();
+    ChunkTask task = _synthesizer->_tasks.pop();
 
     // marker value indicating termination requested
-    if ((request.speed < 0.0) && (request.volume < 0.0)) {
+    if (!task.utterance) {
       SG_LOG(SG_SOUND, SG_INFO, "FLITE synthesis thread exiting");
-      return;
+      break;
     }
 
-    if ( NULL != request.listener) {
-      SGSharedPtr<SGSoundSample> sample = _synthesizer->synthesize(request.text, request.volume, request.speed, request.pitch);
-      request.listener->SoundSampleReady( sample );
+    {
+      SGGuard<SGMutex> g(task.utterance->lock);
+      if (task.utterance->cancelled) continue;
     }
+
+    const SynthesizeRequest & request = task.utterance->request;
+    PhraseSamplesRef phrase = synthesizePhrase(&engine, _synthesizer->_voice,
+        task.utterance->sentences[task.index], _synthesizer->_volume, request.speed, request.pitch);
+
+    {
+      SGGuard<SGMutex> g(task.utterance->lock);
+      task.utterance->phrases[task.index] = phrase;
+      task.utterance->done[task.index] = true;
+    }
+    _synthesizer->chunkDone(task.utterance, task.index);
   }
+
+  Flite_HTS_Engine_clear(&engine);
 }
 
-SynthesizeRequest SynthesizeRequest::cancelThreadRequest()
+void FLITEVoiceSynthesizer::chunkDone( const UtteranceRef & utterance, unsigned index )
 {
-  SynthesizeRequest marker;
-  marker.volume = -999.0;
-  marker.speed = -999.0;
-  return marker;
+  Utterance & u = *utterance;
+  bool complete = false;
+  {
+    SGGuard<SGMutex> g(u.lock);
+    if( u.cancelled ) return;
+
+    // pass on sentences in order; whichever worker completes the next
+    // missing one also delivers those other workers finished meanwhile
+    const unsigned count = u.sentences.size();
+    unsigned first = u.delivered;
+    while( u.delivered < count && u.done[u.delivered] ) {
+      std::vector<PhraseSamplesRef> one(1, u.phrases[u.delivered]);
+      u.request.listener->SoundSampleChunkReady( makeSample(one), u.delivered, count, u.request.id );
+      ++u.delivered;
+    }
+    complete = (u.delivered == count && first < count);
+  }
+
+  // only one worker gets here, and the phrases do not change any more
+  if( complete && u.request.listener->needsWholeSample() ) {
+    u.request.listener->SoundSampleReady( makeSample(u.phrases) );
+  }
 }
 
 string FLITEVoiceSynthesizer::getVoicePath( voice_t voice )
@@ -89,25 +319,79 @@ string FLITEVoiceSynthesizer::getVoicePath( const string & voice )
 
 void FLITEVoiceSynthesizer::synthesize( SynthesizeRequest & request)
 {
-  _requests.push(request);
+  if( NULL == request.listener ) return;
+
+  UtteranceRef utterance(new Utterance);
+  utterance->request = request;
+  SG_CLAMP_RANGE( utterance->request.speed, 0.0, 1.0 );
+  SG_CLAMP_RANGE( utterance->request.pitch, 0.0, 1.0 );
+  utterance->sentences = splitSentences(request.text);
+  utterance->phrases.resize(utterance->sentences.size());
+  utterance->done.resize(utterance->sentences.size(), false);
+  utterance->delivered = 0;
+  utterance->cancelled = false;
+
+  {
+    SGGuard<SGMutex> g(_latestLock);
+    UtteranceRef previous = _latest[request.listener].lock();
+    if( previous ) {
+      SGGuard<SGMutex> pg(previous->lock);
+      previous->cancelled = true;
+    }
+    _latest[request.listener] = utterance;
+  }
+
+  if( utterance->sentences.empty() ) {
+    request.listener->SoundSampleChunkReady( NULL, 0, 0, request.id );
+    if( request.listener->needsWholeSample() ) {
+      request.listener->SoundSampleReady( NULL );
+    }
+    return;
+  }
+
+  // queued in order, so the first sentence is synthesized first
+  for( unsigned i = 0; i < utterance->sentences.size(); ++i ) {
+    ChunkTask task;
+    task.utterance = utterance;
+    task.index = i;
+    _tasks.push(task);
+  }
 }
 
 FLITEVoiceSynthesizer::FLITEVoiceSynthesizer(const std::string & voice)
-    : _engine(new Flite_HTS_Engine), _worker(new FLITEVoiceSynthesizer::WorkerThread(this)), _volume(6.0)
+    : _voice(voice), _engine(new Flite_HTS_Engine), _volume(6.0)
 {
   _volume = fgGetDouble("/sim/sound/voice-synthesizer/volume", _volume );
+  int cacheKb = fgGetInt("/sim/sound/voice-synthesizer/cache-size-kb", 8192);
+  PhraseCache::instance()->setCapacity( cacheKb > 0 ? cacheKb * 1024 : 0 );
+
   Flite_HTS_Engine_initialize(_engine);
   Flite_HTS_Engine_load(_engine, voice.c_str());
-  _worker->start();
+
+  // every worker loads its own copy of the voice
+  int threads = fgGetInt("/sim/sound/voice-synthesizer/threads", 2);
+  SG_CLAMP_RANGE( threads, 1, 8 );
+  for( int i = 0; i < threads; ++i ) {
+    _workers.push_back(new WorkerThread(this));
+    _workers.back()->start();
+  }
 }
 
 FLITEVoiceSynthesizer::~FLITEVoiceSynthesizer()
 {
-  // push the special marker value
-  _requests.push(SynthesizeRequest::cancelThreadRequest());
-  _worker->join();
-  SG_LOG(SG_SOUND, SG_INFO, "FLITE synthesis thread joined OK");
+  // push one exit marker per worker
+  for( size_t i = 0; i < _workers.size(); ++i ) {
+    _tasks.push(ChunkTask());
+  }
+  for( size_t i = 0; i < _workers.size(); ++i ) {
+    _workers[i]->join();
+    delete _workers[i];
+  }
+  SG_LOG(SG_SOUND, SG_INFO, "FLITE synthesis threads joined OK");
+  PhraseCache::instance()->logStats();
+
   Flite_HTS_Engine_clear(_engine);
+  delete _engine;
 }
 
 SGSoundSample * FLITEVoiceSynthesizer::synthesize(const std::string & text, double volume, double speed, double pitch )
@@ -115,18 +399,13 @@ SGSoundSample * FLITEVoiceSynthesizer::synthesize(const std::string & text, doub
   SG_CLAMP_RANGE( volume, 0.0, 1.0 );
   SG_CLAMP_RANGE( speed, 0.0, 1.0 );
   SG_CLAMP_RANGE( pitch, 0.0, 1.0 );
-  HTS_Engine_set_volume( &_engine->engine, _volume );
-  HTS_Engine_set_speed( &_engine->engine, 0.8 + 0.4 * speed );
-  HTS_Engine_add_half_tone(&_engine->engine, -4.0 + 8.0 * pitch );
-
-    
-  ALvoid* data;
-  ALsizei rate, count;
-  if ( FALSE == Flite_HTS_Engine_synthesize_samples_mono16(_engine, text.c_str(), &data, &count, &rate)) return NULL;
-
-  return new SGSoundSample(&data,
-                           count * sizeof(short),
-                           rate,
-                           SG_SAMPLE_MONO16);
-}
 
+  string_list sentences = splitSentences(text);
+  std::vector<PhraseSamplesRef> phrases;
+  SGGuard<SGMutex> g(_engineLock);
+  for( size_t i = 0; i < sentences.size(); ++i ) {
+    phrases.push_back(synthesizePhrase(_engine, _voice, sentences[i], _volume, speed, pitch));
+  }
+
+  return makeSample(phrases);
+}
@@ -21,8 +21,12 @@
 
 #include <simgear/sound/sample.hxx>
 #include <simgear/threads/SGQueue.hxx>
+#include <simgear/threads/SGThread.hxx>
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 struct _Flite_HTS_Engine;
 
 /**
@@ -38,6 +42,23 @@ class SoundSampleReadyListener {
 public:
   virtual ~SoundSampleReadyListener() {}
   virtual void SoundSampleReady( SGSharedPtr<SGSoundSample> ) = 0;
+
+  /**
+   * Called once per sentence, in order, as soon as that sentence has been
+   * synthesized and before SoundSampleReady() delivers the whole text, so
+   * playback can start early. chunk is NULL if a sentence failed, count
+   * is 0 (with a single call) if there was nothing to say. id is the one
+   * of the request the sentence belongs to.
+   * Like SoundSampleReady(), this runs on a synthesizer worker thread.
+   */
+  virtual void SoundSampleChunkReady( SGSharedPtr<SGSoundSample> chunk,
+                                      unsigned index, unsigned count, unsigned id ) {}
+
+  /**
+   * Listeners which only play the chunks return false here, to save
+   * joining all sentences into one sample they do not use.
+   */
+  virtual bool needsWholeSample() const { return true; }
 };
 
 struct SynthesizeRequest {
@@ -46,6 +67,7 @@ struct SynthesizeRequest {
     volume = 1.0;
     pitch = 0.5;
     listener = NULL;
+    id = 0;
   }
   SynthesizeRequest( const SynthesizeRequest & other ) {
     text = other.text;
@@ -53,6 +75,7 @@ struct SynthesizeRequest {
     volume = other.volume;
     pitch = other.pitch;
     listener = other.listener;
+    id = other.id;
   }
 
   SynthesizeRequest & operator = ( const SynthesizeRequest & other ) {
@@ -61,22 +84,28 @@ struct SynthesizeRequest {
     volume = other.volume;
     pitch = other.pitch;
     listener = other.listener;
+    id = other.id;
     return *this;
   }
 
-  // return a special marker request used to indicate the synthesis thread
-  // should be exited.
-  static SynthesizeRequest cancelThreadRequest();
-
   std::string text;
   double speed;
   double volume;
   double pitch;
   SoundSampleReadyListener * listener;
+  unsigned id; // passed back with each chunk
 };
 
 /**
  * A Voice Synthesizer using FLITE+HTS
+ *
+ * Requests are split into sentences which a pool of worker threads, each
+ * with its own engine, synthesizes in parallel. Synthesized sentences are
+ * kept in a cache shared by all voices, so the phrases ATIS and ATC repeat
+ * over and over are only synthesized once.
+ *
+ * A new request supersedes the one before for the same listener: the
+ * sentences of the old one not synthesized yet are dropped.
  */
 class FLITEVoiceSynthesizer : public VoiceSynthesizer {
 public:
@@ -97,13 +126,33 @@ public:
 
   virtual void synthesize( SynthesizeRequest & request );
 private:
-  struct _Flite_HTS_Engine * _engine;
+  struct Utterance;
+  typedef std::shared_ptr<Utterance> UtteranceRef;
+
+  // one sentence of an utterance, or the exit marker if utterance is empty
+  struct ChunkTask {
+    ChunkTask() : index(0) {}
+    UtteranceRef utterance;
+    unsigned index;
+  };
 
   class WorkerThread;
-  WorkerThread * _worker;
+  friend class WorkerThread;
+
+  void chunkDone( const UtteranceRef & utterance, unsigned index );
+
+  std::string _voice;
+
+  // used by the blocking synthesize(), the workers have their own
+  struct _Flite_HTS_Engine * _engine;
+  SGMutex _engineLock;
+
+  std::vector<WorkerThread*> _workers;
+  SGBlockingQueue<ChunkTask> _tasks;
 
-  typedef SGBlockingQueue<SynthesizeRequest> SynthesizeRequestList;
-  SynthesizeRequestList _requests;
+  // the latest utterance of each listener, to cancel when superseded
+  std::map<SoundSampleReadyListener*, std::weak_ptr<Utterance> > _latest;
+  SGMutex _latestLock;
 
   double _volume;
 };
@@ -132,17 +132,27 @@ FGFX::init()
 
     node = root.getNode("fx");
     if(node) {
-        for (int i = 0; i < node->nChildren(); ++i) {
-            SGXmlSound *soundfx = new SGXmlSound();
-  
-            try {
-                soundfx->init( _props, node->getChild(i), this, _avionics,
-                               path.dir() );
-                _sound.push_back( soundfx );
-            } catch ( sg_exception &e ) {
-                SG_LOG(SG_SOUND, SG_ALERT, e.getFormattedMessage());
-                delete soundfx;
-            }
+        init( node, path.dir() );
+    }
+}
+
+
+void
+FGFX::init(SGPropertyNode *fx, const std::string &dir)
+{
+    if (!_smgr || !fx) {
+        return;
+    }
+
+    for (int i = 0; i < fx->nChildren(); ++i) {
+        SGXmlSound *soundfx = new SGXmlSound();
+
+        try {
+            soundfx->init( _props, fx->getChild(i), this, _avionics, dir );
+            _sound.push_back( soundfx );
+        } catch ( sg_exception &e ) {
+            SG_LOG(SG_SOUND, SG_ALERT, e.getFormattedMessage());
+            delete soundfx;
         }
     }
 }
@@ -54,6 +54,14 @@ public:
 
     virtual void init ();
     virtual void reinit ();
+
+    /**
+     * Set up the sounds of an already parsed configuration: the <fx>
+     * node of a sound file, with the samples relative to 'dir'.
+     * AI objects of the same model share it.
+     */
+    void init (SGPropertyNode *fx, const std::string &dir);
+
     virtual void update (double dt);
             void unbind();
 
@@ -26,6 +26,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <map>
 
 #include <simgear/structure/exception.hxx>
 #include <simgear/misc/sg_path.hxx>
@@ -341,7 +342,8 @@ FGElectricalSystem::FGElectricalSystem ( SGPropertyNode *node ) :
     name(node->getStringValue("name", "electrical")),
     num(node->getIntValue("number", 0)),
     path(node->getStringValue("path")),
-    enabled(false)
+    enabled(false),
+    _serviceable_now(false)
 {
 }
 
@@ -417,84 +419,7 @@ void FGElectricalSystem::update (double dt) {
         return;
     }
 
-    // cout << "Updating electrical system, dt = " << dt << endl;
-
-    unsigned int i;
-
-    // zero out the voltage before we start, but don't clear the
-    // requested load values.
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        suppliers[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < buses.size(); ++i ) {
-        buses[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < outputs.size(); ++i ) {
-        outputs[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < connectors.size(); ++i ) {
-        connectors[i]->set_volts( 0.0 );
-    }
-
-    // for each "external" supplier, propagate the electrical current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_EXTERNAL ) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
-    }
-
-    // for each "alternator" supplier, propagate the electrical
-    // current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_ALTERNATOR) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
-    }
-
-    // for each "battery" supplier, propagate the electrical
-    // current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_BATTERY ) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-            // cout << "battery load = " << load << endl;
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
-    }
+    solve( dt );
 
     float alt_norm
         = fgGetFloat("/systems/electrical/suppliers/alternator") / 60.0;
@@ -579,22 +504,253 @@ bool FGElectricalSystem::build (SGPropertyNode* config_props) {
         }
     }
 
+    compile();
     return true;
 }
 
 
+// flatten the component graph into index based arrays, caching the
+// switch and output property nodes so solve() never looks up a path.
+void FGElectricalSystem::compile () {
+    _serviceable = fgGetNode( "/systems/electrical/serviceable", true );
+
+    comp_list all;
+    all.insert( all.end(), suppliers.begin(), suppliers.end() );
+    all.insert( all.end(), buses.begin(), buses.end() );
+    all.insert( all.end(), outputs.begin(), outputs.end() );
+    all.insert( all.end(), connectors.begin(), connectors.end() );
+
+    std::map<FGElectricalComponent *, int> index;
+    for ( unsigned int i = 0; i < all.size(); ++i ) {
+        index[all[i]] = i;
+    }
+
+    _nodes.clear();
+    _node_outputs.clear();
+    _node_switches.clear();
+    _node_props.clear();
+    _roots.clear();
+
+    for ( unsigned int i = 0; i < all.size(); ++i ) {
+        FGElectricalComponent *comp = all[i];
+        CompiledNode n;
+        n.comp = comp;
+        n.kind = comp->get_kind();
+        n.battery = n.kind == FGElectricalComponent::FG_SUPPLIER &&
+            ((FGElectricalSupplier *)comp)->get_model()
+                == FGElectricalSupplier::FG_BATTERY;
+
+        n.first_output = _node_outputs.size();
+        n.num_outputs = comp->get_num_outputs();
+        for ( int j = 0; j < n.num_outputs; ++j ) {
+            _node_outputs.push_back( index[comp->get_output(j)] );
+        }
+
+        n.first_switch = _node_switches.size();
+        n.num_switches = 0;
+        if ( n.kind == FGElectricalComponent::FG_CONNECTOR ) {
+            FGElectricalConnector *c = (FGElectricalConnector *)comp;
+            n.num_switches = c->get_num_switches();
+            for ( int j = 0; j < n.num_switches; ++j ) {
+                _node_switches.push_back( c->get_switch(j).get_node() );
+            }
+        }
+
+        n.first_prop = _node_props.size();
+        n.num_props = comp->get_num_props();
+        for ( int j = 0; j < n.num_props; ++j ) {
+            _node_props.push_back( fgGetNode( comp->get_prop(j).c_str(), true ) );
+        }
+
+        _nodes.push_back( n );
+    }
+
+    // external power first, then alternators, then batteries
+    const FGElectricalSupplier::FGSupplierType order[] = {
+        FGElectricalSupplier::FG_EXTERNAL,
+        FGElectricalSupplier::FG_ALTERNATOR,
+        FGElectricalSupplier::FG_BATTERY
+    };
+    for ( unsigned int m = 0; m < 3; ++m ) {
+        for ( unsigned int i = 0; i < suppliers.size(); ++i ) {
+            if ( ((FGElectricalSupplier *)suppliers[i])->get_model() == order[m] ) {
+                _roots.push_back( i );
+            }
+        }
+    }
+}
+
+
+void FGElectricalSystem::solve( double dt ) {
+    // zero out the voltage before we start, but don't clear the
+    // requested load values.
+    for ( unsigned int i = 0; i < _nodes.size(); ++i ) {
+        _nodes[i].comp->set_volts( 0.0 );
+    }
+
+    _serviceable_now = _serviceable->getBoolValue();
+
+    for ( unsigned int i = 0; i < _roots.size(); ++i ) {
+        FGElectricalSupplier *node =
+            (FGElectricalSupplier *)_nodes[_roots[i]].comp;
+        float load = solve_from( _roots[i], dt,
+                                 node->get_output_volts(),
+                                 node->get_output_amps() );
+
+        if ( node->apply_load( load, dt ) < 0.0 ) {
+            SG_LOG(SG_SYSTEMS, SG_ALERT,
+                   "Error drawing more current than available!");
+        }
+    }
+}
+
+
+// Walk the network below root depth first with an explicit stack,
+// visiting nodes in exactly the order propagate() recurses into them,
+// and return the total current drawn below root.
+float FGElectricalSystem::solve_from( int root, double dt,
+                                      float input_volts, float input_amps ) {
+    float result;
+    _stack.clear();
+    if ( !enter( root, dt, input_volts, input_amps, result ) ) {
+        return result;
+    }
+
+    for ( ;; ) {
+        SolveFrame &frame = _stack.back();
+        const CompiledNode &node = _nodes[frame.node];
+        if ( frame.next_output < node.first_output + node.num_outputs ) {
+            int child = _node_outputs[frame.next_output++];
+            float volts = frame.volts;
+            // send current equal to load
+            if ( enter( child, dt, volts,
+                        _nodes[child].comp->get_load_amps(), result ) ) {
+                continue;
+            }
+            frame.total_load += result;
+            continue;
+        }
+
+        leave( frame );
+        result = frame.total_load;
+        _stack.pop_back();
+        if ( _stack.empty() ) {
+            return result;
+        }
+        _stack.back().total_load += result;
+    }
+}
+
+
+// Start visiting node n. Returns true if a frame was pushed for its
+// outputs, otherwise result holds the load the node presents upstream.
+bool FGElectricalSystem::enter( int n, double dt, float input_volts,
+                                float input_amps, float &result ) {
+    const CompiledNode &node = _nodes[n];
+    float total_load = 0.0;
+
+    // determine the current to carry forward
+    float volts = 0.0;
+    if ( !_serviceable_now ) {
+        volts = 0;
+    } else if ( node.kind == FGElectricalComponent::FG_CONNECTOR ) {
+        volts = input_volts;
+        for ( int i = 0; i < node.num_switches; ++i ) {
+            if ( !_node_switches[node.first_switch + i]->getBoolValue() ) {
+                volts = 0.0;
+                break;
+            }
+        }
+    } else {
+        if ( node.battery ) {
+            FGElectricalSupplier *supplier = (FGElectricalSupplier *)node.comp;
+            float battery_volts = supplier->get_output_volts();
+            if ( battery_volts < (input_volts - 0.1) ) {
+                // special handling of a battery charge condition
+                supplier->apply_load( -supplier->get_charge_amps(), dt );
+                result = supplier->get_charge_amps();
+                return false;
+            }
+        }
+        volts = input_volts;
+        if ( node.kind == FGElectricalComponent::FG_OUTPUT && volts > 1.0 ) {
+            // draw current if we have voltage
+            total_load = node.comp->get_load_amps();
+        }
+    }
+
+    // only a stronger power source than seen so far is propagated
+    if ( !(volts > node.comp->get_volts()) ) {
+        result = 0.0;
+        return false;
+    }
+
+    node.comp->set_volts( volts );
+    SolveFrame frame = { n, input_amps, volts, total_load, node.first_output };
+    _stack.push_back( frame );
+    return true;
+}
+
+
+// all outputs of the frame's node are done, record and publish the result
+void FGElectricalSystem::leave( const SolveFrame &frame ) {
+    const CompiledNode &node = _nodes[frame.node];
+
+    // if not an output node, register the downstream current draw
+    // (sum of all children) with this node.
+    if ( node.kind != FGElectricalComponent::FG_OUTPUT ) {
+        node.comp->set_load_amps( frame.total_load );
+    }
+
+    node.comp->set_available_amps( frame.input_amps - frame.total_load );
+
+    for ( int i = 0; i < node.num_props; ++i ) {
+        _node_props[node.first_prop + i]->setFloatValue( frame.volts );
+    }
+}
+
+
+void FGElectricalSystem::solve_recursive( double dt ) {
+    unsigned int i;
+
+    // zero out the voltage before we start, but don't clear the
+    // requested load values.
+    for ( i = 0; i < suppliers.size(); ++i ) {
+        suppliers[i]->set_volts( 0.0 );
+    }
+    for ( i = 0; i < buses.size(); ++i ) {
+        buses[i]->set_volts( 0.0 );
+    }
+    for ( i = 0; i < outputs.size(); ++i ) {
+        outputs[i]->set_volts( 0.0 );
+    }
+    for ( i = 0; i < connectors.size(); ++i ) {
+        connectors[i]->set_volts( 0.0 );
+    }
+
+    for ( i = 0; i < _roots.size(); ++i ) {
+        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[_roots[i]];
+        float load = propagate( node, dt,
+                                node->get_output_volts(),
+                                node->get_output_amps() );
+
+        if ( node->apply_load( load, dt ) < 0.0 ) {
+            SG_LOG(SG_SYSTEMS, SG_ALERT,
+                   "Error drawing more current than available!");
+        }
+    }
+}
+
+
 // propagate the electrical current through the network, returns the
 // total current drawn by the children of this node.
 float FGElectricalSystem::propagate( FGElectricalComponent *node, double dt,
-                                     float input_volts, float input_amps,
-                                     string s ) {
-    s += " ";
-
+                                     float input_volts, float input_amps ) {
     float total_load = 0.0;
 
     // determine the current to carry forward
     float volts = 0.0;
-    if ( !fgGetBool("/systems/electrical/serviceable") ) {
+    if ( !_serviceable->getBoolValue() ) {
         volts = 0;
     } else if ( node->get_kind() == FGElectricalComponent::FG_SUPPLIER ) {
         // cout << s << "is a supplier (" << node->get_name() << ")" << endl;
@@ -644,8 +800,7 @@ float FGElectricalSystem::propagate( FGElectricalComponent *node, double dt,
             FGElectricalComponent *child = node->get_output(i);
             // send current equal to load
             total_load += propagate( child, dt,
-                                     volts, child->get_load_amps(),
-                                     s );
+                                     volts, child->get_load_amps() );
         }
 
         // if not an output node, register the downstream current draw
@@ -205,6 +205,7 @@ public:
 
     inline bool get_state() const { return switch_node->getBoolValue(); }
     void set_state( bool val ) { switch_node->setBoolValue( val ); }
+    inline SGPropertyNode *get_node() const { return switch_node; }
 };
 
 
@@ -230,6 +231,11 @@ public:
     void set_switches( bool state );
 
     bool get_state();
+
+    inline int get_num_switches() const { return switches.size(); }
+    inline const FGElectricalSwitch& get_switch( const int i ) const {
+        return switches[i];
+    }
 };
 
 
@@ -252,9 +258,16 @@ public:
     virtual void update (double dt);
 
     bool build (SGPropertyNode* config_props);
+
+    // solve the compiled network, this is what update() uses
+    void solve( double dt );
+
+    // solve by recursively propagating from each supplier in turn.
+    // Kept as the reference model solve() has to match.
+    void solve_recursive( double dt );
     float propagate( FGElectricalComponent *node, double dt,
-                     float input_volts, float input_amps,
-                     string s = "" );
+                     float input_volts, float input_amps );
+
     FGElectricalComponent *find ( const string &name );
 
 protected:
@@ -263,6 +276,34 @@ protected:
 
 private:
 
+    // The network flattened into index based arrays by compile().
+    // Outputs, switches and published properties of node i are the
+    // ranges [first, first + num) of the matching arrays.
+    struct CompiledNode {
+        FGElectricalComponent *comp;
+        int kind;
+        bool battery;
+        int first_output, num_outputs;
+        int first_switch, num_switches;
+        int first_prop, num_props;
+    };
+
+    // one level of the depth first walk in solve()
+    struct SolveFrame {
+        int node;
+        float input_amps;
+        float volts;
+        float total_load;
+        int next_output;
+    };
+
+    void compile();
+    float solve_from( int root, double dt, float input_volts,
+                      float input_amps );
+    bool enter( int n, double dt, float input_volts, float input_amps,
+                float &result );
+    void leave( const SolveFrame &frame );
+
     string name;
     int num;
     string path;
@@ -274,8 +315,17 @@ private:
     comp_list outputs;
     comp_list connectors;
 
+    SGPropertyNode_ptr _serviceable;
     SGPropertyNode_ptr _volts_out;
     SGPropertyNode_ptr _amps_out;
+
+    vector<CompiledNode> _nodes;
+    vector<int> _node_outputs;
+    vector<SGPropertyNode *> _node_switches;
+    vector<SGPropertyNode_ptr> _node_props;
+    vector<int> _roots;         // suppliers in propagation order
+    vector<SolveFrame> _stack;
+    bool _serviceable_now;
 };
 
 
@@ -50,6 +50,7 @@
 #include <AIModel/AIManager.hxx>
 #include <AIModel/AIAircraft.hxx>
 #include <Airports/airport.hxx>
+#include <Airports/airportdynamicsmanager.hxx>
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
 
@@ -316,6 +317,14 @@ bool FGAISchedule::update(time_t now, const SGVec3d& userCart)
   SG_LOG (SG_AI, SG_BULK, "Traffic manager: " << registration << " is scheduled for a flight from "
 	     << dep->getId() << " to " << arr->getId() << ". Current distance to user: " 
              << distanceToUser);
+
+  // have the ground networks ready by the time the aircraft is created,
+  // rather than loading them in the frame which creates it
+  if (distanceToUser < TRAFFICTOAIDISTTOPREFETCH) {
+    flightgear::AirportDynamicsManager::prefetch(dep);
+    flightgear::AirportDynamicsManager::prefetch(arr);
+  }
+
   if (distanceToUser >= TRAFFICTOAIDISTTOSTART) {
     return true; // out of visual range, for the moment.
   }
@@ -31,6 +31,7 @@
 
 #define TRAFFICTOAIDISTTOSTART 150.0
 #define TRAFFICTOAIDISTTODIE   200.0
+#define TRAFFICTOAIDISTTOPREFETCH 200.0
 
 // forward decls
 class FGAIAircraft;
@@ -0,0 +1,182 @@
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <AIModel/AIProximityGrid.hxx>
+
+// the grid only keeps pointers, so a stand-in will do
+class FGAIBase
+{
+public:
+    SGVec3d pos;
+    SGVec3d velocity;
+};
+
+// traffic in a box of 200km around a point over Europe
+static const SGVec3d areaCenter(4.2e6, 0.9e6, 4.7e6);
+static const double areaSizeM = 200000;
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * (std::rand() / (RAND_MAX + 1.0));
+}
+
+static void makeTraffic(unsigned n, std::vector<FGAIBase>& objects)
+{
+    objects.resize(n);
+    for (FGAIBase& object : objects) {
+        // half of it around the airport in the middle
+        double spread = (std::rand() % 2) ? 0.05 : 0.5;
+        for (int i = 0; i < 3; ++i) {
+            object.pos[i] = areaCenter[i] + uniform(-spread, spread) * areaSizeM;
+            object.velocity[i] = uniform(-150, 150);
+        }
+    }
+}
+
+static void move(std::vector<FGAIBase>& objects, double dt, FGAIProximityGrid& grid)
+{
+    for (FGAIBase& object : objects) {
+        object.pos += dt * object.velocity;
+        grid.set(&object, object.pos);
+    }
+}
+
+static void bruteForceInRange(std::vector<FGAIBase>& objects, const SGVec3d& pos,
+                              double radiusM, std::vector<FGAIBase*>& result)
+{
+    result.clear();
+    for (FGAIBase& object : objects) {
+        if (dist(pos, object.pos) <= radiusM)
+            result.push_back(&object);
+    }
+}
+
+static void testResults()
+{
+    std::vector<FGAIBase> objects;
+    makeTraffic(3000, objects);
+
+    FGAIProximityGrid grid;
+    move(objects, 0, grid);
+    SG_CHECK_EQUAL(grid.size(), objects.size());
+
+    std::vector<FGAIBase*> found, expected;
+    for (int step = 0; step < 50; ++step) {
+        move(objects, 1.0, grid);
+
+        for (int q = 0; q < 20; ++q) {
+            const FGAIBase& from = objects[std::rand() % objects.size()];
+            double radiusM = uniform(100, 30000);
+
+            grid.findInRange(from.pos, radiusM, found);
+            bruteForceInRange(objects, from.pos, radiusM, expected);
+            std::sort(found.begin(), found.end());
+            std::sort(expected.begin(), expected.end());
+            SG_VERIFY(found == expected);
+
+            // nearest first, and none closer left out
+            size_t k = 1 + std::rand() % 8;
+            grid.findNearest(from.pos, k, 50000, found);
+            bruteForceInRange(objects, from.pos, 50000, expected);
+            SG_CHECK_EQUAL(found.size(), std::min(k, expected.size()));
+            std::vector<double> expectedDist;
+            for (FGAIBase* object : expected)
+                expectedDist.push_back(dist(from.pos, object->pos));
+            std::sort(expectedDist.begin(), expectedDist.end());
+            for (size_t i = 0; i < found.size(); ++i)
+                SG_CHECK_EQUAL_EP2(dist(from.pos, found[i]->pos), expectedDist[i], 1e-6);
+        }
+    }
+
+    // removed objects are not found any more, the others still are
+    for (size_t i = 0; i < objects.size(); i += 3)
+        grid.remove(&objects[i]);
+    grid.findInRange(areaCenter, 2 * areaSizeM, found);
+    SG_CHECK_EQUAL(found.size(), grid.size());
+    SG_CHECK_EQUAL(grid.size(), objects.size() - (objects.size() + 2) / 3);
+    for (FGAIBase* object : found)
+        SG_VERIFY((object - &objects[0]) % 3 != 0);
+
+    grid.clear();
+    grid.findNearest(areaCenter, 4, 1e7, found);
+    SG_VERIFY(found.empty());
+}
+
+static void benchmark(unsigned numObjects, double radiusM)
+{
+    const int steps = 20;
+    const unsigned queriesPerStep = 1000;
+    std::vector<FGAIBase> objects;
+    makeTraffic(numObjects, objects);
+
+    FGAIProximityGrid grid;
+    move(objects, 0, grid);
+    std::vector<FGAIBase*> found;
+    size_t sink = 0;
+
+    // every object moving, as FGAIManager::update() does
+    SGTimeStamp st;
+    st.stamp();
+    for (int step = 0; step < steps; ++step)
+        move(objects, 0.05, grid);
+    double updateUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    st.stamp();
+    for (int step = 0; step < steps; ++step) {
+        for (unsigned q = 0; q < queriesPerStep; ++q) {
+            bruteForceInRange(objects, objects[q % numObjects].pos, radiusM, found);
+            sink += found.size();
+        }
+    }
+    double bruteUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    st.stamp();
+    for (int step = 0; step < steps; ++step) {
+        for (unsigned q = 0; q < queriesPerStep; ++q) {
+            grid.findInRange(objects[q % numObjects].pos, radiusM, found);
+            sink += found.size();
+        }
+    }
+    double gridUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    st.stamp();
+    for (int step = 0; step < steps; ++step) {
+        for (unsigned q = 0; q < queriesPerStep; ++q) {
+            grid.findNearest(objects[q % numObjects].pos, 4, radiusM, found);
+            sink += found.size();
+        }
+    }
+    double nearestUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    double queries = double(steps) * queriesPerStep;
+    std::cout << numObjects << " objects, " << radiusM << "m radius: "
+              << updateUSec / (double(steps) * numObjects) << " usec per update, "
+              << bruteUSec / queries << " usec per query scanning all, "
+              << gridUSec / queries << " with the grid, "
+              << nearestUSec / queries << " for the 4 nearest"
+              << " (" << (sink != 0) << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::srand(42);
+    testResults();
+
+    // submodel collisions, then wake and parking
+    benchmark(500, 500);
+    benchmark(2000, 500);
+    benchmark(8000, 500);
+    benchmark(500, 10000);
+    benchmark(2000, 10000);
+    benchmark(8000, 10000);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#include "config.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/props/props_io.hxx>
+
+#include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
+#include <Systems/electrical.hxx>
+
+// A small single engine network in the style of the c172p electrical.xml,
+// plus a second battery bus fed from two sides to exercise the
+// strongest-source rule and the battery charge path.
+static const char* sampleNetwork =
+"<?xml version=\"1.0\"?>\n"
+"<PropertyList>\n"
+" <supplier><name>Battery 1</name><prop>/systems/electrical/suppliers/battery[0]</prop>"
+"  <kind>battery</kind><volts>24</volts><amps>60</amps></supplier>\n"
+" <supplier><name>Battery 2</name><prop>/systems/electrical/suppliers/battery[1]</prop>"
+"  <kind>battery</kind><volts>24</volts><amp-hours>20</amp-hours></supplier>\n"
+" <supplier><name>Alternator 1</name><prop>/systems/electrical/suppliers/alternator</prop>"
+"  <kind>alternator</kind><rpm-source>/engines/engine[0]/rpm</rpm-source>"
+"  <rpm-threshold>800</rpm-threshold><volts>28</volts><amps>60</amps></supplier>\n"
+" <supplier><name>External</name><prop>/systems/electrical/suppliers/external</prop>"
+"  <kind>external</kind><volts>28</volts><amps>100</amps></supplier>\n"
+" <bus><name>Master Bus</name><prop>/systems/electrical/outputs/bus</prop></bus>\n"
+" <bus><name>Avionics Bus</name><prop>/systems/electrical/outputs/avionics-bus</prop></bus>\n"
+" <bus><name>Standby Bus</name><prop>/systems/electrical/outputs/standby-bus</prop></bus>\n"
+" <output><name>Starter</name><prop>/systems/electrical/outputs/starter</prop>"
+"  <rated-draw>50</rated-draw></output>\n"
+" <output><name>Nav Lights</name><prop>/systems/electrical/outputs/nav-lights</prop>"
+"  <prop>/systems/electrical/outputs/nav-lights-norm</prop><rated-draw>3</rated-draw></output>\n"
+" <output><name>Radio</name><prop>/systems/electrical/outputs/comm</prop></output>\n"
+" <output><name>Standby Horizon</name><prop>/systems/electrical/outputs/standby-horizon</prop>"
+"  <rated-draw>1.5</rated-draw></output>\n"
+" <connector><input>Battery 1</input><output>Master Bus</output>"
+"  <switch><prop>/controls/engines/engine[0]/master-bat</prop></switch></connector>\n"
+" <connector><input>Alternator 1</input><output>Master Bus</output>"
+"  <switch><prop>/controls/engines/engine[0]/master-alt</prop></switch></connector>\n"
+" <connector><input>External</input><output>Master Bus</output>"
+"  <switch><prop>/controls/electric/external-power</prop><initial-state>off</initial-state></switch></connector>\n"
+" <connector><input>Master Bus</input><output>Battery 1</output>"
+"  <switch><prop>/controls/engines/engine[0]/master-bat</prop></switch></connector>\n"
+" <connector><input>Master Bus</input><output>Starter</output>"
+"  <switch><prop>/controls/switches/starter</prop><initial-state>off</initial-state></switch></connector>\n"
+" <connector><input>Master Bus</input><output>Nav Lights</output>"
+"  <switch><prop>/controls/switches/nav-lights</prop></switch>"
+"  <switch><prop>/controls/circuit-breakers/navlights</prop></switch></connector>\n"
+" <connector><input>Master Bus</input><output>Avionics Bus</output>"
+"  <switch><prop>/controls/switches/avionics-master</prop></switch></connector>\n"
+" <connector><input>Avionics Bus</input><output>Radio</output></connector>\n"
+" <connector><input>Master Bus</input><output>Standby Bus</output>"
+"  <switch><prop>/controls/switches/standby-feed</prop></switch></connector>\n"
+" <connector><input>Battery 2</input><output>Standby Bus</output>"
+"  <switch><prop>/controls/switches/standby-battery</prop></switch></connector>\n"
+" <connector><input>Standby Bus</input><output>Battery 2</output></connector>\n"
+" <connector><input>Standby Bus</input><output>Standby Horizon</output></connector>\n"
+"</PropertyList>\n";
+
+static const char* componentNames[] = {
+    "Battery 1", "Battery 2", "Alternator 1", "External",
+    "Master Bus", "Avionics Bus", "Standby Bus",
+    "Starter", "Nav Lights", "Radio", "Standby Horizon"
+};
+
+static FGElectricalSystem* makeSystem()
+{
+    SGPropertyNode_ptr config(new SGPropertyNode);
+    readProperties(sampleNetwork, strlen(sampleNetwork), config);
+
+    SGPropertyNode_ptr systemNode(new SGPropertyNode);
+    FGElectricalSystem* system = new FGElectricalSystem(systemNode);
+    SG_VERIFY(system->build(config));
+    return system;
+}
+
+// flip the switches and the engine through a sequence of states, and
+// check the compiled solver tracks the recursive one exactly
+void testMatchesRecursive()
+{
+    FGElectricalSystem* compiled = makeSystem();
+    FGElectricalSystem* recursive = makeSystem();
+
+    const double dt = 1.0 / 120;
+    for (int step = 0; step < 2400; ++step) {
+        fgSetBool("/systems/electrical/serviceable", (step / 50) % 23 != 7);
+        fgSetDouble("/engines/engine[0]/rpm", (step % 600) * 2.5);
+        fgSetBool("/controls/engines/engine[0]/master-bat", (step / 100) % 7 != 3);
+        fgSetBool("/controls/engines/engine[0]/master-alt", (step / 150) % 3 != 1);
+        fgSetBool("/controls/electric/external-power", (step / 400) % 2 == 1);
+        fgSetBool("/controls/switches/starter", (step % 500) < 40);
+        fgSetBool("/controls/switches/nav-lights", (step / 70) % 2 == 0);
+        fgSetBool("/controls/circuit-breakers/navlights", (step / 900) % 2 == 0);
+        fgSetBool("/controls/switches/avionics-master", (step / 130) % 2 == 0);
+        fgSetBool("/controls/switches/standby-feed", (step / 210) % 2 == 0);
+        fgSetBool("/controls/switches/standby-battery", (step / 330) % 2 == 0);
+
+        recursive->solve_recursive(dt);
+        compiled->solve(dt);
+
+        for (const char* name : componentNames) {
+            FGElectricalComponent* a = compiled->find(name);
+            FGElectricalComponent* b = recursive->find(name);
+            SG_VERIFY(a && b);
+            SG_CHECK_EQUAL(a->get_volts(), b->get_volts());
+            SG_CHECK_EQUAL(a->get_load_amps(), b->get_load_amps());
+            SG_CHECK_EQUAL(a->get_available_amps(), b->get_available_amps());
+        }
+
+        for (const char* name : { "Battery 1", "Battery 2" }) {
+            FGElectricalSupplier* a = (FGElectricalSupplier*) compiled->find(name);
+            FGElectricalSupplier* b = (FGElectricalSupplier*) recursive->find(name);
+            SG_CHECK_EQUAL(a->get_output_volts(), b->get_output_volts());
+        }
+    }
+
+    delete compiled;
+    delete recursive;
+}
+
+// spot check the published values for a simple configuration
+void testPublishedValues()
+{
+    FGElectricalSystem* system = makeSystem();
+
+    fgSetBool("/systems/electrical/serviceable", true);
+    fgSetDouble("/engines/engine[0]/rpm", 2000.0);
+    fgSetBool("/controls/engines/engine[0]/master-bat", true);
+    fgSetBool("/controls/engines/engine[0]/master-alt", true);
+    fgSetBool("/controls/electric/external-power", false);
+    fgSetBool("/controls/switches/starter", false);
+    fgSetBool("/controls/switches/nav-lights", true);
+    fgSetBool("/controls/circuit-breakers/navlights", true);
+    fgSetBool("/controls/switches/avionics-master", false);
+    fgSetBool("/controls/switches/standby-feed", true);
+    fgSetBool("/controls/switches/standby-battery", true);
+
+    system->solve(0.01);
+
+    // the alternator wins over the battery and charges it
+    SG_CHECK_EQUAL(fgGetFloat("/systems/electrical/outputs/bus"), 28.0f);
+    SG_CHECK_EQUAL(fgGetFloat("/systems/electrical/outputs/nav-lights"), 28.0f);
+    SG_CHECK_EQUAL(fgGetFloat("/systems/electrical/outputs/nav-lights-norm"), 28.0f);
+    SG_CHECK_EQUAL(fgGetFloat("/systems/electrical/outputs/standby-bus"), 28.0f);
+    SG_CHECK_EQUAL(fgGetFloat("/systems/electrical/outputs/standby-horizon"), 28.0f);
+    SG_CHECK_EQUAL(system->find("Avionics Bus")->get_volts(), 0.0f);
+    SG_CHECK_EQUAL(system->find("Starter")->get_volts(), 0.0f);
+    SG_CHECK_EQUAL(system->find("Nav Lights")->get_load_amps(), 3.0f);
+
+    // nothing flows with the system failed
+    fgSetBool("/systems/electrical/serviceable", false);
+    system->solve(0.01);
+    for (const char* name : componentNames) {
+        SG_CHECK_EQUAL(system->find(name)->get_volts(), 0.0f);
+    }
+
+    delete system;
+}
+
+int main(int argc, char* argv[])
+{
+    globals = new FGGlobals;
+
+    testMatchesRecursive();
+    testPublishedValues();
+
+    delete globals;
+    return EXIT_SUCCESS;
+}
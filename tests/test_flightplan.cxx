@@ -134,6 +134,65 @@ void testRoutePathTrivialFlightPlan()
     SG_CHECK_EQUAL_EP(0.0, fp1->totalDistanceNm());
 }
 
+// the cached path of the plan, updated incrementally, must match a path
+// computed from scratch
+static void checkSameAsFreshPath(FlightPlanRef fp)
+{
+    const RoutePath& cached(fp->routePath());
+    RoutePath fresh(fp);
+
+    for (int leg = 0; leg < fp->numLegs(); ++leg) {
+        SG_CHECK_EQUAL(cached.trackForIndex(leg), fresh.trackForIndex(leg));
+        SG_CHECK_EQUAL(cached.distanceForIndex(leg), fresh.distanceForIndex(leg));
+
+        SGGeod a = cached.positionForIndex(leg), b = fresh.positionForIndex(leg);
+        SG_CHECK_EQUAL(a.getLatitudeDeg(), b.getLatitudeDeg());
+        SG_CHECK_EQUAL(a.getLongitudeDeg(), b.getLongitudeDeg());
+        SG_CHECK_EQUAL(cached.pathForIndex(leg).size(), fresh.pathForIndex(leg).size());
+    }
+}
+
+void testRoutePathIncremental()
+{
+    FlightPlanRef fp1 = makeTestFP("EGHI", "20", "EDDM", "08L",
+                                   "SFD LYD BNE CIV ELLX LUX SAA KRH WLD");
+    checkSameAsFreshPath(fp1);
+
+    // no change, no recomputation
+    unsigned int rev = fp1->revision();
+    const RoutePath* path = &fp1->routePath();
+    SG_CHECK_EQUAL(fp1->revision(), rev);
+    SG_VERIFY(path == &fp1->routePath());
+
+    fp1->insertWayptAtIndex(fp1->waypointFromString("CLN"), 2);
+    SG_VERIFY(fp1->revision() != rev);
+    checkSameAsFreshPath(fp1);
+
+    fp1->deleteIndex(5);
+    checkSameAsFreshPath(fp1);
+
+    fp1->insertWayptAtIndex(fp1->waypointFromString("TNT"), 0);
+    checkSameAsFreshPath(fp1);
+
+    fp1->insertWayptAtIndex(fp1->waypointFromString("FFM"), -1);
+    checkSameAsFreshPath(fp1);
+
+    fp1->deleteIndex(-1);
+    fp1->deleteIndex(0);
+    checkSameAsFreshPath(fp1);
+
+    fp1->legAtIndex(3)->waypoint()->setFlag(WPT_OVERFLIGHT, true);
+    fp1->legAtIndex(3)->markModified();
+    checkSameAsFreshPath(fp1);
+
+    fp1->setIcaoAircraftCategory("A");
+    checkSameAsFreshPath(fp1);
+    SG_VERIFY(path == &fp1->routePath());
+
+    fp1->clear();
+    checkSameAsFreshPath(fp1);
+}
+
 int main(int argc, char* argv[])
 {
     fgtest::initTestGlobals("flightplan");
@@ -142,6 +201,7 @@ int main(int argc, char* argv[])
     testRoutePathBasic();
     testRoutePathSkipped();
     testRoutePathTrivialFlightPlan();
+    testRoutePathIncremental();
     
     fgtest::shutdownTestGlobals();
 }
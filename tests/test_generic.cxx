@@ -0,0 +1,273 @@
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+
+#include <simgear/io/iochannel.hxx>
+#include <simgear/math/SGMath.hxx>
+#include <simgear/misc/sg_dir.hxx>
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
+#include <Network/generic.hxx>
+
+// hands every written record to the next read, like a datagram socket
+class MemoryChannel : public SGIOChannel {
+public:
+    MemoryChannel() { set_type(sgSocketType); }
+
+    virtual bool open(const SGProtocolDir d) { set_dir(d); return true; }
+    virtual bool close() { return true; }
+
+    virtual int read(char* buf, int length)
+    {
+        if (records.empty()) {
+            return 0;
+        }
+        int n = std::min((int) records.front().size(), length);
+        memcpy(buf, records.front().data(), n);
+        records.pop_front();
+        return n;
+    }
+
+    virtual int readline(char* buf, int length)
+    {
+        int n = read(buf, length - 1);
+        buf[n] = 0;
+        return n;
+    }
+
+    virtual int write(const char* buf, const int length)
+    {
+        records.push_back(std::string(buf, length));
+        return length;
+    }
+
+    std::deque<std::string> records;
+};
+
+static const int numFields = 350;
+static const char* typeNames[] = {
+    "int", "float", "double", "bool", "fixed", "byte", "word"
+};
+
+static const char* asciiFormat(int i)
+{
+    switch (i % 7) {
+    case 1:  return (i % 2) ? "%.3f" : "f=%f;";
+    case 2:  return (i % 3) ? "%.9f" : "%10.4f";   // the latter via snprintf
+    case 4:  return "%.1f";
+    default: return "%d";
+    }
+}
+
+static void writeProtocol(const SGPath& path, bool binary)
+{
+    std::ofstream out(path.local8BitStr().c_str());
+    out << "<?xml version=\"1.0\"?>\n<PropertyList>\n<generic>\n";
+    for (const char* dir : { "output", "input" }) {
+        out << "<" << dir << ">\n";
+        if (binary) {
+            out << "<binary_mode>true</binary_mode>\n";
+        } else {
+            out << "<var_separator>,</var_separator>\n"
+                << "<line_separator>newline</line_separator>\n";
+        }
+        for (int i = 0; i < numFields; ++i) {
+            out << "<chunk><type>" << typeNames[i % 7] << "</type>"
+                << "<node>/bench/" << dir << "/field[" << i << "]</node>";
+            if (!binary) {
+                out << "<format>" << asciiFormat(i) << "</format>";
+            }
+            out << "</chunk>\n";
+        }
+        out << "</" << dir << ">\n";
+    }
+    out << "</generic>\n</PropertyList>\n";
+}
+
+static void setOutputs(int frame)
+{
+    SGPropertyNode* bench = fgGetNode("/bench/output", true);
+    for (int i = 0; i < numFields; ++i) {
+        SGPropertyNode* field = bench->getChild("field", i, true);
+        switch (i % 7) {
+        case 0: field->setIntValue(i * 7 - 1000 + frame); break;
+        case 1: field->setDoubleValue(i * 0.25 - 30.0 + frame); break;
+        case 2: field->setDoubleValue(i * 1.37e-3 - 0.12345678 + frame); break;
+        case 3: field->setBoolValue((i + frame) % 3 == 0); break;
+        case 4: field->setDoubleValue(i * 0.5 - 60.0); break;
+        case 5: field->setIntValue((i + frame) % 200 - 100); break;
+        case 6: field->setIntValue(i * 3 - 400 + frame); break;
+        }
+    }
+}
+
+static FGGeneric* makeProtocol(const std::string& config, const char* dir,
+                               MemoryChannel* channel)
+{
+    vector<string> tokens = { "generic", "socket", dir, "1000", "", "", "", config };
+    FGGeneric* generic = new FGGeneric(tokens);
+    SG_VERIFY(generic->getInitOk());
+    generic->set_direction(dir);
+    generic->set_io_channel(channel);
+    SG_VERIFY(generic->open());
+    return generic;
+}
+
+void testBinaryRoundTrip()
+{
+    MemoryChannel outChannel, inChannel;
+    FGGeneric* out = makeProtocol("bench-binary", "out", &outChannel);
+    FGGeneric* in = makeProtocol("bench-binary", "in", &inChannel);
+
+    for (int frame = 0; frame < 3; ++frame) {
+        setOutputs(frame);
+        SG_VERIFY(out->process());
+        SG_CHECK_EQUAL(outChannel.records.size(), 1u);
+        SG_CHECK_EQUAL(outChannel.records.front().size(), 50u * 24);
+
+        inChannel.records.swap(outChannel.records);
+        SG_VERIFY(in->process());
+
+        SGPropertyNode* sent = fgGetNode("/bench/output");
+        SGPropertyNode* received = fgGetNode("/bench/input");
+        for (int i = 0; i < numFields; ++i) {
+            SGPropertyNode* a = sent->getChild("field", i);
+            SGPropertyNode* b = received->getChild("field", i);
+            switch (i % 7) {
+            case 2:
+                SG_CHECK_EQUAL(a->getDoubleValue(), b->getDoubleValue());
+                break;
+            case 3:
+                SG_CHECK_EQUAL(a->getBoolValue(), b->getBoolValue());
+                break;
+            default:
+                SG_CHECK_EQUAL(a->getFloatValue(), b->getFloatValue());
+                break;
+            }
+        }
+    }
+
+    // network byte order on the wire
+    setOutputs(0);
+    SG_VERIFY(out->process());
+    const std::string& record = outChannel.records.front();
+    SG_CHECK_EQUAL((int)(unsigned char) record[0], 0xff);
+    SG_CHECK_EQUAL((int)(unsigned char) record[3], 0x18);  // -1000
+
+    delete out;
+    delete in;
+}
+
+void testAsciiMatchesPrintf()
+{
+    MemoryChannel outChannel, inChannel;
+    FGGeneric* out = makeProtocol("bench-ascii", "out", &outChannel);
+    FGGeneric* in = makeProtocol("bench-ascii", "in", &inChannel);
+
+    for (int frame = 0; frame < 3; ++frame) {
+        setOutputs(frame);
+        SG_VERIFY(out->process());
+
+        // what the per field snprintf() produced
+        SGPropertyNode* sent = fgGetNode("/bench/output");
+        std::string expected;
+        char tmp[255];
+        for (int i = 0; i < numFields; ++i) {
+            SGPropertyNode* field = sent->getChild("field", i);
+            switch (i % 7) {
+            case 1:
+            case 4:
+                snprintf(tmp, 255, asciiFormat(i), field->getFloatValue());
+                break;
+            case 2:
+                snprintf(tmp, 255, asciiFormat(i), field->getDoubleValue());
+                break;
+            case 3:
+                snprintf(tmp, 255, asciiFormat(i), field->getBoolValue());
+                break;
+            default:
+                snprintf(tmp, 255, asciiFormat(i), (int) field->getFloatValue());
+                break;
+            }
+            if (i > 0) {
+                expected += ",";
+            }
+            expected += tmp;
+        }
+        expected += "\n";
+        SG_CHECK_EQUAL(outChannel.records.front(), expected);
+
+        inChannel.records.swap(outChannel.records);
+        SG_VERIFY(in->process());
+        SGPropertyNode* received = fgGetNode("/bench/input");
+        for (int i = 0; i < numFields; i += 7) {
+            SG_CHECK_EQUAL(sent->getChild("field", i)->getIntValue(),
+                           received->getChild("field", i)->getIntValue());
+        }
+    }
+
+    delete out;
+    delete in;
+}
+
+void benchmark(const std::string& config)
+{
+    const int iterations = 2000;
+    MemoryChannel outChannel, inChannel;
+    FGGeneric* out = makeProtocol(config, "out", &outChannel);
+    FGGeneric* in = makeProtocol(config, "in", &inChannel);
+    setOutputs(0);
+
+    SGTimeStamp st;
+    st.stamp();
+    for (int i = 0; i < iterations; ++i) {
+        out->process();
+        outChannel.records.clear();
+    }
+    const double encodeMSec = st.elapsedMSec();
+
+    out->process();
+    const std::string record = outChannel.records.front();
+    st.stamp();
+    for (int i = 0; i < iterations; ++i) {
+        inChannel.records.push_back(record);
+        in->process();
+    }
+    const double decodeMSec = st.elapsedMSec();
+
+    std::cout << config << ": " << numFields << " fields, encode "
+              << iterations * 1000.0 / encodeMSec << " Hz, decode "
+              << iterations * 1000.0 / decodeMSec << " Hz" << std::endl;
+
+    delete out;
+    delete in;
+}
+
+int main(int argc, char* argv[])
+{
+    globals = new FGGlobals;
+
+    simgear::Dir root = simgear::Dir::tempDir("fgtest");
+    SGPath protocolDir = root.path();
+    protocolDir.append("Protocol");
+    simgear::Dir(protocolDir).create(0755);
+    writeProtocol(SGPath(protocolDir.str() + "/bench-binary.xml"), true);
+    writeProtocol(SGPath(protocolDir.str() + "/bench-ascii.xml"), false);
+    globals->set_fg_root(root.path().str());
+
+    testBinaryRoundTrip();
+    testAsciiMatchesPrintf();
+    benchmark("bench-binary");
+    benchmark("bench-ascii");
+
+    root.remove(true);
+    delete globals;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+#include "config.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <simgear/constants.h>
+#include <simgear/math/SGMath.hxx>
+#include <simgear/math/SGGeometry.hxx>
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/timing/timestamp.hxx>
+#include <simgear/bvh/BVHGroup.hxx>
+#include <simgear/bvh/BVHMaterial.hxx>
+#include <simgear/bvh/BVHTransform.hxx>
+#include <simgear/bvh/BVHMotionTransform.hxx>
+#include <simgear/bvh/BVHStaticGeometryBuilder.hxx>
+#include <simgear/bvh/BVHLineSegmentVisitor.hxx>
+#include <simgear/structure/SGSharedPtr.hxx>
+
+#include <FDM/groundquery.hxx>
+
+using namespace simgear;
+
+// a tile of rolling terrain, 256x256 cells of 10m, below a moving deck
+static const int gridSize = 256;
+static const double cellSize = 10;
+static const SGVec3d tileCenter(4.2e6, 0.9e6, 4.7e6);
+static const SGVec3d deckCenter(500, 600, 40);
+static const SGVec3d deckVelocity(8, 2, 0);
+static const BVHNode::Id deckId = 42;
+
+static BVHMaterial terrainMaterial;
+static BVHMaterial deckMaterial;
+
+static float terrainHeight(double x, double y)
+{
+    return 20*sin(x/97)*cos(y/131) + 3*sin(x/13 + y/17);
+}
+
+static BVHNode* buildTerrain()
+{
+    BVHStaticGeometryBuilder builder;
+    builder.setCurrentMaterial(&terrainMaterial);
+    for (int i = 0; i < gridSize; ++i) {
+        for (int j = 0; j < gridSize; ++j) {
+            double x0 = i*cellSize, x1 = x0 + cellSize;
+            double y0 = j*cellSize, y1 = y0 + cellSize;
+            SGVec3f a(x0, y0, terrainHeight(x0, y0));
+            SGVec3f b(x1, y0, terrainHeight(x1, y0));
+            SGVec3f c(x1, y1, terrainHeight(x1, y1));
+            SGVec3f d(x0, y1, terrainHeight(x0, y1));
+            builder.addTriangle(a, b, c);
+            builder.addTriangle(a, c, d);
+        }
+    }
+    return builder.buildTree();
+}
+
+static BVHNode* buildDeck()
+{
+    BVHStaticGeometryBuilder builder;
+    builder.setCurrentMaterial(&deckMaterial);
+    SGVec3f a(-150, -40, 0), b(150, -40, 0), c(150, 40, 0), d(-150, 40, 0);
+    builder.addTriangle(a, b, c);
+    builder.addTriangle(a, c, d);
+    return builder.buildTree();
+}
+
+static BVHNode* buildScene()
+{
+    BVHTransform* tile = new BVHTransform;
+    tile->setTransform(SGMatrixd(tileCenter));
+    tile->addChild(buildTerrain());
+
+    BVHMotionTransform* deck = new BVHMotionTransform;
+    deck->setToWorldTransform(SGMatrixd(tileCenter + deckCenter));
+    deck->setLinearVelocity(deckVelocity);
+    deck->setId(deckId);
+    deck->addChild(buildDeck());
+
+    BVHGroup* root = new BVHGroup;
+    root->addChild(tile);
+    root->addChild(deck);
+    return root;
+}
+
+// contact points spread over an aircraft of 60m, 3m above the terrain
+static void contactPoints(const SGVec3d& center, unsigned n, std::vector<SGVec3d>& points)
+{
+    points.resize(n);
+    for (unsigned i = 0; i < n; ++i) {
+        double a = 2*SGD_PI*i/n;
+        double r = 30.0*(i % 4 + 1)/4;
+        double x = center[0] + r*cos(a);
+        double y = center[1] + r*sin(a);
+        points[i] = tileCenter + SGVec3d(x, y, terrainHeight(x, y) + 3);
+    }
+}
+
+// on an edge shared by two terrain triangles, either of them may be hit
+static bool onTerrainEdge(const SGVec3d& point)
+{
+    SGVec3d local = point - tileCenter;
+    double x = local[0]/cellSize, y = local[1]/cellSize;
+    double fx = x - floor(x), fy = y - floor(y);
+    const double eps = 1e-3;
+    return fx < eps || 1 - fx < eps || fy < eps || 1 - fy < eps ||
+        fabs(fx - fy) < eps;
+}
+
+static SGLineSegmentd queryLine(const SGVec3d& pt)
+{
+    return SGLineSegmentd(pt, pt - SGVec3d(0, 0, 500));
+}
+
+static void checkAgainstVisitor(FGGroundQueryBatch& batch, BVHNode& scene, double t)
+{
+    batch.run(scene, t);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const FGGroundQueryBatch::Query& q = batch[i];
+        BVHLineSegmentVisitor visitor(q.lineSegment, t);
+        scene.accept(visitor);
+
+        SG_CHECK_EQUAL(q.haveHit, !visitor.empty());
+        if (!q.haveHit)
+            continue;
+        SG_CHECK_EQUAL_EP2(dist(q.point, visitor.getPoint()), 0, 1e-2);
+        SG_VERIFY(dot(q.normal, visitor.getNormal()) > 0.9999 ||
+                  onTerrainEdge(q.point));
+        SG_VERIFY(q.material == visitor.getMaterial());
+        SG_CHECK_EQUAL(q.id, visitor.getId());
+        SG_CHECK_EQUAL_EP2(dist(q.linearVelocity, visitor.getLinearVelocity()), 0, 1e-6);
+        SG_CHECK_EQUAL_EP2(dist(q.angularVelocity, visitor.getAngularVelocity()), 0, 1e-6);
+    }
+}
+
+static void testResults(BVHNode& scene)
+{
+    FGGroundQueryBatch batch;
+    std::vector<SGVec3d> points;
+
+    // rolling over the terrain, the hints of the last step in use
+    SGVec3d center(300, 300, 0);
+    for (int step = 0; step < 50; ++step) {
+        contactPoints(center, 37, points);
+        batch.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            batch[i].lineSegment = queryLine(points[i]);
+        checkAgainstVisitor(batch, scene, 0);
+        center += SGVec3d(0.3, 0.1, 0);
+    }
+
+    // standing still: every point starts from the triangle it hit
+    batch.run(scene, 0);
+    SG_CHECK_EQUAL(batch.getHintHits(), 37u);
+
+    // on the deck, at the time it is there; points off its edge and
+    // outside the tile miss or fall through to the terrain
+    double t = 2;
+    SGVec3d deckAtT = tileCenter + deckCenter + t*deckVelocity;
+    const SGVec3d offsets[] = {
+        SGVec3d(0, 0, 5), SGVec3d(140, 30, 5), SGVec3d(160, 0, 5),
+        SGVec3d(-1e4, 0, 5), SGVec3d(0, -39.9, 0.5)
+    };
+    batch.resize(5);
+    for (int k = 0; k < 2; ++k) {
+        for (size_t i = 0; i < 5; ++i)
+            batch[i].lineSegment = queryLine(deckAtT + offsets[i]);
+        checkAgainstVisitor(batch, scene, t);
+    }
+    SG_CHECK_EQUAL(batch[0].id, deckId);
+    SG_VERIFY(batch[0].material == &deckMaterial);
+    SG_VERIFY(batch[2].material == &terrainMaterial);
+    SG_VERIFY(!batch[3].haveHit);
+    // hits on moving geometry do not leave a hint
+    SG_CHECK_EQUAL(batch.getHintHits(), 1u);
+
+    batch.clearHints();
+    batch.run(scene, t);
+    SG_CHECK_EQUAL(batch.getHintHits(), 0u);
+}
+
+static void benchmark(BVHNode& scene, unsigned numPoints)
+{
+    const int steps = 2000;
+    std::vector<SGVec3d> points;
+    FGGroundQueryBatch batch;
+    batch.resize(numPoints);
+    double sink = 0;
+
+    // one line segment visitor per point, as get_agl() does
+    SGTimeStamp st;
+    st.stamp();
+    SGVec3d center(300, 300, 0);
+    for (int step = 0; step < steps; ++step) {
+        contactPoints(center, numPoints, points);
+        for (unsigned i = 0; i < numPoints; ++i) {
+            BVHLineSegmentVisitor visitor(queryLine(points[i]), 0);
+            scene.accept(visitor);
+            sink += visitor.getPoint()[2];
+        }
+        center += SGVec3d(0.01, 0.005, 0);
+    }
+    double visitorUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    // the batch, with the hints of the previous step
+    st.stamp();
+    center = SGVec3d(300, 300, 0);
+    for (int step = 0; step < steps; ++step) {
+        contactPoints(center, numPoints, points);
+        for (unsigned i = 0; i < numPoints; ++i)
+            batch[i].lineSegment = queryLine(points[i]);
+        batch.run(scene, 0);
+        for (unsigned i = 0; i < numPoints; ++i)
+            sink += batch[i].point[2];
+        center += SGVec3d(0.01, 0.005, 0);
+    }
+    double batchUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    // the batch without hints, as after every cache rebuild
+    st.stamp();
+    center = SGVec3d(300, 300, 0);
+    for (int step = 0; step < steps; ++step) {
+        contactPoints(center, numPoints, points);
+        for (unsigned i = 0; i < numPoints; ++i)
+            batch[i].lineSegment = queryLine(points[i]);
+        batch.clearHints();
+        batch.run(scene, 0);
+        for (unsigned i = 0; i < numPoints; ++i)
+            sink += batch[i].point[2];
+        center += SGVec3d(0.01, 0.005, 0);
+    }
+    double coldUSec = (SGTimeStamp::now() - st).toUSecs();
+
+    double queries = double(steps)*numPoints;
+    std::cout << numPoints << " contact points: "
+              << visitorUSec/queries << " usec per point with a visitor each, "
+              << batchUSec/queries << " batched, "
+              << coldUSec/queries << " batched without hints"
+              << " (" << (sink != 0) << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    SGSharedPtr<BVHNode> scene = buildScene();
+    testResults(*scene);
+
+    benchmark(*scene, 3);
+    benchmark(*scene, 12);
+    benchmark(*scene, 48);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "src/Network/http/jsonprops.hxx"
+
+using flightgear::http::JSON;
+using flightgear::http::JSONWriter;
+
+// the cJSON based serialisation JSON::toJsonString() used to perform
+static std::string cJSONString(bool indent, SGPropertyNode_ptr n, int depth, double timestamp)
+{
+    cJSON * json = JSON::toJson(n, depth, timestamp);
+    char * jsonString = indent ? cJSON_Print(json) : cJSON_PrintUnformatted(json);
+    std::string result(jsonString);
+    free(jsonString);
+    cJSON_Delete(json);
+    return result;
+}
+
+// roughly the shape of /ai/models with a few hundred aircraft
+static SGPropertyNode_ptr makeTree(int numModels)
+{
+    SGPropertyNode_ptr root(new SGPropertyNode);
+    SGPropertyNode* models = root->getNode("ai/models", true);
+    for (int i = 0; i < numModels; ++i) {
+        SGPropertyNode* model = models->getNode("aircraft", i, true);
+        model->setStringValue("callsign", "FG" + std::to_string(i));
+        model->setBoolValue("valid", (i % 3) != 0);
+        model->setIntValue("id", i);
+        SGPropertyNode* pos = model->getNode("position", true);
+        pos->setDoubleValue("latitude-deg", 37.6 + i * 0.0137);
+        pos->setDoubleValue("longitude-deg", -122.4 - i * 0.0219);
+        pos->setDoubleValue("altitude-ft", 1000.0 * i);
+        SGPropertyNode* orient = model->getNode("orientation", true);
+        orient->setDoubleValue("true-heading-deg", (i * 17) % 360 + 0.25);
+        orient->setFloatValue("pitch-deg", 1.5f);
+        orient->setDoubleValue("roll-deg", 0.0);
+        SGPropertyNode* radar = model->getNode("radar", true);
+        radar->setDoubleValue("range-nm", 1e10 + i);
+        radar->setDoubleValue("bearing-deg", 1e-8 * i);
+        radar->setLongValue("id-code", 1234567890123LL + i);
+    }
+    return root;
+}
+
+void testEscaping()
+{
+    SGPropertyNode_ptr root(new SGPropertyNode);
+    root->setStringValue("quoted", "say \"hello\"\\ \t\n\r\b\f \x01 end");
+    root->setStringValue("empty", "");
+    root->setDoubleValue("nan", std::numeric_limits<double>::quiet_NaN());
+    root->setDoubleValue("negative", -42.5);
+    root->setIntValue("int-min", std::numeric_limits<int>::min());
+    root->getNode("no-value", true);
+
+    SG_CHECK_EQUAL(JSON::toJsonString(false, root, 2), cJSONString(false, root, 2, -1.0));
+    SG_CHECK_EQUAL(JSON::toJsonString(true, root, 2), cJSONString(true, root, 2, -1.0));
+    SG_CHECK_EQUAL(JSON::toJsonString(false, root, 2, 123.456),
+                   cJSONString(false, root, 2, 123.456));
+}
+
+void testMatchesCJSON()
+{
+    SGPropertyNode_ptr root = makeTree(20);
+    for (int depth = 0; depth < 5; ++depth) {
+        SG_CHECK_EQUAL(JSON::toJsonString(false, root, depth),
+                       cJSONString(false, root, depth, -1.0));
+        SG_CHECK_EQUAL(JSON::toJsonString(true, root, depth, 1.0),
+                       cJSONString(true, root, depth, 1.0));
+    }
+
+    // a subtree, so paths are built from a non-root prefix
+    SGPropertyNode_ptr model = root->getNode("ai/models/aircraft[3]");
+    SG_CHECK_EQUAL(JSON::toJsonString(false, model, 3),
+                   cJSONString(false, model, 3, -1.0));
+}
+
+void benchmark()
+{
+    const int iterations = 20;
+    SGPropertyNode_ptr root = makeTree(500);
+    SGPropertyNode_ptr models = root->getNode("ai/models");
+
+    size_t bytes = 0;
+    SGTimeStamp st;
+    st.stamp();
+    for (int i = 0; i < iterations; ++i)
+        bytes += cJSONString(false, models, 4, -1.0).size();
+    const double cjsonMSec = st.elapsedMSec();
+
+    std::string buffer;
+    st.stamp();
+    for (int i = 0; i < iterations; ++i) {
+        buffer.clear();
+        JSONWriter writer(buffer);
+        JSON::writeJson(writer, models, 4);
+        bytes -= buffer.size();
+    }
+    const double streamMSec = st.elapsedMSec();
+    SG_CHECK_EQUAL(bytes, 0u);
+
+    std::cout << "serialised " << buffer.size() << " bytes x " << iterations
+              << ": cJSON " << cjsonMSec << " ms, streaming " << streamMSec
+              << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    testEscaping();
+    testMatchesCJSON();
+    benchmark();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,296 @@
+#include "config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <AIModel/AIMultiplayerMotion.hxx>
+
+// every allocation of the process, to check the receiving side
+// does not allocate once warmed up
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static const int numFloatProps = 40;
+
+// a packet like the ones multiplaymgr decodes: floats, an int and a string
+static void makePacket(FGExternalMotionData& packet, int aircraft)
+{
+    packet.lag = 0.1;
+    packet.orientation = SGQuatf::unit();
+    packet.linearVel = SGVec3f(100, 0, 0);
+    packet.angularVel = SGVec3f::zeros();
+    packet.linearAccel = SGVec3f::zeros();
+    packet.angularAccel = SGVec3f::zeros();
+
+    for (int i = 0; i < numFloatProps; ++i) {
+        FGPropertyData* p = new FGPropertyData;
+        p->id = 100 + i;
+        p->type = simgear::props::FLOAT;
+        p->float_value = 0;
+        packet.properties.push_back(p);
+    }
+
+    FGPropertyData* p = new FGPropertyData;
+    p->id = 1100;
+    p->type = simgear::props::INT;
+    p->int_value = aircraft;
+    packet.properties.push_back(p);
+
+    p = new FGPropertyData;
+    p->id = 10001;
+    p->type = simgear::props::STRING;
+    p->string_value = new char[16];
+    ::snprintf(p->string_value, 16, "callsign%03d", aircraft);
+    packet.properties.push_back(p);
+}
+
+static void setPacketTime(FGExternalMotionData& packet, double t)
+{
+    packet.time = t;
+    packet.position = SGVec3d(6378137.0 + t, 100 * t, 0);
+    for (int i = 0; i < numFloatProps; ++i) {
+        packet.properties[i]->float_value = t + i;
+    }
+}
+
+static void testOrdering()
+{
+    FGExternalMotionData packet;
+    makePacket(packet, 7);
+    FGMultiplayerMotionRing ring(4);
+
+    setPacketTime(packet, 10.0);
+    SG_VERIFY(ring.add(packet));
+    setPacketTime(packet, 10.5);
+    SG_VERIFY(ring.add(packet));
+
+    // out of order packets are dropped, duplicates replace their sample
+    setPacketTime(packet, 10.2);
+    SG_VERIFY(!ring.add(packet));
+    setPacketTime(packet, 10.5);
+    SG_VERIFY(ring.add(packet));
+    SG_CHECK_EQUAL(ring.size(), 2u);
+
+    // overwriting the oldest sample once full
+    for (int i = 1; i <= 4; ++i) {
+        setPacketTime(packet, 10.5 + i);
+        SG_VERIFY(ring.add(packet));
+    }
+    SG_CHECK_EQUAL(ring.size(), 4u);
+    SG_CHECK_EQUAL(ring[0].time, 11.5);
+    SG_CHECK_EQUAL(ring.newest().time, 14.5);
+
+    SG_CHECK_EQUAL(ring.upperBound(1.0), 0u);
+    SG_CHECK_EQUAL(ring.upperBound(11.5), 1u);
+    SG_CHECK_EQUAL(ring.upperBound(13.0), 2u);
+    SG_CHECK_EQUAL(ring.upperBound(20.0), 4u);
+
+    ring.dropOldest(2);
+    SG_CHECK_EQUAL(ring.size(), 2u);
+    SG_CHECK_EQUAL(ring[0].time, 13.5);
+
+    // property values survive the copy
+    const FGMultiplayerMotionSample& s = ring.newest();
+    SG_CHECK_EQUAL(s.properties.size(), (size_t) numFloatProps + 2);
+    SG_CHECK_EQUAL(s.properties[3].float_value, 14.5f + 3);
+    SG_CHECK_EQUAL(s.properties[numFloatProps].int_value, 7);
+    SG_CHECK_EQUAL(std::string(s.stringValue(s.properties[numFloatProps + 1])),
+                   std::string("callsign007"));
+
+    // the sender restarted: its clock went back more than 10 seconds
+    setPacketTime(packet, 1.0);
+    SG_VERIFY(ring.add(packet));
+    SG_CHECK_EQUAL(ring.size(), 1u);
+}
+
+// what FGAIMultiplayer::update() does with the buffer each frame
+template <class Lookup>
+static double interpolateAll(Lookup& lookup, size_t numAircraft, double t)
+{
+    double sum = 0;
+    for (size_t i = 0; i < numAircraft; ++i) {
+        sum += lookup(i, t);
+    }
+    return sum;
+}
+
+struct RingBuffers {
+    std::vector<FGMultiplayerMotionRing> rings;
+
+    explicit RingBuffers(size_t n) : rings(n) { }
+
+    void add(size_t i, const FGExternalMotionData& packet)
+    { rings[i].add(packet); }
+
+    double operator()(size_t i, double t)
+    {
+        FGMultiplayerMotionRing& ring = rings[i];
+        size_t next = ring.upperBound(t);
+        if (next == 0 || next == ring.size()) {
+            return ring[next ? next - 1 : 0].properties[0].float_value;
+        }
+        const FGMultiplayerMotionSample& a = ring[next - 1];
+        const FGMultiplayerMotionSample& b = ring[next];
+        double tau = (t - a.time) / (b.time - a.time);
+        double v = 0;
+        for (size_t p = 0; p < a.properties.size(); ++p) {
+            v += (1 - tau) * a.properties[p].float_value + tau * b.properties[p].float_value;
+        }
+        if (next > 1) {
+            ring.dropOldest(next - 2);
+        }
+        return v;
+    }
+};
+
+// the std::map based buffer FGAIMultiplayer used before
+struct MapBuffers {
+    typedef std::map<double, FGExternalMotionData> MotionInfo;
+    std::vector<MotionInfo> maps;
+
+    explicit MapBuffers(size_t n) : maps(n) { }
+
+    // the map shares the packet's property pointers, they are released
+    // from the entries before those are destroyed
+    ~MapBuffers()
+    {
+        for (size_t i = 0; i < maps.size(); ++i) {
+            release(maps[i].begin(), maps[i].end());
+        }
+    }
+
+    static void release(MotionInfo::iterator begin, MotionInfo::iterator end)
+    {
+        for (; begin != end; ++begin) {
+            begin->second.properties.clear();
+        }
+    }
+
+    void add(size_t i, const FGExternalMotionData& packet)
+    {
+        maps[i][packet.time] = packet;
+    }
+
+    double operator()(size_t i, double t)
+    {
+        MotionInfo& m = maps[i];
+        MotionInfo::iterator next = m.upper_bound(t);
+        if (next == m.begin() || next == m.end()) {
+            return m.empty() ? 0 : m.begin()->second.properties[0]->float_value;
+        }
+        MotionInfo::iterator prev = next;
+        --prev;
+        double tau = (t - prev->first) / (next->first - prev->first);
+        double v = 0;
+        const std::vector<FGPropertyData*>& a = prev->second.properties;
+        const std::vector<FGPropertyData*>& b = next->second.properties;
+        for (size_t p = 0; p < a.size(); ++p) {
+            v += (1 - tau) * a[p]->float_value + tau * b[p]->float_value;
+        }
+        if (prev != m.begin()) {
+            --prev;
+            release(m.begin(), prev);
+            m.erase(m.begin(), prev);
+        }
+        return v;
+    }
+};
+
+/**
+ * 128 aircraft sending at 20 Hz, received with some jitter and
+ * interpolated 150ms in the past at 60 frames per second.
+ */
+template <class Buffers>
+static void stress(const char* name, bool expectNoAllocations)
+{
+    const size_t numAircraft = 128;
+    const double packetRate = 20;
+    const double frameRate = 60;
+    const double warmupSec = 10;
+    const double runSec = 60;
+
+    std::vector<FGExternalMotionData> packets(numAircraft);
+    for (size_t i = 0; i < numAircraft; ++i) {
+        makePacket(packets[i], i);
+    }
+
+    Buffers buffers(numAircraft);
+    size_t warmAllocations = 0;
+    size_t frames = 0;
+    double lookupUSec = 0;
+    double sink = 0;
+    double nextPacket = 0;
+    unsigned int seed = 1;
+
+    for (double t = 0; t < warmupSec + runSec; t += 1 / frameRate) {
+        if (t >= warmupSec && warmAllocations == 0) {
+            warmAllocations = allocations;
+        }
+
+        while (nextPacket <= t) {
+            for (size_t i = 0; i < numAircraft; ++i) {
+                // up to 30ms of send time jitter per aircraft
+                seed = seed * 1103515245 + 12345;
+                double jitter = ((seed >> 16) % 30) / 1000.0;
+                setPacketTime(packets[i], nextPacket + jitter);
+                buffers.add(i, packets[i]);
+            }
+            nextPacket += 1 / packetRate;
+        }
+
+        SGTimeStamp st;
+        st.stamp();
+        sink += interpolateAll(buffers, numAircraft, t - 0.15);
+        if (t >= warmupSec) {
+            lookupUSec += (SGTimeStamp::now() - st).toUSecs();
+            ++frames;
+        }
+    }
+
+    size_t steadyAllocations = allocations - warmAllocations;
+    std::cout << name << ": " << numAircraft << " aircraft, "
+              << steadyAllocations / runSec << " allocations/s, "
+              << lookupUSec / (frames * numAircraft) << " usec per aircraft update"
+              << " (" << (sink != 0) << ")" << std::endl;
+
+    if (expectNoAllocations) {
+        SG_CHECK_EQUAL(steadyAllocations, 0u);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    testOrdering();
+    stress<MapBuffers>("std::map", false);
+    stress<RingBuffers>("ring", true);
+    return EXIT_SUCCESS;
+}
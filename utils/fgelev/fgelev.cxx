@@ -21,8 +21,15 @@
 #endif
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <stdint.h>
 
 #include <osg/ArgumentParser>
 #include <osg/Image>
@@ -36,6 +43,10 @@
 #include <simgear/bvh/BVHPager.hxx>
 #include <simgear/bvh/BVHPageNode.hxx>
 #include <simgear/bvh/BVHMaterial.hxx>
+#include <simgear/bvh/BVHStaticGeometry.hxx>
+#include <simgear/bucket/newbucket.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/timing/timestamp.hxx>
 #include <simgear/scene/material/matlib.hxx>
 #include <simgear/scene/model/BVHPageNodeOSG.hxx>
 #include <simgear/scene/model/ModelRegistry.hxx>
@@ -63,6 +74,28 @@ private:
     sg::BVHPager& _pager;
 };
 
+// Pages in everything along a line segment without doing the
+// triangle intersection work. Used in batch mode to load all tiles
+// a chunk of queries touches before the worker threads run.
+class PreloadVisitor : public sg::BVHLineSegmentVisitor {
+public:
+    PreloadVisitor(const SGLineSegmentd& lineSegment, sg::BVHPager& pager) :
+        BVHLineSegmentVisitor(lineSegment, 0),
+        _pager(pager)
+    { }
+    virtual ~PreloadVisitor()
+    { }
+    virtual void apply(sg::BVHPageNode& node)
+    {
+        _pager.use(node);
+        BVHLineSegmentVisitor::apply(node);
+    }
+    virtual void apply(sg::BVHStaticGeometry&)
+    { }
+private:
+    sg::BVHPager& _pager;
+};
+
 // Short circuit reading image files.
 class ReadFileCallback : public sg::OptionsReadFileCallback {
 public:
@@ -87,6 +120,266 @@ intersect(sg::BVHNode& node, sg::BVHPager& pager,
     return true;
 }
 
+// Same as above, but only looks at what is already paged in.
+// Safe to call from several threads as long as the pager is not
+// touched concurrently.
+static bool
+intersectLoaded(sg::BVHNode& node, const SGVec3d& start, SGVec3d& end,
+                double offset, const simgear::BVHMaterial** material)
+{
+    SGVec3d perp = offset*perpendicular(start - end);
+    sg::BVHLineSegmentVisitor visitor(SGLineSegmentd(start + perp, end + perp), 0);
+    node.accept(visitor);
+    if (visitor.empty())
+        return false;
+    end = visitor.getLineSegment().getEnd();
+    * material = visitor.getMaterial();
+    return true;
+}
+
+namespace {
+
+/// One elevation request of a batch run
+struct Query {
+    std::string id;
+    double lon;
+    double lat;
+    long tile;
+};
+
+/// The answer to one Query, stored at the same index
+struct Result {
+    Result() : elevation(-1000), holeScale(0), found(false), solid(false)
+    { }
+    double elevation;
+    double holeScale;
+    bool found;
+    bool solid;
+};
+
+/// Reads the batch input file either as text, one 'id lon lat' or
+/// 'id,lon,lat' record per line, or as binary records of a little endian
+/// uint64 id followed by the two doubles lon and lat.
+class QueryReader {
+public:
+    QueryReader(std::istream& stream, bool binary) :
+        _stream(stream),
+        _binary(binary),
+        _line(0)
+    { }
+
+    /// Appends up to maxCount queries, returns false on a malformed record
+    bool read(std::vector<Query>& queries, size_t maxCount)
+    {
+        while (queries.size() < maxCount && _stream.good()) {
+            Query query;
+            if (_binary) {
+                char record[24];
+                _stream.read(record, sizeof(record));
+                if (_stream.gcount() == 0)
+                    return true;
+                if (_stream.gcount() != sizeof(record)) {
+                    SG_LOG(SG_GENERAL, SG_ALERT, "Truncated binary record");
+                    return false;
+                }
+                uint64_t id;
+                memcpy(&id, record, 8);
+                memcpy(&query.lon, record + 8, 8);
+                memcpy(&query.lat, record + 16, 8);
+                std::ostringstream os;
+                os << id;
+                query.id = os.str();
+            } else {
+                std::string line;
+                if (!std::getline(_stream, line))
+                    return true;
+                ++_line;
+                std::replace(line.begin(), line.end(), ',', ' ');
+                std::istringstream is(line);
+                if (!(is >> query.id))
+                    continue; // empty line
+                if (query.id[0] == '#')
+                    continue;
+                if (!(is >> query.lon >> query.lat)) {
+                    SG_LOG(SG_GENERAL, SG_ALERT, "Malformed input at line " << _line);
+                    return false;
+                }
+            }
+            query.tile = SGBucket(SGGeod::fromDeg(query.lon, query.lat)).gen_index();
+            queries.push_back(query);
+        }
+        return true;
+    }
+
+private:
+    std::istream& _stream;
+    bool _binary;
+    unsigned long _line;
+};
+
+/// Shared state of one chunk that the worker threads chew on.
+struct BatchChunk {
+    BatchChunk(sg::BVHNode& n) : node(n), next(0)
+    { }
+    sg::BVHNode& node;
+    const std::vector<Query>* queries;
+    const std::vector<size_t>* order;
+    std::vector<Result>* results;
+    std::atomic<size_t> next;
+};
+
+class BatchWorker : public SGThread {
+public:
+    BatchWorker(BatchChunk& chunk) :
+        _chunk(chunk)
+    { }
+
+    virtual void run()
+    {
+        // Hand out small blocks of the tile sorted order so that
+        // each thread stays within the same few tiles.
+        const size_t blockSize = 64;
+        const size_t count = _chunk.order->size();
+        for (;;) {
+            size_t begin = _chunk.next.fetch_add(blockSize);
+            if (count <= begin)
+                return;
+            size_t end = std::min(begin + blockSize, count);
+            for (size_t i = begin; i < end; ++i) {
+                size_t index = (*_chunk.order)[i];
+                process((*_chunk.queries)[index], (*_chunk.results)[index]);
+            }
+        }
+    }
+
+    void process(const Query& query, Result& result)
+    {
+        SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, 10000));
+        SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, -1000));
+
+        const simgear::BVHMaterial* material = NULL;
+        bool found = intersectLoaded(_chunk.node, start, end, 0, &material);
+        double scale = 1e-5;
+        while (!found && scale <= 1) {
+            found = intersectLoaded(_chunk.node, start, end, scale, &material);
+            scale *= 2;
+        }
+        if (1e-5 < scale)
+            result.holeScale = scale;
+        result.found = found;
+        result.solid = material && material->get_solid();
+        if (found)
+            result.elevation = SGGeod::fromCart(end).getElevationM();
+    }
+
+private:
+    BatchChunk& _chunk;
+};
+
+class TileOrder {
+public:
+    TileOrder(const std::vector<Query>& queries) : _queries(queries)
+    { }
+    bool operator()(size_t a, size_t b) const
+    { return _queries[a].tile < _queries[b].tile; }
+private:
+    const std::vector<Query>& _queries;
+};
+
+} // anonymous namespace
+
+/// Batch mode: read the whole input in chunks, sort each chunk by
+/// scenery tile, page in the tiles serially and then intersect on
+/// several threads. Results are written in input order.
+static int
+runBatch(sg::BVHNode& node, sg::BVHPager& pager, std::istream& input,
+         bool binary, std::ostream& output, unsigned numThreads,
+         size_t chunkSize, unsigned expire, bool printSolidness)
+{
+    QueryReader reader(input, binary);
+    std::vector<Query> queries;
+    std::vector<size_t> order;
+    std::vector<Result> results;
+    queries.reserve(chunkSize);
+
+    SGTimeStamp total;
+    total.stamp();
+    double preloadTime = 0;
+    unsigned long numPoints = 0;
+
+    for (;;) {
+        queries.clear();
+        if (!reader.read(queries, chunkSize))
+            return EXIT_FAILURE;
+        if (queries.empty())
+            break;
+
+        order.resize(queries.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), TileOrder(queries));
+
+        // Page in everything this chunk needs. The pager is not
+        // thread safe, so this happens before the workers start.
+        SGTimeStamp preload;
+        preload.stamp();
+        pager.setUseStamp(1 + pager.getUseStamp());
+        pager.update(expire);
+        for (size_t i = 0; i < order.size(); ++i) {
+            const Query& query = queries[order[i]];
+            SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, 10000));
+            SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, -1000));
+            PreloadVisitor visitor(SGLineSegmentd(start, end), pager);
+            node.accept(visitor);
+        }
+        preloadTime += preload.elapsedMSec()*1e-3;
+
+        results.assign(queries.size(), Result());
+        BatchChunk chunk(node);
+        chunk.queries = &queries;
+        chunk.order = &order;
+        chunk.results = &results;
+
+        std::vector<BatchWorker*> workers;
+        for (unsigned i = 0; i < numThreads; ++i) {
+            workers.push_back(new BatchWorker(chunk));
+            workers.back()->start();
+        }
+        for (unsigned i = 0; i < workers.size(); ++i) {
+            workers[i]->join();
+            delete workers[i];
+        }
+
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const Result& result = results[i];
+            if (result.holeScale != 0)
+                std::cerr << "Found hole of minimum diameter "
+                          << result.holeScale << "m at lon = " << queries[i].lon
+                          << "deg lat = " << queries[i].lat << "deg" << std::endl;
+
+            output << queries[i].id << ": ";
+            if (!result.found) {
+                output << "-1000";
+            } else {
+                output << std::fixed << std::setprecision(3) << result.elevation;
+                if (printSolidness)
+                    output << " " << (result.solid ? "solid" : "-");
+            }
+            output << '\n';
+        }
+        output.flush();
+        numPoints += queries.size();
+    }
+
+    double seconds = total.elapsedMSec()*1e-3;
+    std::cerr << "Processed " << numPoints << " points in " << seconds
+              << "s (" << preloadTime << "s paging) using " << numThreads
+              << " threads: "
+              << (0 < seconds ? numPoints/seconds : 0) << " points/s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char** argv)
 {
@@ -101,6 +394,19 @@ main(int argc, char** argv)
 
     bool printSolidness = arguments.read("--print-solidness");
 
+    std::string batchFile;
+    bool batch = arguments.read("--batch", batchFile);
+    std::string outputFile;
+    arguments.read("--output", outputFile);
+    std::string inputFormat = "csv";
+    arguments.read("--input-format", inputFormat);
+    unsigned numThreads;
+    if (!arguments.read("--threads", numThreads) || numThreads == 0)
+        numThreads = 4;
+    unsigned chunkSize;
+    if (!arguments.read("--chunk-size", chunkSize) || chunkSize == 0)
+        chunkSize = 100000;
+
     std::string fg_root;
     if (arguments.read("--fg-root", fg_root)) {
     } else if (const char *fg_root_env = std::getenv("FG_ROOT")) {
@@ -194,6 +500,33 @@ main(int argc, char** argv)
     // We assume that the above is a paged database.
     sg::BVHPager pager;
 
+    if (batch) {
+        if (inputFormat != "csv" && inputFormat != "binary") {
+            SG_LOG(SG_GENERAL, SG_ALERT, "Unknown input format " << inputFormat);
+            return EXIT_FAILURE;
+        }
+        bool binary = inputFormat == "binary";
+        std::ifstream input;
+        if (batchFile != "-") {
+            input.open(batchFile.c_str(), binary ? std::ios::in | std::ios::binary : std::ios::in);
+            if (!input.is_open()) {
+                SG_LOG(SG_GENERAL, SG_ALERT, "Can not open " << batchFile);
+                return EXIT_FAILURE;
+            }
+        }
+        std::ofstream output;
+        if (!outputFile.empty()) {
+            output.open(outputFile.c_str());
+            if (!output.is_open()) {
+                SG_LOG(SG_GENERAL, SG_ALERT, "Can not open " << outputFile);
+                return EXIT_FAILURE;
+            }
+        }
+        return runBatch(*node, pager, input.is_open() ? input : std::cin,
+                        binary, output.is_open() ? output : std::cout,
+                        numThreads, chunkSize, expire, printSolidness);
+    }
+
     while (std::cin.good()) {
         // Increment the paging relevant number
         pager.setUseStamp(1 + pager.getUseStamp());
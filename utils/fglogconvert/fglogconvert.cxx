@@ -0,0 +1,271 @@
+// fglogconvert.cxx -- convert binary FlightGear property logs to CSV
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include <Main/binary_log.hxx>
+
+namespace binarylog = flightgear::binarylog;
+
+namespace {
+
+class Reader {
+public:
+    Reader(std::istream& stream) :
+        failed(false),
+        _stream(stream),
+        _swap(false)
+    { }
+
+    bool readHeader()
+    {
+        char magic[8];
+        if (!readBytes(magic, sizeof(magic)) ||
+            memcmp(magic, binarylog::MAGIC, sizeof(magic)) != 0) {
+            std::cerr << "Not a binary FlightGear log" << std::endl;
+            return false;
+        }
+
+        uint32_t bom = 0;
+        if (!readBytes(&bom, 4))
+            return false;
+        if (bom != binarylog::BYTE_ORDER_MARK) {
+            _swap = true;
+            swapBytes(&bom, 4);
+            if (bom != binarylog::BYTE_ORDER_MARK) {
+                std::cerr << "Corrupt byte order mark" << std::endl;
+                return false;
+            }
+        }
+
+        uint32_t version, numColumns;
+        if (!readValue(version) || !readValue(flags) || !readValue(numColumns))
+            return false;
+        if (version != binarylog::VERSION) {
+            std::cerr << "Unsupported log version " << version << std::endl;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < numColumns; ++i) {
+            uint8_t type;
+            uint16_t length;
+            if (!readBytes(&type, 1) || !readValue(length))
+                return false;
+            if (binarylog::columnSize(type) == 0) {
+                std::cerr << "Unknown column type " << int(type) << std::endl;
+                return false;
+            }
+            std::string title(length, ' ');
+            if (length && !readBytes(&title[0], length))
+                return false;
+            types.push_back(type);
+            titles.push_back(title);
+        }
+        return true;
+    }
+
+    /// Read the next block into the columns buffer, false at end of file
+    bool readBlock(uint32_t& numRows)
+    {
+        uint32_t payloadSize, rawSize;
+        if (!readValue(numRows))
+            return false;
+        if (!readValue(payloadSize) || !readValue(rawSize)) {
+            std::cerr << "Truncated block header" << std::endl;
+            failed = true;
+            return false;
+        }
+
+        std::vector<unsigned char> payload(payloadSize);
+        if (payloadSize && !readBytes(&payload[0], payloadSize)) {
+            std::cerr << "Truncated block" << std::endl;
+            failed = true;
+            return false;
+        }
+
+        if (flags & binarylog::FLAG_ZLIB) {
+            columns.resize(rawSize);
+            uLongf size = rawSize;
+            if (uncompress(&columns[0], &size, &payload[0], payloadSize) != Z_OK ||
+                size != rawSize) {
+                std::cerr << "Corrupt compressed block" << std::endl;
+                failed = true;
+                return false;
+            }
+        } else {
+            columns.swap(payload);
+        }
+
+        size_t expected = numRows * sizeof(double);
+        for (size_t i = 0; i < types.size(); ++i)
+            expected += numRows * binarylog::columnSize(types[i]);
+        if (expected != columns.size()) {
+            std::cerr << "Block size mismatch" << std::endl;
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    T value(size_t offset) const
+    {
+        T v;
+        memcpy(&v, &columns[offset], sizeof(T));
+        if (_swap)
+            swapBytes(&v, sizeof(T));
+        return v;
+    }
+
+    uint32_t flags;
+    bool failed;
+    std::vector<uint8_t> types;
+    std::vector<std::string> titles;
+    std::vector<unsigned char> columns;
+
+private:
+    bool readBytes(void* data, size_t size)
+    {
+        _stream.read(static_cast<char*>(data), size);
+        return _stream.gcount() == std::streamsize(size);
+    }
+
+    template<typename T>
+    bool readValue(T& v)
+    {
+        if (!readBytes(&v, sizeof(T)))
+            return false;
+        if (_swap)
+            swapBytes(&v, sizeof(T));
+        return true;
+    }
+
+    static void swapBytes(void* data, size_t size)
+    {
+        unsigned char* bytes = static_cast<unsigned char*>(data);
+        std::reverse(bytes, bytes + size);
+    }
+
+    std::istream& _stream;
+    bool _swap;
+};
+
+void usage(const char* argv0)
+{
+    std::cerr << "Usage: " << argv0
+              << " [--delimiter=<char>] <binary log> [<csv file>]" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    char delimiter = ',';
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, 12, "--delimiter=") == 0 && arg.size() > 12) {
+            delimiter = arg[12];
+        } else if (arg == "--help" || arg == "-h") {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty() || files.size() > 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream input(files[0].c_str(), std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        std::cerr << "Can not open " << files[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream outputFile;
+    if (files.size() == 2) {
+        outputFile.open(files[1].c_str());
+        if (!outputFile.is_open()) {
+            std::cerr << "Can not open " << files[1] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& output = outputFile.is_open() ? outputFile : std::cout;
+
+    Reader reader(input);
+    if (!reader.readHeader())
+        return EXIT_FAILURE;
+
+    output << "Time";
+    for (size_t i = 0; i < reader.titles.size(); ++i)
+        output << delimiter << reader.titles[i];
+    output << '\n';
+
+    std::vector<size_t> columnStart(reader.types.size());
+    uint32_t numRows;
+    while (reader.readBlock(numRows)) {
+        size_t offset = numRows * sizeof(double);
+        for (size_t i = 0; i < reader.types.size(); ++i) {
+            columnStart[i] = offset;
+            offset += numRows * binarylog::columnSize(reader.types[i]);
+        }
+
+        for (uint32_t r = 0; r < numRows; ++r) {
+            output << std::setprecision(10)
+                   << reader.value<double>(r * sizeof(double));
+            for (size_t i = 0; i < reader.types.size(); ++i) {
+                size_t at = columnStart[i] + r * binarylog::columnSize(reader.types[i]);
+                output << delimiter;
+                switch (reader.types[i]) {
+                case binarylog::COLUMN_BOOL:
+                    output << (reader.value<uint8_t>(at) ? "true" : "false");
+                    break;
+                case binarylog::COLUMN_INT:
+                    output << reader.value<int32_t>(at);
+                    break;
+                case binarylog::COLUMN_LONG:
+                    output << reader.value<int64_t>(at);
+                    break;
+                case binarylog::COLUMN_FLOAT:
+                    output << std::setprecision(7) << reader.value<float>(at);
+                    break;
+                default:
+                    output << std::setprecision(15) << reader.value<double>(at);
+                    break;
+                }
+            }
+            output << '\n';
+        }
+    }
+
+    return reader.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -27,6 +27,10 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QDataStream>
+#include <QtEndian>
+#include <QUrlQuery>
+
+#include <cstring>
 
 #include "localprop.h"
 #include "fgqcanvasfontcache.h"
@@ -38,6 +42,8 @@ CanvasConnection::CanvasConnection(QObject *parent) : QObject(parent)
     connect(&m_webSocket, &QWebSocket::disconnected, this, &CanvasConnection::onWebSocketClosed);
     connect(&m_webSocket, &QWebSocket::textMessageReceived,
             this, &CanvasConnection::onTextMessageReceived);
+    connect(&m_webSocket, &QWebSocket::binaryMessageReceived,
+            this, &CanvasConnection::onBinaryMessageReceived);
 
     m_destRect = QRectF(50, 50, 400, 400);
 }
@@ -144,6 +150,11 @@ void CanvasConnection::connectWebSocket(QByteArray hostName, int port)
     wsUrl.setPort(port);
     wsUrl.setPath("/PropertyTreeMirror" + m_rootPropertyPath);
 
+    // ask for the compact encoding, older versions ignore this and send JSON
+    QUrlQuery query;
+    query.addQueryItem("format", "binary");
+    wsUrl.setQuery(query);
+
     m_webSocketUrl = wsUrl;
     emit webSocketUrlChanged();
 
@@ -269,6 +280,166 @@ void CanvasConnection::onTextMessageReceived(QString message)
     emit updated();
 }
 
+namespace {
+
+// reads the binary mirror protocol, see MirrorPropertyTreeWebsocket.cxx
+class MirrorReader
+{
+public:
+    MirrorReader(const QByteArray& data) :
+        m_data(data)
+    {}
+
+    bool atEnd() const
+    {
+        return m_error || (m_pos >= m_data.size());
+    }
+
+    bool error() const
+    {
+        return m_error;
+    }
+
+    quint8 readByte()
+    {
+        if (m_pos >= m_data.size()) {
+            m_error = true;
+            return 0;
+        }
+        return static_cast<quint8>(m_data.at(m_pos++));
+    }
+
+    quint64 readVarUInt()
+    {
+        quint64 result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            quint8 b = readByte();
+            result |= static_cast<quint64>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return result;
+            }
+        }
+        m_error = true;
+        return 0;
+    }
+
+    qint64 readVarInt()
+    {
+        quint64 v = readVarUInt();
+        return static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1);
+    }
+
+    QByteArray readBytes(int len)
+    {
+        if (len < 0 || m_pos + len > m_data.size()) {
+            m_error = true;
+            return {};
+        }
+        QByteArray result = m_data.mid(m_pos, len);
+        m_pos += len;
+        return result;
+    }
+
+    template <class T>
+    T readLittleEndian()
+    {
+        QByteArray bytes = readBytes(sizeof(T));
+        if (m_error) {
+            return 0;
+        }
+        T result;
+        memcpy(&result, bytes.constData(), sizeof(T));
+        return qFromLittleEndian(result);
+    }
+
+    QVariant readValue()
+    {
+        switch (readByte()) {
+        case 0: return {};
+        case 1: return false;
+        case 2: return true;
+        case 3: return static_cast<int>(readVarInt());
+        case 4: return readVarInt();
+        case 5: return readLittleEndian<float>();
+        case 6: return readLittleEndian<double>();
+        case 7: return QString::fromUtf8(readBytes(readVarUInt()));
+        default:
+            m_error = true;
+            return {};
+        }
+    }
+
+private:
+    const QByteArray& m_data;
+    int m_pos = 0;
+    bool m_error = false;
+};
+
+} // of anonymous namespace
+
+void CanvasConnection::onBinaryMessageReceived(QByteArray message)
+{
+    MirrorReader reader(message);
+    if (reader.readByte() != 1) {
+        qWarning() << "unsupported mirror protocol version";
+        return;
+    }
+
+    while (!reader.atEnd()) {
+        const quint8 op = reader.readByte();
+        const unsigned int propId = reader.readVarUInt();
+        if (op == 1) { // created
+            const unsigned int parentId = reader.readVarUInt();
+            const unsigned int index = reader.readVarUInt();
+            const unsigned int position = reader.readVarUInt();
+            const QByteArray name = reader.readBytes(reader.readVarUInt());
+            const QVariant value = reader.readValue();
+            if (reader.error()) {
+                break;
+            }
+
+            LocalProp* newNode = m_localPropertyRoot.get();
+            if (parentId != 0) {
+                LocalProp* parent = idPropertyDict.value(parentId);
+                if (!parent) {
+                    qWarning() << "ignoring child" << name << "of unknown prop ID" << parentId;
+                    continue;
+                }
+                newNode = parent->getOrCreateChildWithNameAndIndex(NameIndexTuple(name.constData(), index));
+            }
+
+            newNode->setPosition(position);
+            if (idPropertyDict.contains(propId)) {
+                qWarning() << "duplicate add of:" << newNode->path();
+            } else {
+                idPropertyDict.insert(propId, newNode);
+            }
+            newNode->processChange(value);
+        } else if (op == 2) { // changed
+            const QVariant value = reader.readValue();
+            LocalProp* lp = idPropertyDict.value(propId);
+            if (lp != nullptr) {
+                lp->processChange(value);
+            }
+        } else if (op == 3) { // removed
+            auto prop = idPropertyDict.value(propId);
+            idPropertyDict.remove(propId);
+            if (!prop.isNull()) {
+                prop->parent()->removeChild(prop);
+            }
+        } else {
+            qWarning() << "malformed mirror message, unknown op" << op;
+            break;
+        }
+    }
+
+    if (reader.error()) {
+        qWarning() << "truncated mirror message";
+    }
+
+    emit updated();
+}
+
 void CanvasConnection::onWebSocketClosed()
 {
     qDebug() << "saw web-socket closed";
@@ -120,6 +120,7 @@ signals:
 private Q_SLOTS:
     void onWebSocketConnected();
     void onTextMessageReceived(QString message);
+    void onBinaryMessageReceived(QByteArray message);
     void onWebSocketClosed();
 
 private:
@@ -0,0 +1,398 @@
+// fgshmfdm.cxx -- reference peer for the ExternalPipe "shm" protocol
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+// Attaches to the segment FlightGear creates for --fdm=pipe,<name>,shm
+// and flies a very simple kinematic model with it. Run with --loopback
+// to play the simulator side as well and measure the frame rate the
+// transport sustains without FlightGear.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <FDM/ExternalPipe/shm_segment.hxx>
+
+#ifndef FG_HAVE_SHM_FDM
+
+int main(int argc, char* argv[])
+{
+    std::cerr << "fgshmfdm: shared memory FDMs are not supported on this platform"
+              << std::endl;
+    return EXIT_FAILURE;
+}
+
+#else
+
+namespace {
+
+const double EARTH_RADIUS_M = 6378137.0;
+const double FEET_TO_METER = 0.3048;
+const double KNOTS_TO_MPS = 0.514444;
+const double DEG_TO_RAD = M_PI / 180.0;
+
+double monotonicSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Enough of an aircraft to see the controls do something: speed follows
+// the throttle, bank follows the ailerons and the nose the elevator.
+class SimpleModel {
+public:
+    SimpleModel() :
+        _generation(0), _lat(0), _lon(0), _alt(0), _ground(0),
+        _heading(0), _pitch(0), _roll(0), _speed(0), _climb(0) {}
+
+    void apply(const FGShmFDMInit& init)
+    {
+        if (init.generation == _generation) {
+            return;
+        }
+        _generation = init.generation;
+        if (init.reset == FGShmFDMInit::RESET_NONE) {
+            return; // weight and balance are beyond this model
+        }
+
+        _lat = init.latitude_deg * DEG_TO_RAD;
+        _lon = init.longitude_deg * DEG_TO_RAD;
+        _ground = init.ground_m;
+        _alt = init.reset == FGShmFDMInit::RESET_GROUND
+            ? _ground : init.altitude_ft * FEET_TO_METER;
+        _heading = init.heading_deg * DEG_TO_RAD;
+        _speed = init.speed_kts * KNOTS_TO_MPS;
+        _pitch = _roll = _climb = 0.0;
+    }
+
+    void step(const FGNetCtrls& ctrls, double dt)
+    {
+        const double throttle = ctrls.num_engines > 0 ? ctrls.throttle[0] : 0.0;
+        _speed += (throttle * 60.0 - _speed) * 0.2 * dt;
+
+        _roll += (ctrls.aileron * 30.0 * DEG_TO_RAD - _roll) * 2.0 * dt;
+        _pitch += (-ctrls.elevator * 15.0 * DEG_TO_RAD - _pitch) * 2.0 * dt;
+
+        if (_speed > 1.0) {
+            _heading += 9.81 * tan(_roll) / _speed * dt;
+            _heading = fmod(_heading + 2 * M_PI, 2 * M_PI);
+        }
+
+        _climb = _speed * sin(_pitch);
+        _alt += _climb * dt;
+        if (_alt < _ground) {
+            _alt = _ground;
+            _climb = 0.0;
+        }
+
+        const double ground_speed = _speed * cos(_pitch);
+        _lat += ground_speed * cos(_heading) / EARTH_RADIUS_M * dt;
+        _lon += ground_speed * sin(_heading) / (EARTH_RADIUS_M * cos(_lat)) * dt;
+    }
+
+    void fill(FGNetFDM& fdm, const FGNetCtrls& ctrls) const
+    {
+        memset(&fdm, 0, sizeof(fdm));
+        fdm.version = FG_NET_FDM_VERSION;
+        fdm.longitude = _lon;
+        fdm.latitude = _lat;
+        fdm.altitude = _alt;
+        fdm.agl = _alt - _ground;
+        fdm.phi = _roll;
+        fdm.theta = _pitch;
+        fdm.psi = _heading;
+        fdm.vcas = _speed / KNOTS_TO_MPS;
+        fdm.climb_rate = _climb / FEET_TO_METER;
+
+        const double ground_speed = _speed * cos(_pitch) / FEET_TO_METER;
+        fdm.v_north = ground_speed * cos(_heading);
+        fdm.v_east = ground_speed * sin(_heading);
+        fdm.v_down = -_climb / FEET_TO_METER;
+        fdm.v_body_u = _speed / FEET_TO_METER;
+        fdm.A_Z_pilot = -32.174;
+
+        fdm.num_engines = 1;
+        fdm.eng_state[0] = 2; // running
+        fdm.rpm[0] = ctrls.num_engines > 0 ? 700 + ctrls.throttle[0] * 1800 : 0;
+
+        fdm.elevator = ctrls.elevator;
+        fdm.left_aileron = ctrls.aileron;
+        fdm.right_aileron = -ctrls.aileron;
+        fdm.rudder = ctrls.rudder;
+    }
+
+private:
+    uint32_t _generation;
+    double _lat, _lon, _alt, _ground;
+    double _heading, _pitch, _roll;
+    double _speed, _climb;
+};
+
+FGShmFDMSegment* mapSegment(const std::string& name, bool create)
+{
+    int fd = create
+        ? shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600)
+        : shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        return NULL;
+    }
+    if (create && ftruncate(fd, sizeof(FGShmFDMSegment)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    void* p = mmap(NULL, sizeof(FGShmFDMSegment), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    return create ? new (p) FGShmFDMSegment : static_cast<FGShmFDMSegment*>(p);
+}
+
+// wait for the simulator to create and initialise the segment
+FGShmFDMSegment* attach(const std::string& name)
+{
+    for (int attempt = 0; attempt < 600; ++attempt) {
+        FGShmFDMSegment* shm = mapSegment(name, false);
+        if (shm) {
+            if (shm->magic.load(std::memory_order_acquire) == FG_SHM_FDM_MAGIC) {
+                if (shm->version != FG_SHM_FDM_VERSION
+                    || shm->ctrls_version != FG_NET_CTRLS_VERSION
+                    || shm->fdm_version != FG_NET_FDM_VERSION
+                    || shm->segment_size != sizeof(FGShmFDMSegment)) {
+                    std::cerr << "fgshmfdm: " << name << " was created by an "
+                              << "incompatible FlightGear version" << std::endl;
+                    munmap(shm, sizeof(FGShmFDMSegment));
+                    return NULL;
+                }
+                return shm;
+            }
+            munmap(shm, sizeof(FGShmFDMSegment));
+        }
+        usleep(100000);
+    }
+
+    std::cerr << "fgshmfdm: no segment " << name << " appeared, is FlightGear "
+              << "running with --fdm=pipe,<name>,shm ?" << std::endl;
+    return NULL;
+}
+
+// the model side: answer every input frame until the simulator goes away
+// or maxFrames have been served
+int serve(FGShmFDMSegment* shm, unsigned long maxFrames, bool verbose)
+{
+    SimpleModel model;
+    FGShmFDMInput input;
+    uint32_t last = 0; // answer a frame that is already waiting right away
+    unsigned long frames = 0, reportFrames = 0;
+    double reportTime = monotonicSeconds();
+
+    while (maxFrames == 0 || frames < maxFrames) {
+        if (!fgShmFutexWait(&shm->input_frame, last, 1000)) {
+            if (shm->magic.load(std::memory_order_acquire) != FG_SHM_FDM_MAGIC) {
+                break;
+            }
+            continue;
+        }
+        if (shm->magic.load(std::memory_order_acquire) != FG_SHM_FDM_MAGIC) {
+            break; // the simulator shut down
+        }
+
+        if (!shm->input.read(input)) {
+            continue; // the simulator stalled mid-write, check it is still there
+        }
+        last = input.frame;
+
+        model.apply(input.init);
+        for (int i = 0; i < input.iterations; ++i) {
+            model.step(input.ctrls, input.dt);
+        }
+
+        FGShmFDMOutput& output = shm->output.beginWrite();
+        output.frame = input.frame;
+        model.fill(output.fdm, input.ctrls);
+        shm->output.endWrite();
+
+        shm->output_frame.store(input.frame, std::memory_order_release);
+        fgShmFutexWake(&shm->output_frame);
+
+        ++frames;
+        ++reportFrames;
+        const double now = monotonicSeconds();
+        if (verbose && now - reportTime >= 5.0) {
+            std::cout << "fgshmfdm: " << reportFrames / (now - reportTime)
+                      << " frames/s" << std::endl;
+            reportFrames = 0;
+            reportTime = now;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// the simulator side of --loopback: lockstep frames against a forked model
+int loopback(const std::string& name, unsigned long frames)
+{
+    shm_unlink(name.c_str());
+    FGShmFDMSegment* shm = mapSegment(name, true);
+    if (!shm) {
+        perror("fgshmfdm: shm_open");
+        return EXIT_FAILURE;
+    }
+    shm->version = FG_SHM_FDM_VERSION;
+    shm->ctrls_version = FG_NET_CTRLS_VERSION;
+    shm->fdm_version = FG_NET_FDM_VERSION;
+    shm->segment_size = sizeof(FGShmFDMSegment);
+    shm->lockstep = 1;
+    shm->magic.store(FG_SHM_FDM_MAGIC, std::memory_order_release);
+
+    pid_t child = fork();
+    if (child == 0) {
+        // the mapping is inherited, no need to attach
+        _exit(serve(shm, frames, false));
+    }
+
+    FGShmFDMInit init;
+    memset(&init, 0, sizeof(init));
+    init.latitude_deg = 37.6;
+    init.longitude_deg = -122.4;
+    init.altitude_ft = 3000.0;
+    init.speed_kts = 100.0;
+    init.reset = FGShmFDMInit::RESET_AIR;
+    init.generation = 1;
+
+    int errors = 0;
+    double worst = 0.0;
+    const double start = monotonicSeconds();
+    for (uint32_t frame = 1; frame <= frames; ++frame) {
+        const double sent = monotonicSeconds();
+
+        FGShmFDMInput& input = shm->input.beginWrite();
+        input.frame = frame;
+        input.iterations = 1;
+        input.dt = 1.0 / 120;
+        input.init = init;
+        memset(&input.ctrls, 0, sizeof(input.ctrls));
+        input.ctrls.num_engines = 1;
+        input.ctrls.throttle[0] = 0.75;
+        input.ctrls.aileron = 0.2;
+        shm->input.endWrite();
+        shm->input_frame.store(frame, std::memory_order_release);
+        fgShmFutexWake(&shm->input_frame);
+
+        uint32_t seen;
+        while ((seen = shm->output_frame.load(std::memory_order_acquire)) != frame) {
+            if (!fgShmFutexWait(&shm->output_frame, seen, 1000)) {
+                std::cerr << "fgshmfdm: no answer for frame " << frame << std::endl;
+                ++errors;
+                break;
+            }
+        }
+        if (shm->output.data.frame != frame
+            || shm->output.data.fdm.version != FG_NET_FDM_VERSION) {
+            ++errors;
+        }
+        worst = std::max(worst, monotonicSeconds() - sent);
+    }
+    const double elapsed = monotonicSeconds() - start;
+
+    const FGNetFDM& fdm = shm->output.data.fdm;
+    std::cout << "fgshmfdm: " << frames << " lockstep frames at "
+              << frames / elapsed << " frames/s, worst round trip "
+              << worst * 1e6 << " us" << std::endl
+              << "fgshmfdm: ended at lat " << fdm.latitude / DEG_TO_RAD
+              << " lon " << fdm.longitude / DEG_TO_RAD
+              << " heading " << fdm.psi / DEG_TO_RAD << std::endl;
+
+    // let the model see we are gone
+    shm->magic.store(0, std::memory_order_release);
+    shm->input_frame.store(0, std::memory_order_release);
+    fgShmFutexWake(&shm->input_frame);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    munmap(shm, sizeof(FGShmFDMSegment));
+    shm_unlink(name.c_str());
+
+    return errors == 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0
+        ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void usage()
+{
+    std::cerr << "Usage: fgshmfdm [--name <name>] [--frames <n>] [--quiet]\n"
+              << "       fgshmfdm --loopback [--frames <n>]\n"
+              << "\n"
+              << "Use the same <name> as in FlightGear's --fdm=pipe,<name>,shm\n"
+              << "(default: fgfdm)." << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::string name = "fgfdm";
+    unsigned long frames = 0;
+    bool verbose = true;
+    bool runLoopback = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if (arg == "--quiet") {
+            verbose = false;
+        } else if (arg == "--loopback") {
+            runLoopback = true;
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (runLoopback) {
+        return loopback(fgShmFDMName(name + "-loopback"), frames ? frames : 100000);
+    }
+
+    FGShmFDMSegment* shm = attach(fgShmFDMName(name));
+    if (!shm) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "fgshmfdm: attached to " << fgShmFDMName(name)
+              << (shm->lockstep ? " (lockstep)" : " (free running)") << std::endl;
+
+    int result = serve(shm, frames, verbose);
+    munmap(shm, sizeof(FGShmFDMSegment));
+    return result;
+}
+
+#endif // FG_HAVE_SHM_FDM